@@ -32,6 +32,7 @@ For discussion please visit http://box2d.org/forum
 // These include files constitute the main Box2D API
 
 #include <Box2D/Common/b2Settings.h>
+#include <Box2D/Common/b2TaskScheduler.h>
 
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
@@ -43,6 +44,7 @@ For discussion please visit http://box2d.org/forum
 
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2Sensor.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
 #include <Box2D/Dynamics/b2World.h>
@@ -59,4 +61,11 @@ For discussion please visit http://box2d.org/forum
 #include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
 #include <Box2D/Dynamics/Joints/b2WeldJoint.h>
 
+#include <Box2D/Dynamics/Controllers/b2BuoyancyField.h>
+#include <Box2D/Dynamics/Controllers/b2DirectionalField.h>
+#include <Box2D/Dynamics/Controllers/b2RadialField.h>
+#include <Box2D/Dynamics/Controllers/b2VortexField.h>
+
+#include <Box2D/Dynamics/Particles/b2ParticleSystem.h>
+
 #endif
@@ -39,6 +39,7 @@ void b2PolygonShape::SetAsBox(float32 hx, float32 hy)
 	m_normals[2].Set(0.0f, 1.0f);
 	m_normals[3].Set(-1.0f, 0.0f);
 	m_centroid.SetZero();
+	m_box = true;
 }
 
 void b2PolygonShape::SetAsBox(float32 hx, float32 hy, const b2Vec2& center, float32 angle)
@@ -53,6 +54,7 @@ void b2PolygonShape::SetAsBox(float32 hx, float32 hy, const b2Vec2& center, floa
 	m_normals[2].Set(0.0f, 1.0f);
 	m_normals[3].Set(-1.0f, 0.0f);
 	m_centroid = center;
+	m_box = true;
 
 	b2Transform xf;
 	xf.position = center;
@@ -75,6 +77,7 @@ void b2PolygonShape::SetAsEdge(const b2Vec2& v1, const b2Vec2& v2)
 	m_normals[0] = b2Cross(v2 - v1, 1.0f);
 	m_normals[0].Normalize();
 	m_normals[1] = -m_normals[0];
+	m_box = false;
 }
 
 static b2Vec2 ComputeCentroid(const b2Vec2* vs, int32 count)
@@ -133,6 +136,7 @@ void b2PolygonShape::Set(const b2Vec2* vertices, int32 count)
 {
 	b2Assert(2 <= count && count <= b2_maxPolygonVertices);
 	m_vertexCount = count;
+	m_box = false;
 
 	// Copy vertices.
 	for (int32 i = 0; i < m_vertexCount; ++i)
@@ -33,9 +33,11 @@ public:
 
 	/// Copy vertices. This assumes the vertices define a convex polygon.
 	/// It is assumed that the exterior is the the right of each edge.
+	/// Polygons set this way are never treated as boxes.
 	void Set(const b2Vec2* vertices, int32 vertexCount);
 
-	/// Build vertices to represent an axis-aligned box.
+	/// Build vertices to represent an axis-aligned box. Boxes collide with
+	/// specialized routines, so don't change their vertices afterwards.
 	/// @param hx the half-width.
 	/// @param hy the half-height.
 	void SetAsBox(float32 hx, float32 hy);
@@ -78,6 +80,9 @@ public:
 	b2Vec2 m_vertices[b2_maxPolygonVertices];
 	b2Vec2 m_normals[b2_maxPolygonVertices];
 	int32 m_vertexCount;
+
+	/// True if this was built by SetAsBox.
+	bool m_box;
 };
 
 inline b2PolygonShape::b2PolygonShape()
@@ -86,6 +91,7 @@ inline b2PolygonShape::b2PolygonShape()
 	m_radius = b2_polygonRadius;
 	m_vertexCount = 0;
 	m_centroid.SetZero();
+	m_box = false;
 }
 
 inline int32 b2PolygonShape::GetSupport(const b2Vec2& d) const
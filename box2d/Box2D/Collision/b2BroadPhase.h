@@ -91,9 +91,15 @@ public:
 	/// Compute the height of the embedded tree.
 	int32 ComputeHeight() const;
 
+	/// Shift the world origin. Useful for large worlds.
+	/// The shift formula is: position -= newOrigin
+	/// @param newOrigin the new origin with respect to the old origin
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
 private:
 
 	friend class b2DynamicTree;
+	friend class b2World;
 
 	void BufferMove(int32 proxyId);
 	void UnBufferMove(int32 proxyId);
@@ -158,6 +164,11 @@ inline int32 b2BroadPhase::ComputeHeight() const
 	return m_tree.ComputeHeight();
 }
 
+inline void b2BroadPhase::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	m_tree.ShiftOrigin(newOrigin);
+}
+
 template <typename T>
 void b2BroadPhase::UpdatePairs(T* callback)
 {
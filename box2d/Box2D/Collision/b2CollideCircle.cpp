@@ -152,3 +152,124 @@ void b2CollidePolygonAndCircle(
 		manifold->points[0].id.key = 0;
 	}
 }
+
+// The edges of a box, see b2PolygonShape::SetAsBox, are in the order bottom,
+// right, top and left. The face separations and the Voronoi regions of the
+// corners come from the position of the circle along the box axes.
+void b2CollideBoxAndCircle(
+	b2Manifold* manifold,
+	const b2PolygonShape* boxA, const b2Transform& xfA,
+	const b2CircleShape* circleB, const b2Transform& xfB)
+{
+	b2Assert(boxA->m_box);
+
+	manifold->pointCount = 0;
+
+	// Compute circle position in the frame of the box.
+	b2Vec2 c = b2Mul(xfB, circleB->m_p);
+	b2Vec2 cLocal = b2MulT(xfA, c);
+
+	float32 radius = boxA->m_radius + circleB->m_radius;
+	const b2Vec2* vertices = boxA->m_vertices;
+	const b2Vec2* normals = boxA->m_normals;
+
+	// Circle position and half extents along the box axes.
+	b2Mat22 axes(normals[1], normals[2]);
+	b2Vec2 p = b2MulT(axes, cLocal - boxA->m_centroid);
+	b2Vec2 h = b2MulT(axes, vertices[2] - boxA->m_centroid);
+
+	float32 separations[4];
+	separations[0] = -p.y - h.y;
+	separations[1] = p.x - h.x;
+	separations[2] = p.y - h.y;
+	separations[3] = -p.x - h.x;
+
+	// Find the min separating edge, in the same order as b2CollidePolygonAndCircle.
+	int32 normalIndex = 0;
+	float32 separation = separations[0];
+	for (int32 i = 1; i < 4; ++i)
+	{
+		if (separations[i] > separation)
+		{
+			separation = separations[i];
+			normalIndex = i;
+		}
+	}
+
+	if (separation > radius)
+	{
+		return;
+	}
+
+	// Vertices that subtend the incident face.
+	int32 vertIndex1 = normalIndex;
+	int32 vertIndex2 = vertIndex1 + 1 < 4 ? vertIndex1 + 1 : 0;
+	b2Vec2 v1 = vertices[vertIndex1];
+	b2Vec2 v2 = vertices[vertIndex2];
+
+	manifold->type = b2Manifold::e_faceA;
+	manifold->points[0].localPoint = circleB->m_p;
+	manifold->points[0].id.key = 0;
+
+	// If the center is inside the box ...
+	if (separation < b2_epsilon)
+	{
+		manifold->pointCount = 1;
+		manifold->localNormal = normals[normalIndex];
+		manifold->localPoint = 0.5f * (v1 + v2);
+		return;
+	}
+
+	// Position of the circle along the face, from v1 to v2.
+	float32 t, ht;
+	switch (normalIndex)
+	{
+	case 0:
+		t = p.x;
+		ht = h.x;
+		break;
+	case 1:
+		t = p.y;
+		ht = h.y;
+		break;
+	case 2:
+		t = -p.x;
+		ht = h.x;
+		break;
+	default:
+		t = -p.y;
+		ht = h.y;
+		break;
+	}
+
+	if (t <= -ht)
+	{
+		if (b2DistanceSquared(cLocal, v1) > radius * radius)
+		{
+			return;
+		}
+
+		manifold->pointCount = 1;
+		manifold->localNormal = cLocal - v1;
+		manifold->localNormal.Normalize();
+		manifold->localPoint = v1;
+	}
+	else if (t >= ht)
+	{
+		if (b2DistanceSquared(cLocal, v2) > radius * radius)
+		{
+			return;
+		}
+
+		manifold->pointCount = 1;
+		manifold->localNormal = cLocal - v2;
+		manifold->localNormal.Normalize();
+		manifold->localPoint = v2;
+	}
+	else
+	{
+		manifold->pointCount = 1;
+		manifold->localNormal = normals[vertIndex1];
+		manifold->localPoint = 0.5f * (v1 + v2);
+	}
+}
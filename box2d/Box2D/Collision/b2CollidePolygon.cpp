@@ -183,30 +183,13 @@ static void b2FindIncidentEdge(b2ClipVertex c[2],
 	c[1].id.features.incidentVertex = 1;
 }
 
-// Find edge normal of max separation on A - return if separating axis is found
-// Find edge normal of max separation on B - return if separation axis is found
-// Choose reference edge as min(minA, minB)
-// Find incident edge
-// Clip
-
-// The normal points from 1 to 2
-void b2CollidePolygons(b2Manifold* manifold,
-					  const b2PolygonShape* polyA, const b2Transform& xfA,
-					  const b2PolygonShape* polyB, const b2Transform& xfB)
+// Choose the reference edge from the edges of max separation on A and B,
+// find the incident edge and clip it.
+static void b2ClipPolygons(b2Manifold* manifold,
+						   const b2PolygonShape* polyA, const b2Transform& xfA, int32 edgeA, float32 separationA,
+						   const b2PolygonShape* polyB, const b2Transform& xfB, int32 edgeB, float32 separationB,
+						   float32 totalRadius)
 {
-	manifold->pointCount = 0;
-	float32 totalRadius = polyA->m_radius + polyB->m_radius;
-
-	int32 edgeA = 0;
-	float32 separationA = b2FindMaxSeparation(&edgeA, polyA, xfA, polyB, xfB);
-	if (separationA > totalRadius)
-		return;
-
-	int32 edgeB = 0;
-	float32 separationB = b2FindMaxSeparation(&edgeB, polyB, xfB, polyA, xfA);
-	if (separationB > totalRadius)
-		return;
-
 	const b2PolygonShape* poly1;	// reference polygon
 	const b2PolygonShape* poly2;	// incident polygon
 	b2Transform xf1, xf2;
@@ -304,3 +287,108 @@ void b2CollidePolygons(b2Manifold* manifold,
 
 	manifold->pointCount = pointCount;
 }
+
+// Find edge normal of max separation on A - return if separating axis is found
+// Find edge normal of max separation on B - return if separation axis is found
+// Choose reference edge as min(minA, minB)
+// Find incident edge
+// Clip
+
+// The normal points from 1 to 2
+void b2CollidePolygons(b2Manifold* manifold,
+					  const b2PolygonShape* polyA, const b2Transform& xfA,
+					  const b2PolygonShape* polyB, const b2Transform& xfB)
+{
+	manifold->pointCount = 0;
+	float32 totalRadius = polyA->m_radius + polyB->m_radius;
+
+	int32 edgeA = 0;
+	float32 separationA = b2FindMaxSeparation(&edgeA, polyA, xfA, polyB, xfB);
+	if (separationA > totalRadius)
+		return;
+
+	int32 edgeB = 0;
+	float32 separationB = b2FindMaxSeparation(&edgeB, polyB, xfB, polyA, xfA);
+	if (separationB > totalRadius)
+		return;
+
+	b2ClipPolygons(manifold, polyA, xfA, edgeA, separationA, polyB, xfB, edgeB, separationB, totalRadius);
+}
+
+// Separation of two boxes along the normal n of a face of the first box, in
+// closed form. d is the vector between the centers, h the half extent of the
+// first box along n and bx, by the axes of the second box scaled by its half
+// extents.
+static inline float32 b2BoxSeparation(const b2Vec2& n, const b2Vec2& d, float32 h,
+							   const b2Vec2& bx, const b2Vec2& by)
+{
+	return b2Abs(b2Dot(n, d)) - h - b2Abs(b2Dot(n, bx)) - b2Abs(b2Dot(n, by));
+}
+
+// The edges of a box, see b2PolygonShape::SetAsBox, are in the order bottom,
+// right, top and left. Pick the face of max separation like b2FindMaxSeparation,
+// then clip like b2CollidePolygons.
+void b2CollideBoxes(b2Manifold* manifold,
+					const b2PolygonShape* boxA, const b2Transform& xfA,
+					const b2PolygonShape* boxB, const b2Transform& xfB)
+{
+	b2Assert(boxA->m_box && boxB->m_box);
+
+	manifold->pointCount = 0;
+	float32 totalRadius = boxA->m_radius + boxB->m_radius;
+
+	// Box axes in world frame.
+	b2Vec2 axA = b2Mul(xfA.R, boxA->m_normals[1]);
+	b2Vec2 ayA = b2Mul(xfA.R, boxA->m_normals[2]);
+	b2Vec2 axB = b2Mul(xfB.R, boxB->m_normals[1]);
+	b2Vec2 ayB = b2Mul(xfB.R, boxB->m_normals[2]);
+
+	// Half extents, from the top right vertex.
+	b2Vec2 hA = b2MulT(b2Mat22(boxA->m_normals[1], boxA->m_normals[2]), boxA->m_vertices[2] - boxA->m_centroid);
+	b2Vec2 hB = b2MulT(b2Mat22(boxB->m_normals[1], boxB->m_normals[2]), boxB->m_vertices[2] - boxB->m_centroid);
+
+	b2Vec2 d = b2Mul(xfB, boxB->m_centroid) - b2Mul(xfA, boxA->m_centroid);
+
+	b2Vec2 exA = hA.x * axA, eyA = hA.y * ayA;
+	b2Vec2 exB = hB.x * axB, eyB = hB.y * ayB;
+
+	float32 sxA = b2BoxSeparation(axA, d, hA.x, exB, eyB);
+	float32 syA = b2BoxSeparation(ayA, d, hA.y, exB, eyB);
+	float32 sxB = b2BoxSeparation(axB, d, hB.x, exA, eyA);
+	float32 syB = b2BoxSeparation(ayB, d, hB.y, exA, eyA);
+
+	int32 edgeA;
+	float32 separationA;
+	if (sxA > syA)
+	{
+		edgeA = b2Dot(axA, d) >= 0.0f ? 1 : 3;
+		separationA = sxA;
+	}
+	else
+	{
+		edgeA = b2Dot(ayA, d) >= 0.0f ? 2 : 0;
+		separationA = syA;
+	}
+
+	if (separationA > totalRadius)
+		return;
+
+	// The centers are seen the other way around from B.
+	int32 edgeB;
+	float32 separationB;
+	if (sxB > syB)
+	{
+		edgeB = b2Dot(axB, d) <= 0.0f ? 1 : 3;
+		separationB = sxB;
+	}
+	else
+	{
+		edgeB = b2Dot(ayB, d) <= 0.0f ? 2 : 0;
+		separationB = syB;
+	}
+
+	if (separationB > totalRadius)
+		return;
+
+	b2ClipPolygons(manifold, boxA, xfA, edgeA, separationA, boxB, xfB, edgeB, separationB, totalRadius);
+}
@@ -231,6 +231,25 @@ int32 b2ClipSegmentToLine(b2ClipVertex vOut[2], const b2ClipVertex vIn[2],
 
 bool b2TestOverlap(const b2Shape* shapeA, const b2Shape* shapeB,
 				   const b2Transform& xfA, const b2Transform& xfB)
+{
+	b2SimplexCache cache;
+	cache.count = 0;
+	return b2TestOverlap(shapeA, shapeB, xfA, xfB, &cache);
+}
+
+bool b2TestOverlap(const b2Shape* shapeA, const b2Shape* shapeB,
+				   const b2Transform& xfA, const b2Transform& xfB,
+				   b2SimplexCache* cache)
+{
+	b2DistanceStats stats;
+	bool overlap = b2TestOverlap(shapeA, shapeB, xfA, xfB, cache, &stats);
+	b2AddDistanceStats(stats);
+	return overlap;
+}
+
+bool b2TestOverlap(const b2Shape* shapeA, const b2Shape* shapeB,
+				   const b2Transform& xfA, const b2Transform& xfB,
+				   b2SimplexCache* cache, b2DistanceStats* stats)
 {
 	b2DistanceInput input;
 	input.proxyA.Set(shapeA);
@@ -239,12 +258,9 @@ bool b2TestOverlap(const b2Shape* shapeA, const b2Shape* shapeB,
 	input.transformB = xfB;
 	input.useRadii = true;
 
-	b2SimplexCache cache;
-	cache.count = 0;
-
 	b2DistanceOutput output;
 
-	b2Distance(&output, &cache, &input);
+	b2Distance(&output, cache, &input, stats);
 
 	return output.distance < 10.0f * b2_epsilon;
 }
@@ -29,6 +29,8 @@
 class b2Shape;
 class b2CircleShape;
 class b2PolygonShape;
+struct b2SimplexCache;
+struct b2DistanceStats;
 
 const uint8 b2_nullFeature = UCHAR_MAX;
 
@@ -204,6 +206,19 @@ void b2CollidePolygons(b2Manifold* manifold,
 					   const b2PolygonShape* polygon1, const b2Transform& xf1,
 					   const b2PolygonShape* polygon2, const b2Transform& xf2);
 
+/// Compute the collision manifold between a box and a circle. This is
+/// b2CollidePolygonAndCircle for polygons built by b2PolygonShape::SetAsBox.
+void b2CollideBoxAndCircle(b2Manifold* manifold,
+						   const b2PolygonShape* box, const b2Transform& xf1,
+						   const b2CircleShape* circle, const b2Transform& xf2);
+
+/// Compute the collision manifold between two boxes. This is
+/// b2CollidePolygons for polygons built by b2PolygonShape::SetAsBox, the
+/// separating axes are tested in closed form. The contact ids are the same.
+void b2CollideBoxes(b2Manifold* manifold,
+					const b2PolygonShape* box1, const b2Transform& xf1,
+					const b2PolygonShape* box2, const b2Transform& xf2);
+
 /// Clipping for contact manifolds.
 int32 b2ClipSegmentToLine(b2ClipVertex vOut[2], const b2ClipVertex vIn[2],
 							const b2Vec2& normal, float32 offset);
@@ -212,6 +227,17 @@ int32 b2ClipSegmentToLine(b2ClipVertex vOut[2], const b2ClipVertex vIn[2],
 bool b2TestOverlap(const b2Shape* shapeA, const b2Shape* shapeB,
 				   const b2Transform& xfA, const b2Transform& xfB);
 
+/// Determine if two generic shapes overlap, warm starting with a simplex cache.
+/// The cache is input/output, see b2Distance.
+bool b2TestOverlap(const b2Shape* shapeA, const b2Shape* shapeB,
+				   const b2Transform& xfA, const b2Transform& xfB,
+				   b2SimplexCache* cache);
+
+/// As above, counting the GJK work into stats instead of the b2_gjk* globals.
+bool b2TestOverlap(const b2Shape* shapeA, const b2Shape* shapeB,
+				   const b2Transform& xfA, const b2Transform& xfB,
+				   b2SimplexCache* cache, b2DistanceStats* stats);
+
 // ---------------- Inline Functions ------------------------------------------
 
 inline bool b2AABB::IsValid() const
@@ -408,11 +408,28 @@ void b2Simplex::Solve3()
 	m_count = 3;
 }
 
+void b2AddDistanceStats(const b2DistanceStats& stats)
+{
+	b2_gjkCalls += stats.calls;
+	b2_gjkIters += stats.iters;
+	b2_gjkMaxIters = b2Max(b2_gjkMaxIters, stats.maxIters);
+}
+
 void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache,
 				const b2DistanceInput* input)
 {
-	++b2_gjkCalls;
+	b2DistanceStats stats;
+	b2Distance(output, cache, input, &stats);
+	b2AddDistanceStats(stats);
+}
+
+void b2Distance(b2DistanceOutput* output,
+				b2SimplexCache* cache,
+				const b2DistanceInput* input,
+				b2DistanceStats* stats)
+{
+	++stats->calls;
 
 	const b2DistanceProxy* proxyA = &input->proxyA;
 	const b2DistanceProxy* proxyB = &input->proxyB;
@@ -509,7 +526,7 @@ void b2Distance(b2DistanceOutput* output,
 
 		// Iteration count is equated to the number of support point calls.
 		++iter;
-		++b2_gjkIters;
+		++stats->iters;
 
 		// Check for duplicate support points. This is the main termination criteria.
 		bool duplicate = false;
@@ -532,7 +549,7 @@ void b2Distance(b2DistanceOutput* output,
 		++simplex.m_count;
 	}
 
-	b2_gjkMaxIters = b2Max(b2_gjkMaxIters, iter);
+	stats->maxIters = b2Max(stats->maxIters, iter);
 
 	// Prepare output.
 	simplex.GetWitnessPoints(&output->pointA, &output->pointB);
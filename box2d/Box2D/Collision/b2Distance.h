@@ -83,6 +83,18 @@ struct b2DistanceOutput
 	int32 iterations;	///< number of GJK iterations used
 };
 
+/// Counters of the GJK work of b2Distance, for profiling. Queries made on
+/// several threads at once count into counters of their own, which are added
+/// to the b2_gjk* globals with b2AddDistanceStats once the queries are done.
+struct b2DistanceStats
+{
+	b2DistanceStats() : calls(0), iters(0), maxIters(0) {}
+
+	int32 calls;
+	int32 iters;
+	int32 maxIters;
+};
+
 /// Compute the closest points between two shapes. Supports any combination of:
 /// b2CircleShape, b2PolygonShape, b2EdgeShape. The simplex cache is input/output.
 /// On the first call set b2SimplexCache.count to zero.
@@ -90,6 +102,15 @@ void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache, 
 				const b2DistanceInput* input);
 
+/// As above, counting into stats instead of the b2_gjk* globals.
+void b2Distance(b2DistanceOutput* output,
+				b2SimplexCache* cache,
+				const b2DistanceInput* input,
+				b2DistanceStats* stats);
+
+/// Add counters to the b2_gjk* globals.
+void b2AddDistanceStats(const b2DistanceStats& stats);
+
 
 //////////////////////////////////////////////////////////////////////////
 
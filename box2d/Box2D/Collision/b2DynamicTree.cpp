@@ -40,12 +40,17 @@ b2DynamicTree::b2DynamicTree()
 	m_path = 0;
 
 	m_insertionCount = 0;
+
+	m_ownsNodes = true;
 }
 
 b2DynamicTree::~b2DynamicTree()
 {
 	// This frees the entire tree in one shot.
-	b2Free(m_nodes);
+	if (m_ownsNodes)
+	{
+		b2Free(m_nodes);
+	}
 }
 
 // Allocate a node from the pool. Grow the pool if necessary.
@@ -61,7 +66,11 @@ int32 b2DynamicTree::AllocateNode()
 		m_nodeCapacity *= 2;
 		m_nodes = (b2DynamicTreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2DynamicTreeNode));
 		memcpy(m_nodes, oldNodes, m_nodeCount * sizeof(b2DynamicTreeNode));
-		b2Free(oldNodes);
+		if (m_ownsNodes)
+		{
+			b2Free(oldNodes);
+		}
+		m_ownsNodes = true;
 
 		// Build a linked list for the free list. The parent
 		// pointer becomes the "next" pointer.
@@ -363,3 +372,13 @@ int32 b2DynamicTree::ComputeHeight() const
 {
 	return ComputeHeight(m_root);
 }
+
+void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	// Free nodes are shifted too, they are cheap and may be reused.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		m_nodes[i].aabb.lowerBound -= newOrigin;
+		m_nodes[i].aabb.upperBound -= newOrigin;
+	}
+}
@@ -91,6 +91,11 @@ public:
 	/// Compute the height of the tree.
 	int32 ComputeHeight() const;
 
+	/// Shift the world origin. Useful for large worlds.
+	/// The shift formula is: position -= newOrigin
+	/// @param newOrigin the new origin with respect to the old origin
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
 	/// Query an AABB for overlapping proxies. The callback class
 	/// is called for each proxy that overlaps the supplied AABB.
 	template <typename T>
@@ -108,6 +113,8 @@ public:
 
 private:
 
+	friend class b2World;
+
 	int32 AllocateNode();
 	void FreeNode(int32 node);
 
@@ -128,6 +135,9 @@ private:
 	uint32 m_path;
 
 	int32 m_insertionCount;
+
+	/// False while the nodes are borrowed, see b2World::LoadBroadPhase.
+	bool m_ownsNodes;
 };
 
 inline void* b2DynamicTree::GetUserData(int32 proxyId) const
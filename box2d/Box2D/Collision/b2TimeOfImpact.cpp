@@ -256,7 +256,31 @@ struct b2SeparationFunction
 // by computing the largest time at which separation is maintained.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 {
-	++b2_toiCalls;
+	b2SimplexCache cache;
+	cache.count = 0;
+	b2TimeOfImpact(output, input, &cache);
+}
+
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input, b2SimplexCache* cache)
+{
+	b2TOIStats stats;
+	b2TimeOfImpact(output, input, cache, &stats);
+	b2AddTOIStats(stats);
+}
+
+void b2AddTOIStats(const b2TOIStats& stats)
+{
+	b2_toiCalls += stats.calls;
+	b2_toiIters += stats.iters;
+	b2_toiMaxIters = b2Max(b2_toiMaxIters, stats.maxIters);
+	b2_toiRootIters += stats.rootIters;
+	b2_toiMaxRootIters = b2Max(b2_toiMaxRootIters, stats.maxRootIters);
+	b2AddDistanceStats(stats.distance);
+}
+
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input, b2SimplexCache* cache, b2TOIStats* stats)
+{
+	++stats->calls;
 
 	output->state = b2TOIOutput::e_unknown;
 	output->t = input->tMax;
@@ -284,8 +308,6 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 	int32 iter = 0;
 
 	// Prepare input for distance query.
-	b2SimplexCache cache;
-	cache.count = 0;
 	b2DistanceInput distanceInput;
 	distanceInput.proxyA = input->proxyA;
 	distanceInput.proxyB = input->proxyB;
@@ -304,7 +326,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		distanceInput.transformA = xfA;
 		distanceInput.transformB = xfB;
 		b2DistanceOutput distanceOutput;
-		b2Distance(&distanceOutput, &cache, &distanceInput);
+		b2Distance(&distanceOutput, cache, &distanceInput, &stats->distance);
 
 		// If the shapes are overlapped, we give up on continuous collision.
 		if (distanceOutput.distance <= 0.0f)
@@ -325,7 +347,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 
 		// Initialize the separating axis.
 		b2SeparationFunction fcn;
-		fcn.Initialize(&cache, proxyA, sweepA, proxyB, sweepB);
+		fcn.Initialize(cache, proxyA, sweepA, proxyB, sweepB);
 #if 0
 		// Dump the curve seen by the root finder
 		{
@@ -444,7 +466,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 
 				++rootIterCount;
-				++b2_toiRootIters;
+				++stats->rootIters;
 
 				if (rootIterCount == 50)
 				{
@@ -452,7 +474,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 				}
 			}
 
-			b2_toiMaxRootIters = b2Max(b2_toiMaxRootIters, rootIterCount);
+			stats->maxRootIters = b2Max(stats->maxRootIters, rootIterCount);
 
 			++pushBackIter;
 
@@ -463,7 +485,7 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 
 		++iter;
-		++b2_toiIters;
+		++stats->iters;
 
 		if (done)
 		{
@@ -479,5 +501,5 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 		}
 	}
 
-	b2_toiMaxIters = b2Max(b2_toiMaxIters, iter);
+	stats->maxIters = b2Max(stats->maxIters, iter);
 }
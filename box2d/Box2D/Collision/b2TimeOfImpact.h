@@ -49,6 +49,19 @@ struct b2TOIOutput
 	float32 t;
 };
 
+/// Counters of the work of b2TimeOfImpact, for profiling, see b2DistanceStats.
+struct b2TOIStats
+{
+	b2TOIStats() : calls(0), iters(0), maxIters(0), rootIters(0), maxRootIters(0) {}
+
+	int32 calls;
+	int32 iters;
+	int32 maxIters;
+	int32 rootIters;
+	int32 maxRootIters;
+	b2DistanceStats distance;
+};
+
 /// Compute the upper bound on time before two shapes penetrate. Time is represented as
 /// a fraction between [0,tMax]. This uses a swept separating axis and may miss some intermediate,
 /// non-tunneling collision. If you change the time interval, you should call this function
@@ -56,4 +69,15 @@ struct b2TOIOutput
 /// Note: use b2Distance to compute the contact point and normal at the time of impact.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input);
 
+/// As above, warm starting the distance queries with a simplex cache. The cache
+/// is input/output and holds the features of the last separating axis, so keep
+/// one per pair of shapes. On the first call set b2SimplexCache.count to zero.
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input, b2SimplexCache* cache);
+
+/// As above, counting into stats instead of the b2_toi* and b2_gjk* globals.
+void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input, b2SimplexCache* cache, b2TOIStats* stats);
+
+/// Add counters to the b2_toi* and b2_gjk* globals.
+void b2AddTOIStats(const b2TOIStats& stats);
+
 #endif
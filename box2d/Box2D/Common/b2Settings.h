@@ -72,6 +72,33 @@ typedef float float32;
 /// Making it larger may create artifacts for vertex collision.
 #define b2_polygonRadius		(2.0f * b2_linearSlop)
 
+/// The smallest number of contacts handed to one task when the narrow-phase
+/// runs on a multi-threaded b2TaskScheduler. Smaller ranges balance better but
+/// pay the scheduling cost more often.
+#define b2_collideTaskRange		32
+
+/// The smallest number of bodies handed to one task when their times of impact
+/// are found on a multi-threaded b2TaskScheduler.
+#define b2_toiTaskRange			8
+
+/// The smallest number of sensors handed to one task when their overlaps are
+/// found on a multi-threaded b2TaskScheduler.
+#define b2_sensorTaskRange		8
+
+/// The smallest number of particles handed to one task when a particle system
+/// is solved on a multi-threaded b2TaskScheduler.
+#define b2_particleTaskRange	512
+
+/// The most neighbors a particle of a particle system interacts with. Beyond
+/// this, which only happens under strong compression, the farther ones are
+/// ignored.
+#define b2_maxParticleNeighbors	32
+
+/// A contact keeps its manifold while the points of its fixtures have moved
+/// less than this relative to each other since it was computed, turns
+/// included. This is in meters.
+#define b2_manifoldLinearTolerance	(0.1f * b2_linearSlop)
+
 
 // Dynamics
 
@@ -105,6 +132,17 @@ typedef float float32;
 /// to overshoot.
 #define b2_contactBaumgarte			0.2f
 
+/// The stiffness of contacts in the sub-stepping solver, in Hertz. It is lowered
+/// to a quarter of the sub-step rate when that is slower.
+#define b2_contactHertz				30.0f
+
+/// The damping ratio of contacts in the sub-stepping solver. Contacts are heavily
+/// over-damped so that overlap is removed without bounce.
+#define b2_contactDampingRatio		10.0f
+
+/// The maximum speed at which the sub-stepping solver pushes bodies out of overlap.
+#define b2_contactPushVelocity		3.0f
+
 // Sleep
 
 /// The time that a body must be still before it will go to sleep.
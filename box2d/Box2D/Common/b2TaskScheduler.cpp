@@ -0,0 +1,370 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2TaskScheduler.h>
+#include <Box2D/Common/b2Math.h>
+
+#if !defined(_WIN32)
+#define B2_USE_PTHREADS
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+int32 b2SerialTaskScheduler::GetThreadCount() const
+{
+	return 1;
+}
+
+void b2SerialTaskScheduler::ParallelFor(b2TaskGroup* group, b2Task* task, int32 count, int32 minRange)
+{
+	B2_NOT_USED(group);
+	B2_NOT_USED(minRange);
+
+	if (count > 0)
+	{
+		task->Execute(0, count, 0);
+	}
+}
+
+void b2SerialTaskScheduler::Wait(b2TaskGroup* group)
+{
+	B2_NOT_USED(group);
+}
+
+#ifdef B2_USE_PTHREADS
+
+struct b2WorkItem
+{
+	b2Task* task;
+	b2TaskGroup* group;
+	int32 begin;
+	int32 end;
+};
+
+// A ring buffer of ranges. The owning thread pops from the back so it keeps
+// working on the data it touched last, thieves take from the front.
+struct b2WorkQueue
+{
+	void Push(const b2WorkItem& item)
+	{
+		pthread_mutex_lock(&mutex);
+		if (count == capacity)
+		{
+			int32 newCapacity = capacity ? 2 * capacity : 64;
+			b2WorkItem* newItems = (b2WorkItem*)b2Alloc(newCapacity * sizeof(b2WorkItem));
+			for (int32 i = 0; i < count; ++i)
+			{
+				newItems[i] = items[(head + i) % capacity];
+			}
+			b2Free(items);
+			items = newItems;
+			capacity = newCapacity;
+			head = 0;
+		}
+		items[(head + count) % capacity] = item;
+		++count;
+		pthread_mutex_unlock(&mutex);
+	}
+
+	bool PopBack(b2WorkItem* item)
+	{
+		bool found = false;
+		pthread_mutex_lock(&mutex);
+		if (count > 0)
+		{
+			--count;
+			*item = items[(head + count) % capacity];
+			found = true;
+		}
+		pthread_mutex_unlock(&mutex);
+		return found;
+	}
+
+	bool PopFront(b2WorkItem* item)
+	{
+		bool found = false;
+		pthread_mutex_lock(&mutex);
+		if (count > 0)
+		{
+			*item = items[head];
+			head = (head + 1) % capacity;
+			--count;
+			found = true;
+		}
+		pthread_mutex_unlock(&mutex);
+		return found;
+	}
+
+	pthread_mutex_t mutex;
+	b2WorkItem* items;
+	int32 capacity;
+	int32 head;
+	int32 count;
+};
+
+struct b2WorkerArgs
+{
+	b2ThreadPoolTaskScheduler* scheduler;
+	int32 threadIndex;
+};
+
+struct b2ThreadPoolState
+{
+	static void* WorkerMain(void* data);
+
+	// Guards sleeping; workers only block when nothing is queued.
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	volatile int32 queued;
+	bool quit;
+
+	pthread_t* threads;
+	b2WorkerArgs* args;
+};
+
+void* b2ThreadPoolState::WorkerMain(void* data)
+{
+	b2WorkerArgs* args = (b2WorkerArgs*)data;
+	b2ThreadPoolTaskScheduler* scheduler = args->scheduler;
+	b2ThreadPoolState* state = scheduler->m_state;
+
+	for (;;)
+	{
+		if (scheduler->ExecuteOne(args->threadIndex))
+		{
+			continue;
+		}
+
+		pthread_mutex_lock(&state->mutex);
+		while (state->quit == false && __sync_fetch_and_add(&state->queued, 0) == 0)
+		{
+			pthread_cond_wait(&state->cond, &state->mutex);
+		}
+		bool quit = state->quit;
+		pthread_mutex_unlock(&state->mutex);
+
+		if (quit)
+		{
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+b2ThreadPoolTaskScheduler::b2ThreadPoolTaskScheduler(int32 threadCount)
+{
+	b2Assert(threadCount > 0);
+	m_threadCount = threadCount;
+	m_nextQueue = 0;
+
+	m_queues = (b2WorkQueue*)b2Alloc(m_threadCount * sizeof(b2WorkQueue));
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		pthread_mutex_init(&m_queues[i].mutex, NULL);
+		m_queues[i].items = NULL;
+		m_queues[i].capacity = 0;
+		m_queues[i].head = 0;
+		m_queues[i].count = 0;
+	}
+
+	m_state = (b2ThreadPoolState*)b2Alloc(sizeof(b2ThreadPoolState));
+	pthread_mutex_init(&m_state->mutex, NULL);
+	pthread_cond_init(&m_state->cond, NULL);
+	m_state->queued = 0;
+	m_state->quit = false;
+	m_state->threads = (pthread_t*)b2Alloc(m_threadCount * sizeof(pthread_t));
+	m_state->args = (b2WorkerArgs*)b2Alloc(m_threadCount * sizeof(b2WorkerArgs));
+
+	// Thread 0 is the caller, it only works while waiting.
+	for (int32 i = 1; i < m_threadCount; ++i)
+	{
+		m_state->args[i].scheduler = this;
+		m_state->args[i].threadIndex = i;
+		if (pthread_create(m_state->threads + i, NULL, b2ThreadPoolState::WorkerMain, m_state->args + i) != 0)
+		{
+			// Run with the workers we got. The queues past them are still
+			// empty, so only their mutexes need to go.
+			for (int32 j = i; j < threadCount; ++j)
+			{
+				pthread_mutex_destroy(&m_queues[j].mutex);
+			}
+			m_threadCount = i;
+			break;
+		}
+	}
+}
+
+b2ThreadPoolTaskScheduler::~b2ThreadPoolTaskScheduler()
+{
+	pthread_mutex_lock(&m_state->mutex);
+	m_state->quit = true;
+	pthread_cond_broadcast(&m_state->cond);
+	pthread_mutex_unlock(&m_state->mutex);
+
+	for (int32 i = 1; i < m_threadCount; ++i)
+	{
+		pthread_join(m_state->threads[i], NULL);
+	}
+
+	pthread_cond_destroy(&m_state->cond);
+	pthread_mutex_destroy(&m_state->mutex);
+	b2Free(m_state->threads);
+	b2Free(m_state->args);
+	b2Free(m_state);
+
+	for (int32 i = 0; m_queues && i < m_threadCount; ++i)
+	{
+		pthread_mutex_destroy(&m_queues[i].mutex);
+		b2Free(m_queues[i].items);
+	}
+	b2Free(m_queues);
+}
+
+int32 b2ThreadPoolTaskScheduler::GetThreadCount() const
+{
+	return m_threadCount;
+}
+
+void b2ThreadPoolTaskScheduler::ParallelFor(b2TaskGroup* group, b2Task* task, int32 count, int32 minRange)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	if (minRange < 1)
+	{
+		minRange = 1;
+	}
+
+	// A few ranges per thread leave room for stealing to even out the load.
+	int32 rangeCount = count / minRange;
+	rangeCount = b2Min(rangeCount, 4 * m_threadCount);
+
+	if (m_threadCount == 1 || rangeCount <= 1)
+	{
+		task->Execute(0, count, 0);
+		return;
+	}
+
+	__sync_fetch_and_add(&group->pending, rangeCount);
+
+	// The first count % rangeCount ranges get one extra item.
+	int32 rangeSize = count / rangeCount;
+	int32 remainder = count % rangeCount;
+	int32 begin = 0;
+
+	for (int32 i = 0; i < rangeCount; ++i)
+	{
+		b2WorkItem item;
+		item.task = task;
+		item.group = group;
+		item.begin = begin;
+		item.end = begin + rangeSize + (i < remainder ? 1 : 0);
+		begin = item.end;
+
+		m_queues[m_nextQueue].Push(item);
+		m_nextQueue = (m_nextQueue + 1) % m_threadCount;
+	}
+
+	pthread_mutex_lock(&m_state->mutex);
+	__sync_fetch_and_add(&m_state->queued, rangeCount);
+	pthread_cond_broadcast(&m_state->cond);
+	pthread_mutex_unlock(&m_state->mutex);
+}
+
+void b2ThreadPoolTaskScheduler::Wait(b2TaskGroup* group)
+{
+	while (__sync_fetch_and_add(&group->pending, 0) > 0)
+	{
+		if (ExecuteOne(0) == false)
+		{
+			// The remaining ranges are running on the workers.
+			sched_yield();
+		}
+	}
+}
+
+bool b2ThreadPoolTaskScheduler::ExecuteOne(int32 threadIndex)
+{
+	b2WorkItem item;
+	bool found = m_queues[threadIndex].PopBack(&item);
+
+	for (int32 i = 1; found == false && i < m_threadCount; ++i)
+	{
+		found = m_queues[(threadIndex + i) % m_threadCount].PopFront(&item);
+	}
+
+	if (found == false)
+	{
+		return false;
+	}
+
+	__sync_fetch_and_sub(&m_state->queued, 1);
+
+	item.task->Execute(item.begin, item.end, threadIndex);
+
+	__sync_fetch_and_sub(&item.group->pending, 1);
+
+	return true;
+}
+
+#else
+
+b2ThreadPoolTaskScheduler::b2ThreadPoolTaskScheduler(int32 threadCount)
+{
+	B2_NOT_USED(threadCount);
+	m_threadCount = 1;
+	m_nextQueue = 0;
+	m_queues = NULL;
+	m_state = NULL;
+}
+
+b2ThreadPoolTaskScheduler::~b2ThreadPoolTaskScheduler()
+{
+}
+
+int32 b2ThreadPoolTaskScheduler::GetThreadCount() const
+{
+	return 1;
+}
+
+void b2ThreadPoolTaskScheduler::ParallelFor(b2TaskGroup* group, b2Task* task, int32 count, int32 minRange)
+{
+	B2_NOT_USED(group);
+	B2_NOT_USED(minRange);
+
+	if (count > 0)
+	{
+		task->Execute(0, count, 0);
+	}
+}
+
+void b2ThreadPoolTaskScheduler::Wait(b2TaskGroup* group)
+{
+	B2_NOT_USED(group);
+}
+
+bool b2ThreadPoolTaskScheduler::ExecuteOne(int32 threadIndex)
+{
+	B2_NOT_USED(threadIndex);
+	return false;
+}
+
+#endif
@@ -0,0 +1,122 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TASK_SCHEDULER_H
+#define B2_TASK_SCHEDULER_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// A unit of parallel work. The scheduler splits the item range [0, count)
+/// into sub-ranges and calls Execute for each of them, possibly concurrently.
+/// Implementations must only write to data owned by the items they are given,
+/// so the result does not depend on how the range was split.
+class b2Task
+{
+public:
+	virtual ~b2Task() {}
+
+	/// Process the items in [begin, end).
+	/// @param threadIndex the executing thread, in [0, b2TaskScheduler::GetThreadCount()).
+	/// Use this to index per-thread scratch data.
+	virtual void Execute(int32 begin, int32 end, int32 threadIndex) = 0;
+};
+
+/// Tracks the completion of the ranges submitted with b2TaskScheduler::ParallelFor.
+/// The group is owned by the caller and must stay alive until b2TaskScheduler::Wait
+/// returns for it.
+struct b2TaskGroup
+{
+	b2TaskGroup() : pending(0), userData(NULL) {}
+
+	/// Number of ranges that have not finished executing. Maintained by the scheduler.
+	volatile int32 pending;
+
+	/// Scheduler private data.
+	void* userData;
+};
+
+/// Interface to a job system used by the world to run work in parallel.
+/// The scheduler is owned by you and must outlive the worlds using it.
+/// All calls are made from the thread stepping the world.
+class b2TaskScheduler
+{
+public:
+	virtual ~b2TaskScheduler() {}
+
+	/// The number of threads that may execute tasks at the same time,
+	/// including the thread calling Wait.
+	virtual int32 GetThreadCount() const = 0;
+
+	/// Split [0, count) into ranges of at least minRange items and queue them
+	/// for execution. The ranges may start executing before this returns.
+	virtual void ParallelFor(b2TaskGroup* group, b2Task* task, int32 count, int32 minRange) = 0;
+
+	/// Block until every range submitted to the group has executed. The calling
+	/// thread executes queued ranges while it waits.
+	virtual void Wait(b2TaskGroup* group) = 0;
+
+	/// Run a task to completion.
+	void Run(b2Task* task, int32 count, int32 minRange)
+	{
+		b2TaskGroup group;
+		ParallelFor(&group, task, count, minRange);
+		Wait(&group);
+	}
+};
+
+/// Runs every task immediately on the calling thread, in order. This is the
+/// default scheduler of a world and gives bit-for-bit reproducible results.
+class b2SerialTaskScheduler : public b2TaskScheduler
+{
+public:
+	int32 GetThreadCount() const;
+	void ParallelFor(b2TaskGroup* group, b2Task* task, int32 count, int32 minRange);
+	void Wait(b2TaskGroup* group);
+};
+
+struct b2WorkQueue;
+struct b2ThreadPoolState;
+
+/// A work-stealing scheduler backed by its own worker threads. Each worker
+/// has a queue of ranges; it takes work from the back of its own queue and
+/// steals from the front of the others when it runs dry.
+/// On platforms without POSIX threads this runs everything serially.
+class b2ThreadPoolTaskScheduler : public b2TaskScheduler
+{
+public:
+	/// @param threadCount the number of threads including the caller's, so
+	/// threadCount - 1 workers are started.
+	b2ThreadPoolTaskScheduler(int32 threadCount);
+	~b2ThreadPoolTaskScheduler();
+
+	int32 GetThreadCount() const;
+	void ParallelFor(b2TaskGroup* group, b2Task* task, int32 count, int32 minRange);
+	void Wait(b2TaskGroup* group);
+
+private:
+	friend struct b2ThreadPoolState;
+
+	bool ExecuteOne(int32 threadIndex);
+
+	int32 m_threadCount;
+	int32 m_nextQueue;
+	b2WorkQueue* m_queues;
+	b2ThreadPoolState* m_state;
+};
+
+#endif
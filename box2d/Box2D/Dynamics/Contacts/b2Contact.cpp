@@ -24,7 +24,8 @@
 
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
-#include <Box2D/Collision/Shapes/b2Shape.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
@@ -110,6 +111,34 @@ void b2Contact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
 	destroyFcn(contact, allocator);
 }
 
+// The farthest a point of the shape is from its origin.
+static float32 b2GetShapeExtent(const b2Shape* shape)
+{
+	switch (shape->GetType())
+	{
+	case b2Shape::e_circle:
+		{
+			const b2CircleShape* circle = (const b2CircleShape*)shape;
+			return circle->m_p.Length() + circle->m_radius;
+		}
+
+	case b2Shape::e_polygon:
+		{
+			const b2PolygonShape* polygon = (const b2PolygonShape*)shape;
+			float32 extentSquared = 0.0f;
+			for (int32 i = 0; i < polygon->m_vertexCount; ++i)
+			{
+				extentSquared = b2Max(extentSquared, polygon->m_vertices[i].LengthSquared());
+			}
+			return b2Sqrt(extentSquared) + polygon->m_radius;
+		}
+
+	default:
+		b2Assert(false);
+		return 0.0f;
+	}
+}
+
 b2Contact::b2Contact(b2Fixture* fA, b2Fixture* fB)
 {
 	m_flags = e_enabledFlag;
@@ -119,49 +148,66 @@ b2Contact::b2Contact(b2Fixture* fA, b2Fixture* fB)
 
 	m_manifold.pointCount = 0;
 
-	m_prev = NULL;
-	m_next = NULL;
+	m_index = -1;
+	m_edgeA = -1;
+	m_edgeB = -1;
 
-	m_nodeA.contact = NULL;
-	m_nodeA.prev = NULL;
-	m_nodeA.next = NULL;
-	m_nodeA.other = NULL;
+	m_toiCount = 0;
 
-	m_nodeB.contact = NULL;
-	m_nodeB.prev = NULL;
-	m_nodeB.next = NULL;
-	m_nodeB.other = NULL;
+	m_simplexCache.count = 0;
 
-	m_toiCount = 0;
+	m_extentB = b2GetShapeExtent(fB->GetShape());
+}
+
+b2Contact* b2Contact::GetNext()
+{
+	b2ContactManager& contactManager = m_fixtureA->GetBody()->GetWorld()->m_contactManager;
+	int32 next = m_index + 1;
+	return next < contactManager.m_contactCount ? contactManager.m_contacts[next] : NULL;
+}
+
+const b2Contact* b2Contact::GetNext() const
+{
+	const b2ContactManager& contactManager = m_fixtureA->GetBody()->GetWorld()->m_contactManager;
+	int32 next = m_index + 1;
+	return next < contactManager.m_contactCount ? contactManager.m_contacts[next] : NULL;
 }
 
 // Update the contact manifold and touching status.
 // Note: do not assume the fixture AABBs are overlapping or are valid.
 void b2Contact::Update(b2ContactListener* listener)
 {
-	b2Manifold oldManifold = m_manifold;
+	b2Manifold oldManifold;
+	b2DistanceStats stats;
+	bool touching = UpdateManifold(&oldManifold, &stats);
+	b2AddDistanceStats(stats);
+	ReportUpdate(touching, &oldManifold, listener);
+}
+
+bool b2Contact::UpdateManifold(b2Manifold* oldManifold, b2DistanceStats* stats)
+{
+	*oldManifold = m_manifold;
 
-	// Re-enable this contact.
+	// Re-enable this contact. Manifolds computed here, for sensors and time
+	// of impact updates, are not kept for reuse.
 	m_flags |= e_enabledFlag;
+	m_flags &= ~e_cachedFlag;
 
 	bool touching = false;
-	bool wasTouching = (m_flags & e_touchingFlag) == e_touchingFlag;
 
 	bool sensorA = m_fixtureA->IsSensor();
 	bool sensorB = m_fixtureB->IsSensor();
 	bool sensor = sensorA || sensorB;
 
-	b2Body* bodyA = m_fixtureA->GetBody();
-	b2Body* bodyB = m_fixtureB->GetBody();
-	const b2Transform& xfA = bodyA->GetTransform();
-	const b2Transform& xfB = bodyB->GetTransform();
+	const b2Transform& xfA = m_fixtureA->GetBody()->GetTransform();
+	const b2Transform& xfB = m_fixtureB->GetBody()->GetTransform();
 
 	// Is this contact a sensor?
 	if (sensor)
 	{
 		const b2Shape* shapeA = m_fixtureA->GetShape();
 		const b2Shape* shapeB = m_fixtureB->GetShape();
-		touching = b2TestOverlap(shapeA, shapeB, xfA, xfB);
+		touching = b2TestOverlap(shapeA, shapeB, xfA, xfB, &m_simplexCache, stats);
 
 		// Sensors don't generate manifolds.
 		m_manifold.pointCount = 0;
@@ -173,31 +219,21 @@ void b2Contact::Update(b2ContactListener* listener)
 
 		// Match old contact ids to new contact ids and copy the
 		// stored impulses to warm start the solver.
-		for (int32 i = 0; i < m_manifold.pointCount; ++i)
-		{
-			b2ManifoldPoint* mp2 = m_manifold.points + i;
-			mp2->normalImpulse = 0.0f;
-			mp2->tangentImpulse = 0.0f;
-			b2ContactID id2 = mp2->id;
+		CopyImpulses(oldManifold);
+	}
 
-			for (int32 j = 0; j < oldManifold.pointCount; ++j)
-			{
-				b2ManifoldPoint* mp1 = oldManifold.points + j;
-
-				if (mp1->id.key == id2.key)
-				{
-					mp2->normalImpulse = mp1->normalImpulse;
-					mp2->tangentImpulse = mp1->tangentImpulse;
-					break;
-				}
-			}
-		}
+	return touching;
+}
 
-		if (touching != wasTouching)
-		{
-			bodyA->SetAwake(true);
-			bodyB->SetAwake(true);
-		}
+void b2Contact::ReportUpdate(bool touching, const b2Manifold* oldManifold, b2ContactListener* listener)
+{
+	bool wasTouching = (m_flags & e_touchingFlag) == e_touchingFlag;
+	bool sensor = m_fixtureA->IsSensor() || m_fixtureB->IsSensor();
+
+	if (sensor == false && touching != wasTouching)
+	{
+		m_fixtureA->GetBody()->SetAwake(true);
+		m_fixtureB->GetBody()->SetAwake(true);
 	}
 
 	if (touching)
@@ -221,6 +257,6 @@ void b2Contact::Update(b2ContactListener* listener)
 
 	if (sensor == false && touching && listener)
 	{
-		listener->PreSolve(this, &oldManifold);
+		listener->PreSolve(this, oldManifold);
 	}
 }
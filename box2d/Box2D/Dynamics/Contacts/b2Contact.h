@@ -21,6 +21,7 @@
 
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Collision/b2Distance.h>
 #include <Box2D/Collision/Shapes/b2Shape.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/b2Fixture.h>
@@ -45,15 +46,13 @@ struct b2ContactRegister
 
 /// A contact edge is used to connect bodies and contacts together
 /// in a contact graph where each body is a node and each contact
-/// is an edge. A contact edge belongs to a doubly linked list
-/// maintained in each attached body. Each contact has two contact
-/// nodes, one for each attached body.
+/// is an edge. Each body keeps the edges of its contacts in an array,
+/// see b2Body::GetContactEdges. Each contact has two contact edges,
+/// one for each attached body.
 struct b2ContactEdge
 {
 	b2Body* other;			///< provides quick access to the other body attached.
 	b2Contact* contact;		///< the contact
-	b2ContactEdge* prev;	///< the previous contact edge in the body's contact list
-	b2ContactEdge* next;	///< the next contact edge in the body's contact list
 };
 
 /// The class manages contact between two shapes. A contact exists for each overlapping
@@ -82,7 +81,8 @@ public:
 	/// Has this contact been disabled?
 	bool IsEnabled() const;
 
-	/// Get the next contact in the world's contact list.
+	/// Get the next contact in the world's contact list. Contacts are kept in
+	/// an array, destroying one moves the last contact in its place.
 	b2Contact* GetNext();
 	const b2Contact* GetNext() const;
 
@@ -103,6 +103,7 @@ protected:
 	friend class b2ContactSolver;
 	friend class b2Body;
 	friend class b2Fixture;
+	template <typename T> friend class b2CollideTask;
 
 	// Flags stored in m_flags
 	enum
@@ -122,6 +123,15 @@ protected:
 		// This bullet contact had a TOI event
 		e_bulletHitFlag		= 0x0010,
 
+		// The manifold was computed with the bodies at m_manifoldXf.
+		e_cachedFlag		= 0x0020,
+
+		// m_toi is known for the current sweeps.
+		e_toiFlag			= 0x0040,
+
+		// The shapes touch at m_toi, else they don't touch before m_toi.
+		e_toiHitFlag		= 0x0080,
+
 	};
 
 	/// Flag this contact for filtering. Filtering will occur the next time step.
@@ -140,26 +150,55 @@ protected:
 
 	void Update(b2ContactListener* listener);
 
+	// Update is split in two so the manifolds can be computed in parallel.
+	// UpdateManifold only writes to this contact and the stats, which are the
+	// thread's own, and returns whether the shapes touch. ReportUpdate wakes
+	// the bodies and calls the listener.
+	bool UpdateManifold(b2Manifold* oldManifold, b2DistanceStats* stats);
+	void ReportUpdate(bool touching, const b2Manifold* oldManifold, b2ContactListener* listener);
+
+	// UpdateManifold for a contact between solid fixtures that is known to be
+	// a T, calling its Evaluate directly. With reuse, the manifold is kept
+	// while the points of the fixtures stay within b2_manifoldLinearTolerance
+	// of where they were at m_manifoldXf; its local points are still valid then.
+	template <typename T>
+	bool UpdateManifold(b2Manifold* oldManifold, bool reuse);
+
+	// Copy the impulses of matching points of the old manifold, to warm start
+	// the solver.
+	void CopyImpulses(const b2Manifold* oldManifold);
+
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
 
 	uint32 m_flags;
 
-	// World pool and list pointers.
-	b2Contact* m_prev;
-	b2Contact* m_next;
+	// Index in the world's contact array.
+	int32 m_index;
 
-	// Nodes for connecting bodies.
-	b2ContactEdge m_nodeA;
-	b2ContactEdge m_nodeB;
+	// Indices of the edges of this contact in the arrays of body A and B.
+	int32 m_edgeA;
+	int32 m_edgeB;
 
 	b2Fixture* m_fixtureA;
 	b2Fixture* m_fixtureB;
 
 	b2Manifold m_manifold;
 
+	// Transform of body B relative to body A when the manifold was computed.
+	b2Transform m_manifoldXf;
+
+	// The farthest the points of fixture B are from the origin of body B.
+	float32 m_extentB;
+
 	int32 m_toiCount;
-//	float32 m_toi;
+
+	// The time of impact of the sweeps, see e_toiFlag.
+	float32 m_toi;
+
+	// Warm starts the distance queries of sensors and time of impact
+	// from one step to the next.
+	b2SimplexCache m_simplexCache;
 };
 
 inline b2Manifold* b2Contact::GetManifold()
@@ -204,16 +243,6 @@ inline bool b2Contact::IsTouching() const
 	return (m_flags & e_touchingFlag) == e_touchingFlag;
 }
 
-inline b2Contact* b2Contact::GetNext()
-{
-	return m_next;
-}
-
-inline const b2Contact* b2Contact::GetNext() const
-{
-	return m_next;
-}
-
 inline b2Fixture* b2Contact::GetFixtureA()
 {
 	return m_fixtureA;
@@ -239,4 +268,66 @@ inline void b2Contact::FlagForFiltering()
 	m_flags |= e_filterFlag;
 }
 
+template <typename T>
+inline bool b2Contact::UpdateManifold(b2Manifold* oldManifold, bool reuse)
+{
+	*oldManifold = m_manifold;
+
+	// Re-enable this contact.
+	m_flags |= e_enabledFlag;
+
+	const b2Transform& xfA = m_fixtureA->GetBody()->GetTransform();
+	const b2Transform& xfB = m_fixtureB->GetBody()->GetTransform();
+
+	b2Transform xf;
+	xf.position = b2MulT(xfA.R, xfB.position - xfA.position);
+	xf.R = b2MulT(xfA.R, xfB.R);
+
+	if (reuse && (m_flags & e_cachedFlag))
+	{
+		// The points of fixture B moved by the translation of body B plus
+		// the sine of its turn times their distance to its origin, at most.
+		// The cosine must stay positive.
+		const b2Vec2& c1 = m_manifoldXf.R.col1;
+		const b2Vec2& c2 = xf.R.col1;
+		float32 drift = b2Distance(xf.position, m_manifoldXf.position) + b2Abs(b2Cross(c1, c2)) * m_extentB;
+		if (drift < b2_manifoldLinearTolerance && b2Dot(c1, c2) > 0.0f)
+		{
+			// The impulses are already those of the last step.
+			return m_manifold.pointCount > 0;
+		}
+	}
+
+	static_cast<T*>(this)->T::Evaluate(&m_manifold, xfA, xfB);
+	CopyImpulses(oldManifold);
+
+	m_manifoldXf = xf;
+	m_flags |= e_cachedFlag;
+
+	return m_manifold.pointCount > 0;
+}
+
+inline void b2Contact::CopyImpulses(const b2Manifold* oldManifold)
+{
+	for (int32 i = 0; i < m_manifold.pointCount; ++i)
+	{
+		b2ManifoldPoint* mp2 = m_manifold.points + i;
+		mp2->normalImpulse = 0.0f;
+		mp2->tangentImpulse = 0.0f;
+		b2ContactID id2 = mp2->id;
+
+		for (int32 j = 0; j < oldManifold->pointCount; ++j)
+		{
+			const b2ManifoldPoint* mp1 = oldManifold->points + j;
+
+			if (mp1->id.key == id2.key)
+			{
+				mp2->normalImpulse = mp1->normalImpulse;
+				mp2->tangentImpulse = mp1->tangentImpulse;
+				break;
+			}
+		}
+	}
+}
+
 #endif
@@ -19,6 +19,8 @@
 #include <Box2D/Dynamics/Contacts/b2PolygonAndCircleContact.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
@@ -46,7 +48,15 @@ b2PolygonAndCircleContact::b2PolygonAndCircleContact(b2Fixture* fixtureA, b2Fixt
 
 void b2PolygonAndCircleContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
 {
-	b2CollidePolygonAndCircle(	manifold,
-								(b2PolygonShape*)m_fixtureA->GetShape(), xfA,
-								(b2CircleShape*)m_fixtureB->GetShape(), xfB);
+	b2PolygonShape* polygonA = (b2PolygonShape*)m_fixtureA->GetShape();
+	b2CircleShape* circleB = (b2CircleShape*)m_fixtureB->GetShape();
+
+	if (polygonA->m_box)
+	{
+		b2CollideBoxAndCircle(manifold, polygonA, xfA, circleB, xfB);
+	}
+	else
+	{
+		b2CollidePolygonAndCircle(manifold, polygonA, xfA, circleB, xfB);
+	}
 }
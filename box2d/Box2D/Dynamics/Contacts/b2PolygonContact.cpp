@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/Contacts/b2PolygonContact.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
@@ -46,7 +47,15 @@ b2PolygonContact::b2PolygonContact(b2Fixture* fixtureA, b2Fixture* fixtureB)
 
 void b2PolygonContact::Evaluate(b2Manifold* manifold, const b2Transform& xfA, const b2Transform& xfB)
 {
-	b2CollidePolygons(	manifold,
-						(b2PolygonShape*)m_fixtureA->GetShape(), xfA,
-						(b2PolygonShape*)m_fixtureB->GetShape(), xfB);
+	b2PolygonShape* polygonA = (b2PolygonShape*)m_fixtureA->GetShape();
+	b2PolygonShape* polygonB = (b2PolygonShape*)m_fixtureB->GetShape();
+
+	if (polygonA->m_box && polygonB->m_box)
+	{
+		b2CollideBoxes(manifold, polygonA, xfA, polygonB, xfB);
+	}
+	else
+	{
+		b2CollidePolygons(manifold, polygonA, xfA, polygonB, xfB);
+	}
 }
@@ -0,0 +1,499 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Contacts/b2SoftContactSolver.h>
+#include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Common/b2StackAllocator.h>
+
+// The per point data that b2ContactConstraintPoint has no room for.
+struct b2SoftContactPoint
+{
+	b2Vec2 localAnchorA;		// rA in the frame of body A
+	b2Vec2 localAnchorB;		// rB in the frame of body B
+	float32 adjustedSeparation;	// separation less that of the anchors
+	float32 maxNormalImpulse;	// largest normal impulse of any sub-step
+};
+
+void b2Softness::Initialize(float32 hertz, float32 dampingRatio, float32 h)
+{
+	if (hertz == 0.0f)
+	{
+		biasRate = 0.0f;
+		massScale = 1.0f;
+		impulseScale = 0.0f;
+		return;
+	}
+
+	// Implicit integration of a spring with damping: the bias and the
+	// scaling of the effective mass and of the accumulated impulse.
+	float32 omega = 2.0f * b2_pi * hertz;
+	float32 a1 = 2.0f * dampingRatio + h * omega;
+	float32 a2 = h * omega * a1;
+	float32 a3 = 1.0f / (1.0f + a2);
+	biasRate = omega / a1;
+	massScale = a2 * a3;
+	impulseScale = a3;
+}
+
+// Gets the normal, a point and the separation of a manifold point, as the
+// position solver of b2ContactSolver does.
+static float32 b2GetSeparation(const b2ContactConstraint* cc, int32 index, b2Vec2* normal, b2Vec2* point)
+{
+	switch (cc->type)
+	{
+	case b2Manifold::e_circles:
+		{
+			b2Vec2 pointA = cc->bodyA->GetWorldPoint(cc->localPoint);
+			b2Vec2 pointB = cc->bodyB->GetWorldPoint(cc->points[0].localPoint);
+			if (b2DistanceSquared(pointA, pointB) > b2_epsilon * b2_epsilon)
+			{
+				*normal = pointB - pointA;
+				normal->Normalize();
+			}
+			else
+			{
+				normal->Set(1.0f, 0.0f);
+			}
+
+			*point = 0.5f * (pointA + pointB);
+			return b2Dot(pointB - pointA, *normal) - cc->radius;
+		}
+
+	case b2Manifold::e_faceA:
+		{
+			*normal = cc->bodyA->GetWorldVector(cc->localNormal);
+			b2Vec2 planePoint = cc->bodyA->GetWorldPoint(cc->localPoint);
+
+			b2Vec2 clipPoint = cc->bodyB->GetWorldPoint(cc->points[index].localPoint);
+			*point = clipPoint;
+			return b2Dot(clipPoint - planePoint, *normal) - cc->radius;
+		}
+
+	default:
+		{
+			b2Assert(cc->type == b2Manifold::e_faceB);
+			*normal = cc->bodyB->GetWorldVector(cc->localNormal);
+			b2Vec2 planePoint = cc->bodyB->GetWorldPoint(cc->localPoint);
+
+			b2Vec2 clipPoint = cc->bodyA->GetWorldPoint(cc->points[index].localPoint);
+			*point = clipPoint;
+			float32 separation = b2Dot(clipPoint - planePoint, *normal) - cc->radius;
+
+			// Ensure normal points from A to B
+			*normal = -*normal;
+			return separation;
+		}
+	}
+}
+
+b2SoftContactSolver::b2SoftContactSolver(const b2TimeStep& subStep, int32 subStepCount,
+										 b2Contact** contacts, int32 contactCount,
+										 b2StackAllocator* allocator, float32 impulseRatio)
+{
+	m_allocator = allocator;
+
+	m_constraintCount = contactCount;
+	m_constraints = (b2ContactConstraint*)m_allocator->Allocate(m_constraintCount * sizeof(b2ContactConstraint));
+	m_points = (b2SoftContactPoint*)m_allocator->Allocate(m_constraintCount * b2_maxManifoldPoints * sizeof(b2SoftContactPoint));
+
+	m_inv_h = subStep.inv_dt;
+	m_subStepCount = subStepCount;
+
+	// The contacts can't be stiffer than the sub-steps can resolve.
+	float32 hertz = b2Min(b2_contactHertz, 0.25f * subStep.inv_dt);
+	m_softness.Initialize(hertz, b2_contactDampingRatio, subStep.dt);
+	m_staticSoftness.Initialize(2.0f * hertz, b2_contactDampingRatio, subStep.dt);
+
+	// The manifolds hold the impulses of whole time steps.
+	impulseRatio /= subStepCount;
+
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		b2Contact* contact = contacts[i];
+
+		b2Fixture* fixtureA = contact->GetFixtureA();
+		b2Fixture* fixtureB = contact->GetFixtureB();
+		b2Body* bodyA = fixtureA->GetBody();
+		b2Body* bodyB = fixtureB->GetBody();
+		b2Manifold* manifold = contact->GetManifold();
+
+		float32 restitution = b2MixRestitution(fixtureA->GetRestitution(), fixtureB->GetRestitution());
+
+		b2Assert(manifold->pointCount > 0);
+
+		b2ContactConstraint* cc = m_constraints + i;
+		cc->bodyA = bodyA;
+		cc->bodyB = bodyB;
+		cc->manifold = manifold;
+		cc->pointCount = manifold->pointCount;
+		cc->friction = b2MixFriction(fixtureA->GetFriction(), fixtureB->GetFriction());
+
+		cc->localNormal = manifold->localNormal;
+		cc->localPoint = manifold->localPoint;
+		cc->radius = fixtureA->GetShape()->m_radius + fixtureB->GetShape()->m_radius;
+		cc->type = manifold->type;
+
+		float32 invMassA = bodyA->m_invMass;
+		float32 invIA = bodyA->m_invI;
+		float32 invMassB = bodyB->m_invMass;
+		float32 invIB = bodyB->m_invI;
+		b2Vec2 vA = bodyA->m_linearVelocity;
+		b2Vec2 vB = bodyB->m_linearVelocity;
+		float32 wA = bodyA->m_angularVelocity;
+		float32 wB = bodyB->m_angularVelocity;
+
+		for (int32 j = 0; j < cc->pointCount; ++j)
+		{
+			b2ManifoldPoint* cp = manifold->points + j;
+			b2ContactConstraintPoint* ccp = cc->points + j;
+			b2SoftContactPoint* sp = m_points + i * b2_maxManifoldPoints + j;
+
+			ccp->normalImpulse = impulseRatio * cp->normalImpulse;
+			ccp->tangentImpulse = impulseRatio * cp->tangentImpulse;
+			ccp->localPoint = cp->localPoint;
+
+			// The normal is kept for the time step. It is the same for all
+			// points of a manifold.
+			b2Vec2 normal, point;
+			float32 separation = b2GetSeparation(cc, j, &normal, &point);
+			if (j == 0)
+			{
+				cc->normal = normal;
+			}
+
+			ccp->rA = point - bodyA->m_sweep.c;
+			ccp->rB = point - bodyB->m_sweep.c;
+
+			// The anchors are fixed to the bodies, so the separation at any
+			// time follows from how far they moved. The island has stored the
+			// centers at the start of the step in m_sweep.c0.
+			sp->localAnchorA = b2MulT(bodyA->m_xf.R, ccp->rA);
+			sp->localAnchorB = b2MulT(bodyB->m_xf.R, ccp->rB);
+			sp->adjustedSeparation = separation - b2Dot(ccp->rB - ccp->rA, cc->normal);
+			sp->maxNormalImpulse = 0.0f;
+
+			float32 rnA = b2Cross(ccp->rA, cc->normal);
+			float32 rnB = b2Cross(ccp->rB, cc->normal);
+			float32 kNormal = invMassA + invMassB + invIA * rnA * rnA + invIB * rnB * rnB;
+
+			b2Assert(kNormal > b2_epsilon);
+			ccp->normalMass = 1.0f / kNormal;
+
+			b2Vec2 tangent = b2Cross(cc->normal, 1.0f);
+			float32 rtA = b2Cross(ccp->rA, tangent);
+			float32 rtB = b2Cross(ccp->rB, tangent);
+			float32 kTangent = invMassA + invMassB + invIA * rtA * rtA + invIB * rtB * rtB;
+
+			b2Assert(kTangent > b2_epsilon);
+			ccp->tangentMass = 1.0f / kTangent;
+
+			// The velocity to restore after the sub-steps, for restitution.
+			ccp->velocityBias = 0.0f;
+			float32 vRel = b2Dot(cc->normal, vB + b2Cross(wB, ccp->rB) - vA - b2Cross(wA, ccp->rA));
+			if (vRel < -b2_velocityThreshold)
+			{
+				ccp->velocityBias = -restitution * vRel;
+			}
+		}
+
+		// If we have two points, then prepare the block solver, as in
+		// b2ContactSolver. A zero K means the points are solved one by one.
+		cc->K.SetZero();
+		if (cc->pointCount == 2)
+		{
+			b2ContactConstraintPoint* ccp1 = cc->points + 0;
+			b2ContactConstraintPoint* ccp2 = cc->points + 1;
+
+			float32 rn1A = b2Cross(ccp1->rA, cc->normal);
+			float32 rn1B = b2Cross(ccp1->rB, cc->normal);
+			float32 rn2A = b2Cross(ccp2->rA, cc->normal);
+			float32 rn2B = b2Cross(ccp2->rB, cc->normal);
+
+			float32 k11 = invMassA + invMassB + invIA * rn1A * rn1A + invIB * rn1B * rn1B;
+			float32 k22 = invMassA + invMassB + invIA * rn2A * rn2A + invIB * rn2B * rn2B;
+			float32 k12 = invMassA + invMassB + invIA * rn1A * rn2A + invIB * rn1B * rn2B;
+
+			// Ensure a reasonable condition number.
+			const float32 k_maxConditionNumber = 100.0f;
+			if (k11 * k11 < k_maxConditionNumber * (k11 * k22 - k12 * k12))
+			{
+				cc->K.col1.Set(k11, k12);
+				cc->K.col2.Set(k12, k22);
+				cc->normalMass = cc->K.GetInverse();
+			}
+		}
+	}
+}
+
+b2SoftContactSolver::~b2SoftContactSolver()
+{
+	m_allocator->Free(m_points);
+	m_allocator->Free(m_constraints);
+}
+
+void b2SoftContactSolver::WarmStart()
+{
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		b2ContactConstraint* c = m_constraints + i;
+
+		b2Body* bodyA = c->bodyA;
+		b2Body* bodyB = c->bodyB;
+		float32 invMassA = bodyA->m_invMass;
+		float32 invIA = bodyA->m_invI;
+		float32 invMassB = bodyB->m_invMass;
+		float32 invIB = bodyB->m_invI;
+		b2Vec2 normal = c->normal;
+		b2Vec2 tangent = b2Cross(normal, 1.0f);
+
+		for (int32 j = 0; j < c->pointCount; ++j)
+		{
+			b2ContactConstraintPoint* ccp = c->points + j;
+			b2Vec2 P = ccp->normalImpulse * normal + ccp->tangentImpulse * tangent;
+			bodyA->m_angularVelocity -= invIA * b2Cross(ccp->rA, P);
+			bodyA->m_linearVelocity -= invMassA * P;
+			bodyB->m_angularVelocity += invIB * b2Cross(ccp->rB, P);
+			bodyB->m_linearVelocity += invMassB * P;
+		}
+	}
+}
+
+void b2SoftContactSolver::SolveVelocityConstraints(bool useBias)
+{
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		b2ContactConstraint* c = m_constraints + i;
+		b2SoftContactPoint* points = m_points + i * b2_maxManifoldPoints;
+		b2Body* bodyA = c->bodyA;
+		b2Body* bodyB = c->bodyB;
+		float32 wA = bodyA->m_angularVelocity;
+		float32 wB = bodyB->m_angularVelocity;
+		b2Vec2 vA = bodyA->m_linearVelocity;
+		b2Vec2 vB = bodyB->m_linearVelocity;
+		float32 invMassA = bodyA->m_invMass;
+		float32 invIA = bodyA->m_invI;
+		float32 invMassB = bodyB->m_invMass;
+		float32 invIB = bodyB->m_invI;
+		b2Vec2 normal = c->normal;
+		b2Vec2 tangent = b2Cross(normal, 1.0f);
+		float32 friction = c->friction;
+
+		bool isStatic = bodyA->GetType() == b2_staticBody || bodyB->GetType() == b2_staticBody;
+		const b2Softness& softness = isStatic ? m_staticSoftness : m_softness;
+
+		float32 bias[b2_maxManifoldPoints];
+		float32 massScale[b2_maxManifoldPoints];
+		float32 impulseScale[b2_maxManifoldPoints];
+		for (int32 j = 0; j < c->pointCount; ++j)
+		{
+			b2SoftContactPoint* sp = points + j;
+
+			// Current separation, from the anchors moved with the bodies.
+			b2Vec2 dA = bodyA->m_sweep.c - bodyA->m_sweep.c0 + b2Mul(bodyA->m_xf.R, sp->localAnchorA);
+			b2Vec2 dB = bodyB->m_sweep.c - bodyB->m_sweep.c0 + b2Mul(bodyB->m_xf.R, sp->localAnchorB);
+			float32 separation = b2Dot(dB - dA, normal) + sp->adjustedSeparation;
+
+			bias[j] = 0.0f;
+			massScale[j] = 1.0f;
+			impulseScale[j] = 0.0f;
+			if (separation > 0.0f)
+			{
+				// Speculative, only stop the gap from closing.
+				bias[j] = separation * m_inv_h;
+			}
+			else if (useBias)
+			{
+				// Push out of the overlap beyond the slop, softly.
+				float32 C = b2Min(separation + b2_linearSlop, 0.0f);
+				bias[j] = b2Max(softness.biasRate * C, -b2_contactPushVelocity);
+				massScale[j] = softness.massScale;
+				impulseScale[j] = softness.impulseScale;
+			}
+		}
+
+		// Solve normal constraints. Two points in the same state are solved
+		// together if neither impulse gets clamped, otherwise the first point
+		// would take all of an impact and start the body rocking.
+		bool solved = false;
+		if (c->pointCount == 2 && c->K.col1.x > 0.0f && massScale[0] == massScale[1])
+		{
+			b2ContactConstraintPoint* cp1 = c->points + 0;
+			b2ContactConstraintPoint* cp2 = c->points + 1;
+
+			b2Vec2 dv1 = vB + b2Cross(wB, cp1->rB) - vA - b2Cross(wA, cp1->rA);
+			b2Vec2 dv2 = vB + b2Cross(wB, cp2->rB) - vA - b2Cross(wA, cp2->rA);
+
+			b2Vec2 a(cp1->normalImpulse, cp2->normalImpulse);
+			b2Vec2 b(b2Dot(dv1, normal) + bias[0], b2Dot(dv2, normal) + bias[1]);
+			b2Vec2 x = (1.0f - impulseScale[0]) * a - massScale[0] * b2Mul(c->normalMass, b);
+
+			if (x.x >= 0.0f && x.y >= 0.0f)
+			{
+				b2Vec2 d = x - a;
+				b2Vec2 P1 = d.x * normal;
+				b2Vec2 P2 = d.y * normal;
+				vA -= invMassA * (P1 + P2);
+				wA -= invIA * (b2Cross(cp1->rA, P1) + b2Cross(cp2->rA, P2));
+
+				vB += invMassB * (P1 + P2);
+				wB += invIB * (b2Cross(cp1->rB, P1) + b2Cross(cp2->rB, P2));
+
+				cp1->normalImpulse = x.x;
+				cp2->normalImpulse = x.y;
+				points[0].maxNormalImpulse = b2Max(points[0].maxNormalImpulse, x.x);
+				points[1].maxNormalImpulse = b2Max(points[1].maxNormalImpulse, x.y);
+				solved = true;
+			}
+		}
+
+		for (int32 j = 0; j < c->pointCount && solved == false; ++j)
+		{
+			b2ContactConstraintPoint* ccp = c->points + j;
+			b2SoftContactPoint* sp = points + j;
+
+			// Relative velocity at contact
+			b2Vec2 dv = vB + b2Cross(wB, ccp->rB) - vA - b2Cross(wA, ccp->rA);
+
+			// Compute normal impulse
+			float32 vn = b2Dot(dv, normal);
+			float32 lambda = -ccp->normalMass * massScale[j] * (vn + bias[j]) - impulseScale[j] * ccp->normalImpulse;
+
+			// b2Clamp the accumulated impulse
+			float32 newImpulse = b2Max(ccp->normalImpulse + lambda, 0.0f);
+			lambda = newImpulse - ccp->normalImpulse;
+			ccp->normalImpulse = newImpulse;
+			sp->maxNormalImpulse = b2Max(sp->maxNormalImpulse, newImpulse);
+
+			// Apply contact impulse
+			b2Vec2 P = lambda * normal;
+			vA -= invMassA * P;
+			wA -= invIA * b2Cross(ccp->rA, P);
+
+			vB += invMassB * P;
+			wB += invIB * b2Cross(ccp->rB, P);
+		}
+
+		// Solve tangent constraints
+		for (int32 j = 0; j < c->pointCount; ++j)
+		{
+			b2ContactConstraintPoint* ccp = c->points + j;
+
+			// Relative velocity at contact
+			b2Vec2 dv = vB + b2Cross(wB, ccp->rB) - vA - b2Cross(wA, ccp->rA);
+
+			// Compute tangent force
+			float32 vt = b2Dot(dv, tangent);
+			float32 lambda = ccp->tangentMass * (-vt);
+
+			// b2Clamp the accumulated force
+			float32 maxFriction = friction * ccp->normalImpulse;
+			float32 newImpulse = b2Clamp(ccp->tangentImpulse + lambda, -maxFriction, maxFriction);
+			lambda = newImpulse - ccp->tangentImpulse;
+			ccp->tangentImpulse = newImpulse;
+
+			// Apply contact impulse
+			b2Vec2 P = lambda * tangent;
+
+			vA -= invMassA * P;
+			wA -= invIA * b2Cross(ccp->rA, P);
+
+			vB += invMassB * P;
+			wB += invIB * b2Cross(ccp->rB, P);
+		}
+
+		bodyA->m_linearVelocity = vA;
+		bodyA->m_angularVelocity = wA;
+		bodyB->m_linearVelocity = vB;
+		bodyB->m_angularVelocity = wB;
+	}
+}
+
+void b2SoftContactSolver::ApplyRestitution()
+{
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		b2ContactConstraint* c = m_constraints + i;
+		b2SoftContactPoint* points = m_points + i * b2_maxManifoldPoints;
+		b2Body* bodyA = c->bodyA;
+		b2Body* bodyB = c->bodyB;
+		float32 wA = bodyA->m_angularVelocity;
+		float32 wB = bodyB->m_angularVelocity;
+		b2Vec2 vA = bodyA->m_linearVelocity;
+		b2Vec2 vB = bodyB->m_linearVelocity;
+		float32 invMassA = bodyA->m_invMass;
+		float32 invIA = bodyA->m_invI;
+		float32 invMassB = bodyB->m_invMass;
+		float32 invIB = bodyB->m_invI;
+		b2Vec2 normal = c->normal;
+
+		for (int32 j = 0; j < c->pointCount; ++j)
+		{
+			b2ContactConstraintPoint* ccp = c->points + j;
+
+			// Only points that were hit hard enough and pushed bounce.
+			if (ccp->velocityBias == 0.0f || points[j].maxNormalImpulse == 0.0f)
+			{
+				continue;
+			}
+
+			b2Vec2 dv = vB + b2Cross(wB, ccp->rB) - vA - b2Cross(wA, ccp->rA);
+			float32 vn = b2Dot(dv, normal);
+			float32 lambda = -ccp->normalMass * (vn - ccp->velocityBias);
+
+			float32 newImpulse = b2Max(ccp->normalImpulse + lambda, 0.0f);
+			lambda = newImpulse - ccp->normalImpulse;
+			ccp->normalImpulse = newImpulse;
+
+			b2Vec2 P = lambda * normal;
+			vA -= invMassA * P;
+			wA -= invIA * b2Cross(ccp->rA, P);
+
+			vB += invMassB * P;
+			wB += invIB * b2Cross(ccp->rB, P);
+		}
+
+		bodyA->m_linearVelocity = vA;
+		bodyA->m_angularVelocity = wA;
+		bodyB->m_linearVelocity = vB;
+		bodyB->m_angularVelocity = wB;
+	}
+}
+
+void b2SoftContactSolver::StoreImpulses()
+{
+	// Back to the impulses of the time step, which is what the manifolds and
+	// the contact listener get from b2ContactSolver too.
+	float32 ratio = float32(m_subStepCount);
+
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		b2ContactConstraint* c = m_constraints + i;
+		b2Manifold* m = c->manifold;
+
+		for (int32 j = 0; j < c->pointCount; ++j)
+		{
+			c->points[j].normalImpulse *= ratio;
+			c->points[j].tangentImpulse *= ratio;
+			m->points[j].normalImpulse = c->points[j].normalImpulse;
+			m->points[j].tangentImpulse = c->points[j].tangentImpulse;
+		}
+	}
+}
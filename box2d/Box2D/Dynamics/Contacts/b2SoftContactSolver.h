@@ -0,0 +1,85 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SOFT_CONTACT_SOLVER_H
+#define B2_SOFT_CONTACT_SOLVER_H
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
+
+class b2Contact;
+class b2StackAllocator;
+struct b2ContactConstraint;
+struct b2SoftContactPoint;
+
+/// The coefficients of a soft constraint, a spring and damper of the given
+/// stiffness solved implicitly over a sub-step.
+struct b2Softness
+{
+	void Initialize(float32 hertz, float32 dampingRatio, float32 h);
+
+	float32 biasRate;
+	float32 massScale;
+	float32 impulseScale;
+};
+
+/// This is an internal class. It solves contacts in sub-steps of the time step,
+/// the alternative to b2ContactSolver used when b2World::SetSubStepping is on.
+///
+/// The contact normal, the anchors and the effective masses are computed once
+/// per time step. Each sub-step the separation is updated from the motion of
+/// the bodies since then, and overlap is pushed out by a soft constraint: a
+/// stiff, heavily damped spring instead of a position correction. After the
+/// positions of a sub-step are integrated the velocities are relaxed, solving
+/// the contacts again without the push, so the push doesn't show up as bounce.
+/// Restitution is applied once at the end of the time step.
+///
+/// Deep stacks stay upright with a few sub-steps where b2ContactSolver needs
+/// many iterations, since each sub-step sees the separation of the previous
+/// one. Accumulated impulses are stored to the manifolds per time step, like
+/// b2ContactSolver does, so warm starting carries over between the solvers.
+class b2SoftContactSolver
+{
+public:
+	/// The impulse ratio is that of the time steps, subStep is one sub-step.
+	b2SoftContactSolver(const b2TimeStep& subStep, int32 subStepCount,
+						b2Contact** contacts, int32 contactCount,
+						b2StackAllocator* allocator, float32 impulseRatio);
+
+	~b2SoftContactSolver();
+
+	void WarmStart();
+
+	/// Solve with the soft push out of overlap, or without it to relax.
+	void SolveVelocityConstraints(bool useBias);
+
+	void ApplyRestitution();
+	void StoreImpulses();
+
+	b2StackAllocator* m_allocator;
+	b2ContactConstraint* m_constraints;
+	b2SoftContactPoint* m_points;
+	int32 m_constraintCount;
+
+	float32 m_inv_h;
+	int32 m_subStepCount;
+	b2Softness m_softness;			// between movable bodies
+	b2Softness m_staticSoftness;	// with a static body, stiffer
+};
+
+#endif
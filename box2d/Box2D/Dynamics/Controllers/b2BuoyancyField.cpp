@@ -0,0 +1,224 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Controllers/b2BuoyancyField.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Common/b2StackAllocator.h>
+
+// The area of a circle where b2Dot(normal, p) < offset, and its centroid.
+static float32 b2ComputeSubmergedArea(const b2CircleShape* circle, const b2Transform& xf,
+									  const b2Vec2& normal, float32 offset, b2Vec2* centroid)
+{
+	b2Vec2 c = b2Mul(xf, circle->m_p);
+	float32 r = circle->m_radius;
+	float32 depth = offset - b2Dot(normal, c);
+
+	if (depth <= -r)
+	{
+		return 0.0f;
+	}
+
+	float32 area = b2_pi * r * r;
+	*centroid = c;
+	if (depth >= r)
+	{
+		return area;
+	}
+
+	// The cap above the surface is cut off, the centroid moves away from it.
+	float32 h2 = r * r - depth * depth;
+	float32 h = b2Sqrt(h2);
+	float32 capArea = r * r * acosf(depth / r) - depth * h;
+	float32 capMoment = (2.0f / 3.0f) * h2 * h;
+	area -= capArea;
+	*centroid = c - (capMoment / area) * normal;
+	return area;
+}
+
+// The area of a polygon where b2Dot(normal, p) < offset, and its centroid.
+static float32 b2ComputeSubmergedArea(const b2PolygonShape* polygon, const b2Transform& xf,
+									  const b2Vec2& normal, float32 offset, b2Vec2* centroid)
+{
+	// Clip the polygon with the surface.
+	b2Vec2 vertices[b2_maxPolygonVertices + 1];
+	int32 count = 0;
+
+	int32 vertexCount = polygon->m_vertexCount;
+	b2Vec2 v1 = b2Mul(xf, polygon->m_vertices[vertexCount - 1]);
+	float32 d1 = offset - b2Dot(normal, v1);
+	for (int32 i = 0; i < vertexCount; ++i)
+	{
+		b2Vec2 v2 = b2Mul(xf, polygon->m_vertices[i]);
+		float32 d2 = offset - b2Dot(normal, v2);
+
+		if ((d1 > 0.0f) != (d2 > 0.0f))
+		{
+			vertices[count++] = v1 + (d1 / (d1 - d2)) * (v2 - v1);
+		}
+
+		if (d2 > 0.0f)
+		{
+			vertices[count++] = v2;
+		}
+
+		v1 = v2;
+		d1 = d2;
+	}
+
+	if (count < 3)
+	{
+		return 0.0f;
+	}
+
+	// Triangle fan, as in b2PolygonShape::ComputeMass.
+	float32 area = 0.0f;
+	b2Vec2 c(0.0f, 0.0f);
+	b2Vec2 p1 = vertices[0];
+	for (int32 i = 1; i < count - 1; ++i)
+	{
+		b2Vec2 e1 = vertices[i] - p1;
+		b2Vec2 e2 = vertices[i + 1] - p1;
+		float32 triangleArea = 0.5f * b2Cross(e1, e2);
+		area += triangleArea;
+		c += triangleArea * (1.0f / 3.0f) * (e1 + e2);
+	}
+
+	if (area <= b2_epsilon)
+	{
+		return 0.0f;
+	}
+
+	*centroid = p1 + (1.0f / area) * c;
+	return area;
+}
+
+b2BuoyancyField::b2BuoyancyField(const b2BuoyancyFieldDef* def)
+: b2Controller(def)
+{
+	m_normal = def->normal;
+	m_normal.Normalize();
+	m_offset = def->offset;
+	m_density = def->density;
+	m_linearDrag = def->linearDrag;
+	m_angularDrag = def->angularDrag;
+	m_velocity = def->velocity;
+}
+
+void b2BuoyancyField::Apply(const b2ControllerBatch& batch)
+{
+	int32 count = batch.count;
+	b2StackAllocator* allocator = batch.allocator;
+	float32* areas = (float32*)allocator->Allocate(3 * count * sizeof(float32));
+	float32* cx = areas + count;
+	float32* cy = cx + count;
+
+	// The surface in world coordinates.
+	b2Transform xf = GetTransform();
+	b2Vec2 normal = b2Mul(xf.R, m_normal);
+	float32 offset = m_offset + b2Dot(normal, xf.position);
+
+	// Find the submerged area of each body and its centroid.
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* body = batch.bodies[i];
+		const b2Transform& bodyXf = body->GetTransform();
+
+		float32 area = 0.0f;
+		b2Vec2 moment(0.0f, 0.0f);
+		for (b2Fixture* f = body->GetFixtureList(); f; f = f->GetNext())
+		{
+			if ((f->GetFilterData().categoryBits & m_maskBits) == 0)
+			{
+				continue;
+			}
+
+			float32 fixtureArea = 0.0f;
+			b2Vec2 centroid;
+			switch (f->GetType())
+			{
+			case b2Shape::e_circle:
+				fixtureArea = b2ComputeSubmergedArea((const b2CircleShape*)f->GetShape(), bodyXf, normal, offset, &centroid);
+				break;
+
+			case b2Shape::e_polygon:
+				fixtureArea = b2ComputeSubmergedArea((const b2PolygonShape*)f->GetShape(), bodyXf, normal, offset, &centroid);
+				break;
+
+			default:
+				break;
+			}
+
+			if (fixtureArea > 0.0f)
+			{
+				area += fixtureArea;
+				moment += fixtureArea * centroid;
+			}
+		}
+
+		areas[i] = area;
+		if (area > 0.0f)
+		{
+			b2Vec2 centroid = b2MulT(xf, (1.0f / area) * moment);
+			cx[i] = centroid.x;
+			cy[i] = centroid.y;
+		}
+		else
+		{
+			cx[i] = batch.px[i];
+			cy[i] = batch.py[i];
+		}
+	}
+
+	// Buoyancy and drag at the centroids.
+	b2Vec2 gravity = b2MulT(xf.R, m_world->GetGravity());
+	const float32 gx = -m_density * gravity.x, gy = -m_density * gravity.y;
+	const float32 ux = m_velocity.x, uy = m_velocity.y;
+	const float32 linearDrag = m_linearDrag;
+	const float32 angularDrag = m_angularDrag;
+
+	const float32* px = batch.px;
+	const float32* py = batch.py;
+	const float32* vx = batch.vx;
+	const float32* vy = batch.vy;
+	const float32* w = batch.w;
+	const float32* mass = batch.mass;
+	const float32* inertia = batch.inertia;
+	float32* fx = batch.fx;
+	float32* fy = batch.fy;
+	float32* torque = batch.torque;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		float32 area = areas[i];
+		float32 rx = cx[i] - px[i];
+		float32 ry = cy[i] - py[i];
+		float32 dvx = vx[i] - w[i] * ry - ux;
+		float32 dvy = vy[i] + w[i] * rx - uy;
+		float32 forceX = area * (gx - linearDrag * dvx);
+		float32 forceY = area * (gy - linearDrag * dvy);
+		fx[i] = forceX;
+		fy[i] = forceY;
+		torque[i] = rx * forceY - ry * forceX - angularDrag * area * w[i] * inertia[i] / mass[i];
+	}
+
+	allocator->Free(areas);
+}
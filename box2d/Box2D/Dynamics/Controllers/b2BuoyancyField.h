@@ -0,0 +1,153 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_BUOYANCY_FIELD_H
+#define B2_BUOYANCY_FIELD_H
+
+#include <Box2D/Dynamics/Controllers/b2Controller.h>
+
+/// Buoyancy field definition. The area should cover the fluid, the field
+/// only finds the bodies that overlap it.
+struct b2BuoyancyFieldDef : public b2ControllerDef
+{
+	b2BuoyancyFieldDef()
+	{
+		type = e_buoyancyField;
+		normal.Set(0.0f, 1.0f);
+		offset = 0.0f;
+		density = 1.0f;
+		linearDrag = 2.0f;
+		angularDrag = 1.0f;
+		velocity.SetZero();
+	}
+
+	/// The normal of the surface of the fluid, pointing out of the fluid.
+	b2Vec2 normal;
+
+	/// The position of the surface along the normal. The fluid is where
+	/// b2Dot(normal, p) < offset.
+	float32 offset;
+
+	/// The density of the fluid, in the units of the fixture densities.
+	float32 density;
+
+	/// The drag of the fluid on the submerged area when moving through it.
+	float32 linearDrag;
+
+	/// The drag of the fluid on the submerged area when turning in it.
+	float32 angularDrag;
+
+	/// The velocity of the current.
+	b2Vec2 velocity;
+};
+
+/// A buoyancy field makes bodies float in a fluid. The submerged area of
+/// each circle and polygon is computed and the buoyancy, against the world
+/// gravity, and the drag of the fluid are applied at its centroid.
+class b2BuoyancyField : public b2Controller
+{
+public:
+
+	/// Set the surface of the fluid.
+	void SetSurface(const b2Vec2& normal, float32 offset);
+	const b2Vec2& GetNormal() const;
+	float32 GetOffset() const;
+
+	/// Set/get the density of the fluid.
+	void SetDensity(float32 density);
+	float32 GetDensity() const;
+
+	/// Set/get the drag of the fluid.
+	void SetDrag(float32 linearDrag, float32 angularDrag);
+	float32 GetLinearDrag() const;
+	float32 GetAngularDrag() const;
+
+	/// Set/get the velocity of the current.
+	void SetVelocity(const b2Vec2& velocity);
+	const b2Vec2& GetVelocity() const;
+
+protected:
+
+	friend class b2Controller;
+
+	b2BuoyancyField(const b2BuoyancyFieldDef* def);
+
+	void Apply(const b2ControllerBatch& batch);
+
+	b2Vec2 m_normal;
+	float32 m_offset;
+	float32 m_density;
+	float32 m_linearDrag;
+	float32 m_angularDrag;
+	b2Vec2 m_velocity;
+};
+
+inline void b2BuoyancyField::SetSurface(const b2Vec2& normal, float32 offset)
+{
+	m_normal = normal;
+	m_normal.Normalize();
+	m_offset = offset;
+}
+
+inline const b2Vec2& b2BuoyancyField::GetNormal() const
+{
+	return m_normal;
+}
+
+inline float32 b2BuoyancyField::GetOffset() const
+{
+	return m_offset;
+}
+
+inline void b2BuoyancyField::SetDensity(float32 density)
+{
+	m_density = density;
+}
+
+inline float32 b2BuoyancyField::GetDensity() const
+{
+	return m_density;
+}
+
+inline void b2BuoyancyField::SetDrag(float32 linearDrag, float32 angularDrag)
+{
+	m_linearDrag = linearDrag;
+	m_angularDrag = angularDrag;
+}
+
+inline float32 b2BuoyancyField::GetLinearDrag() const
+{
+	return m_linearDrag;
+}
+
+inline float32 b2BuoyancyField::GetAngularDrag() const
+{
+	return m_angularDrag;
+}
+
+inline void b2BuoyancyField::SetVelocity(const b2Vec2& velocity)
+{
+	m_velocity = velocity;
+}
+
+inline const b2Vec2& b2BuoyancyField::GetVelocity() const
+{
+	return m_velocity;
+}
+
+#endif
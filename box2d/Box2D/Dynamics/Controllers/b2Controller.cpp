@@ -0,0 +1,290 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Controllers/b2Controller.h>
+#include <Box2D/Dynamics/Controllers/b2BuoyancyField.h>
+#include <Box2D/Dynamics/Controllers/b2DirectionalField.h>
+#include <Box2D/Dynamics/Controllers/b2RadialField.h>
+#include <Box2D/Dynamics/Controllers/b2VortexField.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2StackAllocator.h>
+
+#include <new>
+
+struct b2ControllerQueryWrapper
+{
+	bool QueryCallback(int32 proxyId)
+	{
+		return controller->QueryCallback(proxyId);
+	}
+
+	b2Controller* controller;
+};
+
+b2Controller* b2Controller::Create(const b2ControllerDef* def, b2BlockAllocator* allocator)
+{
+	b2Controller* controller = NULL;
+
+	switch (def->type)
+	{
+	case e_radialField:
+		{
+			void* mem = allocator->Allocate(sizeof(b2RadialField));
+			controller = new (mem) b2RadialField((b2RadialFieldDef*)def);
+		}
+		break;
+
+	case e_directionalField:
+		{
+			void* mem = allocator->Allocate(sizeof(b2DirectionalField));
+			controller = new (mem) b2DirectionalField((b2DirectionalFieldDef*)def);
+		}
+		break;
+
+	case e_buoyancyField:
+		{
+			void* mem = allocator->Allocate(sizeof(b2BuoyancyField));
+			controller = new (mem) b2BuoyancyField((b2BuoyancyFieldDef*)def);
+		}
+		break;
+
+	case e_vortexField:
+		{
+			void* mem = allocator->Allocate(sizeof(b2VortexField));
+			controller = new (mem) b2VortexField((b2VortexFieldDef*)def);
+		}
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+
+	return controller;
+}
+
+void b2Controller::Destroy(b2Controller* controller, b2BlockAllocator* allocator)
+{
+	controller->~b2Controller();
+	switch (controller->m_type)
+	{
+	case e_radialField:
+		allocator->Free(controller, sizeof(b2RadialField));
+		break;
+
+	case e_directionalField:
+		allocator->Free(controller, sizeof(b2DirectionalField));
+		break;
+
+	case e_buoyancyField:
+		allocator->Free(controller, sizeof(b2BuoyancyField));
+		break;
+
+	case e_vortexField:
+		allocator->Free(controller, sizeof(b2VortexField));
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+}
+
+b2Controller::b2Controller(const b2ControllerDef* def)
+{
+	m_type = def->type;
+	m_prev = NULL;
+	m_next = NULL;
+	m_world = NULL;
+	m_body = def->body;
+
+	m_area = def->area;
+	m_maskBits = def->maskBits;
+
+	m_bodyCount = 0;
+
+	m_found = NULL;
+	m_foundCount = 0;
+	m_wake = false;
+
+	m_origin.SetZero();
+
+	m_userData = def->userData;
+}
+
+b2Transform b2Controller::GetTransform() const
+{
+	if (m_body)
+	{
+		return m_body->GetTransform();
+	}
+
+	b2Transform xf;
+	xf.position = m_origin;
+	xf.R.SetIdentity();
+	return xf;
+}
+
+int32 b2Controller::FindBodies(b2Body** bodies, bool wake)
+{
+	// The bounding box of the area in world coordinates.
+	b2Transform xf = GetTransform();
+	b2Vec2 center = b2Mul(xf, 0.5f * (m_area.lowerBound + m_area.upperBound));
+	b2Vec2 extents = b2Mul(b2Abs(xf.R), 0.5f * (m_area.upperBound - m_area.lowerBound));
+	m_worldArea.lowerBound = center - extents;
+	m_worldArea.upperBound = center + extents;
+
+	m_found = bodies;
+	m_foundCount = 0;
+	m_wake = wake;
+
+	b2ControllerQueryWrapper wrapper;
+	wrapper.controller = this;
+	m_world->m_contactManager.m_broadPhase.Query(&wrapper, m_worldArea);
+
+	m_found = NULL;
+	return m_foundCount;
+}
+
+bool b2Controller::QueryCallback(int32 proxyId)
+{
+	b2Fixture* fixture = (b2Fixture*)m_world->m_contactManager.m_broadPhase.GetUserData(proxyId);
+	b2Body* body = fixture->GetBody();
+
+	if ((body->m_flags & b2Body::e_controllerFlag) || body == m_body || body->GetType() != b2_dynamicBody)
+	{
+		return true;
+	}
+
+	if ((fixture->GetFilterData().categoryBits & m_maskBits) == 0)
+	{
+		return true;
+	}
+
+	// The proxy is fattened, the fixture has to overlap the area itself.
+	if (b2TestOverlap(fixture->GetAABB(), m_worldArea) == false)
+	{
+		return true;
+	}
+
+	if (body->IsAwake() == false)
+	{
+		if (m_wake == false)
+		{
+			return true;
+		}
+
+		body->SetAwake(true);
+	}
+
+	body->m_flags |= b2Body::e_controllerFlag;
+	m_found[m_foundCount++] = body;
+	return true;
+}
+
+void b2Controller::WakeBodies()
+{
+	if (m_world->m_bodyCount == 0)
+	{
+		return;
+	}
+
+	b2StackAllocator* allocator = &m_world->m_stackAllocator;
+	b2Body** bodies = (b2Body**)allocator->Allocate(m_world->m_bodyCount * sizeof(b2Body*));
+
+	int32 count = FindBodies(bodies, true);
+	for (int32 i = 0; i < count; ++i)
+	{
+		bodies[i]->m_flags &= ~b2Body::e_controllerFlag;
+	}
+
+	allocator->Free(bodies);
+}
+
+void b2Controller::Step(const b2TimeStep& step)
+{
+	m_bodyCount = 0;
+	if (m_world->m_bodyCount == 0)
+	{
+		return;
+	}
+
+	b2StackAllocator* allocator = &m_world->m_stackAllocator;
+	b2Body** bodies = (b2Body**)allocator->Allocate(m_world->m_bodyCount * sizeof(b2Body*));
+
+	int32 count = FindBodies(bodies, false);
+	m_bodyCount = count;
+	if (count == 0)
+	{
+		allocator->Free(bodies);
+		return;
+	}
+
+	b2ControllerBatch batch;
+	float32* data = (float32*)allocator->Allocate(10 * count * sizeof(float32));
+	batch.count = count;
+	batch.bodies = bodies;
+	batch.px = data;
+	batch.py = batch.px + count;
+	batch.vx = batch.py + count;
+	batch.vy = batch.vx + count;
+	batch.w = batch.vy + count;
+	batch.mass = batch.w + count;
+	batch.inertia = batch.mass + count;
+	batch.fx = batch.inertia + count;
+	batch.fy = batch.fx + count;
+	batch.torque = batch.fy + count;
+	batch.allocator = allocator;
+
+	b2Transform xf = GetTransform();
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* b = bodies[i];
+		b->m_flags &= ~b2Body::e_controllerFlag;
+
+		b2Vec2 p = b2MulT(xf, b->m_sweep.c);
+		b2Vec2 v = b2MulT(xf.R, b->m_linearVelocity);
+		batch.px[i] = p.x;
+		batch.py[i] = p.y;
+		batch.vx[i] = v.x;
+		batch.vy[i] = v.y;
+		batch.w[i] = b->m_angularVelocity;
+		batch.mass[i] = b->m_mass;
+		batch.inertia[i] = b->m_I;
+		batch.fx[i] = 0.0f;
+		batch.fy[i] = 0.0f;
+		batch.torque[i] = 0.0f;
+	}
+
+	Apply(batch);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* b = bodies[i];
+		b2Vec2 f = b2Mul(xf.R, b2Vec2(batch.fx[i], batch.fy[i]));
+		b->m_linearVelocity += step.dt * b->m_invMass * f;
+		b->m_angularVelocity += step.dt * b->m_invI * batch.torque[i];
+	}
+
+	allocator->Free(data);
+	allocator->Free(bodies);
+}
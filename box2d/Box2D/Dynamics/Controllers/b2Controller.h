@@ -0,0 +1,233 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_CONTROLLER_H
+#define B2_CONTROLLER_H
+
+#include <Box2D/Collision/b2Collision.h>
+
+class b2Body;
+class b2BlockAllocator;
+class b2StackAllocator;
+class b2World;
+struct b2TimeStep;
+
+enum b2ControllerType
+{
+	e_unknownController,
+	e_radialField,
+	e_directionalField,
+	e_buoyancyField,
+	e_vortexField,
+};
+
+/// Controller definitions are used to construct controllers.
+struct b2ControllerDef
+{
+	b2ControllerDef()
+	{
+		type = e_unknownController;
+		userData = NULL;
+		body = NULL;
+		area.lowerBound.Set(-1.0f, -1.0f);
+		area.upperBound.Set(1.0f, 1.0f);
+		maskBits = 0xFFFF;
+	}
+
+	/// The controller type is set automatically for concrete controller types.
+	b2ControllerType type;
+
+	/// Use this to attach application specific data to your controllers.
+	void* userData;
+
+	/// The body the controller moves with, or NULL. The area and the other
+	/// points and directions of the controller are in the coordinates of this
+	/// body, or in world coordinates without a body. The body is not affected
+	/// by its own controllers.
+	b2Body* body;
+
+	/// Bodies are affected when one of their fixtures overlaps this box.
+	b2AABB area;
+
+	/// The categories of the fixtures that are affected, see b2Filter.
+	uint16 maskBits;
+};
+
+/// The bodies affected by a controller during a time step, gathered in arrays
+/// so the forces of a field are computed by plain loops over them. Positions
+/// are the centers of mass and, like the velocities and the forces, they are
+/// in the coordinates of the controller.
+struct b2ControllerBatch
+{
+	int32 count;
+	b2Body** bodies;
+	float32* px;
+	float32* py;
+	float32* vx;
+	float32* vy;
+	float32* w;
+	float32* mass;
+	float32* inertia;	///< about the center of mass
+
+	// Outputs, zeroed before b2Controller::Apply.
+	float32* fx;
+	float32* fy;
+	float32* torque;
+
+	/// For the temporary arrays of Apply.
+	b2StackAllocator* allocator;
+};
+
+/// The base controller class. A controller applies forces to the awake dynamic
+/// bodies in its area once per time step, after the contacts are updated and
+/// before the velocities are integrated. The bodies are found with a query of
+/// the broad-phase. Like gravity the forces are not added to the body forces,
+/// they change the velocities of the time step they are computed for.
+/// Sleeping bodies are not woken up, except by the creation of a controller.
+class b2Controller
+{
+public:
+
+	/// Get the type of the concrete controller.
+	b2ControllerType GetType() const;
+
+	/// Get the body the controller moves with, or NULL.
+	b2Body* GetBody();
+
+	/// Set/get the area where bodies are affected.
+	void SetArea(const b2AABB& area);
+	const b2AABB& GetArea() const;
+
+	/// Set/get the categories of the fixtures that are affected.
+	void SetMaskBits(uint16 maskBits);
+	uint16 GetMaskBits() const;
+
+	/// Get the number of bodies affected at the last time step.
+	int32 GetBodyCount() const;
+
+	/// Get the next controller in the world controller list.
+	b2Controller* GetNext();
+
+	/// Get the user data pointer.
+	void* GetUserData() const;
+
+	/// Set the user data pointer.
+	void SetUserData(void* data);
+
+protected:
+	friend class b2World;
+	friend struct b2ControllerQueryWrapper;
+
+	static b2Controller* Create(const b2ControllerDef* def, b2BlockAllocator* allocator);
+	static void Destroy(b2Controller* controller, b2BlockAllocator* allocator);
+
+	b2Controller(const b2ControllerDef* def);
+	virtual ~b2Controller() {}
+
+	// Compute the forces on the bodies of the batch.
+	virtual void Apply(const b2ControllerBatch& batch) = 0;
+
+	// Gather the bodies in the area, apply the forces and integrate them into
+	// the velocities.
+	void Step(const b2TimeStep& step);
+
+	// Wake up the bodies in the area.
+	void WakeBodies();
+
+	// Find the bodies in the area and mark them with e_controllerFlag. The
+	// bodies array must hold the number of bodies of the world.
+	int32 FindBodies(b2Body** bodies, bool wake);
+	bool QueryCallback(int32 proxyId);
+
+	// The transform from the coordinates of the controller to the world.
+	b2Transform GetTransform() const;
+
+	b2ControllerType m_type;
+	b2Controller* m_prev;
+	b2Controller* m_next;
+	b2World* m_world;
+	b2Body* m_body;
+
+	b2AABB m_area;
+	uint16 m_maskBits;
+
+	int32 m_bodyCount;
+
+	// Used by FindBodies.
+	b2Body** m_found;
+	int32 m_foundCount;
+	b2AABB m_worldArea;
+	bool m_wake;
+
+	// The origin of the controller when it has no body, moved by b2World::ShiftOrigin.
+	b2Vec2 m_origin;
+
+	void* m_userData;
+};
+
+inline b2ControllerType b2Controller::GetType() const
+{
+	return m_type;
+}
+
+inline b2Body* b2Controller::GetBody()
+{
+	return m_body;
+}
+
+inline void b2Controller::SetArea(const b2AABB& area)
+{
+	m_area = area;
+}
+
+inline const b2AABB& b2Controller::GetArea() const
+{
+	return m_area;
+}
+
+inline void b2Controller::SetMaskBits(uint16 maskBits)
+{
+	m_maskBits = maskBits;
+}
+
+inline uint16 b2Controller::GetMaskBits() const
+{
+	return m_maskBits;
+}
+
+inline int32 b2Controller::GetBodyCount() const
+{
+	return m_bodyCount;
+}
+
+inline b2Controller* b2Controller::GetNext()
+{
+	return m_next;
+}
+
+inline void* b2Controller::GetUserData() const
+{
+	return m_userData;
+}
+
+inline void b2Controller::SetUserData(void* data)
+{
+	m_userData = data;
+}
+
+#endif
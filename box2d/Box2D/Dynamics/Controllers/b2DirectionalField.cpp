@@ -0,0 +1,47 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Controllers/b2DirectionalField.h>
+
+b2DirectionalField::b2DirectionalField(const b2DirectionalFieldDef* def)
+: b2Controller(def)
+{
+	b2Assert(def->drag >= 0.0f);
+	m_acceleration = def->acceleration;
+	m_velocity = def->velocity;
+	m_drag = def->drag;
+}
+
+void b2DirectionalField::Apply(const b2ControllerBatch& batch)
+{
+	const float32 ax = m_acceleration.x + m_drag * m_velocity.x;
+	const float32 ay = m_acceleration.y + m_drag * m_velocity.y;
+	const float32 drag = m_drag;
+
+	const float32* vx = batch.vx;
+	const float32* vy = batch.vy;
+	const float32* mass = batch.mass;
+	float32* fx = batch.fx;
+	float32* fy = batch.fy;
+
+	for (int32 i = 0; i < batch.count; ++i)
+	{
+		fx[i] = mass[i] * (ax - drag * vx[i]);
+		fy[i] = mass[i] * (ay - drag * vy[i]);
+	}
+}
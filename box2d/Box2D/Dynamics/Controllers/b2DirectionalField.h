@@ -0,0 +1,110 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_DIRECTIONAL_FIELD_H
+#define B2_DIRECTIONAL_FIELD_H
+
+#include <Box2D/Dynamics/Controllers/b2Controller.h>
+
+/// Directional field definition.
+struct b2DirectionalFieldDef : public b2ControllerDef
+{
+	b2DirectionalFieldDef()
+	{
+		type = e_directionalField;
+		acceleration.SetZero();
+		velocity.SetZero();
+		drag = 0.0f;
+	}
+
+	/// A constant acceleration.
+	b2Vec2 acceleration;
+
+	/// The velocity of the wind.
+	b2Vec2 velocity;
+
+	/// How fast the bodies are brought to the velocity of the wind, in 1/s.
+	/// This should stay below the inverse of the time step.
+	float32 drag;
+};
+
+/// A directional field applies the same acceleration everywhere in its area,
+/// like a local gravity, and drags the bodies toward the velocity of a wind.
+/// Both are proportional to the mass of the bodies, so bodies of any mass
+/// are accelerated the same way.
+class b2DirectionalField : public b2Controller
+{
+public:
+
+	/// Set/get the acceleration.
+	void SetAcceleration(const b2Vec2& acceleration);
+	const b2Vec2& GetAcceleration() const;
+
+	/// Set/get the velocity of the wind.
+	void SetVelocity(const b2Vec2& velocity);
+	const b2Vec2& GetVelocity() const;
+
+	/// Set/get the drag.
+	void SetDrag(float32 drag);
+	float32 GetDrag() const;
+
+protected:
+
+	friend class b2Controller;
+
+	b2DirectionalField(const b2DirectionalFieldDef* def);
+
+	void Apply(const b2ControllerBatch& batch);
+
+	b2Vec2 m_acceleration;
+	b2Vec2 m_velocity;
+	float32 m_drag;
+};
+
+inline void b2DirectionalField::SetAcceleration(const b2Vec2& acceleration)
+{
+	m_acceleration = acceleration;
+}
+
+inline const b2Vec2& b2DirectionalField::GetAcceleration() const
+{
+	return m_acceleration;
+}
+
+inline void b2DirectionalField::SetVelocity(const b2Vec2& velocity)
+{
+	m_velocity = velocity;
+}
+
+inline const b2Vec2& b2DirectionalField::GetVelocity() const
+{
+	return m_velocity;
+}
+
+inline void b2DirectionalField::SetDrag(float32 drag)
+{
+	b2Assert(drag >= 0.0f);
+	m_drag = drag;
+}
+
+inline float32 b2DirectionalField::GetDrag() const
+{
+	return m_drag;
+}
+
+#endif
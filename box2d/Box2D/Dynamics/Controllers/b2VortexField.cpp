@@ -0,0 +1,61 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Controllers/b2VortexField.h>
+
+void b2VortexFieldDef::Initialize(const b2Vec2& c, float32 r, float32 s)
+{
+	center = c;
+	radius = r;
+	strength = s;
+	area.lowerBound = c - b2Vec2(r, r);
+	area.upperBound = c + b2Vec2(r, r);
+}
+
+b2VortexField::b2VortexField(const b2VortexFieldDef* def)
+: b2Controller(def)
+{
+	b2Assert(def->radius > 0.0f);
+	m_center = def->center;
+	m_radius = def->radius;
+	m_strength = def->strength;
+}
+
+void b2VortexField::Apply(const b2ControllerBatch& batch)
+{
+	const float32 cx = m_center.x, cy = m_center.y;
+	const float32 invRadius = 1.0f / m_radius;
+	const float32 strength = m_strength;
+
+	const float32* px = batch.px;
+	const float32* py = batch.py;
+	const float32* mass = batch.mass;
+	float32* fx = batch.fx;
+	float32* fy = batch.fy;
+
+	for (int32 i = 0; i < batch.count; ++i)
+	{
+		float32 dx = px[i] - cx;
+		float32 dy = py[i] - cy;
+		float32 distance = b2Sqrt(dx * dx + dy * dy);
+		float32 falloff = b2Max(1.0f - distance * invRadius, 0.0f);
+		float32 s = strength * mass[i] * falloff / b2Max(distance, b2_epsilon);
+		fx[i] = -s * dy;
+		fy[i] = s * dx;
+	}
+}
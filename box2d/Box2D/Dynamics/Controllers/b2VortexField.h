@@ -0,0 +1,114 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_VORTEX_FIELD_H
+#define B2_VORTEX_FIELD_H
+
+#include <Box2D/Dynamics/Controllers/b2Controller.h>
+
+/// Vortex field definition. The area defaults to the box around the circle
+/// of the field, call Initialize after setting the center and the radius.
+struct b2VortexFieldDef : public b2ControllerDef
+{
+	b2VortexFieldDef()
+	{
+		type = e_vortexField;
+		center.SetZero();
+		radius = 1.0f;
+		strength = 10.0f;
+	}
+
+	/// Set the center and the radius, and the area to the box around them.
+	void Initialize(const b2Vec2& center, float32 radius, float32 strength);
+
+	/// The center of the field.
+	b2Vec2 center;
+
+	/// The distance from the center where the field fades out.
+	float32 radius;
+
+	/// The acceleration at the center, counter-clockwise. Use a negative
+	/// value to turn clockwise.
+	float32 strength;
+};
+
+/// A vortex field swirls bodies around a point. The acceleration is
+/// perpendicular to the direction of the center and falls linearly from the
+/// strength at the center to zero at the radius. The bodies drift out of a
+/// vortex on their own, overlap it with a radial field to draw them in.
+class b2VortexField : public b2Controller
+{
+public:
+
+	/// Set/get the center.
+	void SetCenter(const b2Vec2& center);
+	const b2Vec2& GetCenter() const;
+
+	/// Set/get the radius.
+	void SetRadius(float32 radius);
+	float32 GetRadius() const;
+
+	/// Set/get the strength.
+	void SetStrength(float32 strength);
+	float32 GetStrength() const;
+
+protected:
+
+	friend class b2Controller;
+
+	b2VortexField(const b2VortexFieldDef* def);
+
+	void Apply(const b2ControllerBatch& batch);
+
+	b2Vec2 m_center;
+	float32 m_radius;
+	float32 m_strength;
+};
+
+inline void b2VortexField::SetCenter(const b2Vec2& center)
+{
+	m_center = center;
+}
+
+inline const b2Vec2& b2VortexField::GetCenter() const
+{
+	return m_center;
+}
+
+inline void b2VortexField::SetRadius(float32 radius)
+{
+	b2Assert(radius > 0.0f);
+	m_radius = radius;
+}
+
+inline float32 b2VortexField::GetRadius() const
+{
+	return m_radius;
+}
+
+inline void b2VortexField::SetStrength(float32 strength)
+{
+	m_strength = strength;
+}
+
+inline float32 b2VortexField::GetStrength() const
+{
+	return m_strength;
+}
+
+#endif
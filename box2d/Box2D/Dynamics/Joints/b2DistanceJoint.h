@@ -89,6 +89,7 @@ public:
 protected:
 
 	friend class b2Joint;
+	template <typename T> friend class b2JointBatch;
 	b2DistanceJoint(const b2DistanceJointDef* data);
 
 	void InitVelocityConstraints(const b2TimeStep& step);
@@ -97,6 +98,7 @@ protected:
 
 	b2Vec2 m_localAnchor1;
 	b2Vec2 m_localAnchor2;
+	b2Vec2 m_r1, m_r2;
 	b2Vec2 m_u;
 	float32 m_frequencyHz;
 	float32 m_dampingRatio;
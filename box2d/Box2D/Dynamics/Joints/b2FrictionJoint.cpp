@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/Joints/b2FrictionJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Dynamics/Joints/b2JointBatch.h>
 
 // Point-to-point constraint
 // Cdot = v2 - v1
@@ -227,3 +228,5 @@ float32 b2FrictionJoint::GetMaxTorque() const
 {
 	return m_maxTorque;
 }
+
+template class b2JointBatch<b2FrictionJoint>;
@@ -76,6 +76,7 @@ public:
 protected:
 
 	friend class b2Joint;
+	template <typename T> friend class b2JointBatch;
 
 	b2FrictionJoint(const b2FrictionJointDef* def);
 
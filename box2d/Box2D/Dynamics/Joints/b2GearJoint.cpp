@@ -21,6 +21,7 @@
 #include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Dynamics/Joints/b2JointBatch.h>
 
 // Gear Joint:
 // C0 = (coordinate1 + ratio * coordinate2)_initial
@@ -257,3 +258,5 @@ float32 b2GearJoint::GetRatio() const
 {
 	return m_ratio;
 }
+
+template class b2JointBatch<b2GearJoint>;
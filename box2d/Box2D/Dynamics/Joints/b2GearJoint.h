@@ -73,6 +73,7 @@ public:
 protected:
 
 	friend class b2Joint;
+	template <typename T> friend class b2JointBatch;
 	b2GearJoint(const b2GearJointDef* data);
 
 	void InitVelocityConstraints(const b2TimeStep& step);
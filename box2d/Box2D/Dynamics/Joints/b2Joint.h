@@ -140,6 +140,9 @@ public:
 	/// Short-cut function to determine if either body is inactive.
 	bool IsActive() const;
 
+	/// Shift the origin for any points stored in world coordinates.
+	virtual void ShiftOrigin(const b2Vec2& newOrigin) { B2_NOT_USED(newOrigin); }
+
 protected:
 	friend class b2World;
 	friend class b2Body;
@@ -176,6 +179,19 @@ protected:
 	float32 m_invMassB, m_invIB;
 };
 
+/// This is an internal class. It solves a run of joints of type T with
+/// direct calls. It is defined in b2JointBatch.h and instantiated in the
+/// source file of each joint, so the constraint code can be inlined into the
+/// loops.
+template <typename T>
+class b2JointBatch
+{
+public:
+	static void InitVelocityConstraints(b2Joint** joints, int32 count, const b2TimeStep& step);
+	static void SolveVelocityConstraints(b2Joint** joints, int32 count, const b2TimeStep& step);
+	static bool SolvePositionConstraints(b2Joint** joints, int32 count, float32 baumgarte);
+};
+
 inline void b2Jacobian::SetZero()
 {
 	linearA.SetZero(); angularA = 0.0f;
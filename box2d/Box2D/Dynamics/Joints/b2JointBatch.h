@@ -0,0 +1,57 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_JOINT_BATCH_H
+#define B2_JOINT_BATCH_H
+
+#include <Box2D/Dynamics/Joints/b2Joint.h>
+
+// Only include this in the source file of a joint, followed by an explicit
+// instantiation of b2JointBatch for that joint.
+
+template <typename T>
+void b2JointBatch<T>::InitVelocityConstraints(b2Joint** joints, int32 count, const b2TimeStep& step)
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		static_cast<T*>(joints[i])->T::InitVelocityConstraints(step);
+	}
+}
+
+template <typename T>
+void b2JointBatch<T>::SolveVelocityConstraints(b2Joint** joints, int32 count, const b2TimeStep& step)
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		static_cast<T*>(joints[i])->T::SolveVelocityConstraints(step);
+	}
+}
+
+template <typename T>
+bool b2JointBatch<T>::SolvePositionConstraints(b2Joint** joints, int32 count, float32 baumgarte)
+{
+	bool okay = true;
+	for (int32 i = 0; i < count; ++i)
+	{
+		bool jointOkay = static_cast<T*>(joints[i])->T::SolvePositionConstraints(baumgarte);
+		okay = okay && jointOkay;
+	}
+	return okay;
+}
+
+#endif
@@ -0,0 +1,526 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Joints/b2JointTreeSolver.h>
+#include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Common/b2StackAllocator.h>
+
+// Pivots that shrank by more than this while factoring mean that K is close
+// to singular, the iterative solver is used instead then.
+const float32 b2_minJointTreePivot = 1.0e-6f;
+
+// K is singular when joints over-constrain bodies, for example a bridge
+// hanging straight between two static bodies. A fraction of its diagonal is
+// added to keep the impulses finite there. The error this leaves is removed
+// by the following iterations.
+const float32 b2_jointTreeRegularization = 1.0e-4f;
+
+bool b2JointTreeSolver::IsMovable(const b2Body* body)
+{
+	return body->m_invMass > 0.0f || body->m_invI > 0.0f;
+}
+
+bool b2JointTreeSolver::IsTreeJoint(b2Joint* joint)
+{
+	if (joint->GetType() != e_revoluteJoint)
+	{
+		return false;
+	}
+
+	b2RevoluteJoint* revolute = (b2RevoluteJoint*)joint;
+	if (revolute->m_enableMotor || revolute->m_limitState != e_inactiveLimit)
+	{
+		return false;
+	}
+
+	return IsMovable(joint->GetBodyA()) || IsMovable(joint->GetBodyB());
+}
+
+static int32 b2FindRoot(int32* roots, int32 i)
+{
+	while (roots[i] != i)
+	{
+		roots[i] = roots[roots[i]];
+		i = roots[i];
+	}
+	return i;
+}
+
+// Gets the coupling J1 * invM * J2T of two point constraints through a body,
+// with r1 and r2 the arms of the constraints on the body.
+b2Mat22 b2JointTreeSolver::GetCoupling(const b2Body* body, const b2Vec2& r1, const b2Vec2& r2)
+{
+	float32 m = body->m_invMass, i = body->m_invI;
+
+	b2Mat22 K;
+	K.col1.x = m + i * r1.y * r2.y;		K.col2.x = -i * r1.y * r2.x;
+	K.col1.y = -i * r1.x * r2.y;		K.col2.y = m + i * r1.x * r2.x;
+	return K;
+}
+
+b2JointTreeSolver::b2JointTreeSolver(const b2TimeStep& step, b2Joint** joints, int32 jointCount,
+									 int32 bodyCount, b2StackAllocator* allocator)
+{
+	m_step = step;
+	m_allocator = allocator;
+	m_count = 0;
+	m_iterativeCount = jointCount;
+	m_factored = false;
+
+	// Most islands have no joints to solve here, skip them quickly.
+	bool found = false;
+	for (int32 i = 0; i < jointCount && step.jointTrees; ++i)
+	{
+		if (IsTreeJoint(joints[i]))
+		{
+			found = true;
+			break;
+		}
+	}
+
+	if (found == false)
+	{
+		jointCount = 0;
+		bodyCount = 0;
+	}
+
+	m_bodyCount = bodyCount;
+
+	// Pointers first, the stack allocator doesn't align.
+	m_joints = (b2RevoluteJoint**)m_allocator->Allocate(jointCount * sizeof(b2RevoluteJoint*));
+
+	// Per joint: up, slot, list (2) and scratch (2). Per body: list start,
+	// block start and scratch (5). Rounded to keep the floats aligned.
+	m_intCount = 6 * jointCount + 7 * bodyCount + 3;
+	m_intCount += m_intCount & 1;
+	m_ints = (int32*)m_allocator->Allocate(m_intCount * sizeof(int32));
+
+	m_up = m_ints;
+	m_slot = m_up + jointCount;
+	m_list = m_slot + jointCount;
+	m_listStart = m_list + 2 * jointCount;
+	m_blockStart = m_listStart + bodyCount + 1;
+
+	Order(joints, jointCount);
+
+	int32 blockCount = m_blockStart[bodyCount];
+	m_x = (b2Vec2*)m_allocator->Allocate(m_count * sizeof(b2Vec2));
+	m_invD = (b2Mat22*)m_allocator->Allocate(m_count * sizeof(b2Mat22));
+	m_blocks = (b2Mat22*)m_allocator->Allocate(blockCount * sizeof(b2Mat22));
+
+	m_factored = Factor();
+}
+
+b2JointTreeSolver::~b2JointTreeSolver()
+{
+	// Warning: the order should reverse the constructor order.
+	m_allocator->Free(m_blocks);
+	m_allocator->Free(m_invD);
+	m_allocator->Free(m_x);
+	m_allocator->Free(m_ints);
+	m_allocator->Free(m_joints);
+}
+
+void b2JointTreeSolver::Order(b2Joint** joints, int32 jointCount)
+{
+	int32 bodyCount = m_bodyCount;
+
+	// Scratch space, the per joint part is also used for the list.
+	int32* selected = m_list;
+	int32* order = m_list + jointCount;
+	int32* adjacency = m_blockStart + bodyCount + 1;
+	int32* adjacencyStart = adjacency + 2 * jointCount;
+	int32* roots = adjacencyStart + bodyCount + 1;
+	int32* parents = roots + bodyCount;
+	int32* stack = parents + bodyCount;
+	int32* next = stack + bodyCount;
+
+	// Select the joints, skipping those that would close a loop.
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		roots[i] = i;
+	}
+
+	for (int32 i = 0; i < jointCount; ++i)
+	{
+		selected[i] = 0;
+
+		b2Joint* joint = joints[i];
+		if (IsTreeJoint(joint) == false)
+		{
+			continue;
+		}
+
+		b2Body* bA = joint->GetBodyA();
+		b2Body* bB = joint->GetBodyB();
+		if (IsMovable(bA) && IsMovable(bB))
+		{
+			int32 rootA = b2FindRoot(roots, bA->m_islandIndex);
+			int32 rootB = b2FindRoot(roots, bB->m_islandIndex);
+			if (rootA == rootB)
+			{
+				continue;
+			}
+			roots[rootA] = rootB;
+		}
+
+		selected[i] = 1;
+	}
+
+	// Move the selected joints to the end, keeping the order of the others.
+	int32 count = 0;
+	for (int32 i = 0; i < jointCount; ++i)
+	{
+		if (selected[i])
+		{
+			m_joints[count++] = (b2RevoluteJoint*)joints[i];
+		}
+		else
+		{
+			joints[i - count] = joints[i];
+		}
+	}
+
+	m_iterativeCount -= count;
+	for (int32 i = 0; i < count; ++i)
+	{
+		joints[m_iterativeCount + i] = m_joints[i];
+	}
+
+	// Find the joints attached to each body.
+	for (int32 i = 0; i <= bodyCount; ++i)
+	{
+		adjacencyStart[i] = 0;
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* bA = m_joints[i]->m_bodyA;
+		b2Body* bB = m_joints[i]->m_bodyB;
+		if (IsMovable(bA)) ++adjacencyStart[bA->m_islandIndex + 1];
+		if (IsMovable(bB)) ++adjacencyStart[bB->m_islandIndex + 1];
+	}
+
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		adjacencyStart[i + 1] += adjacencyStart[i];
+		next[i] = adjacencyStart[i];
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* bA = m_joints[i]->m_bodyA;
+		b2Body* bB = m_joints[i]->m_bodyB;
+		if (IsMovable(bA)) adjacency[next[bA->m_islandIndex]++] = i;
+		if (IsMovable(bB)) adjacency[next[bB->m_islandIndex]++] = i;
+	}
+
+	// Order the joints from the leaves of each tree towards its root with a
+	// depth first search. A joint is eliminated after all the joints below
+	// it. Its up body is the body through which it couples to the joints
+	// after it.
+	const int32 k_unvisited = -2;
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		parents[i] = k_unvisited;
+		next[i] = adjacencyStart[i];
+	}
+
+	m_count = 0;
+	for (int32 seed = 0; seed < bodyCount; ++seed)
+	{
+		if (parents[seed] != k_unvisited || adjacencyStart[seed] == adjacencyStart[seed + 1])
+		{
+			continue;
+		}
+
+		int32 stackCount = 0;
+		stack[stackCount++] = seed;
+		parents[seed] = -1;
+
+		while (stackCount > 0)
+		{
+			int32 body = stack[stackCount - 1];
+
+			if (next[body] == adjacencyStart[body + 1])
+			{
+				// All the joints below this body are done.
+				--stackCount;
+				if (parents[body] >= 0)
+				{
+					m_up[m_count] = stack[stackCount - 1];
+					order[m_count++] = parents[body];
+				}
+				continue;
+			}
+
+			int32 joint = adjacency[next[body]++];
+			if (joint == parents[body])
+			{
+				continue;
+			}
+
+			b2Body* bA = m_joints[joint]->m_bodyA;
+			b2Body* bB = m_joints[joint]->m_bodyB;
+			b2Body* other = bA->m_islandIndex == body && IsMovable(bA) ? bB : bA;
+			if (IsMovable(other) == false)
+			{
+				// Joints to immovable bodies are leaves.
+				m_up[m_count] = body;
+				order[m_count++] = joint;
+				continue;
+			}
+
+			b2Assert(parents[other->m_islandIndex] == k_unvisited);
+			parents[other->m_islandIndex] = joint;
+			stack[stackCount++] = other->m_islandIndex;
+		}
+	}
+
+	b2Assert(m_count == count);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		m_joints[i] = (b2RevoluteJoint*)joints[m_iterativeCount + order[i]];
+	}
+
+	// Store them in elimination order, so the position iterations also
+	// correct the joints from the leaves up.
+	for (int32 i = 0; i < count; ++i)
+	{
+		joints[m_iterativeCount + i] = m_joints[i];
+	}
+
+	// List the joints attached to each body in elimination order.
+	for (int32 i = 0; i <= bodyCount; ++i)
+	{
+		m_listStart[i] = 0;
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* bA = m_joints[i]->m_bodyA;
+		b2Body* bB = m_joints[i]->m_bodyB;
+		if (IsMovable(bA)) ++m_listStart[bA->m_islandIndex + 1];
+		if (IsMovable(bB)) ++m_listStart[bB->m_islandIndex + 1];
+	}
+
+	m_blockStart[0] = 0;
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		int32 listCount = m_listStart[i + 1];
+		m_listStart[i + 1] += m_listStart[i];
+		m_blockStart[i + 1] = m_blockStart[i] + listCount * listCount;
+		next[i] = m_listStart[i];
+	}
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2Body* bA = m_joints[i]->m_bodyA;
+		b2Body* bB = m_joints[i]->m_bodyB;
+		if (IsMovable(bA))
+		{
+			int32 body = bA->m_islandIndex;
+			if (body == m_up[i])
+			{
+				m_slot[i] = next[body] - m_listStart[body];
+			}
+			m_list[next[body]++] = i;
+		}
+		if (IsMovable(bB))
+		{
+			int32 body = bB->m_islandIndex;
+			if (body == m_up[i])
+			{
+				m_slot[i] = next[body] - m_listStart[body];
+			}
+			m_list[next[body]++] = i;
+		}
+	}
+}
+
+bool b2JointTreeSolver::Factor()
+{
+	// Pivots start as the diagonal blocks of K. Their determinants are kept
+	// in x to check the pivots against.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2RevoluteJoint* joint = m_joints[i];
+		b2Mat22 K = GetCoupling(joint->m_bodyA, joint->m_r1, joint->m_r1) + GetCoupling(joint->m_bodyB, joint->m_r2, joint->m_r2);
+		K.col1.x += b2_jointTreeRegularization * K.col1.x;
+		K.col2.y += b2_jointTreeRegularization * K.col2.y;
+		m_invD[i] = K;
+		m_x[i].x = K.col1.x * K.col2.y - K.col2.x * K.col1.y;
+	}
+
+	// The couplings of the joints attached to each body. A constraint pulls
+	// its first body against the direction it pulls its second body.
+	for (int32 b = 0; b < m_bodyCount; ++b)
+	{
+		int32 start = m_listStart[b];
+		int32 listCount = m_listStart[b + 1] - start;
+		b2Mat22* blocks = m_blocks + m_blockStart[b];
+
+		for (int32 s = 0; s < listCount; ++s)
+		{
+			int32 js = m_list[start + s];
+			b2RevoluteJoint* jointS = m_joints[js];
+			bool firstS = jointS->m_bodyA->m_islandIndex == b && IsMovable(jointS->m_bodyA);
+			b2Body* body = firstS ? jointS->m_bodyA : jointS->m_bodyB;
+			b2Vec2 rS = firstS ? m_joints[js]->m_r1 : m_joints[js]->m_r2;
+
+			for (int32 t = 0; t < listCount; ++t)
+			{
+				if (s == t)
+				{
+					continue;
+				}
+
+				int32 jt = m_list[start + t];
+				b2RevoluteJoint* jointT = m_joints[jt];
+				bool firstT = jointT->m_bodyA->m_islandIndex == b && IsMovable(jointT->m_bodyA);
+				b2Vec2 rT = firstT ? m_joints[jt]->m_r1 : m_joints[jt]->m_r2;
+
+				b2Mat22 K = GetCoupling(body, rS, rT);
+				if (firstS != firstT)
+				{
+					K.col1 = -K.col1;
+					K.col2 = -K.col2;
+				}
+				blocks[s * listCount + t] = K;
+			}
+		}
+	}
+
+	// Eliminate the joints in order. The blocks below the diagonal of a body
+	// are replaced by the factor L as the joints are eliminated.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2Mat22 D = m_invD[i];
+		float32 det = D.col1.x * D.col2.y - D.col2.x * D.col1.y;
+		if (det <= b2_minJointTreePivot * m_x[i].x)
+		{
+			return false;
+		}
+		b2Mat22 invD = D.GetInverse();
+		m_invD[i] = invD;
+
+		int32 b = m_up[i];
+		int32 s = m_slot[i];
+		int32 start = m_listStart[b];
+		int32 listCount = m_listStart[b + 1] - start;
+		b2Mat22* blocks = m_blocks + m_blockStart[b];
+
+		for (int32 t = s + 1; t < listCount; ++t)
+		{
+			blocks[t * listCount + s] = b2Mul(blocks[t * listCount + s], invD);
+		}
+
+		for (int32 t = s + 1; t < listCount; ++t)
+		{
+			const b2Mat22& L = blocks[t * listCount + s];
+			for (int32 q = s + 1; q < listCount; ++q)
+			{
+				b2Mat22 X = b2Mul(L, blocks[s * listCount + q]);
+				b2Mat22& A = t == q ? m_invD[m_list[start + t]] : blocks[t * listCount + q];
+				A.col1 -= X.col1;
+				A.col2 -= X.col2;
+			}
+		}
+	}
+
+	return true;
+}
+
+void b2JointTreeSolver::Solve()
+{
+	// Forward substitution with L, then D.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		int32 b = m_up[i];
+		int32 s = m_slot[i];
+		int32 start = m_listStart[b];
+		int32 listCount = m_listStart[b + 1] - start;
+		const b2Mat22* blocks = m_blocks + m_blockStart[b];
+
+		for (int32 t = s + 1; t < listCount; ++t)
+		{
+			m_x[m_list[start + t]] -= b2Mul(blocks[t * listCount + s], m_x[i]);
+		}
+
+		m_x[i] = b2Mul(m_invD[i], m_x[i]);
+	}
+
+	// Back substitution with LT.
+	for (int32 i = m_count - 1; i >= 0; --i)
+	{
+		int32 b = m_up[i];
+		int32 s = m_slot[i];
+		int32 start = m_listStart[b];
+		int32 listCount = m_listStart[b + 1] - start;
+		const b2Mat22* blocks = m_blocks + m_blockStart[b];
+
+		for (int32 t = s + 1; t < listCount; ++t)
+		{
+			m_x[i] -= b2MulT(blocks[t * listCount + s], m_x[m_list[start + t]]);
+		}
+	}
+}
+
+void b2JointTreeSolver::SolveVelocityConstraints()
+{
+	if (m_factored == false)
+	{
+		for (int32 i = 0; i < m_count; ++i)
+		{
+			m_joints[i]->SolveVelocityConstraints(m_step);
+		}
+		return;
+	}
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2RevoluteJoint* joint = m_joints[i];
+		b2Body* b1 = joint->m_bodyA;
+		b2Body* b2 = joint->m_bodyB;
+
+		b2Vec2 Cdot = b2->m_linearVelocity + b2Cross(b2->m_angularVelocity, joint->m_r2) -
+			b1->m_linearVelocity - b2Cross(b1->m_angularVelocity, joint->m_r1);
+		m_x[i] = -Cdot;
+	}
+
+	Solve();
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2RevoluteJoint* joint = m_joints[i];
+		b2Body* b1 = joint->m_bodyA;
+		b2Body* b2 = joint->m_bodyB;
+		b2Vec2 impulse = m_x[i];
+
+		joint->m_impulse.x += impulse.x;
+		joint->m_impulse.y += impulse.y;
+
+		b1->m_linearVelocity -= b1->m_invMass * impulse;
+		b1->m_angularVelocity -= b1->m_invI * b2Cross(joint->m_r1, impulse);
+
+		b2->m_linearVelocity += b2->m_invMass * impulse;
+		b2->m_angularVelocity += b2->m_invI * b2Cross(joint->m_r2, impulse);
+	}
+}
@@ -0,0 +1,103 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_JOINT_TREE_SOLVER_H
+#define B2_JOINT_TREE_SOLVER_H
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
+
+class b2Body;
+class b2Joint;
+class b2RevoluteJoint;
+class b2StackAllocator;
+
+/// This is an internal class. It solves the velocity constraints of
+/// revolute joints that form trees, such as chains, ropes and bridges, with
+/// a direct solver instead of sequential impulses. The joints of a tree are
+/// solved together and exactly in one pass, so long chains don't stretch
+/// and don't need many iterations to converge. Position errors are still
+/// corrected by the joints one at a time.
+///
+/// Static, kinematic and other bodies that can't be moved by impulses
+/// don't couple the joints attached to them, so a bridge hung between two
+/// static bodies is a tree too. Joints with a motor or an active limit, and
+/// joints that would close a loop between movable bodies, are left to the
+/// iterative solver.
+///
+/// The joint mass matrix K = J * invM * JT is factored as L * D * LT with
+/// the joints eliminated from the leaves of each tree towards its root.
+/// In that order eliminating a joint only touches the joints attached to
+/// the same body, which are coupled already, so there is no fill-in and
+/// the solve takes linear time.
+class b2JointTreeSolver
+{
+public:
+	/// Moves the joints solved here to the end of joints. They must have
+	/// been initialized for the time step. Nothing is solved here unless
+	/// step.jointTrees is set.
+	b2JointTreeSolver(const b2TimeStep& step, b2Joint** joints, int32 jointCount,
+					  int32 bodyCount, b2StackAllocator* allocator);
+	~b2JointTreeSolver();
+
+	/// Get the number of joints at the start of the island joint array that
+	/// are not solved here.
+	int32 GetIterativeCount() const { return m_iterativeCount; }
+
+	void SolveVelocityConstraints();
+
+private:
+
+	static bool IsMovable(const b2Body* body);
+	static bool IsTreeJoint(b2Joint* joint);
+	static b2Mat22 GetCoupling(const b2Body* body, const b2Vec2& r1, const b2Vec2& r2);
+
+	void Order(b2Joint** joints, int32 jointCount);
+	bool Factor();
+	void Solve();
+
+	b2TimeStep m_step;
+	b2StackAllocator* m_allocator;
+
+	// The joints solved here in elimination order.
+	b2RevoluteJoint** m_joints;
+	int32 m_count;
+	int32 m_iterativeCount;
+	int32 m_bodyCount;
+
+	// Per joint, by elimination order.
+	b2Mat22* m_invD;	// inverse of the pivot block
+	b2Vec2* m_x;		// right hand side, then solution
+	int32* m_up;		// the body that couples the joint to later joints
+	int32* m_slot;		// the index of the joint among those of its up body
+
+	// Per body, by island index. The joints attached to a body are listed in
+	// elimination order, and the couplings between them are kept in a square
+	// array of blocks. The lower triangle becomes the factor L.
+	int32* m_listStart;
+	int32* m_list;
+	int32* m_blockStart;
+	b2Mat22* m_blocks;
+
+	int32* m_ints;
+	int32 m_intCount;
+
+	bool m_factored;
+};
+
+#endif
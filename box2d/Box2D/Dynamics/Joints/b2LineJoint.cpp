@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/Joints/b2LineJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Dynamics/Joints/b2JointBatch.h>
 
 // Linear constraint (point-to-line)
 // d = p2 - p1 = x2 + r2 - x1 - r1
@@ -585,7 +586,4 @@ float32 b2LineJoint::GetMotorForce() const
 	return m_motorImpulse;
 }
 
-
-
-
-
+template class b2JointBatch<b2LineJoint>;
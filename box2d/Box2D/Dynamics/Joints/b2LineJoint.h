@@ -131,6 +131,7 @@ public:
 protected:
 
 	friend class b2Joint;
+	template <typename T> friend class b2JointBatch;
 	b2LineJoint(const b2LineJointDef* def);
 
 	void InitVelocityConstraints(const b2TimeStep& step);
@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/Joints/b2MouseJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Dynamics/Joints/b2JointBatch.h>
 
 // p = attached point, m = mouse point
 // C = p - m
@@ -93,6 +94,11 @@ float32 b2MouseJoint::GetDampingRatio() const
 	return m_dampingRatio;
 }
 
+void b2MouseJoint::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	m_target -= newOrigin;
+}
+
 void b2MouseJoint::InitVelocityConstraints(const b2TimeStep& step)
 {
 	b2Body* b = m_bodyB;
@@ -195,3 +201,5 @@ float32 b2MouseJoint::GetReactionTorque(float32 inv_dt) const
 {
 	return inv_dt * 0.0f;
 }
+
+template class b2JointBatch<b2MouseJoint>;
@@ -89,8 +89,12 @@ public:
 	void SetDampingRatio(float32 ratio);
 	float32 GetDampingRatio() const;
 
+	/// Implement b2Joint::ShiftOrigin
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
 protected:
 	friend class b2Joint;
+	template <typename T> friend class b2JointBatch;
 
 	b2MouseJoint(const b2MouseJointDef* def);
 
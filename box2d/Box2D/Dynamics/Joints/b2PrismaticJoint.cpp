@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Dynamics/Joints/b2JointBatch.h>
 
 // Linear constraint (point-to-line)
 // d = p2 - p1 = x2 + r2 - x1 - r1
@@ -584,3 +585,5 @@ float32 b2PrismaticJoint::GetMotorForce() const
 {
 	return m_motorImpulse;
 }
+
+template class b2JointBatch<b2PrismaticJoint>;
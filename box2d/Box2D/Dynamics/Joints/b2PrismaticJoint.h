@@ -134,6 +134,7 @@ public:
 
 protected:
 	friend class b2Joint;
+	template <typename T> friend class b2JointBatch;
 	friend class b2GearJoint;
 	b2PrismaticJoint(const b2PrismaticJointDef* def);
 
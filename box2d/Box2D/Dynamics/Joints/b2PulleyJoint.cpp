@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Dynamics/Joints/b2JointBatch.h>
 
 // Pulley:
 // length1 = norm(p1 - s1)
@@ -425,3 +426,11 @@ float32 b2PulleyJoint::GetRatio() const
 {
 	return m_ratio;
 }
+
+void b2PulleyJoint::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	m_groundAnchor1 -= newOrigin;
+	m_groundAnchor2 -= newOrigin;
+}
+
+template class b2JointBatch<b2PulleyJoint>;
@@ -107,9 +107,13 @@ public:
 	/// Get the pulley ratio.
 	float32 GetRatio() const;
 
+	/// Implement b2Joint::ShiftOrigin
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
 protected:
 
 	friend class b2Joint;
+	template <typename T> friend class b2JointBatch;
 	b2PulleyJoint(const b2PulleyJointDef* data);
 
 	void InitVelocityConstraints(const b2TimeStep& step);
@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Dynamics/Joints/b2JointBatch.h>
 
 // Point-to-point constraint
 // C = p2 - p1
@@ -73,9 +74,12 @@ void b2RevoluteJoint::InitVelocityConstraints(const b2TimeStep& step)
 		b2Assert(b1->m_invI > 0.0f || b2->m_invI > 0.0f);
 	}
 
-	// Compute the effective mass matrix.
+	// Compute the effective mass matrix. The anchors don't move while
+	// velocities are solved, so they are kept for the iterations.
 	b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
 	b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
+	m_r1 = r1;
+	m_r2 = r2;
 
 	// J = [-I -r1_skew I r2_skew]
 	//     [ 0       -1 0       1]
@@ -195,8 +199,8 @@ void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep& step)
 	// Solve limit constraint.
 	if (m_enableLimit && m_limitState != e_inactiveLimit)
 	{
-		b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
-		b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
+		b2Vec2 r1 = m_r1;
+		b2Vec2 r2 = m_r2;
 
 		// Solve point-to-point constraint
 		b2Vec2 Cdot1 = v2 + b2Cross(w2, r2) - v1 - b2Cross(w1, r1);
@@ -248,8 +252,8 @@ void b2RevoluteJoint::SolveVelocityConstraints(const b2TimeStep& step)
 	}
 	else
 	{
-		b2Vec2 r1 = b2Mul(b1->GetTransform().R, m_localAnchor1 - b1->GetLocalCenter());
-		b2Vec2 r2 = b2Mul(b2->GetTransform().R, m_localAnchor2 - b2->GetLocalCenter());
+		b2Vec2 r1 = m_r1;
+		b2Vec2 r2 = m_r2;
 
 		// Solve point-to-point constraint
 		b2Vec2 Cdot = v2 + b2Cross(w2, r2) - v1 - b2Cross(w1, r1);
@@ -476,3 +480,5 @@ void b2RevoluteJoint::SetLimits(float32 lower, float32 upper)
 	m_lowerAngle = lower;
 	m_upperAngle = upper;
 }
+
+template class b2JointBatch<b2RevoluteJoint>;
@@ -138,7 +138,9 @@ public:
 protected:
 	
 	friend class b2Joint;
+	template <typename T> friend class b2JointBatch;
 	friend class b2GearJoint;
+	friend class b2JointTreeSolver;
 
 	b2RevoluteJoint(const b2RevoluteJointDef* def);
 
@@ -149,6 +151,7 @@ protected:
 
 	b2Vec2 m_localAnchor1;	// relative
 	b2Vec2 m_localAnchor2;
+	b2Vec2 m_r1, m_r2;		// anchors relative to the centers of mass, per step
 	b2Vec3 m_impulse;
 	float32 m_motorImpulse;
 
@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/Joints/b2WeldJoint.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Dynamics/Joints/b2JointBatch.h>
 
 // Point-to-point constraint
 // C = p2 - p1
@@ -61,6 +62,8 @@ void b2WeldJoint::InitVelocityConstraints(const b2TimeStep& step)
 	// Compute the effective mass matrix.
 	b2Vec2 rA = b2Mul(bA->GetTransform().R, m_localAnchorA - bA->GetLocalCenter());
 	b2Vec2 rB = b2Mul(bB->GetTransform().R, m_localAnchorB - bB->GetLocalCenter());
+	m_rA = rA;
+	m_rB = rB;
 
 	// J = [-I -r1_skew I r2_skew]
 	//     [ 0       -1 0       1]
@@ -118,8 +121,8 @@ void b2WeldJoint::SolveVelocityConstraints(const b2TimeStep& step)
 	float32 mA = bA->m_invMass, mB = bB->m_invMass;
 	float32 iA = bA->m_invI, iB = bB->m_invI;
 
-	b2Vec2 rA = b2Mul(bA->GetTransform().R, m_localAnchorA - bA->GetLocalCenter());
-	b2Vec2 rB = b2Mul(bB->GetTransform().R, m_localAnchorB - bB->GetLocalCenter());
+	b2Vec2 rA = m_rA;
+	b2Vec2 rB = m_rB;
 
 	// Solve point-to-point constraint
 	b2Vec2 Cdot1 = vB + b2Cross(wB, rB) - vA - b2Cross(wA, rA);
@@ -217,3 +220,5 @@ float32 b2WeldJoint::GetReactionTorque(float32 inv_dt) const
 {
 	return inv_dt * m_impulse.z;
 }
+
+template class b2JointBatch<b2WeldJoint>;
@@ -62,6 +62,7 @@ public:
 protected:
 
 	friend class b2Joint;
+	template <typename T> friend class b2JointBatch;
 
 	b2WeldJoint(const b2WeldJointDef* def);
 
@@ -72,6 +73,7 @@ protected:
 
 	b2Vec2 m_localAnchorA;
 	b2Vec2 m_localAnchorB;
+	b2Vec2 m_rA, m_rB;
 	float32 m_referenceAngle;
 
 	b2Vec3 m_impulse;
@@ -0,0 +1,892 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Particles/b2ParticleSystem.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
+#include <Box2D/Dynamics/b2World.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Common/b2TaskScheduler.h>
+#include <cstring>
+
+// Grow an array allocated with b2Alloc to hold at least one more element.
+template <typename T>
+static void b2GrowArray(T** array, int32 count, int32* capacity)
+{
+	if (count < *capacity)
+	{
+		return;
+	}
+
+	*capacity = b2Max(2 * *capacity, 16);
+	T* grown = (T*)b2Alloc(*capacity * sizeof(T));
+	if (count > 0)
+	{
+		memcpy(grown, *array, count * sizeof(T));
+	}
+	b2Free(*array);
+	*array = grown;
+}
+
+// Resize an array allocated with b2Alloc, keeping its first count elements.
+template <typename T>
+static void b2ResizeArray(T** array, int32 count, int32 capacity)
+{
+	T* resized = (T*)b2Alloc(capacity * sizeof(T));
+	if (count > 0)
+	{
+		memcpy(resized, *array, count * sizeof(T));
+	}
+	b2Free(*array);
+	*array = resized;
+}
+
+static inline int32 b2CellCoordinate(float32 x, float32 inv_h)
+{
+	return (int32)floorf(x * inv_h);
+}
+
+static inline int32 b2CellHash(int32 cx, int32 cy, int32 mask)
+{
+	return (int32)(((uint32)cx * 73856093u) ^ ((uint32)cy * 19349663u)) & mask;
+}
+
+// The signed distance from a point to the shape of a fixture and the
+// direction out of the shape. Points inside a polygon are pushed out
+// through the closest face.
+static void b2ComputeParticleDistance(const b2Fixture* fixture, const b2Vec2& p,
+									  float32* distance, b2Vec2* normal)
+{
+	const b2Transform& xf = fixture->GetBody()->GetTransform();
+	const b2Shape* shape = fixture->GetShape();
+
+	if (shape->GetType() == b2Shape::e_circle)
+	{
+		const b2CircleShape* circle = (const b2CircleShape*)shape;
+		b2Vec2 d = p - b2Mul(xf, circle->m_p);
+		float32 length = d.Normalize();
+		*normal = length > b2_epsilon ? d : b2Vec2(0.0f, 1.0f);
+		*distance = length - circle->m_radius;
+		return;
+	}
+
+	b2Assert(shape->GetType() == b2Shape::e_polygon);
+	const b2PolygonShape* polygon = (const b2PolygonShape*)shape;
+	int32 vertexCount = polygon->m_vertexCount;
+	const b2Vec2* vertices = polygon->m_vertices;
+	const b2Vec2* normals = polygon->m_normals;
+	b2Vec2 pLocal = b2MulT(xf, p);
+
+	int32 bestIndex = 0;
+	float32 maxSeparation = -b2_maxFloat;
+	for (int32 i = 0; i < vertexCount; ++i)
+	{
+		float32 s = b2Dot(normals[i], pLocal - vertices[i]);
+		if (s > maxSeparation)
+		{
+			maxSeparation = s;
+			bestIndex = i;
+		}
+	}
+
+	if (maxSeparation <= 0.0f)
+	{
+		*normal = b2Mul(xf.R, normals[bestIndex]);
+		*distance = maxSeparation - polygon->m_radius;
+		return;
+	}
+
+	float32 minDistanceSquared = b2_maxFloat;
+	b2Vec2 closest = vertices[0];
+	for (int32 i = 0; i < vertexCount; ++i)
+	{
+		b2Vec2 v1 = vertices[i];
+		b2Vec2 e = vertices[i + 1 < vertexCount ? i + 1 : 0] - v1;
+		float32 t = b2Clamp(b2Dot(pLocal - v1, e) / b2Dot(e, e), 0.0f, 1.0f);
+		b2Vec2 q = v1 + t * e;
+		float32 distanceSquared = b2DistanceSquared(pLocal, q);
+		if (distanceSquared < minDistanceSquared)
+		{
+			minDistanceSquared = distanceSquared;
+			closest = q;
+		}
+	}
+
+	b2Vec2 d = pLocal - closest;
+	float32 length = d.Normalize();
+	*normal = b2Mul(xf.R, length > b2_epsilon ? d : normals[bestIndex]);
+	*distance = length - polygon->m_radius;
+}
+
+class b2ParticleTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+		m_system->Execute(m_stage, begin, end);
+	}
+
+	b2ParticleSystem* m_system;
+	b2ParticleSystem::Stage m_stage;
+};
+
+class b2ParticleQueryCallback : public b2QueryCallback
+{
+public:
+	bool ReportFixture(b2Fixture* fixture)
+	{
+		if (fixture->IsSensor())
+		{
+			return true;
+		}
+
+		if ((fixture->GetFilterData().categoryBits & m_system->m_maskBits) == 0)
+		{
+			return true;
+		}
+
+		b2ParticleSystem* s = m_system;
+		b2GrowArray(&s->m_fixtures, s->m_fixtureCount, &s->m_fixtureCapacity);
+		s->m_fixtures[s->m_fixtureCount++] = fixture;
+		return true;
+	}
+
+	b2ParticleSystem* m_system;
+};
+
+b2ParticleSystem::b2ParticleSystem(const b2ParticleSystemDef* def, b2World* world)
+{
+	b2Assert(def->radius > 0.0f);
+	b2Assert(def->iterations > 0);
+
+	m_world = world;
+	m_taskScheduler = NULL;
+
+	m_radius = def->radius;
+	m_density = def->density;
+	m_granular = def->granular;
+	m_iterations = def->iterations;
+	m_viscosity = def->viscosity;
+	m_surfaceTension = def->surfaceTension;
+	m_friction = def->friction;
+	m_gravityScale = def->gravityScale;
+	m_maskBits = def->maskBits;
+
+	// The kernels reach two and a half particle diameters. Poly6 smooths the
+	// density and the gradient of spiky does not vanish at close range.
+	m_h = 5.0f * m_radius;
+	m_inv_h = 1.0f / m_h;
+	m_poly6 = 4.0f / (b2_pi * powf(m_h, 8.0f));
+	m_spiky = -30.0f / (b2_pi * powf(m_h, 5.0f));
+
+	// The rest density and the squared constraint gradient of a particle in
+	// a square lattice of one diameter, the arrangement of particles at rest.
+	float32 h2 = m_h * m_h;
+	float32 spacing = 2.0f * m_radius;
+	float32 restDensity = 0.0f;
+	float32 gradientSquared = 0.0f;
+	for (int32 i = -3; i <= 3; ++i)
+	{
+		for (int32 j = -3; j <= 3; ++j)
+		{
+			float32 r2 = spacing * spacing * (float32)(i * i + j * j);
+			if (r2 >= h2)
+			{
+				continue;
+			}
+
+			float32 w = h2 - r2;
+			restDensity += m_poly6 * w * w * w;
+
+			float32 g = m_h - b2Sqrt(r2);
+			g = m_spiky * g * g;
+			gradientSquared += g * g;
+		}
+	}
+
+	m_inv_restDensity = 1.0f / restDensity;
+	gradientSquared *= m_inv_restDensity * m_inv_restDensity;
+	m_epsilon = def->relaxation * gradientSquared;
+
+	// The artificial pressure of the anti-clustering term, relative to the
+	// kernel at a fifth of its reach.
+	float32 wq = h2 - 0.04f * h2;
+	m_inv_correctionKernel = 1.0f / (m_poly6 * wq * wq * wq);
+	m_correctionScale = m_granular ? 0.0f : -m_surfaceTension / gradientSquared;
+	m_inv_dt = 0.0f;
+
+	m_count = 0;
+	m_capacity = 0;
+	m_x = NULL;
+	m_y = NULL;
+	m_vx = NULL;
+	m_vy = NULL;
+	m_px = NULL;
+	m_py = NULL;
+	m_lambda = NULL;
+	m_dx = NULL;
+	m_dy = NULL;
+	m_neighborCount = NULL;
+	m_neighbors = NULL;
+	m_cellKeys = NULL;
+	m_cellIndices = NULL;
+	m_cellStart = NULL;
+	m_cellMask = 0;
+	m_stamps = NULL;
+
+	m_fixtures = NULL;
+	m_fixtureCount = 0;
+	m_fixtureCapacity = 0;
+	m_contacts = NULL;
+	m_contactCount = 0;
+	m_contactCapacity = 0;
+
+	m_prev = NULL;
+	m_next = NULL;
+
+	m_userData = def->userData;
+}
+
+b2ParticleSystem::~b2ParticleSystem()
+{
+	b2Free(m_x);
+	b2Free(m_y);
+	b2Free(m_vx);
+	b2Free(m_vy);
+	b2Free(m_px);
+	b2Free(m_py);
+	b2Free(m_lambda);
+	b2Free(m_dx);
+	b2Free(m_dy);
+	b2Free(m_neighborCount);
+	b2Free(m_neighbors);
+	b2Free(m_cellKeys);
+	b2Free(m_cellIndices);
+	b2Free(m_cellStart);
+	b2Free(m_stamps);
+	b2Free(m_fixtures);
+	b2Free(m_contacts);
+}
+
+void b2ParticleSystem::Reserve(int32 capacity)
+{
+	// The particles are kept, the scratch arrays are filled at each step.
+	b2ResizeArray(&m_x, m_count, capacity);
+	b2ResizeArray(&m_y, m_count, capacity);
+	b2ResizeArray(&m_vx, m_count, capacity);
+	b2ResizeArray(&m_vy, m_count, capacity);
+	b2ResizeArray(&m_px, 0, capacity);
+	b2ResizeArray(&m_py, 0, capacity);
+	b2ResizeArray(&m_lambda, 0, capacity);
+	b2ResizeArray(&m_dx, 0, capacity);
+	b2ResizeArray(&m_dy, 0, capacity);
+	b2ResizeArray(&m_neighborCount, 0, capacity);
+	b2ResizeArray(&m_neighbors, 0, capacity * b2_maxParticleNeighbors);
+	b2ResizeArray(&m_cellKeys, 0, capacity);
+	b2ResizeArray(&m_cellIndices, 0, capacity);
+	b2ResizeArray(&m_stamps, 0, capacity);
+
+	// At least two cells per particle keep the collisions of the hash rare.
+	int32 cellCount = 16;
+	while (cellCount < 2 * capacity)
+	{
+		cellCount *= 2;
+	}
+	b2ResizeArray(&m_cellStart, 0, cellCount + 1);
+	m_cellMask = cellCount - 1;
+
+	m_capacity = capacity;
+}
+
+int32 b2ParticleSystem::CreateParticle(const b2Vec2& position, const b2Vec2& velocity)
+{
+	b2Assert(m_world->IsLocked() == false);
+	if (m_world->IsLocked())
+	{
+		return -1;
+	}
+
+	if (m_count == m_capacity)
+	{
+		Reserve(b2Max(2 * m_capacity, 256));
+	}
+
+	int32 index = m_count++;
+	m_x[index] = position.x;
+	m_y[index] = position.y;
+	m_vx[index] = velocity.x;
+	m_vy[index] = velocity.y;
+	return index;
+}
+
+void b2ParticleSystem::DestroyParticles(int32 first, int32 count)
+{
+	b2Assert(0 <= first && 0 <= count && first + count <= m_count);
+	b2Assert(m_world->IsLocked() == false);
+	if (m_world->IsLocked())
+	{
+		return;
+	}
+
+	int32 moved = m_count - first - count;
+	if (moved > 0)
+	{
+		memmove(m_x + first, m_x + first + count, moved * sizeof(float32));
+		memmove(m_y + first, m_y + first + count, moved * sizeof(float32));
+		memmove(m_vx + first, m_vx + first + count, moved * sizeof(float32));
+		memmove(m_vy + first, m_vy + first + count, moved * sizeof(float32));
+	}
+	m_count -= count;
+}
+
+// Sort the particles by cell with a counting sort.
+void b2ParticleSystem::BuildGrid(const float32* x, const float32* y)
+{
+	int32 cellCount = m_cellMask + 1;
+	memset(m_cellStart, 0, (cellCount + 1) * sizeof(int32));
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		int32 key = b2CellHash(b2CellCoordinate(x[i], m_inv_h), b2CellCoordinate(y[i], m_inv_h), m_cellMask);
+		m_cellKeys[i] = key;
+		++m_cellStart[key + 1];
+	}
+
+	for (int32 k = 0; k < cellCount; ++k)
+	{
+		m_cellStart[k + 1] += m_cellStart[k];
+	}
+
+	// Each cell start is advanced past its particles, then shifted back.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_cellIndices[m_cellStart[m_cellKeys[i]]++] = i;
+	}
+
+	for (int32 k = cellCount; k > 0; --k)
+	{
+		m_cellStart[k] = m_cellStart[k - 1];
+	}
+	m_cellStart[0] = 0;
+}
+
+// The keys of a cell and of the cells around it. Cells sharing a key are
+// listed once so their particles are not visited twice.
+int32 b2ParticleSystem::GetCellKeys(int32 cx, int32 cy, int32* keys) const
+{
+	int32 count = 0;
+	for (int32 y = cy - 1; y <= cy + 1; ++y)
+	{
+		for (int32 x = cx - 1; x <= cx + 1; ++x)
+		{
+			int32 key = b2CellHash(x, y, m_cellMask);
+			bool found = false;
+			for (int32 k = 0; k < count; ++k)
+			{
+				found = found || keys[k] == key;
+			}
+
+			if (found == false)
+			{
+				keys[count++] = key;
+			}
+		}
+	}
+	return count;
+}
+
+// Gather the particles within reach of the fixtures. The fixtures come from
+// the broad-phase, the particles from the cells covering each fixture.
+void b2ParticleSystem::FindContacts()
+{
+	m_fixtureCount = 0;
+	m_contactCount = 0;
+
+	float32 lowerX = b2_maxFloat, lowerY = b2_maxFloat;
+	float32 upperX = -b2_maxFloat, upperY = -b2_maxFloat;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		lowerX = b2Min(lowerX, m_x[i]);
+		lowerY = b2Min(lowerY, m_y[i]);
+		upperX = b2Max(upperX, m_x[i]);
+		upperY = b2Max(upperY, m_y[i]);
+	}
+
+	float32 margin = m_radius + m_h;
+	b2AABB aabb;
+	aabb.lowerBound.Set(lowerX - margin, lowerY - margin);
+	aabb.upperBound.Set(upperX + margin, upperY + margin);
+
+	b2ParticleQueryCallback callback;
+	callback.m_system = this;
+	m_world->QueryAABB(&callback, aabb);
+
+	if (m_fixtureCount == 0)
+	{
+		return;
+	}
+
+	memset(m_stamps, 0, m_count * sizeof(int32));
+
+	for (int32 f = 0; f < m_fixtureCount; ++f)
+	{
+		b2Fixture* fixture = m_fixtures[f];
+		const b2AABB& fixtureAABB = fixture->GetAABB();
+		int32 cx0 = b2CellCoordinate(b2Max(fixtureAABB.lowerBound.x - margin, aabb.lowerBound.x), m_inv_h);
+		int32 cy0 = b2CellCoordinate(b2Max(fixtureAABB.lowerBound.y - margin, aabb.lowerBound.y), m_inv_h);
+		int32 cx1 = b2CellCoordinate(b2Min(fixtureAABB.upperBound.x + margin, aabb.upperBound.x), m_inv_h);
+		int32 cy1 = b2CellCoordinate(b2Min(fixtureAABB.upperBound.y + margin, aabb.upperBound.y), m_inv_h);
+
+		// A fixture covering more cells than there are particles is tested
+		// against every particle.
+		float32 cellCount = (float32)(cx1 - cx0 + 1) * (float32)(cy1 - cy0 + 1);
+		bool scanAll = cellCount > (float32)m_count;
+
+		int32 cx = cx0, cy = cy0, s = 0, end = scanAll ? m_count : 0;
+		for (;;)
+		{
+			if (s == end)
+			{
+				if (scanAll || cy > cy1)
+				{
+					break;
+				}
+
+				int32 key = b2CellHash(cx, cy, m_cellMask);
+				s = m_cellStart[key];
+				end = m_cellStart[key + 1];
+				if (++cx > cx1)
+				{
+					cx = cx0;
+					++cy;
+				}
+				continue;
+			}
+
+			int32 i = scanAll ? s : m_cellIndices[s];
+			++s;
+
+			if (m_stamps[i] == f + 1)
+			{
+				continue;
+			}
+			m_stamps[i] = f + 1;
+
+			float32 distance;
+			b2Vec2 normal;
+			b2ComputeParticleDistance(fixture, b2Vec2(m_x[i], m_y[i]), &distance, &normal);
+			if (distance < margin)
+			{
+				b2GrowArray(&m_contacts, m_contactCount, &m_contactCapacity);
+				m_contacts[m_contactCount].index = i;
+				m_contacts[m_contactCount].fixture = fixture;
+				++m_contactCount;
+			}
+		}
+	}
+}
+
+// Keep the particles from moving into the fixtures during the step, with
+// friction, and push the dynamic bodies back with the same impulses.
+void b2ParticleSystem::SolveContacts(const b2TimeStep& step)
+{
+	float32 mass = GetParticleMass();
+	float32 invMass = mass > 0.0f ? 1.0f / mass : 0.0f;
+
+	for (int32 c = 0; c < m_contactCount; ++c)
+	{
+		int32 i = m_contacts[c].index;
+		b2Fixture* fixture = m_contacts[c].fixture;
+		b2Body* body = fixture->GetBody();
+
+		float32 distance;
+		b2Vec2 normal;
+		b2Vec2 p(m_x[i], m_y[i]);
+		b2ComputeParticleDistance(fixture, p, &distance, &normal);
+
+		// Approaching is allowed up to contact, overlaps are resolved by
+		// moving the positions instead.
+		b2Vec2 point = p - distance * normal;
+		b2Vec2 relative = b2Vec2(m_vx[i], m_vy[i]) - body->GetLinearVelocityFromWorldPoint(point);
+		float32 vn = b2Dot(relative, normal);
+		float32 vnMin = b2Min(0.0f, (m_radius - distance) * step.inv_dt);
+		if (vn >= vnMin)
+		{
+			continue;
+		}
+
+		b2Vec2 tangent = relative - vn * normal;
+		float32 vt = tangent.Normalize();
+
+		float32 bodyInvMassN = 0.0f, bodyInvMassT = 0.0f;
+		bool dynamic = body->GetType() == b2_dynamicBody;
+		if (dynamic)
+		{
+			b2Vec2 r = point - body->m_sweep.c;
+			float32 rn = b2Cross(r, normal);
+			float32 rt = b2Cross(r, tangent);
+			bodyInvMassN = body->m_invMass + body->m_invI * rn * rn;
+			bodyInvMassT = body->m_invMass + body->m_invI * rt * rt;
+		}
+
+		float32 jn = (vnMin - vn) / (invMass + bodyInvMassN);
+		float32 jt = b2Min(vt / (invMass + bodyInvMassT), m_friction * jn);
+		b2Vec2 impulse = jn * normal - jt * tangent;
+
+		m_vx[i] += invMass * impulse.x;
+		m_vy[i] += invMass * impulse.y;
+
+		if (dynamic)
+		{
+			body->ApplyLinearImpulse(-impulse, point);
+		}
+	}
+}
+
+// Move the predicted positions out of the fixtures. The dynamic bodies take
+// the momentum the moves give the particles, which carries the pressure of
+// the fluid and makes light bodies float.
+void b2ParticleSystem::ProjectContacts()
+{
+	float32 impulseScale = GetParticleMass() * m_inv_dt;
+
+	for (int32 c = 0; c < m_contactCount; ++c)
+	{
+		int32 i = m_contacts[c].index;
+		b2Fixture* fixture = m_contacts[c].fixture;
+
+		float32 distance;
+		b2Vec2 normal;
+		b2Vec2 p(m_px[i], m_py[i]);
+		b2ComputeParticleDistance(fixture, p, &distance, &normal);
+		if (distance >= m_radius)
+		{
+			continue;
+		}
+
+		float32 push = m_radius - distance;
+		m_px[i] += push * normal.x;
+		m_py[i] += push * normal.y;
+
+		b2Body* body = fixture->GetBody();
+		if (body->GetType() == b2_dynamicBody)
+		{
+			body->ApplyLinearImpulse(-(impulseScale * push) * normal, p - distance * normal);
+		}
+	}
+}
+
+// Find the neighbors from the predicted positions. When a particle has too
+// many, the closest are kept.
+void b2ParticleSystem::FindNeighbors(int32 begin, int32 end)
+{
+	float32 h2 = m_h * m_h;
+	float32 distances[b2_maxParticleNeighbors];
+
+	for (int32 i = begin; i < end; ++i)
+	{
+		float32 xi = m_px[i], yi = m_py[i];
+		int32 keys[9];
+		int32 keyCount = GetCellKeys(b2CellCoordinate(xi, m_inv_h), b2CellCoordinate(yi, m_inv_h), keys);
+
+		int32* neighbors = m_neighbors + i * b2_maxParticleNeighbors;
+		int32 count = 0;
+		for (int32 k = 0; k < keyCount; ++k)
+		{
+			int32 cellEnd = m_cellStart[keys[k] + 1];
+			for (int32 s = m_cellStart[keys[k]]; s < cellEnd; ++s)
+			{
+				int32 j = m_cellIndices[s];
+				float32 dx = m_px[j] - xi, dy = m_py[j] - yi;
+				float32 r2 = dx * dx + dy * dy;
+				if (j == i || r2 >= h2)
+				{
+					continue;
+				}
+
+				if (count < b2_maxParticleNeighbors)
+				{
+					neighbors[count] = j;
+					distances[count] = r2;
+					++count;
+					continue;
+				}
+
+				int32 farthest = 0;
+				for (int32 n = 1; n < count; ++n)
+				{
+					farthest = distances[n] > distances[farthest] ? n : farthest;
+				}
+
+				if (r2 < distances[farthest])
+				{
+					neighbors[farthest] = j;
+					distances[farthest] = r2;
+				}
+			}
+		}
+
+		m_neighborCount[i] = count;
+	}
+}
+
+// The density constraint of each particle and its scaling factor.
+void b2ParticleSystem::ComputeLambda(int32 begin, int32 end)
+{
+	float32 h2 = m_h * m_h;
+	float32 selfDensity = m_poly6 * h2 * h2 * h2;
+
+	for (int32 i = begin; i < end; ++i)
+	{
+		const int32* neighbors = m_neighbors + i * b2_maxParticleNeighbors;
+		int32 count = m_neighborCount[i];
+		float32 xi = m_px[i], yi = m_py[i];
+
+		float32 density = selfDensity;
+		float32 gx = 0.0f, gy = 0.0f, sum = 0.0f;
+		for (int32 n = 0; n < count; ++n)
+		{
+			int32 j = neighbors[n];
+			float32 rx = xi - m_px[j], ry = yi - m_py[j];
+			float32 r2 = rx * rx + ry * ry;
+			if (r2 >= h2)
+			{
+				continue;
+			}
+
+			float32 w = h2 - r2;
+			density += m_poly6 * w * w * w;
+
+			float32 r = b2Sqrt(r2);
+			if (r < b2_epsilon)
+			{
+				continue;
+			}
+
+			float32 g = m_h - r;
+			g = m_spiky * g * g / r * m_inv_restDensity;
+			gx += g * rx;
+			gy += g * ry;
+			sum += g * g * r2;
+		}
+
+		float32 constraint = density * m_inv_restDensity - 1.0f;
+		if (m_granular)
+		{
+			constraint = b2Max(constraint, 0.0f);
+		}
+
+		sum += gx * gx + gy * gy;
+		m_lambda[i] = -constraint / (sum + m_epsilon);
+	}
+}
+
+// The moves satisfying the density constraints.
+void b2ParticleSystem::ComputeDelta(int32 begin, int32 end)
+{
+	float32 h2 = m_h * m_h;
+
+	for (int32 i = begin; i < end; ++i)
+	{
+		const int32* neighbors = m_neighbors + i * b2_maxParticleNeighbors;
+		int32 count = m_neighborCount[i];
+		float32 xi = m_px[i], yi = m_py[i], lambda = m_lambda[i];
+
+		float32 dx = 0.0f, dy = 0.0f;
+		for (int32 n = 0; n < count; ++n)
+		{
+			int32 j = neighbors[n];
+			float32 rx = xi - m_px[j], ry = yi - m_py[j];
+			float32 r2 = rx * rx + ry * ry;
+			if (r2 >= h2 || r2 < b2_epsilon * b2_epsilon)
+			{
+				continue;
+			}
+
+			float32 w = h2 - r2;
+			float32 correction = m_poly6 * w * w * w * m_inv_correctionKernel;
+			correction *= correction;
+			correction = m_correctionScale * correction * correction;
+
+			float32 r = b2Sqrt(r2);
+			float32 g = m_h - r;
+			g = m_spiky * g * g / r;
+
+			float32 s = (lambda + m_lambda[j] + correction) * g;
+			dx += s * rx;
+			dy += s * ry;
+		}
+
+		m_dx[i] = dx * m_inv_restDensity;
+		m_dy[i] = dy * m_inv_restDensity;
+	}
+}
+
+// Smooth the velocities with those of the neighbors.
+void b2ParticleSystem::ComputeViscosity(int32 begin, int32 end)
+{
+	float32 h2 = m_h * m_h;
+	float32 scale = m_viscosity * m_poly6 * m_inv_restDensity;
+
+	for (int32 i = begin; i < end; ++i)
+	{
+		const int32* neighbors = m_neighbors + i * b2_maxParticleNeighbors;
+		int32 count = m_neighborCount[i];
+		float32 xi = m_px[i], yi = m_py[i], vxi = m_vx[i], vyi = m_vy[i];
+
+		float32 dvx = 0.0f, dvy = 0.0f;
+		for (int32 n = 0; n < count; ++n)
+		{
+			int32 j = neighbors[n];
+			float32 rx = xi - m_px[j], ry = yi - m_py[j];
+			float32 w = b2Max(h2 - rx * rx - ry * ry, 0.0f);
+			w = w * w * w;
+			dvx += (m_vx[j] - vxi) * w;
+			dvy += (m_vy[j] - vyi) * w;
+		}
+
+		m_dx[i] = scale * dvx;
+		m_dy[i] = scale * dvy;
+	}
+}
+
+void b2ParticleSystem::Execute(Stage stage, int32 begin, int32 end)
+{
+	// The simple stages are plain loops over the coordinate arrays, which
+	// compilers vectorize.
+	switch (stage)
+	{
+	case e_findNeighbors:
+		FindNeighbors(begin, end);
+		break;
+
+	case e_computeLambda:
+		ComputeLambda(begin, end);
+		break;
+
+	case e_computeDelta:
+		ComputeDelta(begin, end);
+		break;
+
+	case e_applyDelta:
+		for (int32 i = begin; i < end; ++i)
+		{
+			m_px[i] += m_dx[i];
+			m_py[i] += m_dy[i];
+		}
+		break;
+
+	case e_updateVelocity:
+		for (int32 i = begin; i < end; ++i)
+		{
+			m_vx[i] = (m_px[i] - m_x[i]) * m_inv_dt;
+			m_vy[i] = (m_py[i] - m_y[i]) * m_inv_dt;
+		}
+		break;
+
+	case e_computeViscosity:
+		ComputeViscosity(begin, end);
+		break;
+
+	case e_finish:
+		if (m_viscosity > 0.0f)
+		{
+			for (int32 i = begin; i < end; ++i)
+			{
+				m_vx[i] += m_dx[i];
+				m_vy[i] += m_dy[i];
+			}
+		}
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			m_x[i] = m_px[i];
+			m_y[i] = m_py[i];
+		}
+		break;
+	}
+}
+
+void b2ParticleSystem::Run(Stage stage)
+{
+	b2ParticleTask task;
+	task.m_system = this;
+	task.m_stage = stage;
+
+	if (m_taskScheduler->GetThreadCount() > 1 && m_count > b2_particleTaskRange)
+	{
+		m_taskScheduler->Run(&task, m_count, b2_particleTaskRange);
+	}
+	else
+	{
+		task.Execute(0, m_count, 0);
+	}
+}
+
+// Each stage reads the results of the previous one, so the stages run one
+// after the other and the particles of a stage in parallel. The contacts
+// with fixtures are solved serially, they are few and move the bodies.
+void b2ParticleSystem::Solve(const b2TimeStep& step, const b2Vec2& gravity)
+{
+	if (m_count == 0)
+	{
+		return;
+	}
+
+	m_taskScheduler = m_world->GetTaskScheduler();
+	m_inv_dt = step.inv_dt;
+
+	float32 gx = step.dt * m_gravityScale * gravity.x;
+	float32 gy = step.dt * m_gravityScale * gravity.y;
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_vx[i] += gx;
+		m_vy[i] += gy;
+	}
+
+	BuildGrid(m_x, m_y);
+	FindContacts();
+	SolveContacts(step);
+
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_px[i] = m_x[i] + step.dt * m_vx[i];
+		m_py[i] = m_y[i] + step.dt * m_vy[i];
+	}
+
+	BuildGrid(m_px, m_py);
+	Run(e_findNeighbors);
+
+	for (int32 i = 0; i < m_iterations; ++i)
+	{
+		Run(e_computeLambda);
+		Run(e_computeDelta);
+		Run(e_applyDelta);
+		ProjectContacts();
+	}
+
+	Run(e_updateVelocity);
+	if (m_viscosity > 0.0f)
+	{
+		Run(e_computeViscosity);
+	}
+	Run(e_finish);
+}
@@ -0,0 +1,327 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_PARTICLE_SYSTEM_H
+#define B2_PARTICLE_SYSTEM_H
+
+#include <Box2D/Common/b2Math.h>
+
+class b2Body;
+class b2Fixture;
+class b2World;
+class b2TaskScheduler;
+struct b2TimeStep;
+
+/// Particle system definitions are used to construct particle systems.
+struct b2ParticleSystemDef
+{
+	b2ParticleSystemDef()
+	{
+		userData = NULL;
+		radius = 0.05f;
+		density = 1.0f;
+		granular = false;
+		iterations = 4;
+		relaxation = 0.1f;
+		viscosity = 0.05f;
+		surfaceTension = 0.05f;
+		friction = 0.2f;
+		gravityScale = 1.0f;
+		maskBits = 0xFFFF;
+	}
+
+	/// Use this to attach application specific data to your particle systems.
+	void* userData;
+
+	/// The radius of the particles. The particles of a system at rest are
+	/// about two radii apart.
+	float32 radius;
+
+	/// The density of the particles, usually in kg/m^2. A particle weighs as
+	/// much as a square of the side of its diameter.
+	float32 density;
+
+	/// Granular particles push each other apart but do not pull each other
+	/// together, like sand instead of a liquid.
+	bool granular;
+
+	/// The number of density constraint iterations per time step.
+	int32 iterations;
+
+	/// Softens the density constraints, usually in the range [0,1]. Higher
+	/// values make the fluid more compressible and the iterations stabler.
+	float32 relaxation;
+
+	/// The amount of velocity shared with the neighbors, usually in the range
+	/// [0,1].
+	float32 viscosity;
+
+	/// Keeps the particles from clustering, and with it from forming strings,
+	/// usually in the range [0,0.2]. Has no effect on granular particles.
+	float32 surfaceTension;
+
+	/// The friction of the particles against fixtures, usually in the range
+	/// [0,1].
+	float32 friction;
+
+	/// Scales the gravity of the world for the particles.
+	float32 gravityScale;
+
+	/// The categories of the fixtures the particles collide with, see b2Filter.
+	uint16 maskBits;
+};
+
+/// A fluid of many small circles, solved with position based dynamics: the
+/// positions of the particles are predicted, moved until the density around
+/// each of them is the rest density and the velocities follow from the moves.
+/// The particles are not bodies. They are kept in arrays of the system, by
+/// index, and found through a grid of their own instead of the broad-phase.
+/// They collide with the fixtures of the world and push the dynamic bodies
+/// back, but not with other particle systems.
+class b2ParticleSystem
+{
+public:
+
+	/// Create a particle.
+	/// @return the index of the particle, the particle count before the call,
+	/// or -1 when the world is locked.
+	/// @warning This function is locked during callbacks.
+	int32 CreateParticle(const b2Vec2& position, const b2Vec2& velocity);
+
+	/// Destroy a range of particles. The particles after them keep their
+	/// order and their indices are lowered by the count.
+	/// @warning This function is locked during callbacks.
+	void DestroyParticles(int32 first, int32 count);
+
+	/// Get the number of particles.
+	int32 GetParticleCount() const;
+
+	/// Get/set the position of a particle.
+	b2Vec2 GetPosition(int32 index) const;
+	void SetPosition(int32 index, const b2Vec2& position);
+
+	/// Get/set the velocity of a particle.
+	b2Vec2 GetVelocity(int32 index) const;
+	void SetVelocity(int32 index, const b2Vec2& velocity);
+
+	/// Get the coordinates of all the particles, in arrays of
+	/// GetParticleCount elements. The arrays move when particles are created.
+	const float32* GetPositionXBuffer() const;
+	const float32* GetPositionYBuffer() const;
+
+	/// Get the radius of the particles.
+	float32 GetRadius() const;
+
+	/// Get the mass of one particle.
+	float32 GetParticleMass() const;
+
+	/// Are the particles granular?
+	bool IsGranular() const;
+
+	/// Get the next particle system in the world particle system list.
+	b2ParticleSystem* GetNext();
+
+	/// Get the user data pointer.
+	void* GetUserData() const;
+
+	/// Set the user data pointer.
+	void SetUserData(void* data);
+
+private:
+	friend class b2World;
+	friend class b2ParticleTask;
+	friend class b2ParticleQueryCallback;
+
+	enum Stage
+	{
+		e_findNeighbors,
+		e_computeLambda,
+		e_computeDelta,
+		e_applyDelta,
+		e_updateVelocity,
+		e_computeViscosity,
+		e_finish
+	};
+
+	// A particle close to a fixture during a time step.
+	struct Contact
+	{
+		int32 index;
+		b2Fixture* fixture;
+	};
+
+	b2ParticleSystem(const b2ParticleSystemDef* def, b2World* world);
+	~b2ParticleSystem();
+
+	void Reserve(int32 capacity);
+
+	void BuildGrid(const float32* x, const float32* y);
+	int32 GetCellKeys(int32 cx, int32 cy, int32* keys) const;
+	void FindContacts();
+	void SolveContacts(const b2TimeStep& step);
+	void ProjectContacts();
+
+	void FindNeighbors(int32 begin, int32 end);
+	void ComputeLambda(int32 begin, int32 end);
+	void ComputeDelta(int32 begin, int32 end);
+	void ComputeViscosity(int32 begin, int32 end);
+
+	void Solve(const b2TimeStep& step, const b2Vec2& gravity);
+	void Run(Stage stage);
+	void Execute(Stage stage, int32 begin, int32 end);
+
+	b2World* m_world;
+	b2TaskScheduler* m_taskScheduler;
+
+	float32 m_radius;
+	float32 m_density;
+	bool m_granular;
+	int32 m_iterations;
+	float32 m_viscosity;
+	float32 m_surfaceTension;
+	float32 m_friction;
+	float32 m_gravityScale;
+	uint16 m_maskBits;
+
+	// The kernels and their values at rest, see the constructor.
+	float32 m_h;
+	float32 m_inv_h;
+	float32 m_poly6;
+	float32 m_spiky;
+	float32 m_inv_restDensity;
+	float32 m_epsilon;
+	float32 m_correctionScale;
+	float32 m_inv_correctionKernel;
+	float32 m_inv_dt;
+
+	int32 m_count;
+	int32 m_capacity;
+
+	// The particles, one array per coordinate.
+	float32* m_x;
+	float32* m_y;
+	float32* m_vx;
+	float32* m_vy;
+
+	// Scratch arrays of a time step.
+	float32* m_px;
+	float32* m_py;
+	float32* m_lambda;
+	float32* m_dx;
+	float32* m_dy;
+
+	// The neighbors of particle i are the m_neighborCount[i] first elements
+	// of m_neighbors + i * b2_maxParticleNeighbors.
+	int32* m_neighborCount;
+	int32* m_neighbors;
+
+	// The grid is a hash table of cells of the size of the kernel. The
+	// particles are sorted by cell and the particles of the cell with key k
+	// are m_cellIndices[m_cellStart[k]] to m_cellIndices[m_cellStart[k + 1] - 1].
+	int32* m_cellKeys;
+	int32* m_cellIndices;
+	int32* m_cellStart;
+	int32 m_cellMask;
+	int32* m_stamps;
+
+	b2Fixture** m_fixtures;
+	int32 m_fixtureCount;
+	int32 m_fixtureCapacity;
+	Contact* m_contacts;
+	int32 m_contactCount;
+	int32 m_contactCapacity;
+
+	b2ParticleSystem* m_prev;
+	b2ParticleSystem* m_next;
+
+	void* m_userData;
+};
+
+inline int32 b2ParticleSystem::GetParticleCount() const
+{
+	return m_count;
+}
+
+inline b2Vec2 b2ParticleSystem::GetPosition(int32 index) const
+{
+	b2Assert(0 <= index && index < m_count);
+	return b2Vec2(m_x[index], m_y[index]);
+}
+
+inline void b2ParticleSystem::SetPosition(int32 index, const b2Vec2& position)
+{
+	b2Assert(0 <= index && index < m_count);
+	m_x[index] = position.x;
+	m_y[index] = position.y;
+}
+
+inline b2Vec2 b2ParticleSystem::GetVelocity(int32 index) const
+{
+	b2Assert(0 <= index && index < m_count);
+	return b2Vec2(m_vx[index], m_vy[index]);
+}
+
+inline void b2ParticleSystem::SetVelocity(int32 index, const b2Vec2& velocity)
+{
+	b2Assert(0 <= index && index < m_count);
+	m_vx[index] = velocity.x;
+	m_vy[index] = velocity.y;
+}
+
+inline const float32* b2ParticleSystem::GetPositionXBuffer() const
+{
+	return m_x;
+}
+
+inline const float32* b2ParticleSystem::GetPositionYBuffer() const
+{
+	return m_y;
+}
+
+inline float32 b2ParticleSystem::GetRadius() const
+{
+	return m_radius;
+}
+
+inline float32 b2ParticleSystem::GetParticleMass() const
+{
+	float32 diameter = 2.0f * m_radius;
+	return m_density * diameter * diameter;
+}
+
+inline bool b2ParticleSystem::IsGranular() const
+{
+	return m_granular;
+}
+
+inline b2ParticleSystem* b2ParticleSystem::GetNext()
+{
+	return m_next;
+}
+
+inline void* b2ParticleSystem::GetUserData() const
+{
+	return m_userData;
+}
+
+inline void b2ParticleSystem::SetUserData(void* data)
+{
+	m_userData = data;
+}
+
+#endif
@@ -65,7 +65,9 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 	m_sweep.c0 = m_sweep.c = b2Mul(m_xf, m_sweep.localCenter);
 
 	m_jointList = NULL;
-	m_contactList = NULL;
+	m_contactEdges = NULL;
+	m_contactCount = 0;
+	m_contactCapacity = 0;
 	m_prev = NULL;
 	m_next = NULL;
 
@@ -80,6 +82,10 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 
 	m_sleepTime = 0.0f;
 
+	m_stepInterval = 1;
+	m_stepsPending = 0;
+	m_stepsSolved = 1;
+
 	m_type = bd->type;
 
 	if (m_type == b2_dynamicBody)
@@ -130,9 +136,9 @@ void b2Body::SetType(b2BodyType type)
 	m_torque = 0.0f;
 
 	// Since the body type changed, we need to flag contacts for filtering.
-	for (b2ContactEdge* ce = m_contactList; ce; ce = ce->next)
+	for (int32 i = 0; i < m_contactCount; ++i)
 	{
-		ce->contact->FlagForFiltering();
+		m_contactEdges[i].contact->FlagForFiltering();
 	}
 }
 
@@ -149,6 +155,7 @@ b2Fixture* b2Body::CreateFixture(const b2FixtureDef* def)
 	void* memory = allocator->Allocate(sizeof(b2Fixture));
 	b2Fixture* fixture = new (memory) b2Fixture;
 	fixture->Create(allocator, this, def);
+	fixture->m_generation = ++m_world->m_fixtureGeneration;
 
 	if (m_flags & e_activeFlag)
 	{
@@ -214,21 +221,23 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 	b2Assert(found);
 
 	// Destroy any contacts associated with the fixture.
-	b2ContactEdge* edge = m_contactList;
-	while (edge)
+	int32 i = 0;
+	while (i < m_contactCount)
 	{
-		b2Contact* c = edge->contact;
-		edge = edge->next;
+		b2Contact* c = m_contactEdges[i].contact;
 
 		b2Fixture* fixtureA = c->GetFixtureA();
 		b2Fixture* fixtureB = c->GetFixtureB();
 
 		if (fixture == fixtureA || fixture == fixtureB)
 		{
-			// This destroys the contact and removes it from
-			// this body's contact list.
+			// This destroys the contact and moves the last edge of
+			// this body in its place.
 			m_world->m_contactManager.Destroy(c);
+			continue;
 		}
+
+		++i;
 	}
 
 	b2BlockAllocator* allocator = &m_world->m_blockAllocator;
@@ -237,6 +246,7 @@ void b2Body::DestroyFixture(b2Fixture* fixture)
 	{
 		b2Assert(fixture->m_proxyId != b2BroadPhase::e_nullProxy);
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
+		m_world->RemoveSensorOverlaps(fixture);
 		fixture->DestroyProxy(broadPhase);
 	}
 	else
@@ -454,17 +464,14 @@ void b2Body::SetActive(bool flag)
 		b2BroadPhase* broadPhase = &m_world->m_contactManager.m_broadPhase;
 		for (b2Fixture* f = m_fixtureList; f; f = f->m_next)
 		{
+			m_world->RemoveSensorOverlaps(f);
 			f->DestroyProxy(broadPhase);
 		}
 
 		// Destroy the attached contacts.
-		b2ContactEdge* ce = m_contactList;
-		while (ce)
+		while (m_contactCount > 0)
 		{
-			b2ContactEdge* ce0 = ce;
-			ce = ce->next;
-			m_world->m_contactManager.Destroy(ce0->contact);
+			m_world->m_contactManager.Destroy(m_contactEdges[m_contactCount - 1].contact);
 		}
-		m_contactList = NULL;
 	}
 }
\ No newline at end of file
@@ -309,6 +309,17 @@ public:
 	/// @return true if the body is sleeping.
 	bool IsAwake() const;
 
+	/// Step this body only every so many time steps, using a time step that
+	/// many times longer. Islands are stepped at the rate of their most often
+	/// stepped body. Lowering the interval catches up the missed time at the
+	/// next step. Use this for bodies that need less accuracy, such as ones
+	/// that are off-screen.
+	/// @param interval the number of time steps, 1 to step every time.
+	void SetStepInterval(int32 interval);
+
+	/// Get the number of time steps between steps of this body.
+	int32 GetStepInterval() const;
+
 	/// Set the active state of the body. An inactive body is not
 	/// simulated and cannot be collided with or woken up.
 	/// If you pass a flag of true, all fixtures will be added to the
@@ -342,11 +353,15 @@ public:
 	b2JointEdge* GetJointList();
 	const b2JointEdge* GetJointList() const;
 
-	/// Get the list of all contacts attached to this body.
-	/// @warning this list changes during the time step and you may
+	/// Get the number of contacts attached to this body.
+	int32 GetContactCount() const;
+
+	/// Get the array of the edges of all contacts attached to this body,
+	/// see GetContactCount.
+	/// @warning this array changes during the time step and you may
 	/// miss some collisions if you don't use b2ContactListener.
-	b2ContactEdge* GetContactList();
-	const b2ContactEdge* GetContactList() const;
+	b2ContactEdge* GetContactEdges();
+	const b2ContactEdge* GetContactEdges() const;
 
 	/// Get the next body in the world's body list.
 	b2Body* GetNext();
@@ -369,6 +384,10 @@ private:
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
 	friend class b2TOISolver;
+	friend class b2JointTreeSolver;
+	friend class b2SoftContactSolver;
+	friend class b2Controller;
+	friend class b2ParticleSystem;
 	
 	friend class b2DistanceJoint;
 	friend class b2GearJoint;
@@ -390,6 +409,7 @@ private:
 		e_fixedRotationFlag	= 0x0010,
 		e_activeFlag		= 0x0020,
 		e_toiFlag			= 0x0040,
+		e_controllerFlag	= 0x0080,
 	};
 
 	b2Body(const b2BodyDef* bd, b2World* world);
@@ -404,6 +424,9 @@ private:
 
 	void Advance(float32 t);
 
+	// Is this body stepped in the current time step?
+	bool IsStepDue() const;
+
 	b2BodyType m_type;
 
 	uint16 m_flags;
@@ -427,7 +450,11 @@ private:
 	int32 m_fixtureCount;
 
 	b2JointEdge* m_jointList;
-	b2ContactEdge* m_contactList;
+
+	// Edges of the contacts, allocated from the world's block allocator.
+	b2ContactEdge* m_contactEdges;
+	int32 m_contactCount;
+	int32 m_contactCapacity;
 
 	float32 m_mass, m_invMass;
 
@@ -439,6 +466,10 @@ private:
 
 	float32 m_sleepTime;
 
+	int32 m_stepInterval;
+	int32 m_stepsPending;	// time steps missed since the last step
+	int32 m_stepsSolved;	// time steps covered by the last step
+
 	void* m_userData;
 };
 
@@ -610,6 +641,7 @@ inline void b2Body::SetAwake(bool flag)
 	{
 		m_flags &= ~e_awakeFlag;
 		m_sleepTime = 0.0f;
+		m_stepsPending = 0;
 		m_linearVelocity.SetZero();
 		m_angularVelocity = 0.0f;
 		m_force.SetZero();
@@ -622,6 +654,22 @@ inline bool b2Body::IsAwake() const
 	return (m_flags & e_awakeFlag) == e_awakeFlag;
 }
 
+inline void b2Body::SetStepInterval(int32 interval)
+{
+	b2Assert(interval >= 1);
+	m_stepInterval = interval;
+}
+
+inline int32 b2Body::GetStepInterval() const
+{
+	return m_stepInterval;
+}
+
+inline bool b2Body::IsStepDue() const
+{
+	return m_type != b2_staticBody && m_stepsPending + 1 >= m_stepInterval;
+}
+
 inline bool b2Body::IsActive() const
 {
 	return (m_flags & e_activeFlag) == e_activeFlag;
@@ -684,14 +732,19 @@ inline const b2JointEdge* b2Body::GetJointList() const
 	return m_jointList;
 }
 
-inline b2ContactEdge* b2Body::GetContactList()
+inline int32 b2Body::GetContactCount() const
+{
+	return m_contactCount;
+}
+
+inline b2ContactEdge* b2Body::GetContactEdges()
 {
-	return m_contactList;
+	return m_contactEdges;
 }
 
-inline const b2ContactEdge* b2Body::GetContactList() const
+inline const b2ContactEdge* b2Body::GetContactEdges() const
 {
-	return m_contactList;
+	return m_contactEdges;
 }
 
 inline b2Body* b2Body::GetNext()
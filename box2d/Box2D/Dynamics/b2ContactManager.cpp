@@ -21,17 +21,144 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/Contacts/b2CircleContact.h>
+#include <Box2D/Dynamics/Contacts/b2PolygonAndCircleContact.h>
+#include <Box2D/Dynamics/Contacts/b2PolygonContact.h>
+#include <Box2D/Common/b2BlockAllocator.h>
+#include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2TaskScheduler.h>
+
+#include <new>
+#include <cstring>
 
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
 
+// The default filter is tested inline, without the virtual call.
+static inline bool b2ShouldCollide(b2ContactFilter* filter, b2Fixture* fixtureA, b2Fixture* fixtureB)
+{
+	if (filter == &b2_defaultFilter)
+	{
+		return b2ShouldCollide(fixtureA->GetFilterData(), fixtureB->GetFilterData());
+	}
+
+	return filter == NULL || filter->ShouldCollide(fixtureA, fixtureB);
+}
+
+struct b2ContactUpdate
+{
+	b2Contact* contact;
+	b2Manifold oldManifold;
+	bool touching;
+};
+
+// The narrow-phase is run in one batch per type of contact, so the manifolds
+// of a batch are computed by the same collide function without virtual calls.
+enum b2ContactBatch
+{
+	e_circleBatch,
+	e_polygonAndCircleBatch,
+	e_polygonBatch,
+	e_otherBatch,	// sensors, computed through Evaluate
+	e_batchCount
+};
+
+static inline int32 b2GetContactBatch(const b2Contact* c)
+{
+	const b2Fixture* fixtureA = c->GetFixtureA();
+	const b2Fixture* fixtureB = c->GetFixtureB();
+
+	if (fixtureA->IsSensor() || fixtureB->IsSensor())
+	{
+		return e_otherBatch;
+	}
+
+	// Contact creation puts the polygon first.
+	b2Shape::Type typeA = fixtureA->GetType();
+	b2Shape::Type typeB = fixtureB->GetType();
+	if (typeA == b2Shape::e_circle && typeB == b2Shape::e_circle)
+	{
+		return e_circleBatch;
+	}
+	if (typeA == b2Shape::e_polygon && typeB == b2Shape::e_circle)
+	{
+		return e_polygonAndCircleBatch;
+	}
+	if (typeA == b2Shape::e_polygon && typeB == b2Shape::e_polygon)
+	{
+		return e_polygonBatch;
+	}
+	return e_otherBatch;
+}
+
+// Computes the manifolds of a batch of persisting contacts of type T. Each
+// range only touches its own contacts, the results are reported serially
+// afterwards. The GJK queries of sensors are counted per thread.
+template <typename T>
+class b2CollideTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+
+		for (int32 i = begin; i < end; ++i)
+		{
+			b2ContactUpdate* update = m_updates + i;
+			update->touching = update->contact->UpdateManifold<T>(&update->oldManifold, m_reuse);
+		}
+	}
+
+	b2ContactUpdate* m_updates;
+	b2DistanceStats* m_stats;
+	bool m_reuse;
+};
+
+template <>
+void b2CollideTask<b2Contact>::Execute(int32 begin, int32 end, int32 threadIndex)
+{
+	for (int32 i = begin; i < end; ++i)
+	{
+		b2ContactUpdate* update = m_updates + i;
+		update->touching = update->contact->UpdateManifold(&update->oldManifold, m_stats + threadIndex);
+	}
+}
+
+template <typename T>
+static void b2CollideBatch(b2TaskScheduler* scheduler, b2DistanceStats* stats,
+						   b2ContactUpdate* updates, int32 count, bool reuse)
+{
+	b2CollideTask<T> task;
+	task.m_updates = updates;
+	task.m_stats = stats;
+	task.m_reuse = reuse;
+
+	if (scheduler && scheduler->GetThreadCount() > 1 && count > b2_collideTaskRange)
+	{
+		scheduler->Run(&task, count, b2_collideTaskRange);
+	}
+	else
+	{
+		task.Execute(0, count, 0);
+	}
+}
+
 b2ContactManager::b2ContactManager()
 {
-	m_contactList = NULL;
+	m_contactCapacity = 16;
 	m_contactCount = 0;
+	m_contacts = (b2Contact**)b2Alloc(m_contactCapacity * sizeof(b2Contact*));
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = NULL;
+	m_stackAllocator = NULL;
+	m_taskScheduler = NULL;
+	m_manifoldReuse = true;
+}
+
+b2ContactManager::~b2ContactManager()
+{
+	b2Free(m_contacts);
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -47,56 +174,97 @@ void b2ContactManager::Destroy(b2Contact* c)
 	}
 
 	// Remove from the world.
-	if (c->m_prev)
+	--m_contactCount;
+	if (c->m_index != m_contactCount)
 	{
-		c->m_prev->m_next = c->m_next;
+		b2Contact* last = m_contacts[m_contactCount];
+		m_contacts[c->m_index] = last;
+		last->m_index = c->m_index;
 	}
 
-	if (c->m_next)
-	{
-		c->m_next->m_prev = c->m_prev;
-	}
+	// Remove from the bodies.
+	RemoveEdge(bodyA, c->m_edgeA);
+	RemoveEdge(bodyB, c->m_edgeB);
+
+	// Call the factory.
+	b2Contact::Destroy(c, m_allocator);
+}
+
+// Edge arrays of bodies with many contacts are too big for the block allocator.
+static b2ContactEdge* b2AllocateEdges(b2BlockAllocator* allocator, int32 capacity)
+{
+	int32 size = capacity * sizeof(b2ContactEdge);
+	return (b2ContactEdge*)(size <= b2_maxBlockSize ? allocator->Allocate(size) : b2Alloc(size));
+}
 
-	if (c == m_contactList)
+static void b2FreeEdges(b2BlockAllocator* allocator, b2ContactEdge* edges, int32 capacity)
+{
+	int32 size = capacity * sizeof(b2ContactEdge);
+	if (size <= b2_maxBlockSize)
 	{
-		m_contactList = c->m_next;
+		allocator->Free(edges, size);
 	}
-
-	// Remove from body 1
-	if (c->m_nodeA.prev)
+	else
 	{
-		c->m_nodeA.prev->next = c->m_nodeA.next;
+		b2Free(edges);
 	}
+}
 
-	if (c->m_nodeA.next)
+int32 b2ContactManager::AddEdge(b2Body* body, b2Contact* c, b2Body* other)
+{
+	if (body->m_contactCount == body->m_contactCapacity)
 	{
-		c->m_nodeA.next->prev = c->m_nodeA.prev;
+		b2ContactEdge* oldEdges = body->m_contactEdges;
+		int32 oldCapacity = body->m_contactCapacity;
+		body->m_contactCapacity = b2Max(4, 2 * oldCapacity);
+		body->m_contactEdges = b2AllocateEdges(m_allocator, body->m_contactCapacity);
+		if (oldEdges)
+		{
+			memcpy(body->m_contactEdges, oldEdges, body->m_contactCount * sizeof(b2ContactEdge));
+			b2FreeEdges(m_allocator, oldEdges, oldCapacity);
+		}
 	}
 
-	if (&c->m_nodeA == bodyA->m_contactList)
+	int32 index = body->m_contactCount++;
+	body->m_contactEdges[index].other = other;
+	body->m_contactEdges[index].contact = c;
+	return index;
+}
+
+void b2ContactManager::FreeEdges(b2Body* body)
+{
+	b2Assert(body->m_contactCount == 0);
+
+	if (body->m_contactEdges)
 	{
-		bodyA->m_contactList = c->m_nodeA.next;
+		b2FreeEdges(m_allocator, body->m_contactEdges, body->m_contactCapacity);
+		body->m_contactEdges = NULL;
+		body->m_contactCapacity = 0;
 	}
+}
 
-	// Remove from body 2
-	if (c->m_nodeB.prev)
+void b2ContactManager::RemoveEdge(b2Body* body, int32 index)
+{
+	b2Assert(0 <= index && index < body->m_contactCount);
+
+	--body->m_contactCount;
+	if (index == body->m_contactCount)
 	{
-		c->m_nodeB.prev->next = c->m_nodeB.next;
+		return;
 	}
 
-	if (c->m_nodeB.next)
+	b2ContactEdge* edge = body->m_contactEdges + index;
+	*edge = body->m_contactEdges[body->m_contactCount];
+
+	// Bodies don't have contacts with themselves, so the side is unambiguous.
+	if (edge->contact->GetFixtureA()->GetBody() == body)
 	{
-		c->m_nodeB.next->prev = c->m_nodeB.prev;
+		edge->contact->m_edgeA = index;
 	}
-
-	if (&c->m_nodeB == bodyB->m_contactList)
+	else
 	{
-		bodyB->m_contactList = c->m_nodeB.next;
+		edge->contact->m_edgeB = index;
 	}
-
-	// Call the factory.
-	b2Contact::Destroy(c, m_allocator);
-	--m_contactCount;
 }
 
 // This is the top level collision call for the time step. Here
@@ -104,10 +272,21 @@ void b2ContactManager::Destroy(b2Contact* c)
 // contact list.
 void b2ContactManager::Collide()
 {
-	// Update awake contacts.
-	b2Contact* c = m_contactList;
-	while (c)
+	// The narrow-phase is deferred until the contacts have been pruned.
+	// Bodies woken by a new touch are then only seen by the contacts of the
+	// next step.
+	// The stack allocator doesn't align, so the int32 slots come last.
+	b2ContactUpdate* updates = (b2ContactUpdate*)m_stackAllocator->Allocate(m_contactCount * sizeof(b2ContactUpdate));
+	b2ContactUpdate* batched = (b2ContactUpdate*)m_stackAllocator->Allocate(m_contactCount * sizeof(b2ContactUpdate));
+	int32* slots = (int32*)m_stackAllocator->Allocate(m_contactCount * sizeof(int32));
+	int32 batchCounts[e_batchCount] = { 0 };
+	int32 updateCount = 0;
+
+	// Update awake contacts. Destroying a contact moves the last one to index i.
+	int32 i = 0;
+	while (i < m_contactCount)
 	{
+		b2Contact* c = m_contacts[i];
 		b2Fixture* fixtureA = c->GetFixtureA();
 		b2Fixture* fixtureB = c->GetFixtureB();
 		b2Body* bodyA = fixtureA->GetBody();
@@ -115,7 +294,14 @@ void b2ContactManager::Collide()
 
 		if (bodyA->IsAwake() == false && bodyB->IsAwake() == false)
 		{
-			c = c->GetNext();
+			++i;
+			continue;
+		}
+
+		// Bodies waiting for their step don't move until then.
+		if (bodyA->IsStepDue() == false && bodyB->IsStepDue() == false)
+		{
+			++i;
 			continue;
 		}
 
@@ -125,18 +311,14 @@ void b2ContactManager::Collide()
 			// Should these bodies collide?
 			if (bodyB->ShouldCollide(bodyA) == false)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
+				Destroy(c);
 				continue;
 			}
 
 			// Check user filtering.
-			if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
+			if (b2ShouldCollide(m_contactFilter, fixtureA, fixtureB) == false)
 			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
+				Destroy(c);
 				continue;
 			}
 
@@ -151,16 +333,67 @@ void b2ContactManager::Collide()
 		// Here we destroy contacts that cease to overlap in the broad-phase.
 		if (overlap == false)
 		{
-			b2Contact* cNuke = c;
-			c = cNuke->GetNext();
-			Destroy(cNuke);
+			Destroy(c);
 			continue;
 		}
 
-		// The contact persists.
-		c->Update(m_contactListener);
-		c = c->GetNext();
+		// The contact persists, remember it in array order with its batch.
+		int32 batch = b2GetContactBatch(c);
+		++batchCounts[batch];
+		updates[updateCount].contact = c;
+		slots[updateCount] = batch;
+		++updateCount;
+
+		++i;
 	}
+
+	// Sort the contacts by batch. The array order is kept in the slots.
+	int32 batchStarts[e_batchCount];
+	int32 batchEnds[e_batchCount];
+	int32 start = 0;
+	for (i = 0; i < e_batchCount; ++i)
+	{
+		batchStarts[i] = start;
+		batchEnds[i] = start;
+		start += batchCounts[i];
+	}
+
+	for (i = 0; i < updateCount; ++i)
+	{
+		int32 slot = batchEnds[slots[i]]++;
+		batched[slot].contact = updates[i].contact;
+		slots[i] = slot;
+	}
+
+	int32 threadCount = m_taskScheduler ? m_taskScheduler->GetThreadCount() : 1;
+	b2DistanceStats* stats = (b2DistanceStats*)m_stackAllocator->Allocate(threadCount * sizeof(b2DistanceStats));
+	for (i = 0; i < threadCount; ++i)
+	{
+		new (stats + i) b2DistanceStats;
+	}
+
+	b2CollideBatch<b2CircleContact>(m_taskScheduler, stats, batched + batchStarts[e_circleBatch], batchCounts[e_circleBatch], m_manifoldReuse);
+	b2CollideBatch<b2PolygonAndCircleContact>(m_taskScheduler, stats, batched + batchStarts[e_polygonAndCircleBatch], batchCounts[e_polygonAndCircleBatch], m_manifoldReuse);
+	b2CollideBatch<b2PolygonContact>(m_taskScheduler, stats, batched + batchStarts[e_polygonBatch], batchCounts[e_polygonBatch], m_manifoldReuse);
+	b2CollideBatch<b2Contact>(m_taskScheduler, stats, batched + batchStarts[e_otherBatch], batchCounts[e_otherBatch], false);
+
+	// The profiling globals are only written by this thread.
+	for (i = 0; i < threadCount; ++i)
+	{
+		b2AddDistanceStats(stats[i]);
+	}
+	m_stackAllocator->Free(stats);
+
+	// Report in array order so callbacks do not depend on the batches.
+	for (i = 0; i < updateCount; ++i)
+	{
+		b2ContactUpdate* update = batched + slots[i];
+		update->contact->ReportUpdate(update->touching, &update->oldManifold, m_contactListener);
+	}
+
+	m_stackAllocator->Free(slots);
+	m_stackAllocator->Free(batched);
+	m_stackAllocator->Free(updates);
 }
 
 void b2ContactManager::FindNewContacts()
@@ -182,10 +415,19 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 		return;
 	}
 
+	// The default filter is a bit test, so it goes before the search of the
+	// contacts of the body. A user filter is only asked about new pairs.
+	bool defaultFilter = m_contactFilter == &b2_defaultFilter;
+	if (defaultFilter && b2ShouldCollide(fixtureA->m_filter, fixtureB->m_filter) == false)
+	{
+		return;
+	}
+
 	// Does a contact already exist?
-	b2ContactEdge* edge = bodyB->GetContactList();
-	while (edge)
+	b2ContactEdge* edges = bodyB->GetContactEdges();
+	for (int32 i = 0; i < bodyB->GetContactCount(); ++i)
 	{
+		b2ContactEdge* edge = edges + i;
 		if (edge->other == bodyA)
 		{
 			b2Fixture* fA = edge->contact->GetFixtureA();
@@ -202,8 +444,6 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 				return;
 			}
 		}
-
-		edge = edge->next;
 	}
 
 	// Does a joint override collision? Is at least one body dynamic?
@@ -213,7 +453,7 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	}
 
 	// Check user filtering.
-	if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
+	if (defaultFilter == false && m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
 	{
 		return;
 	}
@@ -221,46 +461,30 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	// Call the factory.
 	b2Contact* c = b2Contact::Create(fixtureA, fixtureB, m_allocator);
 
+	Insert(c);
+}
+
+void b2ContactManager::Insert(b2Contact* c)
+{
 	// Contact creation may swap fixtures.
-	fixtureA = c->GetFixtureA();
-	fixtureB = c->GetFixtureB();
-	bodyA = fixtureA->GetBody();
-	bodyB = fixtureB->GetBody();
+	b2Body* bodyA = c->GetFixtureA()->GetBody();
+	b2Body* bodyB = c->GetFixtureB()->GetBody();
 
 	// Insert into the world.
-	c->m_prev = NULL;
-	c->m_next = m_contactList;
-	if (m_contactList != NULL)
-	{
-		m_contactList->m_prev = c;
-	}
-	m_contactList = c;
-
-	// Connect to island graph.
-
-	// Connect to body A
-	c->m_nodeA.contact = c;
-	c->m_nodeA.other = bodyB;
-
-	c->m_nodeA.prev = NULL;
-	c->m_nodeA.next = bodyA->m_contactList;
-	if (bodyA->m_contactList != NULL)
+	if (m_contactCount == m_contactCapacity)
 	{
-		bodyA->m_contactList->prev = &c->m_nodeA;
+		b2Contact** oldContacts = m_contacts;
+		m_contactCapacity *= 2;
+		m_contacts = (b2Contact**)b2Alloc(m_contactCapacity * sizeof(b2Contact*));
+		memcpy(m_contacts, oldContacts, m_contactCount * sizeof(b2Contact*));
+		b2Free(oldContacts);
 	}
-	bodyA->m_contactList = &c->m_nodeA;
-
-	// Connect to body B
-	c->m_nodeB.contact = c;
-	c->m_nodeB.other = bodyA;
-
-	c->m_nodeB.prev = NULL;
-	c->m_nodeB.next = bodyB->m_contactList;
-	if (bodyB->m_contactList != NULL)
-	{
-		bodyB->m_contactList->prev = &c->m_nodeB;
-	}
-	bodyB->m_contactList = &c->m_nodeB;
 
+	c->m_index = m_contactCount;
+	m_contacts[m_contactCount] = c;
 	++m_contactCount;
+
+	// Connect to island graph.
+	c->m_edgeA = AddEdge(bodyA, c, bodyB);
+	c->m_edgeB = AddEdge(bodyB, c, bodyA);
 }
@@ -22,15 +22,19 @@
 #include <Box2D/Collision/b2BroadPhase.h>
 
 class b2Contact;
+class b2Body;
 class b2ContactFilter;
 class b2ContactListener;
 class b2BlockAllocator;
+class b2StackAllocator;
+class b2TaskScheduler;
 
 // Delegate of b2World.
 class b2ContactManager
 {
 public:
 	b2ContactManager();
+	~b2ContactManager();
 
 	// Broad-phase callback.
 	void AddPair(void* proxyUserDataA, void* proxyUserDataB);
@@ -39,14 +43,34 @@ public:
 
 	void Destroy(b2Contact* c);
 
+	// Add a new contact to the world and body contact arrays.
+	void Insert(b2Contact* c);
+
 	void Collide();
+
+	// Add an edge to the contact array of a body, returning its index.
+	int32 AddEdge(b2Body* body, b2Contact* c, b2Body* other);
+
+	// Remove an edge, moving the last edge of the body in its place.
+	void RemoveEdge(b2Body* body, int32 index);
+
+	// Free the edge array of a body without contacts.
+	void FreeEdges(b2Body* body);
             
 	b2BroadPhase m_broadPhase;
-	b2Contact* m_contactList;
+
+	// Contacts are kept in an array so the contact phases scan them in order.
+	// A destroyed contact is replaced by the last one.
+	b2Contact** m_contacts;
 	int32 m_contactCount;
+	int32 m_contactCapacity;
+
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+	b2StackAllocator* m_stackAllocator;
+	b2TaskScheduler* m_taskScheduler;
+	bool m_manifoldReuse;
 };
 
 #endif
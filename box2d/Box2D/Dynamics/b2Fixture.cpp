@@ -33,6 +33,7 @@ b2Fixture::b2Fixture()
 	m_proxyId = b2BroadPhase::e_nullProxy;
 	m_shape = NULL;
 	m_density = 0.0f;
+	m_generation = 0;
 }
 
 b2Fixture::~b2Fixture()
@@ -141,18 +142,35 @@ void b2Fixture::SetFilterData(const b2Filter& filter)
 	}
 
 	// Flag associated contacts for filtering.
-	b2ContactEdge* edge = m_body->GetContactList();
-	while (edge)
+	b2ContactEdge* edges = m_body->GetContactEdges();
+	for (int32 i = 0; i < m_body->GetContactCount(); ++i)
 	{
-		b2Contact* contact = edge->contact;
+		b2Contact* contact = edges[i].contact;
 		b2Fixture* fixtureA = contact->GetFixtureA();
 		b2Fixture* fixtureB = contact->GetFixtureB();
 		if (fixtureA == this || fixtureB == this)
 		{
 			contact->FlagForFiltering();
 		}
+	}
+}
 
-		edge = edge->next;
+void b2Fixture::ShapeChanged()
+{
+	if (m_body == NULL)
+	{
+		return;
+	}
+
+	b2ContactEdge* edges = m_body->GetContactEdges();
+	for (int32 i = 0; i < m_body->GetContactCount(); ++i)
+	{
+		b2Contact* contact = edges[i].contact;
+		if (contact->GetFixtureA() == this || contact->GetFixtureB() == this)
+		{
+			contact->m_simplexCache.count = 0;
+			contact->m_flags &= ~b2Contact::e_cachedFlag;
+		}
 	}
 }
 
@@ -43,6 +43,18 @@ struct b2Filter
 	int16 groupIndex;
 };
 
+/// Should fixtures with these filters collide? This is the test of the default
+/// contact filter, cheap enough to be done before anything else about a pair.
+inline bool b2ShouldCollide(const b2Filter& filterA, const b2Filter& filterB)
+{
+	if (filterA.groupIndex == filterB.groupIndex && filterA.groupIndex != 0)
+	{
+		return filterA.groupIndex > 0;
+	}
+
+	return (filterA.maskBits & filterB.categoryBits) != 0 && (filterA.categoryBits & filterB.maskBits) != 0;
+}
+
 /// A fixture definition is used to create a fixture. This class defines an
 /// abstract fixture definition. You can reuse fixture definitions safely.
 struct b2FixtureDef
@@ -100,12 +112,16 @@ public:
 	/// @return the shape type.
 	b2Shape::Type GetType() const;
 
-	/// Get the child shape. You can modify the child shape, however you should not change the
-	/// number of vertices because this will crash some collision caching mechanisms.
+	/// Get the child shape. You can modify the child shape, however you must call ShapeChanged
+	/// afterwards or the collision caching mechanisms may crash.
 	/// Manipulating the shape may lead to non-physical behavior.
 	b2Shape* GetShape();
 	const b2Shape* GetShape() const;
 
+	/// Drop what the contacts of this fixture have cached about the shape: their
+	/// simplex caches and reusable manifolds. Call this after modifying the shape.
+	void ShapeChanged();
+
 	/// Set if this fixture is a sensor.
 	void SetSensor(bool sensor);
 
@@ -182,6 +198,7 @@ protected:
 	friend class b2World;
 	friend class b2Contact;
 	friend class b2ContactManager;
+	friend class b2Sensor;
 
 	b2Fixture();
 	~b2Fixture();
@@ -214,6 +231,9 @@ protected:
 
 	bool m_isSensor;
 
+	// Tells a recreated fixture from the one a world state was saved with.
+	uint32 m_generation;
+
 	void* m_userData;
 };
 
@@ -22,7 +22,17 @@
 #include <Box2D/Dynamics/b2World.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
-#include <Box2D/Dynamics/Joints/b2Joint.h>
+#include <Box2D/Dynamics/Contacts/b2SoftContactSolver.h>
+#include <Box2D/Dynamics/Joints/b2DistanceJoint.h>
+#include <Box2D/Dynamics/Joints/b2FrictionJoint.h>
+#include <Box2D/Dynamics/Joints/b2GearJoint.h>
+#include <Box2D/Dynamics/Joints/b2JointTreeSolver.h>
+#include <Box2D/Dynamics/Joints/b2LineJoint.h>
+#include <Box2D/Dynamics/Joints/b2MouseJoint.h>
+#include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
+#include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
+#include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
+#include <Box2D/Dynamics/Joints/b2WeldJoint.h>
 #include <Box2D/Common/b2StackAllocator.h>
 
 /*
@@ -143,6 +153,49 @@ This might be faster than computing sin+cos.
 However, we can compute sin+cos of the same angle fast.
 */
 
+struct b2JointBatchFcns
+{
+	void (*initFcn)(b2Joint** joints, int32 count, const b2TimeStep& step);
+	void (*solveVelocityFcn)(b2Joint** joints, int32 count, const b2TimeStep& step);
+	bool (*solvePositionFcn)(b2Joint** joints, int32 count, float32 baumgarte);
+};
+
+#define B2_JOINT_BATCH(T) { &b2JointBatch<T>::InitVelocityConstraints, \
+	&b2JointBatch<T>::SolveVelocityConstraints, &b2JointBatch<T>::SolvePositionConstraints }
+
+// Indexed by b2JointType.
+static const b2JointBatchFcns s_jointBatches[] =
+{
+	{ NULL, NULL, NULL },
+	B2_JOINT_BATCH(b2RevoluteJoint),
+	B2_JOINT_BATCH(b2PrismaticJoint),
+	B2_JOINT_BATCH(b2DistanceJoint),
+	B2_JOINT_BATCH(b2PulleyJoint),
+	B2_JOINT_BATCH(b2MouseJoint),
+	B2_JOINT_BATCH(b2GearJoint),
+	B2_JOINT_BATCH(b2LineJoint),
+	B2_JOINT_BATCH(b2WeldJoint),
+	B2_JOINT_BATCH(b2FrictionJoint),
+};
+
+#undef B2_JOINT_BATCH
+
+// Gets the length of the run of joints of the same type starting at joints[0].
+// Joints are solved in island order, since reordering them would change the
+// results of the sequential impulses.
+static int32 b2GetJointRun(b2Joint** joints, int32 count)
+{
+	b2JointType type = joints[0]->GetType();
+	b2Assert(e_unknownJoint < type && type <= e_frictionJoint);
+
+	int32 run = 1;
+	while (run < count && joints[run]->GetType() == type)
+	{
+		++run;
+	}
+	return run;
+}
+
 b2Island::b2Island(
 	int32 bodyCapacity,
 	int32 contactCapacity,
@@ -179,6 +232,79 @@ b2Island::~b2Island()
 }
 
 void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
+{
+	// Partition contacts so that contacts with static bodies are solved last.
+	int32 i1 = -1;
+	for (int32 i2 = 0; i2 < m_contactCount; ++i2)
+	{
+		b2Fixture* fixtureA = m_contacts[i2]->GetFixtureA();
+		b2Fixture* fixtureB = m_contacts[i2]->GetFixtureB();
+		b2Body* bodyA = fixtureA->GetBody();
+		b2Body* bodyB = fixtureB->GetBody();
+		bool nonStatic = bodyA->GetType() != b2_staticBody && bodyB->GetType() != b2_staticBody;
+		if (nonStatic)
+		{
+			++i1;
+			b2Swap(m_contacts[i1], m_contacts[i2]);
+		}
+	}
+
+	if (step.subStepping)
+	{
+		SolveSubSteps(step, gravity);
+	}
+	else
+	{
+		SolveIterative(step, gravity);
+	}
+
+	if (allowSleep)
+	{
+		float32 minSleepTime = b2_maxFloat;
+
+		const float32 linTolSqr = b2_linearSleepTolerance * b2_linearSleepTolerance;
+		const float32 angTolSqr = b2_angularSleepTolerance * b2_angularSleepTolerance;
+
+		for (int32 i = 0; i < m_bodyCount; ++i)
+		{
+			b2Body* b = m_bodies[i];
+			if (b->GetType() == b2_staticBody)
+			{
+				continue;
+			}
+
+			if ((b->m_flags & b2Body::e_autoSleepFlag) == 0)
+			{
+				b->m_sleepTime = 0.0f;
+				minSleepTime = 0.0f;
+			}
+
+			if ((b->m_flags & b2Body::e_autoSleepFlag) == 0 ||
+				b->m_angularVelocity * b->m_angularVelocity > angTolSqr ||
+				b2Dot(b->m_linearVelocity, b->m_linearVelocity) > linTolSqr)
+			{
+				b->m_sleepTime = 0.0f;
+				minSleepTime = 0.0f;
+			}
+			else
+			{
+				b->m_sleepTime += step.dt;
+				minSleepTime = b2Min(minSleepTime, b->m_sleepTime);
+			}
+		}
+
+		if (minSleepTime >= b2_timeToSleep)
+		{
+			for (int32 i = 0; i < m_bodyCount; ++i)
+			{
+				b2Body* b = m_bodies[i];
+				b->SetAwake(false);
+			}
+		}
+	}
+}
+
+void b2Island::IntegrateVelocities(const b2TimeStep& step, const b2Vec2& gravity)
 {
 	// Integrate velocities and apply damping.
 	for (int32 i = 0; i < m_bodyCount; ++i)
@@ -204,38 +330,41 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 		b->m_linearVelocity *= b2Clamp(1.0f - step.dt * b->m_linearDamping, 0.0f, 1.0f);
 		b->m_angularVelocity *= b2Clamp(1.0f - step.dt * b->m_angularDamping, 0.0f, 1.0f);
 	}
+}
 
-	// Partition contacts so that contacts with static bodies are solved last.
-	int32 i1 = -1;
-	for (int32 i2 = 0; i2 < m_contactCount; ++i2)
+void b2Island::SolveJointVelocities(const b2TimeStep& step, int32 jointCount)
+{
+	for (int32 i = 0; i < jointCount; )
 	{
-		b2Fixture* fixtureA = m_contacts[i2]->GetFixtureA();
-		b2Fixture* fixtureB = m_contacts[i2]->GetFixtureB();
-		b2Body* bodyA = fixtureA->GetBody();
-		b2Body* bodyB = fixtureB->GetBody();
-		bool nonStatic = bodyA->GetType() != b2_staticBody && bodyB->GetType() != b2_staticBody;
-		if (nonStatic)
-		{
-			++i1;
-			b2Swap(m_contacts[i1], m_contacts[i2]);
-		}
+		int32 run = b2GetJointRun(m_joints + i, jointCount - i);
+		s_jointBatches[m_joints[i]->GetType()].solveVelocityFcn(m_joints + i, run, step);
+		i += run;
 	}
+}
+
+void b2Island::SolveIterative(const b2TimeStep& step, const b2Vec2& gravity)
+{
+	IntegrateVelocities(step, gravity);
 
 	// Initialize velocity constraints.
 	b2ContactSolver contactSolver(m_contacts, m_contactCount, m_allocator, step.dtRatio);
 	contactSolver.WarmStart();
-	for (int32 i = 0; i < m_jointCount; ++i)
+	for (int32 i = 0; i < m_jointCount; )
 	{
-		m_joints[i]->InitVelocityConstraints(step);
+		int32 run = b2GetJointRun(m_joints + i, m_jointCount - i);
+		s_jointBatches[m_joints[i]->GetType()].initFcn(m_joints + i, run, step);
+		i += run;
 	}
 
+	// Take the trees of joints out of the iterative solver.
+	b2JointTreeSolver treeSolver(step, m_joints, m_jointCount, m_bodyCount, m_allocator);
+	int32 jointCount = treeSolver.GetIterativeCount();
+
 	// Solve velocity constraints.
 	for (int32 i = 0; i < step.velocityIterations; ++i)
 	{
-		for (int32 j = 0; j < m_jointCount; ++j)
-		{
-			m_joints[j]->SolveVelocityConstraints(step);
-		}
+		SolveJointVelocities(step, jointCount);
+		treeSolver.SolveVelocityConstraints();
 
 		contactSolver.SolveVelocityConstraints();
 	}
@@ -288,10 +417,12 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 		bool contactsOkay = contactSolver.SolvePositionConstraints(b2_contactBaumgarte);
 
 		bool jointsOkay = true;
-		for (int32 i = 0; i < m_jointCount; ++i)
+		for (int32 j = 0; j < m_jointCount; )
 		{
-			bool jointOkay = m_joints[i]->SolvePositionConstraints(b2_contactBaumgarte);
-			jointsOkay = jointsOkay && jointOkay;
+			int32 run = b2GetJointRun(m_joints + j, m_jointCount - j);
+			bool runOkay = s_jointBatches[m_joints[j]->GetType()].solvePositionFcn(m_joints + j, run, b2_contactBaumgarte);
+			jointsOkay = jointsOkay && runOkay;
+			j += run;
 		}
 
 		if (contactsOkay && jointsOkay)
@@ -302,51 +433,111 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 	}
 
 	Report(contactSolver.m_constraints);
+}
 
-	if (allowSleep)
+void b2Island::SolveSubSteps(const b2TimeStep& step, const b2Vec2& gravity)
+{
+	int32 subStepCount = b2Max(step.velocityIterations, 1);
+
+	b2TimeStep subStep = step;
+	subStep.dt = step.dt / subStepCount;
+	subStep.inv_dt = step.inv_dt * subStepCount;
+
+	// Store positions for continuous collision. The contact solver also
+	// measures the motion of the bodies from here.
+	for (int32 i = 0; i < m_bodyCount; ++i)
 	{
-		float32 minSleepTime = b2_maxFloat;
+		b2Body* b = m_bodies[i];
+		b->m_sweep.c0 = b->m_sweep.c;
+		b->m_sweep.a0 = b->m_sweep.a;
+	}
 
-		const float32 linTolSqr = b2_linearSleepTolerance * b2_linearSleepTolerance;
-		const float32 angTolSqr = b2_angularSleepTolerance * b2_angularSleepTolerance;
+	b2SoftContactSolver contactSolver(subStep, subStepCount, m_contacts, m_contactCount, m_allocator, step.dtRatio);
 
-		for (int32 i = 0; i < m_bodyCount; ++i)
+	for (int32 i = 0; i < subStepCount; ++i)
+	{
+		IntegrateVelocities(subStep, gravity);
+
+		// Joints are linearized again each sub-step. Their impulses are those
+		// of a sub-step, which only changes length with the time step.
+		subStep.dtRatio = i == 0 ? step.dtRatio : 1.0f;
+		for (int32 j = 0; j < m_jointCount; )
 		{
-			b2Body* b = m_bodies[i];
+			int32 run = b2GetJointRun(m_joints + j, m_jointCount - j);
+			s_jointBatches[m_joints[j]->GetType()].initFcn(m_joints + j, run, subStep);
+			j += run;
+		}
+
+		b2JointTreeSolver treeSolver(subStep, m_joints, m_jointCount, m_bodyCount, m_allocator);
+		int32 jointCount = treeSolver.GetIterativeCount();
+
+		contactSolver.WarmStart();
+
+		// Solve, pushing bodies out of overlap.
+		SolveJointVelocities(subStep, jointCount);
+		treeSolver.SolveVelocityConstraints();
+		contactSolver.SolveVelocityConstraints(true);
+
+		// Integrate positions.
+		for (int32 j = 0; j < m_bodyCount; ++j)
+		{
+			b2Body* b = m_bodies[j];
+
 			if (b->GetType() == b2_staticBody)
 			{
 				continue;
 			}
 
-			if ((b->m_flags & b2Body::e_autoSleepFlag) == 0)
+			// Check for large velocities, over the whole time step.
+			b2Vec2 translation = step.dt * b->m_linearVelocity;
+			if (b2Dot(translation, translation) > b2_maxTranslationSquared)
 			{
-				b->m_sleepTime = 0.0f;
-				minSleepTime = 0.0f;
+				float32 ratio = b2_maxTranslation / translation.Length();
+				b->m_linearVelocity *= ratio;
 			}
 
-			if ((b->m_flags & b2Body::e_autoSleepFlag) == 0 ||
-				b->m_angularVelocity * b->m_angularVelocity > angTolSqr ||
-				b2Dot(b->m_linearVelocity, b->m_linearVelocity) > linTolSqr)
+			float32 rotation = step.dt * b->m_angularVelocity;
+			if (rotation * rotation > b2_maxRotationSquared)
 			{
-				b->m_sleepTime = 0.0f;
-				minSleepTime = 0.0f;
-			}
-			else
-			{
-				b->m_sleepTime += step.dt;
-				minSleepTime = b2Min(minSleepTime, b->m_sleepTime);
+				float32 ratio = b2_maxRotation / b2Abs(rotation);
+				b->m_angularVelocity *= ratio;
 			}
+
+			b->m_sweep.c += subStep.dt * b->m_linearVelocity;
+			b->m_sweep.a += subStep.dt * b->m_angularVelocity;
+			b->SynchronizeTransform();
 		}
 
-		if (minSleepTime >= b2_timeToSleep)
+		// Relax, removing the velocity the push added.
+		SolveJointVelocities(subStep, jointCount);
+		treeSolver.SolveVelocityConstraints();
+		contactSolver.SolveVelocityConstraints(false);
+	}
+
+	contactSolver.ApplyRestitution();
+
+	// Post-solve (store impulses for warm starting).
+	contactSolver.StoreImpulses();
+
+	// Joints are still rigid, correct what they drifted.
+	for (int32 i = 0; i < step.positionIterations; ++i)
+	{
+		bool jointsOkay = true;
+		for (int32 j = 0; j < m_jointCount; )
 		{
-			for (int32 i = 0; i < m_bodyCount; ++i)
-			{
-				b2Body* b = m_bodies[i];
-				b->SetAwake(false);
-			}
+			int32 run = b2GetJointRun(m_joints + j, m_jointCount - j);
+			bool runOkay = s_jointBatches[m_joints[j]->GetType()].solvePositionFcn(m_joints + j, run, b2_contactBaumgarte);
+			jointsOkay = jointsOkay && runOkay;
+			j += run;
+		}
+
+		if (jointsOkay)
+		{
+			break;
 		}
 	}
+
+	Report(contactSolver.m_constraints);
 }
 
 void b2Island::Report(const b2ContactConstraint* constraints)
@@ -81,6 +81,15 @@ public:
 
 	void Report(const b2ContactConstraint* constraints);
 
+	void IntegrateVelocities(const b2TimeStep& step, const b2Vec2& gravity);
+	void SolveJointVelocities(const b2TimeStep& step, int32 jointCount);
+
+	// The default solver, sequential impulses and then position iterations.
+	void SolveIterative(const b2TimeStep& step, const b2Vec2& gravity);
+
+	// The sub-stepping solver, see b2World::SetSubStepping.
+	void SolveSubSteps(const b2TimeStep& step, const b2Vec2& gravity);
+
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
 
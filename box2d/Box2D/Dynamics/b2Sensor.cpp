@@ -0,0 +1,299 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2Sensor.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Collision/Shapes/b2CircleShape.h>
+#include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Collision/b2Distance.h>
+#include <Box2D/Common/b2BlockAllocator.h>
+#include <algorithm>
+#include <cstring>
+
+// Grow an array allocated with b2Alloc to hold at least one more element.
+template <typename T>
+static void b2GrowArray(T** array, int32 count, int32* capacity)
+{
+	if (count < *capacity)
+	{
+		return;
+	}
+
+	*capacity = b2Max(2 * *capacity, 16);
+	T* grown = (T*)b2Alloc(*capacity * sizeof(T));
+	if (count > 0)
+	{
+		memcpy(grown, *array, count * sizeof(T));
+	}
+	b2Free(*array);
+	*array = grown;
+}
+
+struct b2SensorQueryWrapper
+{
+	bool QueryCallback(int32 proxyId)
+	{
+		return sensor->QueryCallback(proxyId);
+	}
+
+	b2Sensor* sensor;
+};
+
+// The shapes are tested the way their contacts would find them touching,
+// without building manifolds where a cheaper test gives the same answer.
+static bool b2TestSensorOverlap(const b2Shape* shapeA, const b2Transform& xfA,
+								const b2Shape* shapeB, const b2Transform& xfB,
+								b2DistanceStats* stats)
+{
+	b2Shape::Type typeA = shapeA->GetType();
+	b2Shape::Type typeB = shapeB->GetType();
+
+	if (typeA == b2Shape::e_circle && typeB == b2Shape::e_circle)
+	{
+		const b2CircleShape* circleA = (const b2CircleShape*)shapeA;
+		const b2CircleShape* circleB = (const b2CircleShape*)shapeB;
+		b2Vec2 d = b2Mul(xfB, circleB->m_p) - b2Mul(xfA, circleA->m_p);
+		float32 radius = circleA->m_radius + circleB->m_radius;
+		return b2Dot(d, d) <= radius * radius;
+	}
+
+	if (typeA == b2Shape::e_polygon && typeB == b2Shape::e_circle)
+	{
+		b2Manifold manifold;
+		b2CollidePolygonAndCircle(&manifold, (const b2PolygonShape*)shapeA, xfA, (const b2CircleShape*)shapeB, xfB);
+		return manifold.pointCount > 0;
+	}
+
+	if (typeA == b2Shape::e_circle && typeB == b2Shape::e_polygon)
+	{
+		b2Manifold manifold;
+		b2CollidePolygonAndCircle(&manifold, (const b2PolygonShape*)shapeB, xfB, (const b2CircleShape*)shapeA, xfA);
+		return manifold.pointCount > 0;
+	}
+
+	b2SimplexCache cache;
+	cache.count = 0;
+	return b2TestOverlap(shapeA, shapeB, xfA, xfB, &cache, stats);
+}
+
+bool b2Sensor::OverlapLessThan(const Overlap& a, const Overlap& b)
+{
+	return a.proxyId < b.proxyId;
+}
+
+b2Sensor::b2Sensor()
+{
+	m_prev = NULL;
+	m_next = NULL;
+	m_body = NULL;
+	m_shape = NULL;
+	m_aabbOnly = false;
+	m_overlaps = NULL;
+	m_overlapCount = 0;
+	m_overlapCapacity = 0;
+	m_found = NULL;
+	m_foundCount = 0;
+	m_foundCapacity = 0;
+	m_broadPhase = NULL;
+	m_stats = NULL;
+	m_userData = NULL;
+}
+
+void b2Sensor::Create(b2BlockAllocator* allocator, const b2SensorDef* def)
+{
+	m_body = def->body;
+	m_shape = def->shape->Clone(allocator);
+	m_filter = def->filter;
+	m_aabbOnly = def->aabbOnly;
+	m_userData = def->userData;
+}
+
+void b2Sensor::Destroy(b2BlockAllocator* allocator)
+{
+	b2Free(m_overlaps);
+	b2Free(m_found);
+	m_overlaps = NULL;
+	m_found = NULL;
+	m_overlapCount = 0;
+	m_foundCount = 0;
+
+	switch (m_shape->m_type)
+	{
+	case b2Shape::e_circle:
+		{
+			b2CircleShape* s = (b2CircleShape*)m_shape;
+			s->~b2CircleShape();
+			allocator->Free(s, sizeof(b2CircleShape));
+		}
+		break;
+
+	case b2Shape::e_polygon:
+		{
+			b2PolygonShape* s = (b2PolygonShape*)m_shape;
+			s->~b2PolygonShape();
+			allocator->Free(s, sizeof(b2PolygonShape));
+		}
+		break;
+
+	default:
+		b2Assert(false);
+		break;
+	}
+
+	m_shape = NULL;
+}
+
+void b2Sensor::Update(const b2BroadPhase* broadPhase, b2DistanceStats* stats)
+{
+	m_foundCount = 0;
+
+	// A sensor on an inactive body overlaps nothing.
+	if (m_body->IsActive() == false)
+	{
+		return;
+	}
+
+	m_broadPhase = broadPhase;
+	m_stats = stats;
+	m_xf = m_body->GetTransform();
+	m_shape->ComputeAABB(&m_aabb, m_xf);
+
+	b2SensorQueryWrapper wrapper;
+	wrapper.sensor = this;
+	broadPhase->Query(&wrapper, m_aabb);
+
+	std::sort(m_found, m_found + m_foundCount, OverlapLessThan);
+}
+
+bool b2Sensor::QueryCallback(int32 proxyId)
+{
+	b2Fixture* fixture = (b2Fixture*)m_broadPhase->GetUserData(proxyId);
+	b2Body* body = fixture->GetBody();
+
+	if (body == m_body)
+	{
+		return true;
+	}
+
+	if (b2ShouldCollide(m_filter, fixture->GetFilterData()) == false)
+	{
+		return true;
+	}
+
+	bool overlap;
+	if (m_aabbOnly)
+	{
+		b2AABB aabb;
+		fixture->GetShape()->ComputeAABB(&aabb, body->GetTransform());
+		overlap = b2TestOverlap(m_aabb, aabb);
+	}
+	else
+	{
+		overlap = b2TestSensorOverlap(m_shape, m_xf, fixture->GetShape(), body->GetTransform(), m_stats);
+	}
+
+	if (overlap)
+	{
+		b2GrowArray(&m_found, m_foundCount, &m_foundCapacity);
+		m_found[m_foundCount].proxyId = proxyId;
+		m_found[m_foundCount].fixture = fixture;
+		++m_foundCount;
+	}
+
+	return true;
+}
+
+void b2Sensor::Report(b2SensorEvent** events, int32* count, int32* capacity)
+{
+	// Both lists are sorted by proxy id. A proxy id that now belongs to
+	// another fixture is the end of one overlap and the beginning of another.
+	int32 i = 0, j = 0;
+	while (i < m_overlapCount || j < m_foundCount)
+	{
+		const Overlap* old = i < m_overlapCount ? m_overlaps + i : NULL;
+		const Overlap* now = j < m_foundCount ? m_found + j : NULL;
+
+		if (old && now && old->proxyId == now->proxyId && old->fixture == now->fixture)
+		{
+			++i;
+			++j;
+			continue;
+		}
+
+		b2GrowArray(events, *count, capacity);
+		b2SensorEvent* event = *events + *count;
+		event->sensor = this;
+		++*count;
+
+		if (now == NULL || (old && old->proxyId <= now->proxyId))
+		{
+			event->fixture = old->fixture;
+			event->begin = false;
+			++i;
+		}
+		else
+		{
+			event->fixture = now->fixture;
+			event->begin = true;
+			++j;
+		}
+	}
+
+	b2Swap(m_overlaps, m_found);
+	b2Swap(m_overlapCapacity, m_foundCapacity);
+	m_overlapCount = m_foundCount;
+	m_foundCount = 0;
+}
+
+void b2Sensor::RemoveFixture(b2Fixture* fixture)
+{
+	int32 proxyId = fixture->m_proxyId;
+	Overlap* end = m_overlaps + m_overlapCount;
+	Overlap key;
+	key.proxyId = proxyId;
+	key.fixture = fixture;
+
+	Overlap* overlap = std::lower_bound(m_overlaps, end, key, OverlapLessThan);
+	if (overlap == end || overlap->proxyId != proxyId || overlap->fixture != fixture)
+	{
+		return;
+	}
+
+	memmove(overlap, overlap + 1, (end - overlap - 1) * sizeof(Overlap));
+	--m_overlapCount;
+}
+
+void b2Sensor::RefreshProxies()
+{
+	int32 count = 0;
+	for (int32 i = 0; i < m_overlapCount; ++i)
+	{
+		b2Fixture* fixture = m_overlaps[i].fixture;
+		if (fixture->m_proxyId != b2BroadPhase::e_nullProxy)
+		{
+			m_overlaps[count].proxyId = fixture->m_proxyId;
+			m_overlaps[count].fixture = fixture;
+			++count;
+		}
+	}
+	m_overlapCount = count;
+
+	std::sort(m_overlaps, m_overlaps + m_overlapCount, OverlapLessThan);
+}
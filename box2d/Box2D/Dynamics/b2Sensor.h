@@ -0,0 +1,222 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SENSOR_H
+#define B2_SENSOR_H
+
+#include <Box2D/Dynamics/b2Fixture.h>
+
+class b2BlockAllocator;
+class b2BroadPhase;
+class b2Sensor;
+struct b2DistanceStats;
+
+/// A sensor definition is used to create a sensor. You can reuse sensor
+/// definitions safely.
+struct b2SensorDef
+{
+	/// The constructor sets the default sensor definition values.
+	b2SensorDef()
+	{
+		shape = NULL;
+		body = NULL;
+		userData = NULL;
+		aabbOnly = false;
+		filter.categoryBits = 0x0001;
+		filter.maskBits = 0xFFFF;
+		filter.groupIndex = 0;
+	}
+
+	/// The shape, this must be set. The shape will be cloned, so you
+	/// can create the shape on the stack.
+	const b2Shape* shape;
+
+	/// The body the sensor moves with, this must be set.
+	b2Body* body;
+
+	/// Use this to store application specific sensor data.
+	void* userData;
+
+	/// Only test the bounding boxes of the sensor and the fixtures instead
+	/// of their shapes. This is cheaper and enough for many trigger zones.
+	bool aabbOnly;
+
+	/// Which fixtures the sensor detects, using the same rules as the
+	/// default contact filter.
+	b2Filter filter;
+};
+
+/// A fixture that started or stopped overlapping a sensor.
+/// @see b2World::GetSensorEvents
+struct b2SensorEvent
+{
+	b2Sensor* sensor;
+	b2Fixture* fixture;
+	bool begin;		///< false when the overlap ended
+};
+
+/// A sensor reports the fixtures that overlap a shape attached to a body.
+/// Unlike a sensor fixture it has no broad-phase proxy and creates no
+/// contacts: once per time step it queries the broad-phase with its bounding
+/// box and tests the shapes found directly, circles and polygons each with
+/// their own test. The overlaps that began or ended are gathered by the world.
+/// Sensors do not detect the fixtures of their own body.
+class b2Sensor
+{
+public:
+	/// Get the parent body of this sensor.
+	b2Body* GetBody();
+
+	/// Get the shape of this sensor.
+	const b2Shape* GetShape() const;
+
+	/// Set the filter, this takes effect at the next time step.
+	void SetFilterData(const b2Filter& filter);
+
+	/// Get the filter.
+	const b2Filter& GetFilterData() const;
+
+	/// Is this sensor testing bounding boxes only?
+	bool IsAABBOnly() const;
+
+	/// Get the user data that was assigned in the sensor definition.
+	void* GetUserData() const;
+
+	/// Set the user data.
+	void SetUserData(void* data);
+
+	/// Get the number of fixtures overlapping the sensor at the last time step.
+	int32 GetOverlapCount() const;
+
+	/// Get an overlapping fixture, in the order of their broad-phase proxies.
+	b2Fixture* GetOverlap(int32 index) const;
+
+	/// Get the next sensor in the world's sensor list.
+	b2Sensor* GetNext();
+
+private:
+
+	friend class b2World;
+	friend class b2SensorTask;
+	friend struct b2SensorQueryWrapper;
+
+	struct Overlap
+	{
+		int32 proxyId;
+		b2Fixture* fixture;
+	};
+
+	static bool OverlapLessThan(const Overlap& a, const Overlap& b);
+
+	b2Sensor();
+
+	void Create(b2BlockAllocator* allocator, const b2SensorDef* def);
+	void Destroy(b2BlockAllocator* allocator);
+
+	// Find the fixtures overlapping now. This only reads the world, so the
+	// sensors can be updated in parallel, each thread with its own stats.
+	void Update(const b2BroadPhase* broadPhase, b2DistanceStats* stats);
+	bool QueryCallback(int32 proxyId);
+
+	// Report the changes found by Update, and keep the new overlaps.
+	void Report(b2SensorEvent** events, int32* count, int32* capacity);
+
+	// The fixture is losing its proxy.
+	void RemoveFixture(b2Fixture* fixture);
+
+	// The proxies of the fixtures were changed by b2World::RestoreState.
+	void RefreshProxies();
+
+	b2Sensor* m_prev;
+	b2Sensor* m_next;
+	b2Body* m_body;
+
+	b2Shape* m_shape;
+	b2Filter m_filter;
+	bool m_aabbOnly;
+
+	// Sorted by proxy id.
+	Overlap* m_overlaps;
+	int32 m_overlapCount;
+	int32 m_overlapCapacity;
+
+	// Filled by Update.
+	Overlap* m_found;
+	int32 m_foundCount;
+	int32 m_foundCapacity;
+
+	const b2BroadPhase* m_broadPhase;
+	b2DistanceStats* m_stats;
+	b2Transform m_xf;
+	b2AABB m_aabb;
+
+	void* m_userData;
+};
+
+inline b2Body* b2Sensor::GetBody()
+{
+	return m_body;
+}
+
+inline const b2Shape* b2Sensor::GetShape() const
+{
+	return m_shape;
+}
+
+inline void b2Sensor::SetFilterData(const b2Filter& filter)
+{
+	m_filter = filter;
+}
+
+inline const b2Filter& b2Sensor::GetFilterData() const
+{
+	return m_filter;
+}
+
+inline bool b2Sensor::IsAABBOnly() const
+{
+	return m_aabbOnly;
+}
+
+inline void* b2Sensor::GetUserData() const
+{
+	return m_userData;
+}
+
+inline void b2Sensor::SetUserData(void* data)
+{
+	m_userData = data;
+}
+
+inline int32 b2Sensor::GetOverlapCount() const
+{
+	return m_overlapCount;
+}
+
+inline b2Fixture* b2Sensor::GetOverlap(int32 index) const
+{
+	b2Assert(0 <= index && index < m_overlapCount);
+	return m_overlaps[index].fixture;
+}
+
+inline b2Sensor* b2Sensor::GetNext()
+{
+	return m_next;
+}
+
+#endif
@@ -30,6 +30,8 @@ struct b2TimeStep
 	int32 velocityIterations;
 	int32 positionIterations;
 	bool warmStarting;
+	bool jointTrees;		// solve trees of revolute joints directly
+	bool subStepping;		// solve contacts softly in sub-steps
 };
 
 #endif
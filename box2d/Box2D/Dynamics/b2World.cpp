@@ -20,16 +20,29 @@
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2Island.h>
+#include <Box2D/Dynamics/b2Sensor.h>
+#include <Box2D/Dynamics/Controllers/b2Controller.h>
+#include <Box2D/Dynamics/Particles/b2ParticleSystem.h>
+#include <Box2D/Dynamics/Joints/b2DistanceJoint.h>
+#include <Box2D/Dynamics/Joints/b2FrictionJoint.h>
+#include <Box2D/Dynamics/Joints/b2GearJoint.h>
+#include <Box2D/Dynamics/Joints/b2LineJoint.h>
+#include <Box2D/Dynamics/Joints/b2MouseJoint.h>
+#include <Box2D/Dynamics/Joints/b2PrismaticJoint.h>
 #include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
+#include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
+#include <Box2D/Dynamics/Joints/b2WeldJoint.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
 #include <Box2D/Dynamics/Contacts/b2TOISolver.h>
 #include <Box2D/Collision/b2Collision.h>
+#include <Box2D/Collision/b2Distance.h>
 #include <Box2D/Collision/b2BroadPhase.h>
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <new>
+#include <cstring>
 
 b2World::b2World(const b2Vec2& gravity, bool doSleep)
 {
@@ -38,12 +51,24 @@ b2World::b2World(const b2Vec2& gravity, bool doSleep)
 
 	m_bodyList = NULL;
 	m_jointList = NULL;
+	m_sensorList = NULL;
+	m_controllerList = NULL;
+	m_particleSystemList = NULL;
 
 	m_bodyCount = 0;
 	m_jointCount = 0;
+	m_sensorCount = 0;
+	m_controllerCount = 0;
+	m_particleSystemCount = 0;
+
+	m_sensorEvents = NULL;
+	m_sensorEventCount = 0;
+	m_sensorEventCapacity = 0;
 
 	m_warmStarting = true;
 	m_continuousPhysics = true;
+	m_jointTrees = true;
+	m_subStepping = false;
 
 	m_allowSleep = doSleep;
 	m_gravity = gravity;
@@ -51,12 +76,37 @@ b2World::b2World(const b2Vec2& gravity, bool doSleep)
 	m_flags = e_clearForces;
 
 	m_inv_dt0 = 0.0f;
+	m_fixtureGeneration = 0;
 
 	m_contactManager.m_allocator = &m_blockAllocator;
+	m_contactManager.m_stackAllocator = &m_stackAllocator;
+
+	m_taskScheduler = &m_serialTaskScheduler;
+	m_contactManager.m_taskScheduler = m_taskScheduler;
 }
 
 b2World::~b2World()
 {
+	// Large contact arrays are not in the chunks of the block allocator.
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b->m_contactCount = 0;
+		m_contactManager.FreeEdges(b);
+	}
+
+	// So are the overlaps of sensors.
+	for (b2Sensor* s = m_sensorList; s; s = s->m_next)
+	{
+		b2Free(s->m_overlaps);
+		b2Free(s->m_found);
+	}
+	b2Free(m_sensorEvents);
+
+	// And the particles.
+	for (b2ParticleSystem* p = m_particleSystemList; p; p = p->m_next)
+	{
+		p->~b2ParticleSystem();
+	}
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -79,6 +129,13 @@ void b2World::SetDebugDraw(b2DebugDraw* debugDraw)
 	m_debugDraw = debugDraw;
 }
 
+void b2World::SetTaskScheduler(b2TaskScheduler* scheduler)
+{
+	b2Assert(IsLocked() == false);
+	m_taskScheduler = scheduler ? scheduler : &m_serialTaskScheduler;
+	m_contactManager.m_taskScheduler = m_taskScheduler;
+}
+
 b2Body* b2World::CreateBody(const b2BodyDef* def)
 {
 	b2Assert(IsLocked() == false);
@@ -128,15 +185,52 @@ void b2World::DestroyBody(b2Body* b)
 	}
 	b->m_jointList = NULL;
 
+	// Delete the attached sensors.
+	b2Sensor* s = m_sensorList;
+	while (s)
+	{
+		b2Sensor* s0 = s;
+		s = s->m_next;
+
+		if (s0->m_body != b)
+		{
+			continue;
+		}
+
+		if (m_destructionListener)
+		{
+			m_destructionListener->SayGoodbye(s0);
+		}
+
+		DestroySensor(s0);
+	}
+
+	// Delete the controllers moving with the body.
+	b2Controller* c = m_controllerList;
+	while (c)
+	{
+		b2Controller* c0 = c;
+		c = c->m_next;
+
+		if (c0->m_body != b)
+		{
+			continue;
+		}
+
+		if (m_destructionListener)
+		{
+			m_destructionListener->SayGoodbye(c0);
+		}
+
+		DestroyController(c0);
+	}
+
 	// Delete the attached contacts.
-	b2ContactEdge* ce = b->m_contactList;
-	while (ce)
+	while (b->m_contactCount > 0)
 	{
-		b2ContactEdge* ce0 = ce;
-		ce = ce->next;
-		m_contactManager.Destroy(ce0->contact);
+		m_contactManager.Destroy(b->m_contactEdges[b->m_contactCount - 1].contact);
 	}
-	b->m_contactList = NULL;
+	m_contactManager.FreeEdges(b);
 
 	// Delete the attached fixtures. This destroys broad-phase proxies.
 	b2Fixture* f = b->m_fixtureList;
@@ -150,6 +244,7 @@ void b2World::DestroyBody(b2Body* b)
 			m_destructionListener->SayGoodbye(f0);
 		}
 
+		RemoveSensorOverlaps(f0);
 		f0->DestroyProxy(&m_contactManager.m_broadPhase);
 		f0->Destroy(&m_blockAllocator);
 		f0->~b2Fixture();
@@ -220,17 +315,15 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 	// If the joint prevents collisions, then flag any contacts for filtering.
 	if (def->collideConnected == false)
 	{
-		b2ContactEdge* edge = bodyB->GetContactList();
-		while (edge)
+		b2ContactEdge* edges = bodyB->GetContactEdges();
+		for (int32 i = 0; i < bodyB->GetContactCount(); ++i)
 		{
-			if (edge->other == bodyA)
+			if (edges[i].other == bodyA)
 			{
 				// Flag the contact for filtering at the next time step (where either
 				// body is awake).
-				edge->contact->FlagForFiltering();
+				edges[i].contact->FlagForFiltering();
 			}
-
-			edge = edge->next;
 		}
 	}
 
@@ -319,19 +412,196 @@ void b2World::DestroyJoint(b2Joint* j)
 	// If the joint prevents collisions, then flag any contacts for filtering.
 	if (collideConnected == false)
 	{
-		b2ContactEdge* edge = bodyB->GetContactList();
-		while (edge)
+		b2ContactEdge* edges = bodyB->GetContactEdges();
+		for (int32 i = 0; i < bodyB->GetContactCount(); ++i)
 		{
-			if (edge->other == bodyA)
+			if (edges[i].other == bodyA)
 			{
 				// Flag the contact for filtering at the next time step (where either
 				// body is awake).
-				edge->contact->FlagForFiltering();
+				edges[i].contact->FlagForFiltering();
 			}
+		}
+	}
+}
+
+b2Sensor* b2World::CreateSensor(const b2SensorDef* def)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return NULL;
+	}
+
+	b2Assert(def->shape != NULL && def->body != NULL);
+
+	void* mem = m_blockAllocator.Allocate(sizeof(b2Sensor));
+	b2Sensor* s = new (mem) b2Sensor;
+	s->Create(&m_blockAllocator, def);
+
+	// Add to world doubly linked list.
+	s->m_prev = NULL;
+	s->m_next = m_sensorList;
+	if (m_sensorList)
+	{
+		m_sensorList->m_prev = s;
+	}
+	m_sensorList = s;
+	++m_sensorCount;
+
+	return s;
+}
+
+void b2World::DestroySensor(b2Sensor* s)
+{
+	b2Assert(m_sensorCount > 0);
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
 
-			edge = edge->next;
+	// Drop the events of the sensor.
+	int32 count = 0;
+	for (int32 i = 0; i < m_sensorEventCount; ++i)
+	{
+		if (m_sensorEvents[i].sensor != s)
+		{
+			m_sensorEvents[count++] = m_sensorEvents[i];
 		}
 	}
+	m_sensorEventCount = count;
+
+	// Remove from the doubly linked list.
+	if (s->m_prev)
+	{
+		s->m_prev->m_next = s->m_next;
+	}
+
+	if (s->m_next)
+	{
+		s->m_next->m_prev = s->m_prev;
+	}
+
+	if (s == m_sensorList)
+	{
+		m_sensorList = s->m_next;
+	}
+
+	--m_sensorCount;
+	s->Destroy(&m_blockAllocator);
+	s->~b2Sensor();
+	m_blockAllocator.Free(s, sizeof(b2Sensor));
+}
+
+b2Controller* b2World::CreateController(const b2ControllerDef* def)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return NULL;
+	}
+
+	b2Controller* c = b2Controller::Create(def, &m_blockAllocator);
+	c->m_world = this;
+
+	// Add to world doubly linked list.
+	c->m_prev = NULL;
+	c->m_next = m_controllerList;
+	if (m_controllerList)
+	{
+		m_controllerList->m_prev = c;
+	}
+	m_controllerList = c;
+	++m_controllerCount;
+
+	// Bodies are not woken up by the controller afterwards.
+	c->WakeBodies();
+
+	return c;
+}
+
+void b2World::DestroyController(b2Controller* c)
+{
+	b2Assert(m_controllerCount > 0);
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	// Remove from the doubly linked list.
+	if (c->m_prev)
+	{
+		c->m_prev->m_next = c->m_next;
+	}
+
+	if (c->m_next)
+	{
+		c->m_next->m_prev = c->m_prev;
+	}
+
+	if (c == m_controllerList)
+	{
+		m_controllerList = c->m_next;
+	}
+
+	--m_controllerCount;
+	b2Controller::Destroy(c, &m_blockAllocator);
+}
+
+b2ParticleSystem* b2World::CreateParticleSystem(const b2ParticleSystemDef* def)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return NULL;
+	}
+
+	void* mem = m_blockAllocator.Allocate(sizeof(b2ParticleSystem));
+	b2ParticleSystem* p = new (mem) b2ParticleSystem(def, this);
+
+	// Add to world doubly linked list.
+	p->m_prev = NULL;
+	p->m_next = m_particleSystemList;
+	if (m_particleSystemList)
+	{
+		m_particleSystemList->m_prev = p;
+	}
+	m_particleSystemList = p;
+	++m_particleSystemCount;
+
+	return p;
+}
+
+void b2World::DestroyParticleSystem(b2ParticleSystem* p)
+{
+	b2Assert(m_particleSystemCount > 0);
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	// Remove from the doubly linked list.
+	if (p->m_prev)
+	{
+		p->m_prev->m_next = p->m_next;
+	}
+
+	if (p->m_next)
+	{
+		p->m_next->m_prev = p->m_prev;
+	}
+
+	if (p == m_particleSystemList)
+	{
+		m_particleSystemList = p->m_next;
+	}
+
+	--m_particleSystemCount;
+	p->~b2ParticleSystem();
+	m_blockAllocator.Free(p, sizeof(b2ParticleSystem));
 }
 
 // Find islands, integrate and solve constraints, solve position constraints
@@ -349,9 +619,9 @@ void b2World::Solve(const b2TimeStep& step)
 	{
 		b->m_flags &= ~b2Body::e_islandFlag;
 	}
-	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
 	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
+		m_contactManager.m_contacts[i]->m_flags &= ~b2Contact::e_islandFlag;
 	}
 	for (b2Joint* j = m_jointList; j; j = j->m_next)
 	{
@@ -404,8 +674,9 @@ void b2World::Solve(const b2TimeStep& step)
 			}
 
 			// Search all contacts connected to this body.
-			for (b2ContactEdge* ce = b->m_contactList; ce; ce = ce->next)
+			for (int32 i = 0; i < b->m_contactCount; ++i)
 			{
+				b2ContactEdge* ce = b->m_contactEdges + i;
 				b2Contact* contact = ce->contact;
 
 				// Has this contact already been added to an island?
@@ -475,7 +746,55 @@ void b2World::Solve(const b2TimeStep& step)
 			}
 		}
 
-		island.Solve(step, m_gravity, m_allowSleep);
+		// Islands of bodies with a step interval are solved when one of
+		// them is due, with the time steps all of them missed.
+		bool due = false;
+		int32 stepCount = 0;
+		int32 stepCount0 = 1;
+		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		{
+			b2Body* b = island.m_bodies[i];
+			if (b->GetType() == b2_staticBody)
+			{
+				continue;
+			}
+
+			due = due || b->IsStepDue();
+			if (stepCount == 0 || b->m_stepsPending + 1 < stepCount)
+			{
+				stepCount = b->m_stepsPending + 1;
+				stepCount0 = b->m_stepsSolved;
+			}
+		}
+
+		if (due == false)
+		{
+			for (int32 i = 0; i < island.m_bodyCount; ++i)
+			{
+				b2Body* b = island.m_bodies[i];
+				if (b->GetType() != b2_staticBody)
+				{
+					// Not moving, as far as continuous collision is concerned.
+					++b->m_stepsPending;
+					b->m_sweep.c0 = b->m_sweep.c;
+					b->m_sweep.a0 = b->m_sweep.a;
+				}
+			}
+		}
+		else if (stepCount > 1 || stepCount0 > 1)
+		{
+			// The warm starting impulses are those of the last step of the
+			// island, which may have covered another number of time steps.
+			b2TimeStep catchUp = step;
+			catchUp.dt = stepCount * step.dt;
+			catchUp.inv_dt = step.inv_dt / stepCount;
+			catchUp.dtRatio = step.dtRatio * stepCount / stepCount0;
+			island.Solve(catchUp, m_gravity, m_allowSleep);
+		}
+		else
+		{
+			island.Solve(step, m_gravity, m_allowSleep);
+		}
 
 		// Post solve cleanup.
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
@@ -486,6 +805,11 @@ void b2World::Solve(const b2TimeStep& step)
 			{
 				b->m_flags &= ~b2Body::e_islandFlag;
 			}
+			else if (due)
+			{
+				b->m_stepsPending = 0;
+				b->m_stepsSolved = stepCount;
+			}
 		}
 	}
 
@@ -505,6 +829,12 @@ void b2World::Solve(const b2TimeStep& step)
 			continue;
 		}
 
+		// Nor did bodies waiting for their step.
+		if (b->m_stepsPending > 0)
+		{
+			continue;
+		}
+
 		// Update fixtures (for broad-phase).
 		b->SynchronizeFixtures();
 	}
@@ -513,143 +843,348 @@ void b2World::Solve(const b2TimeStep& step)
 	m_contactManager.FindNewContacts();
 }
 
-// Advance a dynamic body to its first time of contact
-// and adjust the position to ensure clearance.
-void b2World::SolveTOI(b2Body* body)
+// A time of impact event: the first contact a body hits over its sweep.
+struct b2TOIEvent
 {
-	// Find the minimum contact.
-	b2Contact* toiContact = NULL;
-	float32 toi = 1.0f;
-	b2Body* toiOther = NULL;
-	bool found;
-	int32 count;
-	int32 iter = 0;
+	b2Body* body;
+	b2Contact* contact;	// NULL if the body hits nothing
+	float32 toi;
+};
 
-	bool bullet = body->IsBullet();
+// The pending events, a binary heap of event indices ordered by time of
+// impact and then by index. m_positions[i] is the heap position of event i.
+class b2TOIQueue
+{
+public:
+	b2TOIQueue(const b2TOIEvent* events, int32* heap, int32* positions, int32 count)
+	{
+		m_events = events;
+		m_heap = heap;
+		m_positions = positions;
+		m_count = count;
+
+		for (int32 i = 0; i < count; ++i)
+		{
+			m_heap[i] = i;
+			m_positions[i] = i;
+		}
+
+		for (int32 i = count / 2 - 1; i >= 0; --i)
+		{
+			Down(i);
+		}
+	}
+
+	bool IsEmpty() const
+	{
+		return m_count == 0;
+	}
 
-	// Iterate until all contacts agree on the minimum TOI. We have
-	// to iterate because the TOI algorithm may skip some intermediate
-	// collisions when objects rotate through each other.
-	do
+	// Remove the earliest event.
+	int32 Pop()
 	{
-		count = 0;
-		found = false;
-		for (b2ContactEdge* ce = body->m_contactList; ce; ce = ce->next)
+		int32 index = m_heap[0];
+		--m_count;
+		if (m_count > 0)
 		{
-			if (ce->contact == toiContact)
-			{
-				continue;
-			}
+			Place(0, m_heap[m_count]);
+			Down(0);
+		}
+		m_positions[index] = -1;
+		return index;
+	}
 
-			b2Body* other = ce->other;
-			b2BodyType type = other->GetType();
+	// Reorder a pending event after its time of impact changed.
+	void Update(int32 index)
+	{
+		int32 position = m_positions[index];
+		b2Assert(position != -1);
+		Up(position);
+		Down(m_positions[index]);
+	}
 
-			// Only bullets perform TOI with dynamic bodies.
-			if (bullet == true)
-			{
-				// Bullets only perform TOI with bodies that have their TOI resolved.
-				if ((other->m_flags & b2Body::e_toiFlag) == 0)
-				{
-					continue;
-				}
+private:
+	bool Less(int32 a, int32 b) const
+	{
+		float32 toiA = m_events[a].toi;
+		float32 toiB = m_events[b].toi;
+		return toiA < toiB || (toiA == toiB && a < b);
+	}
 
-				// No repeated hits on non-static bodies
-				if (type != b2_staticBody && (ce->contact->m_flags & b2Contact::e_bulletHitFlag) != 0)
-				{
-						continue;
-				}
-			}
-			else if (type == b2_dynamicBody)
-			{
-				continue;
-			}
+	void Place(int32 position, int32 index)
+	{
+		m_heap[position] = index;
+		m_positions[index] = position;
+	}
 
-			// Check for a disabled contact.
-			b2Contact* contact = ce->contact;
-			if (contact->IsEnabled() == false)
+	void Up(int32 position)
+	{
+		int32 index = m_heap[position];
+		while (position > 0)
+		{
+			int32 parent = (position - 1) / 2;
+			if (Less(index, m_heap[parent]) == false)
 			{
-				continue;
+				break;
 			}
 
-			// Prevent infinite looping.
-			if (contact->m_toiCount > 10)
+			Place(position, m_heap[parent]);
+			position = parent;
+		}
+		Place(position, index);
+	}
+
+	void Down(int32 position)
+	{
+		int32 index = m_heap[position];
+		for (;;)
+		{
+			int32 child = 2 * position + 1;
+			if (child >= m_count)
 			{
-				continue;
+				break;
 			}
 
-			b2Fixture* fixtureA = contact->m_fixtureA;
-			b2Fixture* fixtureB = contact->m_fixtureB;
-
-			// Cull sensors.
-			if (fixtureA->IsSensor() || fixtureB->IsSensor())
+			if (child + 1 < m_count && Less(m_heap[child + 1], m_heap[child]))
 			{
-				continue;
+				++child;
 			}
 
-			b2Body* bodyA = fixtureA->m_body;
-			b2Body* bodyB = fixtureB->m_body;
-
-			// Compute the time of impact in interval [0, minTOI]
-			b2TOIInput input;
-			input.proxyA.Set(fixtureA->GetShape());
-			input.proxyB.Set(fixtureB->GetShape());
-			input.sweepA = bodyA->m_sweep;
-			input.sweepB = bodyB->m_sweep;
-			input.tMax = toi;
-
-			b2TOIOutput output;
-			b2TimeOfImpact(&output, &input);
-
-			if (output.state == b2TOIOutput::e_touching && output.t < toi)
+			if (Less(m_heap[child], index) == false)
 			{
-				toiContact = contact;
-				toi = output.t;
-				toiOther = other;
-				found = true;
+				break;
 			}
 
-			++count;
+			Place(position, m_heap[child]);
+			position = child;
 		}
+		Place(position, index);
+	}
 
-		++iter;
-	} while (found && count > 1 && iter < 50);
+	const b2TOIEvent* m_events;
+	int32* m_heap;
+	int32* m_positions;
+	int32 m_count;
+};
 
-	if (toiContact == NULL)
+// Finds the events of a range of bodies, counting the queries per thread.
+class b2TOITask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
 	{
-		body->Advance(1.0f);
-		return;
+		for (int32 i = begin; i < end; ++i)
+		{
+			b2World::FindMinTOI(m_events + i, m_stats + threadIndex);
+		}
 	}
 
-	b2Sweep backup = body->m_sweep;
-	body->Advance(toi);
-	toiContact->Update(m_contactManager.m_contactListener);
-	if (toiContact->IsEnabled() == false)
-	{
-		// Contact disabled. Backup and recurse.
-		body->m_sweep = backup;
-		SolveTOI(body);
-	}
+	b2TOIEvent* m_events;
+	b2TOIStats* m_stats;
+};
 
-	++toiContact->m_toiCount;
+// Find the first contact hit by the body of the event. A body only considers
+// contacts with bodies the TOI doesn't move, which no other body considers,
+// so bodies are searched in parallel. For the same reason the times of impact
+// cached in the contacts stay valid until the body is advanced, after which
+// they aren't looked at anymore.
+void b2World::FindMinTOI(b2TOIEvent* event)
+{
+	b2TOIStats stats;
+	FindMinTOI(event, &stats);
+	b2AddTOIStats(stats);
+}
 
-	// Update all the valid contacts on this body and build a contact island.
-	b2Contact* contacts[b2_maxTOIContacts];
-	count = 0;
-	for (b2ContactEdge* ce = body->m_contactList; ce && count < b2_maxTOIContacts; ce = ce->next)
+void b2World::FindMinTOI(b2TOIEvent* event, b2TOIStats* stats)
+{
+	b2Body* body = event->body;
+	bool bullet = body->IsBullet();
+
+	event->contact = NULL;
+	event->toi = 1.0f;
+
+	for (int32 i = 0; i < body->m_contactCount; ++i)
 	{
+		b2ContactEdge* ce = body->m_contactEdges + i;
 		b2Body* other = ce->other;
 		b2BodyType type = other->GetType();
 
-		// Only perform correction with static bodies, so the
-		// body won't get pushed out of the world.
-		if (type == b2_dynamicBody)
+		// Only bullets perform TOI with dynamic bodies.
+		if (bullet == true)
 		{
-			continue;
-		}
+			// Bullets only perform TOI with bodies that have their TOI resolved.
+			if ((other->m_flags & b2Body::e_toiFlag) == 0)
+			{
+				continue;
+			}
 
-		// Check for a disabled contact.
-		b2Contact* contact = ce->contact;
-		if (contact->IsEnabled() == false)
+			// No repeated hits on non-static bodies
+			if (type != b2_staticBody && (ce->contact->m_flags & b2Contact::e_bulletHitFlag) != 0)
+			{
+					continue;
+			}
+		}
+		else if (type == b2_dynamicBody)
+		{
+			continue;
+		}
+
+		// Check for a disabled contact.
+		b2Contact* contact = ce->contact;
+		if (contact->IsEnabled() == false)
+		{
+			continue;
+		}
+
+		// Prevent infinite looping.
+		if (contact->m_toiCount > 10)
+		{
+			continue;
+		}
+
+		b2Fixture* fixtureA = contact->m_fixtureA;
+		b2Fixture* fixtureB = contact->m_fixtureB;
+
+		// Cull sensors.
+		if (fixtureA->IsSensor() || fixtureB->IsSensor())
+		{
+			continue;
+		}
+
+		if (contact->m_flags & b2Contact::e_toiFlag)
+		{
+			// Can't beat the minimum found so far.
+			if (contact->m_toi >= event->toi)
+			{
+				continue;
+			}
+
+			if (contact->m_flags & b2Contact::e_toiHitFlag)
+			{
+				event->contact = contact;
+				event->toi = contact->m_toi;
+				continue;
+			}
+		}
+
+		b2Body* bodyA = fixtureA->m_body;
+		b2Body* bodyB = fixtureB->m_body;
+
+		// Compute the time of impact in interval [0, minTOI]
+		b2TOIInput input;
+		input.proxyA.Set(fixtureA->GetShape());
+		input.proxyB.Set(fixtureB->GetShape());
+		input.sweepA = bodyA->m_sweep;
+		input.sweepB = bodyB->m_sweep;
+		input.tMax = event->toi;
+
+		b2TOIOutput output;
+		b2TimeOfImpact(&output, &input, &contact->m_simplexCache, stats);
+
+		contact->m_flags |= b2Contact::e_toiFlag;
+		if (output.state == b2TOIOutput::e_touching && output.t < event->toi)
+		{
+			contact->m_toi = output.t;
+			contact->m_flags |= b2Contact::e_toiHitFlag;
+
+			event->contact = contact;
+			event->toi = output.t;
+		}
+		else
+		{
+			contact->m_toi = event->toi;
+			contact->m_flags &= ~b2Contact::e_toiHitFlag;
+		}
+	}
+}
+
+static void b2FindMinTOIs(b2TaskScheduler* scheduler, b2StackAllocator* allocator, b2TOIEvent* events, int32 count)
+{
+	int32 threadCount = scheduler ? scheduler->GetThreadCount() : 1;
+	b2TOIStats* stats = (b2TOIStats*)allocator->Allocate(threadCount * sizeof(b2TOIStats));
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		new (stats + i) b2TOIStats;
+	}
+
+	b2TOITask task;
+	task.m_events = events;
+	task.m_stats = stats;
+
+	if (threadCount > 1 && count > b2_toiTaskRange)
+	{
+		scheduler->Run(&task, count, b2_toiTaskRange);
+	}
+	else
+	{
+		task.Execute(0, count, 0);
+	}
+
+	// The profiling globals are only written by this thread.
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		b2AddTOIStats(stats[i]);
+	}
+	allocator->Free(stats);
+}
+
+// Advance a dynamic body to its first time of contact
+// and adjust the position to ensure clearance.
+void b2World::SolveTOI(b2TOIEvent* event)
+{
+	b2Body* body = event->body;
+
+	// Find the first contact the listener leaves enabled.
+	b2Contact* toiContact;
+	for (;;)
+	{
+		toiContact = event->contact;
+		if (toiContact == NULL)
+		{
+			body->Advance(1.0f);
+			break;
+		}
+
+		b2Sweep backup = body->m_sweep;
+		body->Advance(event->toi);
+		toiContact->Update(m_contactManager.m_contactListener);
+		if (toiContact->IsEnabled() == true)
+		{
+			break;
+		}
+
+		// Contact disabled. Backup and look again, the other
+		// times of impact are still cached.
+		body->m_sweep = backup;
+		FindMinTOI(event);
+	}
+
+	if (toiContact == NULL)
+	{
+		return;
+	}
+
+	++toiContact->m_toiCount;
+
+	// Update all the valid contacts on this body and build a contact island.
+	b2Contact* contacts[b2_maxTOIContacts];
+	int32 count = 0;
+	for (int32 i = 0; i < body->m_contactCount && count < b2_maxTOIContacts; ++i)
+	{
+		b2ContactEdge* ce = body->m_contactEdges + i;
+		b2Body* other = ce->other;
+		b2BodyType type = other->GetType();
+
+		// Only perform correction with static bodies, so the
+		// body won't get pushed out of the world.
+		if (type == b2_dynamicBody)
+		{
+			continue;
+		}
+
+		// Check for a disabled contact.
+		b2Contact* contact = ce->contact;
+		if (contact->IsEnabled() == false)
 		{
 			continue;
 		}
@@ -702,77 +1237,245 @@ void b2World::SolveTOI(b2Body* body)
 		}
 	}
 
+	b2Body* toiOther = toiContact->m_fixtureA->m_body;
+	if (toiOther == body)
+	{
+		toiOther = toiContact->m_fixtureB->m_body;
+	}
+
 	if (toiOther->GetType() != b2_staticBody)
 	{
 			toiContact->m_flags |= b2Contact::e_bulletHitFlag;
 	}
 }
 
-// Sequentially solve TOIs for each body. We bring each
+// Solve the events of the bullets or of the other bodies with their TOI
+// unresolved, earliest first.
+void b2World::SolveTOIEvents(bool bullets, int32 count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// The stack allocator doesn't align, so the int32 arrays come last.
+	b2TOIEvent* events = (b2TOIEvent*)m_stackAllocator.Allocate(count * sizeof(b2TOIEvent));
+	int32* heap = (int32*)m_stackAllocator.Allocate(count * sizeof(int32));
+	int32* positions = (int32*)m_stackAllocator.Allocate(count * sizeof(int32));
+
+	// The island index is free during the TOI, it locates the event of a bullet.
+	int32 index = 0;
+	for (b2Body* body = m_bodyList; body; body = body->m_next)
+	{
+		if ((body->m_flags & b2Body::e_toiFlag) == 0 && body->IsBullet() == bullets)
+		{
+			events[index].body = body;
+			body->m_islandIndex = index;
+			++index;
+		}
+	}
+	b2Assert(index == count);
+
+	b2FindMinTOIs(m_taskScheduler, &m_stackAllocator, events, count);
+
+	// Other bodies don't hit a non-bullet later, so only those hitting
+	// something are queued.
+	if (bullets == false)
+	{
+		int32 eventCount = 0;
+		for (int32 i = 0; i < count; ++i)
+		{
+			if (events[i].contact == NULL)
+			{
+				SolveTOI(events + i);
+				events[i].body->m_flags |= b2Body::e_toiFlag;
+			}
+			else
+			{
+				events[eventCount++] = events[i];
+			}
+		}
+		count = eventCount;
+	}
+
+	b2TOIQueue queue(events, heap, positions, count);
+	while (queue.IsEmpty() == false)
+	{
+		b2TOIEvent* event = events + queue.Pop();
+		SolveTOI(event);
+
+		b2Body* body = event->body;
+		body->m_flags |= b2Body::e_toiFlag;
+
+		if (bullets == false)
+		{
+			continue;
+		}
+
+		// The pending bullets touching this one may hit it now.
+		for (int32 i = 0; i < body->m_contactCount; ++i)
+		{
+			b2Body* other = body->m_contactEdges[i].other;
+			if ((other->m_flags & b2Body::e_toiFlag) == 0 && other->IsBullet() == true)
+			{
+				FindMinTOI(events + other->m_islandIndex);
+				queue.Update(other->m_islandIndex);
+			}
+		}
+	}
+
+	m_stackAllocator.Free(positions);
+	m_stackAllocator.Free(heap);
+	m_stackAllocator.Free(events);
+}
+
+// Solve TOIs for each body, earliest first. We bring each
 // body to the time of contact and perform some position correction.
 // Time is not conserved.
 void b2World::SolveTOI()
 {
 	// Prepare all contacts.
-	for (b2Contact* c = m_contactManager.m_contactList; c; c = c->m_next)
+	for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
 	{
+		b2Contact* c = m_contactManager.m_contacts[i];
 		// Enable the contact
 		c->m_flags |= b2Contact::e_enabledFlag;
 
+		// The sweeps are new.
+		c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_toiHitFlag);
+
 		// Set the number of TOI events for this contact to zero.
 		c->m_toiCount = 0;
 	}
 
 	// Initialize the TOI flag.
+	int32 bodyCount = 0;
+	int32 bulletCount = 0;
 	for (b2Body* body = m_bodyList; body; body = body->m_next)
 	{
 		// Kinematic, and static bodies will not be affected by the TOI event.
 		// If a body was not in an island then it did not move.
-		if ((body->m_flags & b2Body::e_islandFlag) == 0 || body->GetType() == b2_kinematicBody || body->GetType() == b2_staticBody)
+		if ((body->m_flags & b2Body::e_islandFlag) == 0 || body->m_stepsPending > 0 || body->GetType() == b2_kinematicBody || body->GetType() == b2_staticBody)
 		{
 			body->m_flags |= b2Body::e_toiFlag;
 		}
 		else
 		{
 			body->m_flags &= ~b2Body::e_toiFlag;
+
+			if (body->IsBullet() == true)
+			{
+				++bulletCount;
+			}
+			else
+			{
+				++bodyCount;
+			}
 		}
 	}
 
-	// Collide non-bullets.
-	for (b2Body* body = m_bodyList; body; body = body->m_next)
+	// Collide non-bullets. They only hit bodies the TOI doesn't move,
+	// so their events are independent and found in parallel.
+	SolveTOIEvents(false, bodyCount);
+
+	// Collide bullets. They hit bodies with their TOI resolved, which
+	// includes the bullets solved before them.
+	SolveTOIEvents(true, bulletCount);
+}
+
+// Finds the overlaps of a range of sensors, counting the queries per thread.
+class b2SensorTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
 	{
-		if (body->m_flags & b2Body::e_toiFlag)
+		for (int32 i = begin; i < end; ++i)
 		{
-			continue;
+			m_sensors[i]->Update(m_broadPhase, m_stats + threadIndex);
 		}
+	}
 
-		if (body->IsBullet() == true)
-		{
-			continue;
-		}
+	b2Sensor** m_sensors;
+	const b2BroadPhase* m_broadPhase;
+	b2DistanceStats* m_stats;
+};
 
-		SolveTOI(body);
+// Each sensor queries the broad-phase once with its final transform. The
+// queries run in parallel, the events are then reported in list order.
+void b2World::UpdateSensors()
+{
+	m_sensorEventCount = 0;
 
-		body->m_flags |= b2Body::e_toiFlag;
+	if (m_sensorCount == 0)
+	{
+		return;
 	}
 
-	// Collide bullets.
-	for (b2Body* body = m_bodyList; body; body = body->m_next)
+	b2Sensor** sensors = (b2Sensor**)m_stackAllocator.Allocate(m_sensorCount * sizeof(b2Sensor*));
+	int32 count = 0;
+	for (b2Sensor* s = m_sensorList; s; s = s->m_next)
 	{
-		if (body->m_flags & b2Body::e_toiFlag)
-		{
-			continue;
-		}
+		sensors[count++] = s;
+	}
 
-		if (body->IsBullet() == false)
-		{
-			continue;
-		}
+	int32 threadCount = m_taskScheduler->GetThreadCount();
+	b2DistanceStats* stats = (b2DistanceStats*)m_stackAllocator.Allocate(threadCount * sizeof(b2DistanceStats));
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		new (stats + i) b2DistanceStats;
+	}
 
-		SolveTOI(body);
+	b2SensorTask task;
+	task.m_sensors = sensors;
+	task.m_broadPhase = &m_contactManager.m_broadPhase;
+	task.m_stats = stats;
 
-		body->m_flags |= b2Body::e_toiFlag;
+	if (threadCount > 1 && count > b2_sensorTaskRange)
+	{
+		m_taskScheduler->Run(&task, count, b2_sensorTaskRange);
+	}
+	else
+	{
+		task.Execute(0, count, 0);
+	}
+
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		b2AddDistanceStats(stats[i]);
+	}
+	m_stackAllocator.Free(stats);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		sensors[i]->Report(&m_sensorEvents, &m_sensorEventCount, &m_sensorEventCapacity);
+	}
+
+	m_stackAllocator.Free(sensors);
+}
+
+// Called before a fixture loses its proxy, after which its proxy id may be
+// reused and the fixture freed.
+void b2World::RemoveSensorOverlaps(b2Fixture* fixture)
+{
+	if (m_sensorCount == 0 || fixture->m_proxyId == b2BroadPhase::e_nullProxy)
+	{
+		return;
+	}
+
+	for (b2Sensor* s = m_sensorList; s; s = s->m_next)
+	{
+		s->RemoveFixture(fixture);
+	}
+
+	int32 count = 0;
+	for (int32 i = 0; i < m_sensorEventCount; ++i)
+	{
+		if (m_sensorEvents[i].fixture != fixture)
+		{
+			m_sensorEvents[count++] = m_sensorEvents[i];
+		}
 	}
+	m_sensorEventCount = count;
 }
 
 void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
@@ -802,6 +1505,8 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.dtRatio = m_inv_dt0 * dt;
 
 	step.warmStarting = m_warmStarting;
+	step.jointTrees = m_jointTrees;
+	step.subStepping = m_subStepping;
 
 	// Update contacts. This is where some contacts are destroyed.
 	m_contactManager.Collide();
@@ -809,6 +1514,16 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	// Integrate velocities, solve velocity constraints, and integrate positions.
 	if (step.dt > 0.0f)
 	{
+		for (b2Controller* c = m_controllerList; c; c = c->m_next)
+		{
+			c->Step(step);
+		}
+
+		for (b2ParticleSystem* p = m_particleSystemList; p; p = p->m_next)
+		{
+			p->Solve(step, m_gravity);
+		}
+
 		Solve(step);
 	}
 
@@ -823,6 +1538,9 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 		m_inv_dt0 = step.inv_dt;
 	}
 
+	// Report the sensor overlaps at the new positions.
+	UpdateSensors();
+
 	if (m_flags & e_clearForces)
 	{
 		ClearForces();
@@ -895,52 +1613,217 @@ void b2World::RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b
 	m_contactManager.m_broadPhase.RayCast(&wrapper, input);
 }
 
-void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color)
+struct b2ExplosionImpulse
 {
-	switch (fixture->GetType())
+	b2Body* body;
+	b2Vec2 impulse;
+	b2Vec2 point;
+};
+
+// Finds the impulses of the fixtures in reach of an explosion, they are only
+// applied once the query is over.
+class b2ExplosionQuery : public b2QueryCallback
+{
+public:
+	b2ExplosionQuery(const b2World* world, const b2ExplosionDef* def)
 	{
-	case b2Shape::e_circle:
-		{
-			b2CircleShape* circle = (b2CircleShape*)fixture->GetShape();
+		m_world = world;
+		m_def = def;
+		m_impulses = NULL;
+		m_count = 0;
+		m_capacity = 0;
+	}
 
-			b2Vec2 center = b2Mul(xf, circle->m_p);
-			float32 radius = circle->m_radius;
-			b2Vec2 axis = xf.R.col1;
+	~b2ExplosionQuery()
+	{
+		b2Free(m_impulses);
+	}
 
-			m_debugDraw->DrawSolidCircle(center, radius, axis, color);
-		}
-		break;
+	bool ReportFixture(b2Fixture* fixture);
 
-	case b2Shape::e_polygon:
-		{
-			b2PolygonShape* poly = (b2PolygonShape*)fixture->GetShape();
-			int32 vertexCount = poly->m_vertexCount;
-			b2Assert(vertexCount <= b2_maxPolygonVertices);
-			b2Vec2 vertices[b2_maxPolygonVertices];
+	const b2World* m_world;
+	const b2ExplosionDef* m_def;
+	b2ExplosionImpulse* m_impulses;
+	int32 m_count;
+	int32 m_capacity;
+};
 
-			for (int32 i = 0; i < vertexCount; ++i)
-			{
-				vertices[i] = b2Mul(xf, poly->m_vertices[i]);
-			}
+// Looks for anything but the pushed body between the center and a fixture.
+class b2ExplosionOcclusion : public b2RayCastCallback
+{
+public:
+	float32 ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float32 fraction)
+	{
+		B2_NOT_USED(point);
+		B2_NOT_USED(normal);
+		B2_NOT_USED(fraction);
 
-			m_debugDraw->DrawSolidPolygon(vertices, vertexCount, color);
+		if (fixture->GetBody() == m_body || fixture->IsSensor())
+		{
+			return -1.0f;
 		}
-		break;
+
+		m_occluded = true;
+		return 0.0f;
 	}
-}
 
-void b2World::DrawJoint(b2Joint* joint)
-{
-	b2Body* bodyA = joint->GetBodyA();
-	b2Body* bodyB = joint->GetBodyB();
-	const b2Transform& xf1 = bodyA->GetTransform();
-	const b2Transform& xf2 = bodyB->GetTransform();
-	b2Vec2 x1 = xf1.position;
-	b2Vec2 x2 = xf2.position;
-	b2Vec2 p1 = joint->GetAnchorA();
-	b2Vec2 p2 = joint->GetAnchorB();
+	const b2Body* m_body;
+	bool m_occluded;
+};
 
-	b2Color color(0.5f, 0.8f, 0.8f);
+bool b2ExplosionQuery::ReportFixture(b2Fixture* fixture)
+{
+	b2Body* body = fixture->GetBody();
+	if (body->GetType() != b2_dynamicBody || fixture->IsSensor())
+	{
+		return true;
+	}
+
+	if ((fixture->GetFilterData().categoryBits & m_def->maskBits) == 0)
+	{
+		return true;
+	}
+
+	// The closest point of the fixture to the center.
+	b2DistanceInput input;
+	input.proxyA.Set(fixture->GetShape());
+	input.proxyB.m_vertices = &m_def->position;
+	input.proxyB.m_count = 1;
+	input.proxyB.m_radius = 0.0f;
+	input.transformA = body->GetTransform();
+	input.transformB.SetIdentity();
+	input.useRadii = true;
+
+	b2SimplexCache cache;
+	cache.count = 0;
+	b2DistanceOutput output;
+	b2Distance(&output, &cache, &input);
+
+	float32 reach = m_def->radius + m_def->falloff;
+	if (output.distance > reach)
+	{
+		return true;
+	}
+
+	float32 scale = 1.0f;
+	if (output.distance > m_def->radius)
+	{
+		scale = (reach - output.distance) / m_def->falloff;
+	}
+
+	// A center inside the fixture pushes it from its center of mass.
+	b2Vec2 d = output.pointA - m_def->position;
+	if (d.LengthSquared() < b2_epsilon * b2_epsilon)
+	{
+		d = body->GetWorldCenter() - m_def->position;
+	}
+
+	if (d.Normalize() < b2_epsilon)
+	{
+		return true;
+	}
+
+	if (m_def->occlusion && output.distance > b2_linearSlop)
+	{
+		b2ExplosionOcclusion occlusion;
+		occlusion.m_body = body;
+		occlusion.m_occluded = false;
+		m_world->RayCast(&occlusion, m_def->position, output.pointA);
+
+		if (occlusion.m_occluded)
+		{
+			return true;
+		}
+	}
+
+	if (m_count == m_capacity)
+	{
+		m_capacity = b2Max(2 * m_capacity, 16);
+		b2ExplosionImpulse* impulses = (b2ExplosionImpulse*)b2Alloc(m_capacity * sizeof(b2ExplosionImpulse));
+		if (m_count > 0)
+		{
+			memcpy(impulses, m_impulses, m_count * sizeof(b2ExplosionImpulse));
+		}
+		b2Free(m_impulses);
+		m_impulses = impulses;
+	}
+
+	b2ExplosionImpulse* impulse = m_impulses + m_count++;
+	impulse->body = body;
+	impulse->impulse = (scale * m_def->impulse) * d;
+	impulse->point = output.pointA;
+
+	return true;
+}
+
+int32 b2World::Explode(const b2ExplosionDef& def)
+{
+	b2Assert(IsLocked() == false);
+	b2Assert(def.radius >= 0.0f && def.falloff >= 0.0f);
+
+	b2Vec2 reach(def.radius + def.falloff, def.radius + def.falloff);
+	b2AABB aabb;
+	aabb.lowerBound = def.position - reach;
+	aabb.upperBound = def.position + reach;
+
+	b2ExplosionQuery query(this, &def);
+	QueryAABB(&query, aabb);
+
+	for (int32 i = 0; i < query.m_count; ++i)
+	{
+		const b2ExplosionImpulse* impulse = query.m_impulses + i;
+		impulse->body->ApplyLinearImpulse(impulse->impulse, impulse->point);
+	}
+
+	return query.m_count;
+}
+
+void b2World::DrawShape(b2Fixture* fixture, const b2Transform& xf, const b2Color& color)
+{
+	switch (fixture->GetType())
+	{
+	case b2Shape::e_circle:
+		{
+			b2CircleShape* circle = (b2CircleShape*)fixture->GetShape();
+
+			b2Vec2 center = b2Mul(xf, circle->m_p);
+			float32 radius = circle->m_radius;
+			b2Vec2 axis = xf.R.col1;
+
+			m_debugDraw->DrawSolidCircle(center, radius, axis, color);
+		}
+		break;
+
+	case b2Shape::e_polygon:
+		{
+			b2PolygonShape* poly = (b2PolygonShape*)fixture->GetShape();
+			int32 vertexCount = poly->m_vertexCount;
+			b2Assert(vertexCount <= b2_maxPolygonVertices);
+			b2Vec2 vertices[b2_maxPolygonVertices];
+
+			for (int32 i = 0; i < vertexCount; ++i)
+			{
+				vertices[i] = b2Mul(xf, poly->m_vertices[i]);
+			}
+
+			m_debugDraw->DrawSolidPolygon(vertices, vertexCount, color);
+		}
+		break;
+	}
+}
+
+void b2World::DrawJoint(b2Joint* joint)
+{
+	b2Body* bodyA = joint->GetBodyA();
+	b2Body* bodyB = joint->GetBodyB();
+	const b2Transform& xf1 = bodyA->GetTransform();
+	const b2Transform& xf2 = bodyB->GetTransform();
+	b2Vec2 x1 = xf1.position;
+	b2Vec2 x2 = xf2.position;
+	b2Vec2 p1 = joint->GetAnchorA();
+	b2Vec2 p2 = joint->GetAnchorB();
+
+	b2Color color(0.5f, 0.8f, 0.8f);
 
 	switch (joint->GetType())
 	{
@@ -1021,8 +1904,9 @@ void b2World::DrawDebugData()
 	if (flags & b2DebugDraw::e_pairBit)
 	{
 		b2Color color(0.3f, 0.9f, 0.9f);
-		for (b2Contact* c = m_contactManager.m_contactList; c; c = c->GetNext())
+		for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
 		{
+			b2Contact* c = m_contactManager.m_contacts[i];
 			b2Fixture* fixtureA = c->GetFixtureA();
 			b2Fixture* fixtureB = c->GetFixtureB();
 
@@ -1074,3 +1958,935 @@ int32 b2World::GetProxyCount() const
 {
 	return m_contactManager.m_broadPhase.GetProxyCount();
 }
+
+void b2World::ShiftOrigin(const b2Vec2& newOrigin)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return;
+	}
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b->m_xf.position -= newOrigin;
+		b->m_sweep.c0 -= newOrigin;
+		b->m_sweep.c -= newOrigin;
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		j->ShiftOrigin(newOrigin);
+	}
+
+	for (b2Controller* c = m_controllerList; c; c = c->m_next)
+	{
+		c->m_origin -= newOrigin;
+	}
+
+	for (b2ParticleSystem* p = m_particleSystemList; p; p = p->m_next)
+	{
+		for (int32 i = 0; i < p->m_count; ++i)
+		{
+			p->m_x[i] -= newOrigin.x;
+			p->m_y[i] -= newOrigin.y;
+		}
+	}
+
+	m_contactManager.m_broadPhase.ShiftOrigin(newOrigin);
+}
+
+// Layout of a saved world state. The header is followed by one record for
+// each body, fixture, joint and contact, in list or array order, then by the
+// nodes of the broad-phase tree and its move buffer, then by the particle
+// count of each particle system followed by its particle arrays.
+struct b2WorldStateHeader
+{
+	uint32 magic;
+	int32 size;
+	int32 bodyCount;
+	int32 fixtureCount;
+	int32 jointCount;
+	int32 contactCount;
+	int32 flags;
+	float32 inv_dt0;
+	int32 proxyCount;
+	int32 root;
+	int32 nodeCount;
+	int32 nodeCapacity;
+	int32 freeList;
+	uint32 path;
+	int32 insertionCount;
+	int32 moveCount;
+	int32 particleSystemCount;
+};
+
+struct b2BodyState
+{
+	b2BodyType type;
+	uint16 flags;
+	int32 islandIndex;
+	b2Transform xf;
+	b2Sweep sweep;
+	b2Vec2 linearVelocity;
+	float32 angularVelocity;
+	b2Vec2 force;
+	float32 torque;
+	float32 mass, invMass;
+	float32 I, invI;
+	float32 linearDamping;
+	float32 angularDamping;
+	float32 sleepTime;
+	int32 stepInterval;
+	int32 stepsPending;
+	int32 stepsSolved;
+	int32 fixtureCount;
+};
+
+struct b2FixtureState
+{
+	b2AABB aabb;
+	float32 density;
+	float32 friction;
+	float32 restitution;
+	int32 proxyId;
+	b2Filter filter;
+	bool isSensor;
+	uint32 generation;
+};
+
+// Contacts refer to their fixtures by proxy, the broad-phase maps them back.
+struct b2ContactState
+{
+	int32 proxyIdA;
+	int32 proxyIdB;
+	uint32 flags;
+	int32 toiCount;
+	b2Manifold manifold;
+	b2Transform manifoldXf;
+	b2SimplexCache simplexCache;
+	int32 edgeA;
+	int32 edgeB;
+};
+
+// Joints are saved whole, preceded by their type.
+static int32 b2GetJointSize(b2JointType type)
+{
+	switch (type)
+	{
+	case e_distanceJoint:
+		return sizeof(b2DistanceJoint);
+	case e_mouseJoint:
+		return sizeof(b2MouseJoint);
+	case e_prismaticJoint:
+		return sizeof(b2PrismaticJoint);
+	case e_revoluteJoint:
+		return sizeof(b2RevoluteJoint);
+	case e_pulleyJoint:
+		return sizeof(b2PulleyJoint);
+	case e_gearJoint:
+		return sizeof(b2GearJoint);
+	case e_lineJoint:
+		return sizeof(b2LineJoint);
+	case e_weldJoint:
+		return sizeof(b2WeldJoint);
+	case e_frictionJoint:
+		return sizeof(b2FrictionJoint);
+	default:
+		b2Assert(false);
+		return 0;
+	}
+}
+
+const uint32 b2_worldStateMagic = 0x62325753;
+
+int32 b2World::GetStateSize() const
+{
+	int32 size = sizeof(b2WorldStateHeader);
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		size += sizeof(b2BodyState);
+		size += b->m_fixtureCount * sizeof(b2FixtureState);
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		size += sizeof(int32) + b2GetJointSize(j->m_type);
+	}
+
+	const b2BroadPhase& broadPhase = m_contactManager.m_broadPhase;
+	size += m_contactManager.m_contactCount * sizeof(b2ContactState);
+	size += broadPhase.m_tree.m_nodeCapacity * sizeof(b2DynamicTreeNode);
+	size += broadPhase.m_moveCount * sizeof(int32);
+
+	for (b2ParticleSystem* p = m_particleSystemList; p; p = p->m_next)
+	{
+		size += sizeof(int32) + 4 * p->m_count * sizeof(float32);
+	}
+
+	return size;
+}
+
+int32 b2World::SaveState(void* buffer, int32 bufferSize) const
+{
+	int32 size = GetStateSize();
+	if (bufferSize < size)
+	{
+		return 0;
+	}
+
+	const b2BroadPhase& broadPhase = m_contactManager.m_broadPhase;
+	const b2DynamicTree& tree = broadPhase.m_tree;
+
+	b2WorldStateHeader header;
+	header.magic = b2_worldStateMagic;
+	header.size = size;
+	header.bodyCount = m_bodyCount;
+	header.fixtureCount = 0;
+	header.jointCount = m_jointCount;
+	header.contactCount = m_contactManager.m_contactCount;
+	header.flags = m_flags & ~e_locked;
+	header.inv_dt0 = m_inv_dt0;
+	header.proxyCount = broadPhase.m_proxyCount;
+	header.root = tree.m_root;
+	header.nodeCount = tree.m_nodeCount;
+	header.nodeCapacity = tree.m_nodeCapacity;
+	header.freeList = tree.m_freeList;
+	header.path = tree.m_path;
+	header.insertionCount = tree.m_insertionCount;
+	header.moveCount = broadPhase.m_moveCount;
+	header.particleSystemCount = m_particleSystemCount;
+
+	char* data = (char*)buffer + sizeof(b2WorldStateHeader);
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b2BodyState state;
+		state.type = b->m_type;
+		state.flags = b->m_flags;
+		state.islandIndex = b->m_islandIndex;
+		state.xf = b->m_xf;
+		state.sweep = b->m_sweep;
+		state.linearVelocity = b->m_linearVelocity;
+		state.angularVelocity = b->m_angularVelocity;
+		state.force = b->m_force;
+		state.torque = b->m_torque;
+		state.mass = b->m_mass;
+		state.invMass = b->m_invMass;
+		state.I = b->m_I;
+		state.invI = b->m_invI;
+		state.linearDamping = b->m_linearDamping;
+		state.angularDamping = b->m_angularDamping;
+		state.sleepTime = b->m_sleepTime;
+		state.stepInterval = b->m_stepInterval;
+		state.stepsPending = b->m_stepsPending;
+		state.stepsSolved = b->m_stepsSolved;
+		state.fixtureCount = b->m_fixtureCount;
+		memcpy(data, &state, sizeof(state));
+		data += sizeof(state);
+	}
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			b2FixtureState state;
+			state.aabb = f->m_aabb;
+			state.density = f->m_density;
+			state.friction = f->m_friction;
+			state.restitution = f->m_restitution;
+			state.proxyId = f->m_proxyId;
+			state.filter = f->m_filter;
+			state.isSensor = f->m_isSensor;
+			state.generation = f->m_generation;
+			memcpy(data, &state, sizeof(state));
+			data += sizeof(state);
+			++header.fixtureCount;
+		}
+	}
+
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		int32 type = j->m_type;
+		int32 jointSize = b2GetJointSize(j->m_type);
+		memcpy(data, &type, sizeof(int32));
+		memcpy(data + sizeof(int32), j, jointSize);
+		data += sizeof(int32) + jointSize;
+	}
+
+	for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
+	{
+		b2Contact* c = m_contactManager.m_contacts[i];
+		b2ContactState state;
+		state.proxyIdA = c->m_fixtureA->m_proxyId;
+		state.proxyIdB = c->m_fixtureB->m_proxyId;
+		state.flags = c->m_flags;
+		state.toiCount = c->m_toiCount;
+		state.manifold = c->m_manifold;
+		state.manifoldXf = c->m_manifoldXf;
+		state.simplexCache = c->m_simplexCache;
+		state.edgeA = c->m_edgeA;
+		state.edgeB = c->m_edgeB;
+		memcpy(data, &state, sizeof(state));
+		data += sizeof(state);
+	}
+
+	memcpy(data, tree.m_nodes, tree.m_nodeCapacity * sizeof(b2DynamicTreeNode));
+	data += tree.m_nodeCapacity * sizeof(b2DynamicTreeNode);
+
+	memcpy(data, broadPhase.m_moveBuffer, broadPhase.m_moveCount * sizeof(int32));
+	data += broadPhase.m_moveCount * sizeof(int32);
+
+	for (b2ParticleSystem* p = m_particleSystemList; p; p = p->m_next)
+	{
+		int32 arraySize = p->m_count * sizeof(float32);
+		memcpy(data, &p->m_count, sizeof(int32));
+		memcpy(data + sizeof(int32), p->m_x, arraySize);
+		memcpy(data + sizeof(int32) + arraySize, p->m_y, arraySize);
+		memcpy(data + sizeof(int32) + 2 * arraySize, p->m_vx, arraySize);
+		memcpy(data + sizeof(int32) + 3 * arraySize, p->m_vy, arraySize);
+		data += sizeof(int32) + 4 * arraySize;
+	}
+
+	memcpy(buffer, &header, sizeof(header));
+
+	b2Assert(data - (char*)buffer == size);
+	return size;
+}
+
+// Check the fixtures of a saved state are the live ones, and that the leaves
+// of the saved tree, the contacts and the move buffer only refer to them.
+bool b2World::CheckStateFixtures(const b2WorldStateHeader& header, const char* fixtureData,
+								 const char* nodeData, const char* contactData, const char* moveData)
+{
+	int32 fixtureCount = 0;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		fixtureCount += b->m_fixtureCount;
+	}
+
+	if (header.fixtureCount != fixtureCount || header.proxyCount < 0 ||
+		header.proxyCount > header.nodeCapacity)
+	{
+		return false;
+	}
+
+	// Marks the nodes that are the proxies of live fixtures.
+	bool* proxies = (bool*)m_stackAllocator.Allocate(header.nodeCapacity * sizeof(bool));
+	memset(proxies, 0, header.nodeCapacity * sizeof(bool));
+
+	bool valid = true;
+	int32 proxyCount = 0;
+	const char* data = fixtureData;
+	for (b2Body* b = m_bodyList; b && valid; b = b->m_next)
+	{
+		for (b2Fixture* f = b->m_fixtureList; f && valid; f = f->m_next)
+		{
+			b2FixtureState state;
+			memcpy(&state, data, sizeof(state));
+			data += sizeof(state);
+
+			if (state.generation != f->m_generation)
+			{
+				valid = false;
+				break;
+			}
+
+			if (state.proxyId == b2BroadPhase::e_nullProxy)
+			{
+				continue;
+			}
+
+			if (state.proxyId < 0 || state.proxyId >= header.nodeCapacity || proxies[state.proxyId])
+			{
+				valid = false;
+				break;
+			}
+
+			b2DynamicTreeNode node;
+			memcpy(&node, nodeData + state.proxyId * sizeof(b2DynamicTreeNode), sizeof(node));
+			if (node.IsLeaf() == false || node.userData != f)
+			{
+				valid = false;
+				break;
+			}
+
+			proxies[state.proxyId] = true;
+			++proxyCount;
+		}
+	}
+
+	valid = valid && proxyCount == header.proxyCount;
+
+	for (int32 i = 0; i < header.contactCount && valid; ++i)
+	{
+		b2ContactState state;
+		memcpy(&state, contactData + i * sizeof(b2ContactState), sizeof(state));
+
+		valid = 0 <= state.proxyIdA && state.proxyIdA < header.nodeCapacity && proxies[state.proxyIdA] &&
+				0 <= state.proxyIdB && state.proxyIdB < header.nodeCapacity && proxies[state.proxyIdB];
+	}
+
+	for (int32 i = 0; i < header.moveCount && valid; ++i)
+	{
+		int32 proxyId;
+		memcpy(&proxyId, moveData + i * sizeof(int32), sizeof(int32));
+
+		valid = proxyId == b2BroadPhase::e_nullProxy ||
+				(0 <= proxyId && proxyId < header.nodeCapacity && proxies[proxyId]);
+	}
+
+	m_stackAllocator.Free(proxies);
+	return valid;
+}
+
+bool b2World::RestoreState(const void* buffer, int32 bufferSize)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked() || bufferSize < (int32)sizeof(b2WorldStateHeader))
+	{
+		return false;
+	}
+
+	b2WorldStateHeader header;
+	memcpy(&header, buffer, sizeof(header));
+
+	if (header.magic != b2_worldStateMagic || header.size > bufferSize ||
+		header.bodyCount != m_bodyCount || header.jointCount != m_jointCount ||
+		header.nodeCapacity < 0 || header.contactCount < 0 || header.moveCount < 0 ||
+		header.particleSystemCount != m_particleSystemCount)
+	{
+		return false;
+	}
+
+	const char* bodyData = (const char*)buffer + sizeof(b2WorldStateHeader);
+	const char* fixtureData = bodyData + header.bodyCount * sizeof(b2BodyState);
+	const char* jointData = fixtureData + header.fixtureCount * sizeof(b2FixtureState);
+
+	// Check the bodies and joints match before touching anything.
+	const char* data = bodyData;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b2BodyState state;
+		memcpy(&state, data, sizeof(state));
+		data += sizeof(state);
+
+		if (state.fixtureCount != b->m_fixtureCount)
+		{
+			return false;
+		}
+	}
+
+	data = jointData;
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		int32 type;
+		memcpy(&type, data, sizeof(int32));
+
+		if (type != j->m_type)
+		{
+			return false;
+		}
+
+		data += sizeof(int32) + b2GetJointSize(j->m_type);
+	}
+
+	const char* contactData = data;
+	const char* nodeData = contactData + header.contactCount * sizeof(b2ContactState);
+	const char* moveData = nodeData + header.nodeCapacity * sizeof(b2DynamicTreeNode);
+	const char* particleData = moveData + header.moveCount * sizeof(int32);
+
+	// The particle systems are matched in list order. Their particles may
+	// have been created or destroyed since, only the counts must fit.
+	const char* end = (const char*)buffer + header.size;
+	data = particleData;
+	for (int32 i = 0; i < header.particleSystemCount; ++i)
+	{
+		if (end - data < (int32)sizeof(int32))
+		{
+			return false;
+		}
+
+		int32 count;
+		memcpy(&count, data, sizeof(int32));
+		if (count < 0 || count > (end - data - (int32)sizeof(int32)) / (4 * (int32)sizeof(float32)))
+		{
+			return false;
+		}
+
+		data += sizeof(int32) + 4 * count * sizeof(float32);
+	}
+
+	if (data != end)
+	{
+		return false;
+	}
+
+	// The saved tree and contacts point at fixtures, which must be the very
+	// ones saved: a fixture destroyed since, even if recreated, is gone.
+	if (CheckStateFixtures(header, fixtureData, nodeData, contactData, moveData) == false)
+	{
+		return false;
+	}
+
+	// Contacts are rebuilt from the saved ones, drop the current ones quietly.
+	for (int32 i = 0; i < m_contactManager.m_contactCount; ++i)
+	{
+		b2Contact::Destroy(m_contactManager.m_contacts[i], &m_blockAllocator);
+	}
+	m_contactManager.m_contactCount = 0;
+
+	data = bodyData;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		b2BodyState state;
+		memcpy(&state, data, sizeof(state));
+		data += sizeof(state);
+
+		b->m_type = state.type;
+		b->m_flags = state.flags;
+		b->m_islandIndex = state.islandIndex;
+		b->m_xf = state.xf;
+		b->m_sweep = state.sweep;
+		b->m_linearVelocity = state.linearVelocity;
+		b->m_angularVelocity = state.angularVelocity;
+		b->m_force = state.force;
+		b->m_torque = state.torque;
+		b->m_mass = state.mass;
+		b->m_invMass = state.invMass;
+		b->m_I = state.I;
+		b->m_invI = state.invI;
+		b->m_linearDamping = state.linearDamping;
+		b->m_angularDamping = state.angularDamping;
+		b->m_sleepTime = state.sleepTime;
+		b->m_stepInterval = state.stepInterval;
+		b->m_stepsPending = state.stepsPending;
+		b->m_stepsSolved = state.stepsSolved;
+		b->m_contactCount = 0;
+	}
+
+	data = fixtureData;
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		for (b2Fixture* f = b->m_fixtureList; f; f = f->m_next)
+		{
+			b2FixtureState state;
+			memcpy(&state, data, sizeof(state));
+			data += sizeof(state);
+
+			f->m_aabb = state.aabb;
+			f->m_density = state.density;
+			f->m_friction = state.friction;
+			f->m_restitution = state.restitution;
+			f->m_proxyId = state.proxyId;
+			f->m_filter = state.filter;
+			f->m_isSensor = state.isSensor;
+		}
+	}
+
+	// Sensors are not part of the state. They keep the overlaps reported last,
+	// so the next step reports what changed for them, under the restored proxies.
+	for (b2Sensor* s = m_sensorList; s; s = s->m_next)
+	{
+		s->RefreshProxies();
+	}
+	m_sensorEventCount = 0;
+
+	// The joint graph is unchanged, so only the links of the saved copy
+	// need to be kept from the live joint.
+	data = jointData;
+	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	{
+		b2Joint* prev = j->m_prev;
+		b2Joint* next = j->m_next;
+		b2JointEdge edgeA = j->m_edgeA;
+		b2JointEdge edgeB = j->m_edgeB;
+		void* userData = j->m_userData;
+
+		int32 jointSize = b2GetJointSize(j->m_type);
+		memcpy((void*)j, data + sizeof(int32), jointSize);
+		data += sizeof(int32) + jointSize;
+
+		j->m_prev = prev;
+		j->m_next = next;
+		j->m_edgeA = edgeA;
+		j->m_edgeB = edgeB;
+		j->m_userData = userData;
+	}
+
+	b2BroadPhase& broadPhase = m_contactManager.m_broadPhase;
+	b2DynamicTree& tree = broadPhase.m_tree;
+
+	if (tree.m_nodeCapacity != header.nodeCapacity)
+	{
+		if (tree.m_ownsNodes)
+		{
+			b2Free(tree.m_nodes);
+		}
+		tree.m_nodes = (b2DynamicTreeNode*)b2Alloc(header.nodeCapacity * sizeof(b2DynamicTreeNode));
+		tree.m_nodeCapacity = header.nodeCapacity;
+		tree.m_ownsNodes = true;
+	}
+	memcpy(tree.m_nodes, nodeData, header.nodeCapacity * sizeof(b2DynamicTreeNode));
+	tree.m_root = header.root;
+	tree.m_nodeCount = header.nodeCount;
+	tree.m_freeList = header.freeList;
+	tree.m_path = header.path;
+	tree.m_insertionCount = header.insertionCount;
+	broadPhase.m_proxyCount = header.proxyCount;
+
+	if (broadPhase.m_moveCapacity < header.moveCount)
+	{
+		b2Free(broadPhase.m_moveBuffer);
+		broadPhase.m_moveCapacity = header.moveCount;
+		broadPhase.m_moveBuffer = (int32*)b2Alloc(broadPhase.m_moveCapacity * sizeof(int32));
+	}
+	memcpy(broadPhase.m_moveBuffer, moveData, header.moveCount * sizeof(int32));
+	broadPhase.m_moveCount = header.moveCount;
+
+	// Contacts are appended to the arrays, so the world array gets its saved
+	// order. The body arrays may have been reordered by removals, so their
+	// edges are put back in their saved places.
+	for (int32 i = 0; i < header.contactCount; ++i)
+	{
+		b2ContactState state;
+		memcpy(&state, contactData + i * sizeof(b2ContactState), sizeof(state));
+
+		b2Fixture* fixtureA = (b2Fixture*)broadPhase.GetUserData(state.proxyIdA);
+		b2Fixture* fixtureB = (b2Fixture*)broadPhase.GetUserData(state.proxyIdB);
+
+		b2Contact* c = b2Contact::Create(fixtureA, fixtureB, &m_blockAllocator);
+		b2Assert(c->m_fixtureA == fixtureA);
+		c->m_flags = state.flags;
+		c->m_toiCount = state.toiCount;
+		c->m_manifold = state.manifold;
+		c->m_manifoldXf = state.manifoldXf;
+		c->m_simplexCache = state.simplexCache;
+		m_contactManager.Insert(c);
+	}
+
+	for (int32 i = 0; i < header.contactCount; ++i)
+	{
+		b2ContactState state;
+		memcpy(&state, contactData + i * sizeof(b2ContactState), sizeof(state));
+
+		b2Contact* c = m_contactManager.m_contacts[i];
+		b2Body* bodyA = c->m_fixtureA->m_body;
+		b2Body* bodyB = c->m_fixtureB->m_body;
+
+		c->m_edgeA = state.edgeA;
+		bodyA->m_contactEdges[state.edgeA].other = bodyB;
+		bodyA->m_contactEdges[state.edgeA].contact = c;
+
+		c->m_edgeB = state.edgeB;
+		bodyB->m_contactEdges[state.edgeB].other = bodyA;
+		bodyB->m_contactEdges[state.edgeB].contact = c;
+	}
+
+	data = particleData;
+	for (b2ParticleSystem* p = m_particleSystemList; p; p = p->m_next)
+	{
+		int32 count;
+		memcpy(&count, data, sizeof(int32));
+		if (count > p->m_capacity)
+		{
+			p->Reserve(count);
+		}
+		p->m_count = count;
+
+		int32 arraySize = count * sizeof(float32);
+		memcpy(p->m_x, data + sizeof(int32), arraySize);
+		memcpy(p->m_y, data + sizeof(int32) + arraySize, arraySize);
+		memcpy(p->m_vx, data + sizeof(int32) + 2 * arraySize, arraySize);
+		memcpy(p->m_vy, data + sizeof(int32) + 3 * arraySize, arraySize);
+		data += sizeof(int32) + 4 * arraySize;
+	}
+
+	m_flags = (m_flags & e_locked) | header.flags;
+	m_inv_dt0 = header.inv_dt0;
+
+	return true;
+}
+
+int32 b2World::SaveBroadPhase(b2DynamicTreeNode* nodes, int32* root, b2Fixture* const* fixtures, int32 fixtureCount) const
+{
+	const b2BroadPhase& broadPhase = m_contactManager.m_broadPhase;
+	const b2DynamicTree& tree = broadPhase.m_tree;
+
+	int32 proxyCount = 0;
+	for (int32 i = 0; i < fixtureCount; ++i)
+	{
+		const b2Fixture* fixture = fixtures[i];
+		if (fixture == NULL)
+		{
+			continue;
+		}
+
+		if (fixture->m_proxyId == b2BroadPhase::e_nullProxy)
+		{
+			return 0;
+		}
+
+		++proxyCount;
+	}
+
+	if (proxyCount == 0 || proxyCount != broadPhase.m_proxyCount)
+	{
+		return 0;
+	}
+
+	int32 nodeCount = tree.m_nodeCount;
+	b2Assert(nodeCount == 2 * proxyCount - 1);
+
+	// Number the nodes depth first, so subtrees stay together in the copy.
+	int32* remap = (int32*)b2Alloc(tree.m_nodeCapacity * sizeof(int32));
+	int32* stack = (int32*)b2Alloc(nodeCount * sizeof(int32));
+	for (int32 i = 0; i < tree.m_nodeCapacity; ++i)
+	{
+		remap[i] = b2_nullNode;
+	}
+
+	int32 count = 0;
+	int32 stackCount = 0;
+	stack[stackCount++] = tree.m_root;
+	while (stackCount > 0)
+	{
+		int32 nodeId = stack[--stackCount];
+		const b2DynamicTreeNode* node = tree.m_nodes + nodeId;
+		remap[nodeId] = count++;
+
+		if (node->IsLeaf() == false)
+		{
+			stack[stackCount++] = node->child2;
+			stack[stackCount++] = node->child1;
+		}
+	}
+	b2Assert(count == nodeCount);
+
+	for (int32 i = 0; i < tree.m_nodeCapacity; ++i)
+	{
+		if (remap[i] == b2_nullNode)
+		{
+			continue;
+		}
+
+		const b2DynamicTreeNode* node = tree.m_nodes + i;
+		b2DynamicTreeNode* copy = nodes + remap[i];
+		copy->aabb = node->aabb;
+		copy->userData = NULL;
+		copy->parent = node->parent == b2_nullNode ? b2_nullNode : remap[node->parent];
+		copy->child1 = node->IsLeaf() ? b2_nullNode : remap[node->child1];
+		copy->child2 = node->IsLeaf() ? b2_nullNode : remap[node->child2];
+	}
+
+	// Leaves refer to the fixtures by index. The stack is reused to catch
+	// a fixture that is listed twice.
+	bool valid = true;
+	memset(stack, 0, nodeCount * sizeof(int32));
+	for (int32 i = 0; i < fixtureCount; ++i)
+	{
+		const b2Fixture* fixture = fixtures[i];
+		if (fixture == NULL)
+		{
+			continue;
+		}
+
+		int32 nodeId = remap[fixture->m_proxyId];
+		if (tree.m_nodes[fixture->m_proxyId].userData != fixture || stack[nodeId])
+		{
+			valid = false;
+			break;
+		}
+
+		stack[nodeId] = 1;
+		nodes[nodeId].userData = (void*)(size_t)i;
+	}
+
+	*root = remap[tree.m_root];
+
+	b2Free(stack);
+	b2Free(remap);
+
+	return valid ? nodeCount : 0;
+}
+
+bool b2World::LoadBroadPhase(b2DynamicTreeNode* nodes, int32 nodeCount, int32 root, b2Fixture* const* fixtures, int32 fixtureCount)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked())
+	{
+		return false;
+	}
+
+	b2BroadPhase& broadPhase = m_contactManager.m_broadPhase;
+	b2DynamicTree& tree = broadPhase.m_tree;
+
+	if (broadPhase.m_proxyCount != 0 || root < 0 || root >= nodeCount)
+	{
+		return false;
+	}
+
+	int32 proxyCount = 0;
+	for (int32 i = 0; i < fixtureCount; ++i)
+	{
+		b2Fixture* fixture = fixtures[i];
+		if (fixture == NULL)
+		{
+			continue;
+		}
+
+		if (fixture->m_proxyId != b2BroadPhase::e_nullProxy || fixture->m_body->IsActive())
+		{
+			return false;
+		}
+
+		fixture->m_body->m_flags &= ~b2Body::e_islandFlag;
+		++proxyCount;
+	}
+
+	if (proxyCount == 0 || nodeCount != 2 * proxyCount - 1)
+	{
+		return false;
+	}
+
+	// Every body has to be covered by the tree, or activating it would
+	// leave fixtures without proxies. The island flag marks counted bodies.
+	int32 bodyFixtureCount = 0;
+	for (int32 i = 0; i < fixtureCount; ++i)
+	{
+		b2Body* body = fixtures[i] ? fixtures[i]->m_body : NULL;
+		if (body && (body->m_flags & b2Body::e_islandFlag) == 0)
+		{
+			body->m_flags |= b2Body::e_islandFlag;
+			bodyFixtureCount += body->m_fixtureCount;
+		}
+	}
+
+	for (int32 i = 0; i < fixtureCount; ++i)
+	{
+		if (fixtures[i])
+		{
+			fixtures[i]->m_body->m_flags &= ~b2Body::e_islandFlag;
+		}
+	}
+
+	// The nodes may come from a file, so check the links before using them.
+	bool valid = bodyFixtureCount == proxyCount;
+	int32 leafCount = 0;
+	bool* used = (bool*)b2Alloc(fixtureCount * sizeof(bool));
+	memset(used, 0, fixtureCount * sizeof(bool));
+
+	for (int32 i = 0; valid && i < nodeCount; ++i)
+	{
+		const b2DynamicTreeNode* node = nodes + i;
+
+		if (i == root)
+		{
+			valid = node->parent == b2_nullNode;
+		}
+		else
+		{
+			valid = 0 <= node->parent && node->parent < nodeCount;
+		}
+
+		if (valid && node->IsLeaf())
+		{
+			size_t index = (size_t)node->userData;
+			valid = index < (size_t)fixtureCount && fixtures[index] && used[index] == false;
+			if (valid)
+			{
+				used[index] = true;
+				++leafCount;
+			}
+		}
+		else if (valid)
+		{
+			valid = 0 <= node->child1 && node->child1 < nodeCount &&
+				0 <= node->child2 && node->child2 < nodeCount &&
+				node->child1 != node->child2 &&
+				nodes[node->child1].parent == i && nodes[node->child2].parent == i;
+		}
+	}
+
+	b2Free(used);
+
+	// The back-links keep a node from having two parents, but not the nodes
+	// from forming a cycle away from the root. The tree must reach every
+	// node exactly once from the root.
+	if (valid)
+	{
+		bool* visited = (bool*)b2Alloc(nodeCount * sizeof(bool));
+		int32* stack = (int32*)b2Alloc(nodeCount * sizeof(int32));
+		memset(visited, 0, nodeCount * sizeof(bool));
+
+		int32 visitedCount = 0;
+		int32 stackCount = 0;
+		stack[stackCount++] = root;
+		while (valid && stackCount > 0)
+		{
+			int32 index = stack[--stackCount];
+			if (visited[index])
+			{
+				valid = false;
+				break;
+			}
+
+			visited[index] = true;
+			++visitedCount;
+
+			const b2DynamicTreeNode* node = nodes + index;
+			if (node->IsLeaf() == false)
+			{
+				// Each node is pushed at most once while the walk is valid.
+				valid = stackCount + 2 <= nodeCount;
+				if (valid)
+				{
+					stack[stackCount++] = node->child1;
+					stack[stackCount++] = node->child2;
+				}
+			}
+		}
+
+		valid = valid && visitedCount == nodeCount;
+
+		b2Free(stack);
+		b2Free(visited);
+	}
+
+	if (valid == false || leafCount != proxyCount)
+	{
+		return false;
+	}
+
+	if (tree.m_ownsNodes)
+	{
+		b2Free(tree.m_nodes);
+	}
+	tree.m_nodes = nodes;
+	tree.m_nodeCount = nodeCount;
+	tree.m_nodeCapacity = nodeCount;
+	tree.m_root = root;
+	tree.m_freeList = b2_nullNode;
+	tree.m_ownsNodes = false;
+
+	for (int32 i = 0; i < nodeCount; ++i)
+	{
+		b2DynamicTreeNode* node = nodes + i;
+		if (node->IsLeaf() == false)
+		{
+			continue;
+		}
+
+		b2Fixture* fixture = fixtures[(size_t)node->userData];
+		node->userData = fixture;
+		fixture->m_proxyId = i;
+		fixture->m_body->m_flags |= b2Body::e_activeFlag;
+
+		// New proxies look for pairs in the next step.
+		broadPhase.BufferMove(i);
+	}
+	broadPhase.m_proxyCount = proxyCount;
+
+	return true;
+}
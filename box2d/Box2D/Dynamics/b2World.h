@@ -22,16 +22,61 @@
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2TaskScheduler.h>
 #include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 
 struct b2AABB;
 struct b2BodyDef;
+struct b2ControllerDef;
 struct b2JointDef;
+struct b2ParticleSystemDef;
+struct b2SensorDef;
+struct b2SensorEvent;
 struct b2TimeStep;
+struct b2TOIEvent;
+struct b2TOIStats;
+struct b2WorldStateHeader;
 class b2Body;
+class b2Controller;
 class b2Fixture;
 class b2Joint;
+class b2ParticleSystem;
+class b2Sensor;
+
+/// An explosion definition is used by b2World::Explode.
+struct b2ExplosionDef
+{
+	b2ExplosionDef()
+	{
+		position.SetZero();
+		radius = 0.0f;
+		falloff = 0.0f;
+		impulse = 0.0f;
+		maskBits = 0xFFFF;
+		occlusion = false;
+	}
+
+	/// The center of the explosion, in world coordinates.
+	b2Vec2 position;
+
+	/// Fixtures closer than this to the center get the full impulse.
+	float32 radius;
+
+	/// The distance past the radius over which the impulse fades out linearly.
+	float32 falloff;
+
+	/// The impulse given to each fixture within the radius. A negative
+	/// impulse pulls fixtures in.
+	float32 impulse;
+
+	/// Only fixtures with one of these category bits are pushed.
+	uint16 maskBits;
+
+	/// Skip fixtures that are hidden from the center by another body. This
+	/// costs a ray-cast per fixture.
+	bool occlusion;
+};
 
 /// The world class manages all physics entities, dynamic simulation,
 /// and asynchronous queries. The world also contains efficient memory
@@ -65,6 +110,14 @@ public:
 	/// by you and must remain in scope.
 	void SetDebugDraw(b2DebugDraw* debugDraw);
 
+	/// Register a task scheduler used to run parts of the time step in parallel.
+	/// The scheduler is owned by you and must remain in scope. Pass NULL to
+	/// go back to the default b2SerialTaskScheduler.
+	void SetTaskScheduler(b2TaskScheduler* scheduler);
+
+	/// Get the task scheduler used by the world.
+	b2TaskScheduler* GetTaskScheduler() const;
+
 	/// Create a rigid body given a definition. No reference to the definition
 	/// is retained.
 	/// @warning This function is locked during callbacks.
@@ -85,6 +138,35 @@ public:
 	/// @warning This function is locked during callbacks.
 	void DestroyJoint(b2Joint* joint);
 
+	/// Create a sensor on a body. No reference to the definition is retained.
+	/// The sensor is destroyed with its body.
+	/// @warning This function is locked during callbacks.
+	b2Sensor* CreateSensor(const b2SensorDef* def);
+
+	/// Destroy a sensor. Its pending events are dropped.
+	/// @warning This function is locked during callbacks.
+	void DestroySensor(b2Sensor* sensor);
+
+	/// Create a controller, such as a force field. No reference to the definition
+	/// is retained. A controller with a body is destroyed with the body. The
+	/// sleeping bodies in the area of the controller are woken up.
+	/// @warning This function is locked during callbacks.
+	b2Controller* CreateController(const b2ControllerDef* def);
+
+	/// Destroy a controller.
+	/// @warning This function is locked during callbacks.
+	void DestroyController(b2Controller* controller);
+
+	/// Create a particle system, such as a fluid. No reference to the
+	/// definition is retained. The particles are solved after the controllers
+	/// and before the bodies.
+	/// @warning This function is locked during callbacks.
+	b2ParticleSystem* CreateParticleSystem(const b2ParticleSystemDef* def);
+
+	/// Destroy a particle system and its particles.
+	/// @warning This function is locked during callbacks.
+	void DestroyParticleSystem(b2ParticleSystem* system);
+
 	/// Take a time step. This performs collision detection, integration,
 	/// and constraint solution.
 	/// @param timeStep the amount of time to simulate, this should not vary.
@@ -117,6 +199,13 @@ public:
 	/// @param point2 the ray ending point
 	void RayCast(b2RayCastCallback* callback, const b2Vec2& point1, const b2Vec2& point2) const;
 
+	/// Push the dynamic bodies near a point away from it. Each fixture in reach
+	/// gets an impulse at its point closest to the center, so bodies also start
+	/// spinning. The fixtures are found with the broad-phase, the cost only
+	/// depends on how many are in reach.
+	/// @return the number of fixtures that were pushed.
+	int32 Explode(const b2ExplosionDef& def);
+
 	/// Get the world body list. With the returned body, use b2Body::GetNext to get
 	/// the next body in the world list. A NULL body indicates the end of the list.
 	/// @return the head of the world body list.
@@ -133,12 +222,53 @@ public:
 	/// @warning contacts are 
 	b2Contact* GetContactList();
 
+	/// Get the world sensor list. With the returned sensor, use b2Sensor::GetNext to get
+	/// the next sensor in the world list. A NULL sensor indicates the end of the list.
+	/// @return the head of the world sensor list.
+	b2Sensor* GetSensorList();
+
+	/// Get the world controller list. With the returned controller, use b2Controller::GetNext
+	/// to get the next controller in the world list. A NULL controller indicates the end of the list.
+	/// @return the head of the world controller list.
+	b2Controller* GetControllerList();
+
+	/// Get the world particle system list. With the returned particle system, use
+	/// b2ParticleSystem::GetNext to get the next particle system in the world list.
+	/// A NULL particle system indicates the end of the list.
+	/// @return the head of the world particle system list.
+	b2ParticleSystem* GetParticleSystemList();
+
+	/// Get the overlaps of sensors and fixtures that began or ended during the last
+	/// time step, grouped by sensor. Fixtures that lost their proxy since, by being
+	/// destroyed or deactivated, are left out. The events are valid until the next step.
+	const b2SensorEvent* GetSensorEvents() const;
+
+	/// Get the number of sensor events of the last time step.
+	int32 GetSensorEventCount() const;
+
 	/// Enable/disable warm starting. For testing.
 	void SetWarmStarting(bool flag) { m_warmStarting = flag; }
 
 	/// Enable/disable continuous physics. For testing.
 	void SetContinuousPhysics(bool flag) { m_continuousPhysics = flag; }
 
+	/// Enable/disable reusing the manifolds of contacts whose bodies barely
+	/// moved relative to each other. For testing.
+	void SetManifoldReuse(bool flag) { m_contactManager.m_manifoldReuse = flag; }
+
+	/// Enable/disable solving chains and other trees of revolute joints
+	/// directly instead of iteratively. For testing.
+	void SetJointTreeSolver(bool flag) { m_jointTrees = flag; }
+
+	/// Enable/disable the sub-stepping solver. Each time step is then divided
+	/// into as many sub-steps as the velocity iterations passed to Step. Contacts
+	/// are solved as soft constraints once per sub-step, which keeps deep stacks
+	/// stable at a lower cost than raising the iterations of the default solver.
+	/// The position iterations only correct joints. Joint impulses, and so
+	/// b2Joint::GetReactionForce, are those of a sub-step.
+	void SetSubStepping(bool flag) { m_subStepping = flag; }
+	bool GetSubStepping() const { return m_subStepping; }
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -151,12 +281,29 @@ public:
 	/// Get the number of contacts (each may have 0 or more contact points).
 	int32 GetContactCount() const;
 
+	/// Get the number of sensors.
+	int32 GetSensorCount() const;
+
+	/// Get the number of controllers.
+	int32 GetControllerCount() const;
+
+	/// Get the number of particle systems.
+	int32 GetParticleSystemCount() const;
+
 	/// Change the global gravity vector.
 	void SetGravity(const b2Vec2& gravity);
 	
 	/// Get the global gravity vector.
 	b2Vec2 GetGravity() const;
 
+	/// Shift the world origin. Useful for large worlds.
+	/// The body shift formula is: position -= newOrigin
+	/// Contacts and sleeping states are kept, so the simulation carries on
+	/// as before.
+	/// @param newOrigin the new origin with respect to the old origin
+	/// @warning This function is locked during callbacks.
+	void ShiftOrigin(const b2Vec2& newOrigin);
+
 	/// Is the world locked (in the middle of a time step).
 	bool IsLocked() const;
 
@@ -166,6 +313,44 @@ public:
 	/// Get the flag that controls automatic clearing of forces after each time step.
 	bool GetAutoClearForces() const;
 
+	/// Get the number of bytes SaveState needs for the current world.
+	int32 GetStateSize() const;
+
+	/// Save the simulation state: body motion, fixture proxies, contacts with
+	/// their warm starting impulses, joint solver state, the broad-phase and
+	/// the positions and velocities of the particles.
+	/// The buffer holds pointers and is only valid for this world, in this process.
+	/// @return the number of bytes written, or 0 if the buffer is too small.
+	int32 SaveState(void* buffer, int32 bufferSize) const;
+
+	/// Restore a state saved by SaveState. Stepping from a restored state gives
+	/// the same results as stepping from the original state. The world must have
+	/// the same bodies, fixtures, joints and particle systems it had when saved;
+	/// shapes, user data, listeners and particle system settings are not part of
+	/// the state. A fixture destroyed and created again since is not the same
+	/// fixture. Particle systems are matched in list order and get back the
+	/// particles they had. No contact callbacks are made.
+	/// @return false if the buffer does not match the world, which is unchanged then.
+	/// @warning This function is locked during callbacks.
+	bool RestoreState(const void* buffer, int32 bufferSize);
+
+	/// Copy the broad-phase tree in a compact form that LoadBroadPhase can use
+	/// in place, e.g. from a memory mapped file. The leaves refer to fixtures by
+	/// their index in the fixtures array, which must hold every fixture that has
+	/// a proxy; NULL entries are skipped. The nodes array needs room for
+	/// 2 * GetProxyCount() - 1 nodes.
+	/// @return the number of nodes written, or 0 if the fixtures do not match.
+	int32 SaveBroadPhase(b2DynamicTreeNode* nodes, int32* root, b2Fixture* const* fixtures, int32 fixtureCount) const;
+
+	/// Create the proxies of inactive bodies in bulk from a tree saved with
+	/// SaveBroadPhase, and activate the bodies. The leaves are patched to point
+	/// at the fixtures and the tree works on the nodes directly until it has to
+	/// grow, so they must be writable and outlive the world. The world must not
+	/// have any proxies, and the fixtures must be all the fixtures of their bodies.
+	/// @return false if the tree does not match the fixtures, nothing is changed then.
+	/// @warning This function is locked during callbacks.
+	bool LoadBroadPhase(b2DynamicTreeNode* nodes, int32 nodeCount, int32 root, b2Fixture* const* fixtures, int32 fixtureCount);
+
 private:
 
 	// m_flags
@@ -177,12 +362,23 @@ private:
 	};
 
 	friend class b2Body;
+	friend class b2Contact;
 	friend class b2ContactManager;
 	friend class b2Controller;
+	friend class b2TOITask;
 
 	void Solve(const b2TimeStep& step);
 	void SolveTOI();
-	void SolveTOI(b2Body* body);
+	void SolveTOIEvents(bool bullets, int32 count);
+	void SolveTOI(b2TOIEvent* event);
+	static void FindMinTOI(b2TOIEvent* event);
+	static void FindMinTOI(b2TOIEvent* event, b2TOIStats* stats);
+
+	void UpdateSensors();
+
+	bool CheckStateFixtures(const b2WorldStateHeader& header, const char* fixtureData,
+							const char* nodeData, const char* contactData, const char* moveData);
+	void RemoveSensorOverlaps(b2Fixture* fixture);
 
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
@@ -196,9 +392,19 @@ private:
 
 	b2Body* m_bodyList;
 	b2Joint* m_jointList;
+	b2Sensor* m_sensorList;
+	b2Controller* m_controllerList;
+	b2ParticleSystem* m_particleSystemList;
 
 	int32 m_bodyCount;
 	int32 m_jointCount;
+	int32 m_sensorCount;
+	int32 m_controllerCount;
+	int32 m_particleSystemCount;
+
+	b2SensorEvent* m_sensorEvents;
+	int32 m_sensorEventCount;
+	int32 m_sensorEventCapacity;
 
 	b2Vec2 m_gravity;
 	bool m_allowSleep;
@@ -208,15 +414,26 @@ private:
 	b2DestructionListener* m_destructionListener;
 	b2DebugDraw* m_debugDraw;
 
+	b2TaskScheduler* m_taskScheduler;
+	b2SerialTaskScheduler m_serialTaskScheduler;
+
 	// This is used to compute the time step ratio to
 	// support a variable time step.
 	float32 m_inv_dt0;
 
+	// The generation of the last fixture created, see b2Fixture.
+	uint32 m_fixtureGeneration;
+
 	// This is for debugging the solver.
 	bool m_warmStarting;
 
 	// This is for debugging the solver.
 	bool m_continuousPhysics;
+
+	// This is for debugging the solver.
+	bool m_jointTrees;
+
+	bool m_subStepping;
 };
 
 inline b2Body* b2World::GetBodyList()
@@ -231,7 +448,32 @@ inline b2Joint* b2World::GetJointList()
 
 inline b2Contact* b2World::GetContactList()
 {
-	return m_contactManager.m_contactList;
+	return m_contactManager.m_contactCount > 0 ? m_contactManager.m_contacts[0] : NULL;
+}
+
+inline b2Sensor* b2World::GetSensorList()
+{
+	return m_sensorList;
+}
+
+inline b2Controller* b2World::GetControllerList()
+{
+	return m_controllerList;
+}
+
+inline b2ParticleSystem* b2World::GetParticleSystemList()
+{
+	return m_particleSystemList;
+}
+
+inline const b2SensorEvent* b2World::GetSensorEvents() const
+{
+	return m_sensorEvents;
+}
+
+inline int32 b2World::GetSensorEventCount() const
+{
+	return m_sensorEventCount;
 }
 
 inline int32 b2World::GetBodyCount() const
@@ -249,6 +491,21 @@ inline int32 b2World::GetContactCount() const
 	return m_contactManager.m_contactCount;
 }
 
+inline int32 b2World::GetSensorCount() const
+{
+	return m_sensorCount;
+}
+
+inline int32 b2World::GetControllerCount() const
+{
+	return m_controllerCount;
+}
+
+inline int32 b2World::GetParticleSystemCount() const
+{
+	return m_particleSystemCount;
+}
+
 inline void b2World::SetGravity(const b2Vec2& gravity)
 {
 	m_gravity = gravity;
@@ -282,4 +539,9 @@ inline bool b2World::GetAutoClearForces() const
 	return (m_flags & e_clearForces) == e_clearForces;
 }
 
+inline b2TaskScheduler* b2World::GetTaskScheduler() const
+{
+	return m_taskScheduler;
+}
+
 #endif
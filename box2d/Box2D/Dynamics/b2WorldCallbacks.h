@@ -27,6 +27,8 @@ class b2Fixture;
 class b2Body;
 class b2Joint;
 class b2Contact;
+class b2Sensor;
+class b2Controller;
 struct b2ContactPoint;
 struct b2ContactResult;
 struct b2Manifold;
@@ -46,6 +48,14 @@ public:
 	/// Called when any fixture is about to be destroyed due
 	/// to the destruction of its parent body.
 	virtual void SayGoodbye(b2Fixture* fixture) = 0;
+
+	/// Called when any sensor is about to be destroyed due
+	/// to the destruction of its parent body.
+	virtual void SayGoodbye(b2Sensor* sensor) { B2_NOT_USED(sensor); }
+
+	/// Called when any controller is about to be destroyed due
+	/// to the destruction of the body it moves with.
+	virtual void SayGoodbye(b2Controller* controller) { B2_NOT_USED(controller); }
 };
 
 /// Implement this class to provide collision filtering. In other words, you can implement
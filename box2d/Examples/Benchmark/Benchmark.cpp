@@ -0,0 +1,608 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Box2D.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(_WIN32)
+#include <ctime>
+#else
+#include <sys/time.h>
+#endif
+
+// Times the world step on a few stock scenes with each task scheduler, and
+// without manifold reuse, and the cost of dispatching work through a
+// scheduler for a range of split sizes. Usage: Benchmark [threadCount]
+//
+// The checksum column sums the final body positions; it must not change
+// with the scheduler. Without manifold reuse it differs slightly.
+//
+// The contacts column is the average number of contacts, one per pair of
+// fixtures that overlap in the broad-phase and pass the filtering. The
+// debris scenes show how many pairs collision filtering prunes. The fields
+// scene has bodies in a buoyancy, a vortex, a wind and a radial field.
+//
+// The trigger zone scenes compare b2Sensor with sensor fixtures. Their
+// checksums differ a little, as sensor fixtures change the broad-phase tree
+// and with it the order contacts are solved in.
+//
+// The stacks are also run with the default solver at increasing iterations
+// and with the sub-stepping solver at increasing sub-steps. The drift column
+// is the largest horizontal distance any body moved, large when the stacks
+// topple, and the awake column counts the bodies that haven't come to rest.
+//
+// The particle runs drop a block of fluid with a few floating boxes into a
+// tank, for a range of particle counts. Their checksum sums the final
+// particle positions and does not change with the scheduler either.
+
+static double GetMilliseconds()
+{
+#if defined(_WIN32)
+	return 1000.0 * clock() / CLOCKS_PER_SEC;
+#else
+	timeval tv;
+	gettimeofday(&tv, NULL);
+	return 1000.0 * tv.tv_sec + 0.001 * tv.tv_usec;
+#endif
+}
+
+static void CreateGround(b2World* world)
+{
+	b2BodyDef bd;
+	b2Body* ground = world->CreateBody(&bd);
+
+	b2PolygonShape shape;
+	shape.SetAsEdge(b2Vec2(-80.0f, 0.0f), b2Vec2(80.0f, 0.0f));
+	ground->CreateFixture(&shape, 0.0f);
+}
+
+// Ten columns of twenty boxes.
+static void CreateVerticalStack(b2World* world)
+{
+	CreateGround(world);
+
+	b2PolygonShape shape;
+	shape.SetAsBox(0.5f, 0.5f);
+
+	b2FixtureDef fd;
+	fd.shape = &shape;
+	fd.density = 1.0f;
+	fd.friction = 0.3f;
+
+	for (int32 j = 0; j < 10; ++j)
+	{
+		for (int32 i = 0; i < 20; ++i)
+		{
+			b2BodyDef bd;
+			bd.type = b2_dynamicBody;
+			bd.position.Set(-30.0f + 6.0f * j, 0.752f + 1.54f * i);
+			b2Body* body = world->CreateBody(&bd);
+			body->CreateFixture(&fd);
+		}
+	}
+}
+
+// A pyramid with a base of forty boxes.
+static void CreatePyramid(b2World* world)
+{
+	CreateGround(world);
+
+	b2PolygonShape shape;
+	shape.SetAsBox(0.5f, 0.5f);
+
+	b2Vec2 x(-20.0f, 0.75f);
+	b2Vec2 deltaX(0.5625f, 1.25f);
+	b2Vec2 deltaY(1.125f, 0.0f);
+
+	for (int32 i = 0; i < 40; ++i)
+	{
+		b2Vec2 y = x;
+
+		for (int32 j = i; j < 40; ++j)
+		{
+			b2BodyDef bd;
+			bd.type = b2_dynamicBody;
+			bd.position = y;
+			b2Body* body = world->CreateBody(&bd);
+			body->CreateFixture(&shape, 5.0f);
+			y += deltaY;
+		}
+
+		x += deltaX;
+	}
+}
+
+// Small fast bodies in a box with a floor of tiles, a quarter of them
+// bullets. Most of the step is the continuous collision.
+static void CreateProjectiles(b2World* world)
+{
+	b2BodyDef bd;
+	b2Body* ground = world->CreateBody(&bd);
+
+	b2PolygonShape shape;
+	shape.SetAsBox(0.1f, 40.0f, b2Vec2(-40.0f, 40.0f), 0.0f);
+	ground->CreateFixture(&shape, 0.0f);
+	shape.SetAsBox(0.1f, 40.0f, b2Vec2(40.0f, 40.0f), 0.0f);
+	ground->CreateFixture(&shape, 0.0f);
+
+	for (int32 i = 0; i < 400; ++i)
+	{
+		shape.SetAsBox(0.1f, 0.1f, b2Vec2(-39.9f + 0.2f * i, 0.0f), 0.0f);
+		ground->CreateFixture(&shape, 0.0f);
+	}
+
+	b2PolygonShape box;
+	box.SetAsBox(0.1f, 0.1f);
+
+	b2CircleShape circle;
+	circle.m_radius = 0.1f;
+
+	for (int32 i = 0; i < 1000; ++i)
+	{
+		bd.type = b2_dynamicBody;
+		bd.position.Set(-38.0f + 0.076f * i, 2.0f + 0.07f * ((37 * i) % 1000));
+		bd.linearVelocity.Set((i & 1) ? 200.0f : -200.0f, -100.0f);
+		bd.angularVelocity = 20.0f;
+		bd.bullet = (i % 4) == 0;
+		b2Body* body = world->CreateBody(&bd);
+
+		if (i % 3 == 0)
+		{
+			body->CreateFixture(&circle, 1.0f);
+		}
+		else
+		{
+			body->CreateFixture(&box, 1.0f);
+		}
+	}
+}
+
+// Bodies raining through a grid of trigger zones, half of them circles.
+// The zones are b2Sensors or sensor fixtures.
+static void CreateTriggerZones(b2World* world, bool sensorFixtures)
+{
+	CreateGround(world);
+
+	b2BodyDef bd;
+	b2Body* zones = world->CreateBody(&bd);
+
+	b2PolygonShape box;
+	b2CircleShape circle;
+	circle.m_radius = 1.0f;
+
+	for (int32 j = 0; j < 10; ++j)
+	{
+		for (int32 i = 0; i < 20; ++i)
+		{
+			b2Vec2 center(-38.0f + 4.0f * i, 4.0f + 4.0f * j);
+			const b2Shape* shape;
+			if ((i + j) & 1)
+			{
+				circle.m_p = center;
+				shape = &circle;
+			}
+			else
+			{
+				box.SetAsBox(1.0f, 1.0f, center, 0.0f);
+				shape = &box;
+			}
+
+			if (sensorFixtures)
+			{
+				b2FixtureDef fd;
+				fd.shape = shape;
+				fd.isSensor = true;
+				zones->CreateFixture(&fd);
+			}
+			else
+			{
+				b2SensorDef sd;
+				sd.shape = shape;
+				sd.body = zones;
+				world->CreateSensor(&sd);
+			}
+		}
+	}
+
+	box.SetAsBox(0.3f, 0.3f);
+	circle.m_p.SetZero();
+	circle.m_radius = 0.3f;
+
+	for (int32 i = 0; i < 600; ++i)
+	{
+		bd.type = b2_dynamicBody;
+		bd.position.Set(-39.0f + 0.13f * i, 45.0f + 0.1f * ((37 * i) % 100));
+		b2Body* body = world->CreateBody(&bd);
+		body->CreateFixture((i & 1) ? (b2Shape*)&circle : (b2Shape*)&box, 1.0f);
+	}
+}
+
+static void CreateSensors(b2World* world)
+{
+	CreateTriggerZones(world, false);
+}
+
+static void CreateSensorFixtures(b2World* world)
+{
+	CreateTriggerZones(world, true);
+}
+
+// Boxes dropped into a heap of small debris. The debris is decorative, so
+// it can be filtered to only collide with the ground and the boxes, which
+// takes most of the pairs out before they get contacts.
+static void CreateDebris(b2World* world, bool filtered)
+{
+	CreateGround(world);
+
+	b2PolygonShape box;
+	box.SetAsBox(0.5f, 0.5f);
+
+	b2FixtureDef fd;
+	fd.shape = &box;
+	fd.density = 1.0f;
+
+	for (int32 i = 0; i < 100; ++i)
+	{
+		b2BodyDef bd;
+		bd.type = b2_dynamicBody;
+		bd.position.Set(-20.0f + 0.4f * i, 20.0f + 1.1f * (i % 10));
+		b2Body* body = world->CreateBody(&bd);
+		body->CreateFixture(&fd);
+	}
+
+	b2PolygonShape chip;
+	chip.SetAsBox(0.12f, 0.06f);
+	fd.shape = &chip;
+	if (filtered)
+	{
+		fd.filter.categoryBits = 0x0002;
+		fd.filter.maskBits = 0x0001;
+	}
+
+	for (int32 i = 0; i < 1500; ++i)
+	{
+		b2BodyDef bd;
+		bd.type = b2_dynamicBody;
+		bd.position.Set(-22.0f + 0.03f * i, 0.5f + 0.15f * ((37 * i) % 40));
+		bd.angle = 0.1f * i;
+		b2Body* body = world->CreateBody(&bd);
+		body->CreateFixture(&fd);
+	}
+}
+
+static void CreateDebrisUnfiltered(b2World* world)
+{
+	CreateDebris(world, false);
+}
+
+static void CreateDebrisFiltered(b2World* world)
+{
+	CreateDebris(world, true);
+}
+
+// Boxes and balls dropped into a pool with a current swirling in it, a
+// wind blowing over it and a gravity well above.
+static void CreateFields(b2World* world)
+{
+	CreateGround(world);
+
+	b2BodyDef bd;
+	b2Body* pool = world->CreateBody(&bd);
+	b2PolygonShape wall;
+	wall.SetAsBox(0.5f, 10.0f, b2Vec2(-30.5f, 10.0f), 0.0f);
+	pool->CreateFixture(&wall, 0.0f);
+	wall.SetAsBox(0.5f, 10.0f, b2Vec2(30.5f, 10.0f), 0.0f);
+	pool->CreateFixture(&wall, 0.0f);
+
+	b2PolygonShape box;
+	box.SetAsBox(0.3f, 0.2f);
+	b2CircleShape ball;
+	ball.m_radius = 0.25f;
+
+	b2FixtureDef fd;
+	fd.density = 0.6f;
+	fd.friction = 0.3f;
+
+	for (int32 i = 0; i < 800; ++i)
+	{
+		bd.type = b2_dynamicBody;
+		bd.position.Set(-28.0f + 0.07f * i, 2.0f + 0.9f * (i % 30));
+		b2Body* body = world->CreateBody(&bd);
+		fd.shape = (i & 1) ? (b2Shape*)&ball : (b2Shape*)&box;
+		body->CreateFixture(&fd);
+	}
+
+	b2BuoyancyFieldDef water;
+	water.area.lowerBound.Set(-30.0f, 0.0f);
+	water.area.upperBound.Set(30.0f, 12.0f);
+	water.offset = 12.0f;
+	water.density = 1.0f;
+	world->CreateController(&water);
+
+	b2VortexFieldDef current;
+	current.Initialize(b2Vec2(0.0f, 6.0f), 12.0f, 20.0f);
+	world->CreateController(&current);
+
+	b2DirectionalFieldDef wind;
+	wind.area.lowerBound.Set(-30.0f, 12.0f);
+	wind.area.upperBound.Set(30.0f, 20.0f);
+	wind.velocity.Set(8.0f, 0.0f);
+	wind.drag = 1.0f;
+	world->CreateController(&wind);
+
+	b2RadialFieldDef well;
+	well.Initialize(b2Vec2(10.0f, 22.0f), 8.0f, 15.0f);
+	world->CreateController(&well);
+}
+
+struct Scene
+{
+	const char* name;
+	void (*create)(b2World* world);
+	int32 stepCount;
+	bool stack;	// rated by the solver runs
+};
+
+static Scene s_scenes[] =
+{
+	{"VerticalStack", CreateVerticalStack, 300, true},
+	{"Pyramid", CreatePyramid, 300, true},
+	{"Projectiles", CreateProjectiles, 300, false},
+	{"Sensors", CreateSensors, 300, false},
+	{"SensorFixtures", CreateSensorFixtures, 300, false},
+	{"Debris", CreateDebrisUnfiltered, 300, false},
+	{"DebrisFiltered", CreateDebrisFiltered, 300, false},
+	{"Fields", CreateFields, 300, false},
+};
+
+static void RunScene(const Scene* scene, const char* schedulerName, b2TaskScheduler* scheduler,
+					 bool manifoldReuse = true)
+{
+	b2World world(b2Vec2(0.0f, -10.0f), true);
+	world.SetTaskScheduler(scheduler);
+	world.SetManifoldReuse(manifoldReuse);
+	scene->create(&world);
+
+	double start = GetMilliseconds();
+	int32 contactCount = 0;
+	for (int32 i = 0; i < scene->stepCount; ++i)
+	{
+		world.Step(1.0f / 60.0f, 8, 3);
+		contactCount += world.GetContactCount();
+	}
+	double elapsed = GetMilliseconds() - start;
+
+	float32 checksum = 0.0f;
+	for (b2Body* b = world.GetBodyList(); b; b = b->GetNext())
+	{
+		checksum += b->GetPosition().x + b->GetPosition().y;
+	}
+
+	printf("%-16s %-12s %8.3f ms/step  checksum %.6f  contacts %d\n", scene->name, schedulerName,
+		elapsed / scene->stepCount, checksum, contactCount / scene->stepCount);
+}
+
+static void RunSolver(const Scene* scene, bool subStepping, int32 iterations)
+{
+	b2World world(b2Vec2(0.0f, -10.0f), true);
+	world.SetSubStepping(subStepping);
+	scene->create(&world);
+
+	int32 bodyCount = world.GetBodyCount();
+	float32* startX = new float32[bodyCount];
+	int32 index = 0;
+	for (b2Body* b = world.GetBodyList(); b; b = b->GetNext())
+	{
+		startX[index++] = b->GetPosition().x;
+	}
+
+	// Twice as long as the other runs, for the stacks to topple or settle.
+	int32 stepCount = 2 * scene->stepCount;
+	double start = GetMilliseconds();
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		world.Step(1.0f / 60.0f, iterations, 3);
+	}
+	double elapsed = GetMilliseconds() - start;
+
+	float32 drift = 0.0f;
+	int32 awakeCount = 0;
+	index = 0;
+	for (b2Body* b = world.GetBodyList(); b; b = b->GetNext())
+	{
+		drift = b2Max(drift, b2Abs(b->GetPosition().x - startX[index++]));
+		if (b->GetType() == b2_dynamicBody && b->IsAwake())
+		{
+			++awakeCount;
+		}
+	}
+	delete [] startX;
+
+	char solverName[32];
+	sprintf(solverName, "%s/%d", subStepping ? "substep" : "iterate", iterations);
+
+	printf("%-16s %-12s %8.3f ms/step  drift %8.3f  awake %d\n", scene->name, solverName,
+		elapsed / stepCount, drift, awakeCount);
+}
+
+// A block of fluid at one side of a tank twice as wide, with boxes on top.
+static void RunParticles(int32 particleCount, const char* schedulerName, b2TaskScheduler* scheduler)
+{
+	b2World world(b2Vec2(0.0f, -10.0f), true);
+	world.SetTaskScheduler(scheduler);
+
+	b2ParticleSystemDef pd;
+	b2ParticleSystem* system = world.CreateParticleSystem(&pd);
+	float32 spacing = 2.0f * pd.radius;
+
+	int32 side = 1;
+	while (side * side < particleCount)
+	{
+		++side;
+	}
+	float32 width = 2.0f * side * spacing;
+	float32 height = 2.0f * side * spacing;
+
+	{
+		b2BodyDef bd;
+		b2Body* tank = world.CreateBody(&bd);
+
+		b2PolygonShape shape;
+		shape.SetAsBox(0.5f * width + 1.0f, 0.5f, b2Vec2(0.0f, -0.5f), 0.0f);
+		tank->CreateFixture(&shape, 0.0f);
+		shape.SetAsBox(0.5f, height, b2Vec2(-0.5f * width - 0.5f, height), 0.0f);
+		tank->CreateFixture(&shape, 0.0f);
+		shape.SetAsBox(0.5f, height, b2Vec2(0.5f * width + 0.5f, height), 0.0f);
+		tank->CreateFixture(&shape, 0.0f);
+	}
+
+	for (int32 i = 0; i < particleCount; ++i)
+	{
+		float32 x = -0.5f * width + (0.5f + i % side) * spacing;
+		float32 y = (0.5f + i / side) * spacing;
+		system->CreateParticle(b2Vec2(x, y), b2Vec2_zero);
+	}
+
+	for (int32 i = 0; i < 4; ++i)
+	{
+		b2BodyDef bd;
+		bd.type = b2_dynamicBody;
+		bd.position.Set(-0.5f * width + (i + 0.5f) * 0.125f * width, (side + 10) * spacing);
+		b2Body* body = world.CreateBody(&bd);
+
+		b2PolygonShape shape;
+		shape.SetAsBox(5.0f * spacing, 5.0f * spacing);
+		body->CreateFixture(&shape, 0.5f * pd.density);
+	}
+
+	const int32 stepCount = 60;
+	double start = GetMilliseconds();
+	for (int32 i = 0; i < stepCount; ++i)
+	{
+		world.Step(1.0f / 60.0f, 8, 3);
+	}
+	double elapsed = GetMilliseconds() - start;
+
+	float32 checksum = 0.0f;
+	const float32* x = system->GetPositionXBuffer();
+	const float32* y = system->GetPositionYBuffer();
+	for (int32 i = 0; i < system->GetParticleCount(); ++i)
+	{
+		checksum += x[i] + y[i];
+	}
+
+	char name[32];
+	sprintf(name, "Particles/%d", particleCount);
+
+	printf("%-16s %-12s %8.3f ms/step  checksum %.6f  particles %d\n", name, schedulerName,
+		elapsed / stepCount, checksum, system->GetParticleCount());
+}
+
+const int32 k_dispatchItemCount = 1024;
+
+// Barely any work per item, so the timing is dominated by the scheduler.
+class EmptyTask : public b2Task
+{
+public:
+	void Execute(int32 begin, int32 end, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+		for (int32 i = begin; i < end; ++i)
+		{
+			m_items[i] = i;
+		}
+	}
+
+	int32 m_items[k_dispatchItemCount];
+};
+
+static void RunDispatch(const char* schedulerName, b2TaskScheduler* scheduler)
+{
+	const int32 itemCount = k_dispatchItemCount;
+	const int32 runCount = 2000;
+
+	for (int32 minRange = 1; minRange <= itemCount; minRange *= 4)
+	{
+		EmptyTask task;
+
+		double start = GetMilliseconds();
+		for (int32 i = 0; i < runCount; ++i)
+		{
+			scheduler->Run(&task, itemCount, minRange);
+		}
+		double elapsed = GetMilliseconds() - start;
+
+		printf("%-16s %-12s minRange %4d %8.3f us/run\n", "Dispatch", schedulerName,
+			minRange, 1000.0 * elapsed / runCount);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32 threadCount = 4;
+	if (argc > 1)
+	{
+		threadCount = b2Max(1, atoi(argv[1]));
+	}
+
+	b2SerialTaskScheduler serial;
+	b2ThreadPoolTaskScheduler pool(threadCount);
+
+	char poolName[32];
+	sprintf(poolName, "pool/%d", pool.GetThreadCount());
+
+	int32 sceneCount = sizeof(s_scenes) / sizeof(s_scenes[0]);
+	for (int32 i = 0; i < sceneCount; ++i)
+	{
+		RunScene(s_scenes + i, "serial", &serial);
+		RunScene(s_scenes + i, poolName, &pool);
+		RunScene(s_scenes + i, "serial/exact", &serial, false);
+	}
+
+	for (int32 i = 0; i < sceneCount; ++i)
+	{
+		if (s_scenes[i].stack == false)
+		{
+			continue;
+		}
+
+		for (int32 iterations = 4; iterations <= 32; iterations *= 2)
+		{
+			RunSolver(s_scenes + i, false, iterations);
+		}
+
+		for (int32 subSteps = 2; subSteps <= 8; subSteps *= 2)
+		{
+			RunSolver(s_scenes + i, true, subSteps);
+		}
+	}
+
+	const int32 particleCounts[] = {1000, 10000, 50000, 100000};
+	for (int32 i = 0; i < 4; ++i)
+	{
+		RunParticles(particleCounts[i], "serial", &serial);
+		RunParticles(particleCounts[i], poolName, &pool);
+	}
+
+	RunDispatch("serial", &serial);
+	RunDispatch(poolName, &pool);
+
+	return 0;
+}
@@ -0,0 +1,246 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Box2D.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Checks of b2World::SaveState, b2World::RestoreState, with and without
+// particles, and of loading a saved broad-phase tree. Returns non-zero when one fails.
+
+static int32 s_failures = 0;
+
+static void Check(bool condition, const char* what)
+{
+	printf("%-60s %s\n", what, condition ? "ok" : "FAILED");
+	if (condition == false)
+	{
+		++s_failures;
+	}
+}
+
+// A few boxes falling on the ground.
+static void CreateScene(b2World* world, b2Body** bodies, int32 count, bool active = true)
+{
+	b2BodyDef bd;
+	bd.active = active;
+	b2Body* ground = world->CreateBody(&bd);
+
+	b2PolygonShape shape;
+	shape.SetAsEdge(b2Vec2(-40.0f, 0.0f), b2Vec2(40.0f, 0.0f));
+	ground->CreateFixture(&shape, 0.0f);
+
+	shape.SetAsBox(0.5f, 0.5f);
+	for (int32 i = 0; i < count; ++i)
+	{
+		bd.type = b2_dynamicBody;
+		bd.position.Set(0.1f * i, 0.5f + 1.1f * i);
+		bodies[i] = world->CreateBody(&bd);
+		bodies[i]->CreateFixture(&shape, 1.0f);
+	}
+}
+
+static void Step(b2World* world, int32 count)
+{
+	for (int32 i = 0; i < count; ++i)
+	{
+		world->Step(1.0f / 60.0f, 8, 3);
+	}
+}
+
+static void TestRestore()
+{
+	const int32 count = 8;
+	b2Body* bodies[count];
+	b2World world(b2Vec2(0.0f, -10.0f), true);
+	CreateScene(&world, bodies, count);
+	Step(&world, 30);
+
+	int32 size = world.GetStateSize();
+	char* buffer = (char*)malloc(size);
+	Check(world.SaveState(buffer, size) == size, "save");
+
+	Step(&world, 60);
+	b2Vec2 position = bodies[count - 1]->GetPosition();
+
+	Check(world.RestoreState(buffer, size), "restore");
+	Step(&world, 60);
+	Check(bodies[count - 1]->GetPosition() == position, "stepping a restored state repeats the steps");
+
+	free(buffer);
+}
+
+static void TestRecreatedFixture()
+{
+	const int32 count = 8;
+	b2Body* bodies[count];
+	b2World world(b2Vec2(0.0f, -10.0f), true);
+	CreateScene(&world, bodies, count);
+	Step(&world, 30);
+
+	int32 size = world.GetStateSize();
+	char* buffer = (char*)malloc(size);
+	world.SaveState(buffer, size);
+
+	// Recreating a fixture usually gets the memory of the old one back.
+	b2Body* body = bodies[count / 2];
+	b2PolygonShape shape;
+	shape.SetAsBox(0.5f, 0.5f);
+	body->DestroyFixture(body->GetFixtureList());
+	body->CreateFixture(&shape, 1.0f);
+
+	b2Vec2 position = body->GetPosition();
+	Check(world.RestoreState(buffer, size) == false, "restore fails after a fixture was recreated");
+	Check(body->GetPosition() == position, "a failed restore leaves the world untouched");
+
+	Step(&world, 60);
+	Check(world.GetContactCount() > 0, "the world still steps");
+
+	free(buffer);
+}
+
+static void TestParticles()
+{
+	const int32 count = 8;
+	b2Body* bodies[count];
+	b2World world(b2Vec2(0.0f, -10.0f), true);
+	CreateScene(&world, bodies, count);
+
+	b2ParticleSystemDef def;
+	def.radius = 0.1f;
+	b2ParticleSystem* system = world.CreateParticleSystem(&def);
+	for (int32 i = 0; i < 200; ++i)
+	{
+		system->CreateParticle(b2Vec2(-5.0f + 0.2f * (i % 20), 1.0f + 0.2f * (i / 20)), b2Vec2_zero);
+	}
+	Step(&world, 30);
+
+	int32 size = world.GetStateSize();
+	char* buffer = (char*)malloc(size);
+	Check(world.SaveState(buffer, size) == size, "save with particles");
+
+	Step(&world, 60);
+	b2Vec2 particle = system->GetPosition(199);
+	b2Vec2 position = bodies[0]->GetPosition();
+
+	// Particles created after the save are dropped by the restore.
+	for (int32 i = 0; i < 1000; ++i)
+	{
+		system->CreateParticle(b2Vec2(5.0f, 1.0f + 0.2f * i), b2Vec2_zero);
+	}
+
+	Check(world.RestoreState(buffer, size), "restore with particles");
+	Check(system->GetParticleCount() == 200, "the restored particle count is the saved one");
+	Step(&world, 60);
+	Check(system->GetPosition(199) == particle && bodies[0]->GetPosition() == position,
+		"stepping a restored state repeats the particle steps");
+
+	world.DestroyParticleSystem(system);
+	Check(world.RestoreState(buffer, size) == false, "restore fails after a particle system was destroyed");
+
+	free(buffer);
+}
+
+// The fixtures of a world in body order, the order SaveBroadPhase is given.
+static int32 GetFixtures(b2World* world, b2Fixture** fixtures)
+{
+	int32 count = 0;
+	for (b2Body* b = world->GetBodyList(); b; b = b->GetNext())
+	{
+		for (b2Fixture* f = b->GetFixtureList(); f; f = f->GetNext())
+		{
+			fixtures[count++] = f;
+		}
+	}
+	return count;
+}
+
+static void TestBroadPhaseLinks()
+{
+	const int32 count = 8;
+	b2Body* bodies[count];
+	b2Fixture* fixtures[count + 1];
+	b2DynamicTreeNode saved[2 * (count + 1)];
+	b2DynamicTreeNode nodes[2 * (count + 1)];
+	int32 root;
+
+	b2World source(b2Vec2(0.0f, -10.0f), true);
+	CreateScene(&source, bodies, count);
+	int32 fixtureCount = GetFixtures(&source, fixtures);
+	int32 nodeCount = source.SaveBroadPhase(saved, &root, fixtures, fixtureCount);
+	Check(nodeCount == 2 * fixtureCount - 1, "save the broad-phase");
+
+	{
+		b2World world(b2Vec2(0.0f, -10.0f), true);
+		CreateScene(&world, bodies, count, false);
+		GetFixtures(&world, fixtures);
+		memcpy(nodes, saved, nodeCount * sizeof(b2DynamicTreeNode));
+		Check(world.LoadBroadPhase(nodes, nodeCount, root, fixtures, fixtureCount), "load the broad-phase");
+		Step(&world, 10);
+		Check(world.GetContactCount() > 0, "the loaded bodies collide");
+	}
+
+	// Two internal nodes other than the root.
+	int32 first = b2_nullNode, internal = b2_nullNode;
+	for (int32 i = 0; i < nodeCount; ++i)
+	{
+		if (i != root && saved[i].IsLeaf() == false)
+		{
+			first = first == b2_nullNode ? i : first;
+			internal = i;
+		}
+	}
+
+	// An internal node whose child is the root makes a cycle.
+	{
+		b2World world(b2Vec2(0.0f, -10.0f), true);
+		CreateScene(&world, bodies, count, false);
+		GetFixtures(&world, fixtures);
+		memcpy(nodes, saved, nodeCount * sizeof(b2DynamicTreeNode));
+		nodes[internal].child1 = root;
+		Check(world.LoadBroadPhase(nodes, nodeCount, root, fixtures, fixtureCount) == false,
+			"a tree with a cycle is rejected");
+		Check(world.GetProxyCount() == 0, "a rejected tree leaves the world untouched");
+	}
+
+	// Children that don't link back to their parent.
+	{
+		b2World world(b2Vec2(0.0f, -10.0f), true);
+		CreateScene(&world, bodies, count, false);
+		GetFixtures(&world, fixtures);
+		memcpy(nodes, saved, nodeCount * sizeof(b2DynamicTreeNode));
+		b2Swap(nodes[first].child1, nodes[internal].child1);
+		Check(world.LoadBroadPhase(nodes, nodeCount, root, fixtures, fixtureCount) == false,
+			"a tree with broken parent links is rejected");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	B2_NOT_USED(argc);
+	B2_NOT_USED(argv);
+
+	TestRestore();
+	TestRecreatedFixture();
+	TestParticles();
+	TestBroadPhaseLinks();
+
+	return s_failures == 0 ? 0 : 1;
+}
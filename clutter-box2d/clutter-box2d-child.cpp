@@ -44,11 +44,18 @@ enum
   PROP_ANGULAR_VELOCITY,
   PROP_MODE,
   PROP_MANIPULATABLE,
+  PROP_LOD,
+  PROP_IS_SENSOR,
+  PROP_CATEGORY_BITS,
+  PROP_MASK_BITS,
+  PROP_GROUP_INDEX,
 };
 
 enum
 {
   COLLISION,
+  ENTER,
+  LEAVE,
   LAST_SIGNAL
 };
 
@@ -69,7 +76,16 @@ static gboolean clutter_box2d_child_captured_event (ClutterActor *stage,
 static gboolean
 clutter_box2d_child_is_bullet (ClutterBox2DChild *box2d_child)
 {
-  return box2d_child->priv->body->IsBullet ();
+  ClutterBox2D *box2d = CLUTTER_BOX2D (clutter_child_meta_get_container (
+                                       CLUTTER_CHILD_META (box2d_child)));
+  gboolean is_bullet;
+
+  _clutter_box2d_lock_world (box2d);
+  is_bullet = box2d_child->priv->body ?
+              box2d_child->priv->body->IsBullet () : FALSE;
+  _clutter_box2d_unlock_world (box2d);
+
+  return is_bullet;
 }
 
 static void
@@ -82,15 +98,25 @@ clutter_box2d_child_set_type2 (ClutterBox2DChild *box2d_child,
   if (box2d_child->priv->type == type)
     return;
 
+  _clutter_box2d_lock_world (box2d);
+
   if (box2d_child->priv->type != CLUTTER_BOX2D_NONE)
     {
       g_assert (box2d_child->priv->body);
 
+      /* The fields attached to the body go with it */
+      while (box2d_child->priv->fields)
+        clutter_box2d_field_destroy (
+          (ClutterBox2DField *) box2d_child->priv->fields->data);
+
       g_hash_table_remove (box2d->priv->bodies, box2d_child->priv->body);
+      _clutter_box2d_purge_bulk_commands (box2d, box2d_child->priv->body);
       world->DestroyBody (box2d_child->priv->body);
       box2d_child->priv->body = NULL;
       box2d_child->priv->fixture = NULL;
+      box2d_child->priv->sensor = NULL;
       box2d_child->priv->type = CLUTTER_BOX2D_NONE;
+      box2d->priv->snapshot_serial++;
     }
 
   if (type == CLUTTER_BOX2D_DYNAMIC ||
@@ -100,6 +126,7 @@ clutter_box2d_child_set_type2 (ClutterBox2DChild *box2d_child,
 
       bodyDef.linearDamping = 0.5f;
       bodyDef.angularDamping = 0.5f;
+      bodyDef.userData = box2d_child;
 
 
       SYNCLOG ("making an actor to be %s\n",
@@ -122,6 +149,8 @@ clutter_box2d_child_set_type2 (ClutterBox2DChild *box2d_child,
 
       g_hash_table_insert (box2d->priv->bodies, box2d_child->priv->body, box2d_child);
     }
+
+  _clutter_box2d_unlock_world (box2d);
 }
 
 /* Set the type of physical object an actor in a Box2D group is of.
@@ -141,16 +170,30 @@ clutter_box2d_child_set_type (ClutterBox2D      *box2d,
 static inline void
 clutter_box2d_child_refresh_shape (ClutterBox2DChild *box2d_child)
 {
-  if (box2d_child->priv->fixture)
+  if (box2d_child->priv->fixture || box2d_child->priv->sensor)
     {
       ClutterBox2D *box2d = CLUTTER_BOX2D (clutter_child_meta_get_container (
                                            CLUTTER_CHILD_META (box2d_child)));
-      box2d_child->priv->body->DestroyFixture (box2d_child->priv->fixture);
+      _clutter_box2d_lock_world (box2d);
+      if (box2d_child->priv->fixture)
+        box2d_child->priv->body->DestroyFixture (box2d_child->priv->fixture);
+      if (box2d_child->priv->sensor)
+        box2d_child->priv->world->DestroySensor (box2d_child->priv->sensor);
       box2d_child->priv->fixture = NULL;
+      box2d_child->priv->sensor = NULL;
       _clutter_box2d_sync_body (box2d, box2d_child);
+      _clutter_box2d_unlock_world (box2d);
     }
 }
 
+/* Counts the moves of the actor that didn't come from the simulation */
+static void
+clutter_box2d_child_transform_changed (ClutterBox2DChild *box2d_child)
+{
+  if (!box2d_child->priv->syncing)
+    box2d_child->priv->changes++;
+}
+
 static void
 clutter_box2d_child_set_manipulatable_internal (ClutterBox2DChild *box2d_child,
                                                 ClutterActor      *child,
@@ -196,13 +239,19 @@ clutter_box2d_child_set_is_bullet_internal (ClutterBox2DChild *box2d_child,
 {
   ClutterBox2D *box2d = CLUTTER_BOX2D (clutter_child_meta_get_container (
                                        CLUTTER_CHILD_META (box2d_child)));
+  _clutter_box2d_lock_world (box2d);
   _clutter_box2d_sync_body (box2d, box2d_child);
 
   if (!box2d_child->priv->body ||
       box2d_child->priv->body->IsBullet () == is_bullet)
-    return;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return;
+    }
 
   box2d_child->priv->body->SetBullet (is_bullet);
+  _clutter_box2d_unlock_world (box2d);
+
   g_object_notify (G_OBJECT (box2d_child), "is-bullet");
 }
 
@@ -218,6 +267,67 @@ clutter_box2d_child_set_is_circle_internal (ClutterBox2DChild *box2d_child,
     }
 }
 
+/* A sensor keeps its body, only the fixture is swapped for a b2Sensor.
+ * Overlaps of the fixture it had are forgotten without "leave" signals.
+ */
+static void
+clutter_box2d_child_set_is_sensor_internal (ClutterBox2DChild *box2d_child,
+                                            gboolean           is_sensor)
+{
+  if (box2d_child->priv->is_sensor != is_sensor)
+    {
+      box2d_child->priv->is_sensor = is_sensor;
+      clutter_box2d_child_refresh_shape (box2d_child);
+      g_object_notify (G_OBJECT (box2d_child), "is-sensor");
+    }
+}
+
+/* The filter is changed in place, contacts that are no longer wanted are
+ * destroyed at the next step and new pairs are found by the broad-phase.
+ */
+static void
+clutter_box2d_child_set_collision_filter_internal (ClutterBox2DChild *box2d_child,
+                                                   guint16            category_bits,
+                                                   guint16            mask_bits,
+                                                   gint16             group_index)
+{
+  ClutterBox2DChildPrivate *priv = box2d_child->priv;
+  ClutterBox2D *box2d = CLUTTER_BOX2D (clutter_child_meta_get_container (
+                                       CLUTTER_CHILD_META (box2d_child)));
+  GObject *gobject = G_OBJECT (box2d_child);
+  b2Filter filter;
+
+  if (priv->category_bits == category_bits &&
+      priv->mask_bits == mask_bits &&
+      priv->group_index == group_index)
+    return;
+
+  g_object_freeze_notify (gobject);
+  if (priv->category_bits != category_bits)
+    g_object_notify (gobject, "category-bits");
+  if (priv->mask_bits != mask_bits)
+    g_object_notify (gobject, "mask-bits");
+  if (priv->group_index != group_index)
+    g_object_notify (gobject, "group-index");
+
+  priv->category_bits = category_bits;
+  priv->mask_bits = mask_bits;
+  priv->group_index = group_index;
+
+  filter.categoryBits = category_bits;
+  filter.maskBits = mask_bits;
+  filter.groupIndex = group_index;
+
+  _clutter_box2d_lock_world (box2d);
+  if (priv->fixture)
+    priv->fixture->SetFilterData (filter);
+  if (priv->sensor)
+    priv->sensor->SetFilterData (filter);
+  _clutter_box2d_unlock_world (box2d);
+
+  g_object_thaw_notify (gobject);
+}
+
 static void
 clutter_box2d_child_set_density_internal (ClutterBox2DChild *box2d_child,
                                           gfloat             density)
@@ -262,14 +372,50 @@ clutter_box2d_child_set_linear_velocity_internal (ClutterBox2DChild   *box2d_chi
                                        CLUTTER_CHILD_META (box2d_child)));
   b2Vec2 b2velocity (velocity->x * box2d->priv->scale_factor,
                      velocity->y * box2d->priv->scale_factor);
-  box2d_child->priv->body->SetLinearVelocity (b2velocity);
+
+  if (!box2d_child->priv->body)
+    return;
+
+  if (!_clutter_box2d_queue_command (box2d,
+                                     CLUTTER_BOX2D_COMMAND_LINEAR_VELOCITY,
+                                     box2d_child->priv->body, b2velocity))
+    box2d_child->priv->body->SetLinearVelocity (b2velocity);
 }
 
 static void
 clutter_box2d_child_set_angular_velocity_internal (ClutterBox2DChild *box2d_child,
                                                    gfloat             velocity)
 {
-  box2d_child->priv->body->SetAngularVelocity (velocity);
+  ClutterBox2D *box2d = CLUTTER_BOX2D (clutter_child_meta_get_container (
+                                       CLUTTER_CHILD_META (box2d_child)));
+
+  if (!box2d_child->priv->body)
+    return;
+
+  if (!_clutter_box2d_queue_command (box2d,
+                                     CLUTTER_BOX2D_COMMAND_ANGULAR_VELOCITY,
+                                     box2d_child->priv->body,
+                                     b2Vec2 (velocity, 0)))
+    box2d_child->priv->body->SetAngularVelocity (velocity);
+}
+
+static void
+clutter_box2d_child_set_lod_internal (ClutterBox2DChild *box2d_child,
+                                      ClutterBox2DLod    lod)
+{
+  ClutterBox2D *box2d = CLUTTER_BOX2D (clutter_child_meta_get_container (
+                                       CLUTTER_CHILD_META (box2d_child)));
+
+  if (box2d_child->priv->lod == lod)
+    return;
+
+  /* Undo the old policy, the new one applies from the next step */
+  _clutter_box2d_lock_world (box2d);
+  _clutter_box2d_child_set_hidden (box2d, box2d_child, FALSE);
+  box2d_child->priv->lod = lod;
+  _clutter_box2d_unlock_world (box2d);
+
+  g_object_notify (G_OBJECT (box2d_child), "lod");
 }
 
 static void
@@ -304,6 +450,32 @@ clutter_box2d_child_set_property (GObject      *gobject,
                                                   g_value_get_boolean (value));
       break;
 
+    case PROP_IS_SENSOR:
+      clutter_box2d_child_set_is_sensor_internal (box2d_child,
+                                                  g_value_get_boolean (value));
+      break;
+
+    case PROP_CATEGORY_BITS:
+      clutter_box2d_child_set_collision_filter_internal (box2d_child,
+                                                         g_value_get_uint (value),
+                                                         box2d_child->priv->mask_bits,
+                                                         box2d_child->priv->group_index);
+      break;
+
+    case PROP_MASK_BITS:
+      clutter_box2d_child_set_collision_filter_internal (box2d_child,
+                                                         box2d_child->priv->category_bits,
+                                                         g_value_get_uint (value),
+                                                         box2d_child->priv->group_index);
+      break;
+
+    case PROP_GROUP_INDEX:
+      clutter_box2d_child_set_collision_filter_internal (box2d_child,
+                                                         box2d_child->priv->category_bits,
+                                                         box2d_child->priv->mask_bits,
+                                                         g_value_get_int (value));
+      break;
+
     case PROP_DENSITY:
       clutter_box2d_child_set_density_internal (box2d_child,
                                                 g_value_get_float (value));
@@ -335,6 +507,11 @@ clutter_box2d_child_set_property (GObject      *gobject,
 
       break;
 
+    case PROP_LOD:
+      clutter_box2d_child_set_lod_internal (box2d_child,
+                                            (ClutterBox2DLod) g_value_get_int (value));
+      break;
+
     case PROP_OUTLINE:
       {
         GValueArray *array;
@@ -393,12 +570,15 @@ clutter_box2d_child_get_property (GObject      *gobject,
   ClutterBox2DChild *box2d_child;
   ClutterBox2DChildPrivate *priv;
 
+  ClutterBox2D *box2d;
+
   child_meta = CLUTTER_CHILD_META (gobject);
   box2d_child = CLUTTER_BOX2D_CHILD (child_meta);
   priv = box2d_child->priv;
- 
+  box2d = CLUTTER_BOX2D (clutter_child_meta_get_container (child_meta));
+
+  _clutter_box2d_lock_world (box2d);
 
- 
   switch (prop_id)
     {
     case PROP_IS_BULLET:
@@ -408,6 +588,18 @@ clutter_box2d_child_get_property (GObject      *gobject,
     case PROP_IS_CIRCLE:
       g_value_set_boolean (value, box2d_child->priv->is_circle);
       break;
+    case PROP_IS_SENSOR:
+      g_value_set_boolean (value, box2d_child->priv->is_sensor);
+      break;
+    case PROP_CATEGORY_BITS:
+      g_value_set_uint (value, priv->category_bits);
+      break;
+    case PROP_MASK_BITS:
+      g_value_set_uint (value, priv->mask_bits);
+      break;
+    case PROP_GROUP_INDEX:
+      g_value_set_int (value, priv->group_index);
+      break;
     case PROP_DENSITY:
       g_value_set_float (value, box2d_child->priv->density);
       break;
@@ -423,8 +615,6 @@ clutter_box2d_child_get_property (GObject      *gobject,
 
         if (box2d_child->priv->body)
           {
-            ClutterBox2D *box2d = CLUTTER_BOX2D (clutter_child_meta_get_container (
-                                                 CLUTTER_CHILD_META (box2d_child)));
             b2Vec2 velocity = box2d_child->priv->body->GetLinearVelocity();
             vertex.x = velocity.x / box2d->priv->scale_factor;
             vertex.y = velocity.y / box2d->priv->scale_factor;
@@ -444,10 +634,15 @@ clutter_box2d_child_get_property (GObject      *gobject,
     case PROP_MANIPULATABLE:
       g_value_set_boolean (value, priv->manipulatable);
       break;
+    case PROP_LOD:
+      g_value_set_int (value, priv->lod);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
     }
+
+  _clutter_box2d_unlock_world (box2d);
 }
 
 static void
@@ -470,6 +665,26 @@ clutter_box2d_child_class_init (ClutterBox2DChildClass *klass)
                                  G_TYPE_NONE, 1, 
                                  CLUTTER_TYPE_BOX2D_COLLISION);
 
+  /* Sensor children report the actors that start and stop overlapping
+   * them, see clutter_box2d_child_set_is_sensor() */
+  box2d_child_signals[ENTER] = g_signal_new ("enter",
+                                 G_TYPE_FROM_CLASS (gobject_class),
+                                 G_SIGNAL_RUN_LAST,
+                                 0,
+                                 NULL, NULL,
+                                 _clutter_box2d_marshal_VOID__OBJECT,
+                                 G_TYPE_NONE, 1,
+                                 CLUTTER_TYPE_ACTOR);
+
+  box2d_child_signals[LEAVE] = g_signal_new ("leave",
+                                 G_TYPE_FROM_CLASS (gobject_class),
+                                 G_SIGNAL_RUN_LAST,
+                                 0,
+                                 NULL, NULL,
+                                 _clutter_box2d_marshal_VOID__OBJECT,
+                                 G_TYPE_NONE, 1,
+                                 CLUTTER_TYPE_ACTOR);
+
   g_object_class_install_property (gobject_class,
                                    PROP_DENSITY,
                                    g_param_spec_float ("density",
@@ -535,6 +750,43 @@ clutter_box2d_child_class_init (ClutterBox2DChildClass *klass)
                                      "a rectangle.",
                                                          FALSE,
                                                          (GParamFlags)G_PARAM_READWRITE));
+  g_object_class_install_property (gobject_class,
+                                   PROP_IS_SENSOR,
+                                   g_param_spec_boolean ("is-sensor",
+                                                         "Is sensor",
+                                     "Whether this object only reports the "
+                                     "actors overlapping it, through the "
+                                     "enter and leave signals, instead of "
+                                     "colliding with them.",
+                                                         FALSE,
+                                                         (GParamFlags)G_PARAM_READWRITE));
+  g_object_class_install_property (gobject_class,
+                                   PROP_CATEGORY_BITS,
+                                   g_param_spec_uint ("category-bits",
+                                                      "Category bits",
+                                     "The collision categories this object "
+                                     "belongs to, one per bit.",
+                                                      0, G_MAXUINT16, 0x0001,
+                                                      (GParamFlags)G_PARAM_READWRITE));
+  g_object_class_install_property (gobject_class,
+                                   PROP_MASK_BITS,
+                                   g_param_spec_uint ("mask-bits",
+                                                      "Mask bits",
+                                     "The collision categories this object "
+                                     "collides with, both objects have to "
+                                     "accept each other's category.",
+                                                      0, G_MAXUINT16, 0xFFFF,
+                                                      (GParamFlags)G_PARAM_READWRITE));
+  g_object_class_install_property (gobject_class,
+                                   PROP_GROUP_INDEX,
+                                   g_param_spec_int ("group-index",
+                                                     "Group index",
+                                     "Objects sharing a positive group always "
+                                     "collide and objects sharing a negative "
+                                     "group never do, whatever their "
+                                     "categories. Zero is no group.",
+                                                     G_MININT16, G_MAXINT16, 0,
+                                                     (GParamFlags)G_PARAM_READWRITE));
 
 
   g_object_class_install_property (gobject_class,
@@ -545,6 +797,16 @@ clutter_box2d_child_class_init (ClutterBox2DChildClass *klass)
                                                          FALSE,
                                                          (GParamFlags)G_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_class,
+                                   PROP_LOD,
+                                   g_param_spec_int ("lod",
+                                                     "Level of detail",
+                                   "How the actor is simulated while it isn't visible (full rate, reduced rate or asleep)",
+                                                     CLUTTER_BOX2D_LOD_NONE,
+                                                     CLUTTER_BOX2D_LOD_SLEEP,
+                                                     CLUTTER_BOX2D_LOD_NONE,
+                                                     (GParamFlags)G_PARAM_READWRITE));
+
   g_object_class_install_property (gobject_class,
                                    PROP_OUTLINE,
                                    g_param_spec_value_array ("outline",
@@ -571,6 +833,18 @@ clutter_box2d_child_constructed (GObject *object)
   g_signal_connect_swapped (actor, "notify::natural-height",
                             G_CALLBACK (clutter_box2d_child_refresh_shape),
                             object);
+
+  /* The fixed position only changes when the actor is moved, x and y are
+   * also notified when it is allocated */
+  g_signal_connect_swapped (actor, "notify::fixed-x",
+                            G_CALLBACK (clutter_box2d_child_transform_changed),
+                            object);
+  g_signal_connect_swapped (actor, "notify::fixed-y",
+                            G_CALLBACK (clutter_box2d_child_transform_changed),
+                            object);
+  g_signal_connect_swapped (actor, "notify::rotation-angle-z",
+                            G_CALLBACK (clutter_box2d_child_transform_changed),
+                            object);
 }
 
 static void
@@ -582,6 +856,12 @@ clutter_box2d_child_init (ClutterBox2DChild *self)
   priv->density = 7.0f;
   priv->friction = 0.4f;
   priv->restitution = 0.f;
+  priv->category_bits = 0x0001;
+  priv->mask_bits = 0xFFFF;
+  priv->group_index = 0;
+
+  /* The first step syncs the body with the actor */
+  priv->changes = 1;
 }
 
 static void
@@ -590,19 +870,28 @@ clutter_box2d_child_dispose (GObject *object)
   ClutterChildMeta *child_meta = CLUTTER_CHILD_META (object);
   ClutterBox2DChild *self = CLUTTER_BOX2D_CHILD (object);
   ClutterBox2DChildPrivate *priv = self->priv;
+  ClutterBox2D *box2d =
+    CLUTTER_BOX2D (clutter_child_meta_get_container (child_meta));
 
   g_assert (priv->world);
 
   if (child_meta->actor)
-    g_signal_handlers_disconnect_by_func (child_meta->actor,
-                                          (gpointer)clutter_box2d_child_refresh_shape,
-                                          object);
+    {
+      g_signal_handlers_disconnect_by_func (child_meta->actor,
+                                            (gpointer)clutter_box2d_child_refresh_shape,
+                                            object);
+      g_signal_handlers_disconnect_by_func (child_meta->actor,
+                                            (gpointer)clutter_box2d_child_transform_changed,
+                                            object);
+    }
 
   /* This will disconnect any capture/press signal handlers */
   if (priv->manipulatable)
     clutter_box2d_child_set_manipulatable_internal (self, child_meta->actor,
                                                     FALSE);
 
+  _clutter_box2d_lock_world (box2d);
+
   if (priv->mouse_joint)
     {
       clutter_box2d_joint_destroy (priv->mouse_joint);
@@ -612,12 +901,22 @@ clutter_box2d_child_dispose (GObject *object)
   while (priv->joints)
     clutter_box2d_joint_destroy ((ClutterBox2DJoint*)priv->joints->data);
 
+  while (priv->fields)
+    clutter_box2d_field_destroy ((ClutterBox2DField *) priv->fields->data);
+
+  if (child_meta->actor)
+    _clutter_box2d_purge_sensor_events (box2d, child_meta->actor);
+
   if (priv->body)
     {
+      _clutter_box2d_purge_bulk_commands (box2d, priv->body);
       priv->world->DestroyBody (priv->body);
       priv->body = NULL;
+      box2d->priv->snapshot_serial++;
     }
 
+  _clutter_box2d_unlock_world (box2d);
+
   G_OBJECT_CLASS (clutter_box2d_child_parent_class)->dispose (object);
 }
 
@@ -775,7 +1074,9 @@ clutter_box2d_child_get_is_bullet (ClutterBox2D *box2d,
   g_return_val_if_fail (CLUTTER_IS_ACTOR (child), FALSE);
 
   if ((self = clutter_box2d_get_child (box2d, child)))
-    return (self->priv->body ? self->priv->body->IsBullet () : FALSE);
+    return clutter_box2d_child_is_bullet (self);
+  else
+    return FALSE;
 }
 
 void
@@ -805,6 +1106,80 @@ clutter_box2d_child_get_is_circle (ClutterBox2D *box2d,
     return self->priv->is_circle;
 }
 
+/* Turns the child into a trigger zone: it has the same shape, but other
+ * bodies go through it. The "enter" and "leave" signals of the child meta
+ * are emitted after each iteration with the actors that started or
+ * stopped overlapping it, in the order of the steps.
+ */
+void
+clutter_box2d_child_set_is_sensor (ClutterBox2D *box2d,
+                                   ClutterActor *child,
+                                   gboolean      is_sensor)
+{
+  ClutterBox2DChild *self;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (CLUTTER_IS_ACTOR (child));
+
+  if ((self = clutter_box2d_get_child (box2d, child)))
+    clutter_box2d_child_set_is_sensor_internal (self, is_sensor);
+}
+
+gboolean
+clutter_box2d_child_get_is_sensor (ClutterBox2D *box2d,
+                                   ClutterActor *child)
+{
+  ClutterBox2DChild *self;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), FALSE);
+  g_return_val_if_fail (CLUTTER_IS_ACTOR (child), FALSE);
+
+  if ((self = clutter_box2d_get_child (box2d, child)))
+    return self->priv->is_sensor;
+  else
+    return FALSE;
+}
+
+void
+clutter_box2d_child_set_collision_filter (ClutterBox2D *box2d,
+                                          ClutterActor *child,
+                                          guint16       category_bits,
+                                          guint16       mask_bits,
+                                          gint16        group_index)
+{
+  ClutterBox2DChild *self;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (CLUTTER_IS_ACTOR (child));
+
+  if ((self = clutter_box2d_get_child (box2d, child)))
+    clutter_box2d_child_set_collision_filter_internal (self, category_bits,
+                                                       mask_bits, group_index);
+}
+
+void
+clutter_box2d_child_get_collision_filter (ClutterBox2D *box2d,
+                                          ClutterActor *child,
+                                          guint16      *category_bits,
+                                          guint16      *mask_bits,
+                                          gint16       *group_index)
+{
+  ClutterBox2DChild *self;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (CLUTTER_IS_ACTOR (child));
+
+  if (!(self = clutter_box2d_get_child (box2d, child)))
+    return;
+
+  if (category_bits)
+    *category_bits = self->priv->category_bits;
+  if (mask_bits)
+    *mask_bits = self->priv->mask_bits;
+  if (group_index)
+    *group_index = self->priv->group_index;
+}
+
 void
 clutter_box2d_child_set_outline (ClutterBox2D        *box2d,
                                  ClutterActor        *child,
@@ -983,7 +1358,12 @@ clutter_box2d_child_get_linear_velocity (ClutterBox2D  *box2d,
 
   if ((self = clutter_box2d_get_child (box2d, child)) && self->priv->body)
     {
-      b2Vec2 b2velocity = self->priv->body->GetLinearVelocity ();
+      b2Vec2 b2velocity;
+
+      _clutter_box2d_lock_world (box2d);
+      b2velocity = self->priv->body->GetLinearVelocity ();
+      _clutter_box2d_unlock_world (box2d);
+
       velocity->x = b2velocity.x * box2d->priv->inv_scale_factor;
       velocity->y = b2velocity.y * box2d->priv->inv_scale_factor;
       velocity->z = 0;
@@ -1016,7 +1396,15 @@ clutter_box2d_child_get_angular_velocity (ClutterBox2D   *box2d,
   g_return_val_if_fail (CLUTTER_IS_ACTOR (child), 0.f);
 
   if ((self = clutter_box2d_get_child (box2d, child)) && self->priv->body)
-    return self->priv->body->GetAngularVelocity ();
+    {
+      gfloat velocity;
+
+      _clutter_box2d_lock_world (box2d);
+      velocity = self->priv->body->GetAngularVelocity ();
+      _clutter_box2d_unlock_world (box2d);
+
+      return velocity;
+    }
   else
     return 0.f;
 }
@@ -1079,3 +1467,31 @@ clutter_box2d_child_get_manipulatable (ClutterBox2D *box2d,
     return FALSE;
 }
 
+void
+clutter_box2d_child_set_lod (ClutterBox2D    *box2d,
+                             ClutterActor    *child,
+                             ClutterBox2DLod  lod)
+{
+  ClutterBox2DChild *self;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (CLUTTER_IS_ACTOR (child));
+
+  if ((self = clutter_box2d_get_child (box2d, child)))
+    clutter_box2d_child_set_lod_internal (self, lod);
+}
+
+ClutterBox2DLod
+clutter_box2d_child_get_lod (ClutterBox2D *box2d,
+                             ClutterActor *child)
+{
+  ClutterBox2DChild *self;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), CLUTTER_BOX2D_LOD_NONE);
+  g_return_val_if_fail (CLUTTER_IS_ACTOR (child), CLUTTER_BOX2D_LOD_NONE);
+
+  if ((self = clutter_box2d_get_child (box2d, child)))
+    return self->priv->lod;
+  else
+    return CLUTTER_BOX2D_LOD_NONE;
+}
@@ -77,6 +77,23 @@ void clutter_box2d_child_set_is_circle (ClutterBox2D *box2d,
 gboolean clutter_box2d_child_get_is_circle (ClutterBox2D *box2d,
                                             ClutterActor *child);
 
+void clutter_box2d_child_set_is_sensor (ClutterBox2D *box2d,
+                                        ClutterActor *child,
+                                        gboolean      is_sensor);
+gboolean clutter_box2d_child_get_is_sensor (ClutterBox2D *box2d,
+                                            ClutterActor *child);
+
+void clutter_box2d_child_set_collision_filter (ClutterBox2D *box2d,
+                                               ClutterActor *child,
+                                               guint16       category_bits,
+                                               guint16       mask_bits,
+                                               gint16        group_index);
+void clutter_box2d_child_get_collision_filter (ClutterBox2D *box2d,
+                                               ClutterActor *child,
+                                               guint16      *category_bits,
+                                               guint16      *mask_bits,
+                                               gint16       *group_index);
+
 void clutter_box2d_child_set_outline (ClutterBox2D        *box2d,
                                       ClutterActor        *child,
                                       const ClutterVertex *outline,
@@ -128,6 +145,12 @@ void clutter_box2d_child_set_manipulatable (ClutterBox2D *box2d,
 gboolean clutter_box2d_child_get_manipulatable (ClutterBox2D *box2d,
                                                 ClutterActor *child);
 
+void clutter_box2d_child_set_lod (ClutterBox2D    *box2d,
+                                  ClutterActor    *child,
+                                  ClutterBox2DLod  lod);
+ClutterBox2DLod clutter_box2d_child_get_lod (ClutterBox2D *box2d,
+                                             ClutterActor *child);
+
 G_END_DECLS
 
 #endif
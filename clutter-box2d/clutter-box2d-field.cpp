@@ -0,0 +1,288 @@
+/* clutter-box2d - Clutter box2d integration
+ *
+ * Copyright 2010 Intel Corporation
+ * Licensed under the LGPL v2 or greater.
+ */
+
+#include "Box2D.h"
+#include <clutter/clutter.h>
+#include "clutter-box2d.h"
+#include "clutter-box2d-child.h"
+#include "clutter-box2d-private.h"
+
+/* A Box2DField tracks a b2Controller of the world */
+struct _ClutterBox2DField
+{
+  ClutterBox2D          *box2d;
+  ClutterBox2DFieldType  type;
+  b2Controller          *controller;
+  ClutterBox2DChild     *child; /* The child the field is attached to, or
+                                   NULL for a field of the container */
+};
+
+ClutterBox2DFieldType
+clutter_box2d_field_get_type (ClutterBox2DField *field)
+{
+  g_return_val_if_fail (field != NULL, CLUTTER_BOX2D_FIELD_RADIAL);
+  return field->type;
+}
+
+/* Gets the child a field is attached to, making sure it has a body.
+ * Returns FALSE if the actor isn't simulated.
+ */
+static gboolean
+clutter_box2d_field_get_child (ClutterBox2D       *box2d,
+                               ClutterActor       *actor,
+                               ClutterBox2DChild **child)
+{
+  *child = NULL;
+  if (!actor)
+    return TRUE;
+
+  *child = clutter_box2d_get_child (box2d, actor);
+  if (!*child)
+    return FALSE;
+
+  _clutter_box2d_sync_body (box2d, *child);
+  return (*child)->priv->body != NULL;
+}
+
+static ClutterBox2DField *
+clutter_box2d_field_new (ClutterBox2D          *box2d,
+                         ClutterBox2DChild     *child,
+                         b2ControllerDef       *def,
+                         ClutterBox2DFieldType  type)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  ClutterBox2DField *self = g_new0 (ClutterBox2DField, 1);
+
+  def->body = child ? child->priv->body : NULL;
+
+  self->box2d = box2d;
+  self->type = type;
+  self->child = child;
+  self->controller = priv->world->CreateController (def);
+  self->controller->SetUserData (self);
+
+  if (child)
+    child->priv->fields = g_list_prepend (child->priv->fields, self);
+  else
+    priv->fields = g_list_prepend (priv->fields, self);
+
+  return self;
+}
+
+void
+clutter_box2d_field_destroy (ClutterBox2DField *field)
+{
+  ClutterBox2DPrivate *priv;
+
+  g_return_if_fail (field);
+
+  priv = field->box2d->priv;
+
+  _clutter_box2d_lock_world (field->box2d);
+  priv->world->DestroyController (field->controller);
+  _clutter_box2d_unlock_world (field->box2d);
+
+  if (field->child)
+    field->child->priv->fields = g_list_remove (field->child->priv->fields,
+                                                field);
+  else
+    priv->fields = g_list_remove (priv->fields, field);
+
+  g_free (field);
+}
+
+void
+clutter_box2d_field_set_mask_bits (ClutterBox2DField *field,
+                                   guint16            mask_bits)
+{
+  g_return_if_fail (field);
+
+  _clutter_box2d_lock_world (field->box2d);
+  field->controller->SetMaskBits (mask_bits);
+  _clutter_box2d_unlock_world (field->box2d);
+}
+
+static inline void
+clutter_box2d_field_set_area (ClutterBox2D          *box2d,
+                              b2ControllerDef       *def,
+                              const ClutterActorBox *area)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+
+  def->area.lowerBound = b2Vec2 (MIN (area->x1, area->x2) * priv->scale_factor,
+                                 MIN (area->y1, area->y2) * priv->scale_factor);
+  def->area.upperBound = b2Vec2 (MAX (area->x1, area->x2) * priv->scale_factor,
+                                 MAX (area->y1, area->y2) * priv->scale_factor);
+}
+
+ClutterBox2DField *
+clutter_box2d_add_radial_field (ClutterBox2D        *box2d,
+                                ClutterActor        *actor,
+                                const ClutterVertex *center,
+                                gdouble              radius,
+                                gdouble              strength)
+{
+  ClutterBox2DPrivate *priv;
+  ClutterBox2DChild *child;
+  ClutterBox2DField *field;
+  b2RadialFieldDef def;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), NULL);
+  g_return_val_if_fail (actor == NULL || CLUTTER_IS_ACTOR (actor), NULL);
+  g_return_val_if_fail (center != NULL, NULL);
+  g_return_val_if_fail (radius > 0, NULL);
+
+  priv = box2d->priv;
+
+  _clutter_box2d_lock_world (box2d);
+
+  if (!clutter_box2d_field_get_child (box2d, actor, &child))
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
+
+  def.Initialize (b2Vec2 (center->x * priv->scale_factor,
+                          center->y * priv->scale_factor),
+                  radius * priv->scale_factor,
+                  strength * priv->scale_factor);
+
+  field = clutter_box2d_field_new (box2d, child, &def,
+                                   CLUTTER_BOX2D_FIELD_RADIAL);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return field;
+}
+
+ClutterBox2DField *
+clutter_box2d_add_vortex_field (ClutterBox2D        *box2d,
+                                ClutterActor        *actor,
+                                const ClutterVertex *center,
+                                gdouble              radius,
+                                gdouble              strength)
+{
+  ClutterBox2DPrivate *priv;
+  ClutterBox2DChild *child;
+  ClutterBox2DField *field;
+  b2VortexFieldDef def;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), NULL);
+  g_return_val_if_fail (actor == NULL || CLUTTER_IS_ACTOR (actor), NULL);
+  g_return_val_if_fail (center != NULL, NULL);
+  g_return_val_if_fail (radius > 0, NULL);
+
+  priv = box2d->priv;
+
+  _clutter_box2d_lock_world (box2d);
+
+  if (!clutter_box2d_field_get_child (box2d, actor, &child))
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
+
+  def.Initialize (b2Vec2 (center->x * priv->scale_factor,
+                          center->y * priv->scale_factor),
+                  radius * priv->scale_factor,
+                  strength * priv->scale_factor);
+
+  field = clutter_box2d_field_new (box2d, child, &def,
+                                   CLUTTER_BOX2D_FIELD_VORTEX);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return field;
+}
+
+ClutterBox2DField *
+clutter_box2d_add_directional_field (ClutterBox2D          *box2d,
+                                     ClutterActor          *actor,
+                                     const ClutterActorBox *area,
+                                     const ClutterVertex   *acceleration,
+                                     const ClutterVertex   *velocity,
+                                     gdouble                drag)
+{
+  ClutterBox2DPrivate *priv;
+  ClutterBox2DChild *child;
+  ClutterBox2DField *field;
+  b2DirectionalFieldDef def;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), NULL);
+  g_return_val_if_fail (actor == NULL || CLUTTER_IS_ACTOR (actor), NULL);
+  g_return_val_if_fail (area != NULL, NULL);
+  g_return_val_if_fail (drag >= 0, NULL);
+
+  priv = box2d->priv;
+
+  _clutter_box2d_lock_world (box2d);
+
+  if (!clutter_box2d_field_get_child (box2d, actor, &child))
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
+
+  clutter_box2d_field_set_area (box2d, &def, area);
+  if (acceleration)
+    def.acceleration = b2Vec2 (acceleration->x * priv->scale_factor,
+                               acceleration->y * priv->scale_factor);
+  if (velocity)
+    def.velocity = b2Vec2 (velocity->x * priv->scale_factor,
+                           velocity->y * priv->scale_factor);
+  def.drag = drag;
+
+  field = clutter_box2d_field_new (box2d, child, &def,
+                                   CLUTTER_BOX2D_FIELD_DIRECTIONAL);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return field;
+}
+
+ClutterBox2DField *
+clutter_box2d_add_buoyancy_field (ClutterBox2D          *box2d,
+                                  ClutterActor          *actor,
+                                  const ClutterActorBox *area,
+                                  gdouble                level,
+                                  gdouble                density,
+                                  gdouble                linear_drag,
+                                  gdouble                angular_drag)
+{
+  ClutterBox2DPrivate *priv;
+  ClutterBox2DChild *child;
+  ClutterBox2DField *field;
+  b2BuoyancyFieldDef def;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), NULL);
+  g_return_val_if_fail (actor == NULL || CLUTTER_IS_ACTOR (actor), NULL);
+  g_return_val_if_fail (area != NULL, NULL);
+
+  priv = box2d->priv;
+
+  _clutter_box2d_lock_world (box2d);
+
+  if (!clutter_box2d_field_get_child (box2d, actor, &child))
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
+
+  /* The y axis points down, the fluid is below the level */
+  clutter_box2d_field_set_area (box2d, &def, area);
+  def.normal = b2Vec2 (0.0f, -1.0f);
+  def.offset = -level * priv->scale_factor;
+  def.density = density;
+  def.linearDrag = linear_drag;
+  def.angularDrag = angular_drag;
+
+  field = clutter_box2d_field_new (box2d, child, &def,
+                                   CLUTTER_BOX2D_FIELD_BUOYANCY);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return field;
+}
@@ -0,0 +1,176 @@
+/* clutter-box2d - Clutter box2d integration
+ *
+ * Copyright 2010 Intel Corporation
+ * Licensed under the LGPL v2 or greater.
+ */
+
+#ifndef _CLUTTER_BOX2D_FIELD_H
+#define _CLUTTER_BOX2D_FIELD_H
+
+#include <clutter/clutter.h>
+#include <clutter-box2d/clutter-box2d.h>
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:clutter-box2d-field
+ * @short_description: Force fields acting on the actors in an area.
+ *
+ * Fields push the dynamic actors that overlap their area around, once per
+ * step of the simulation, without the application setting velocities
+ * every frame. A field is either fixed in the coordinates of the
+ * #ClutterBox2D or attached to an actor, in which case its area and
+ * points are relative to the actor and move and rotate with it. The actor
+ * itself is not affected by its fields.
+ *
+ * Positions are in pixels and accelerations in pixels per second squared.
+ * Fields do not wake up actors that went to sleep after they were added.
+ */
+
+/**
+ * ClutterBox2DField:
+ *
+ * A handle refering to a field in a #ClutterBox2D container. A field
+ * attached to an actor is destroyed along with it, or when the actor
+ * stops being simulated. Other fields last until they are destroyed with
+ * clutter_box2d_field_destroy() or the container is destroyed.
+ */
+typedef struct _ClutterBox2DField   ClutterBox2DField;
+
+/**
+ * ClutterBox2DFieldType:
+ * @CLUTTER_BOX2D_FIELD_RADIAL: Pulls actors toward a point
+ * @CLUTTER_BOX2D_FIELD_DIRECTIONAL: Accelerates actors in one direction,
+ *   and drags them along with a wind
+ * @CLUTTER_BOX2D_FIELD_BUOYANCY: Makes actors float in a fluid
+ * @CLUTTER_BOX2D_FIELD_VORTEX: Swirls actors around a point
+ *
+ * Identifiers for different field types.
+ */
+typedef enum
+{
+  CLUTTER_BOX2D_FIELD_RADIAL,
+  CLUTTER_BOX2D_FIELD_DIRECTIONAL,
+  CLUTTER_BOX2D_FIELD_BUOYANCY,
+  CLUTTER_BOX2D_FIELD_VORTEX
+} ClutterBox2DFieldType;
+
+/**
+ * clutter_box2d_field_get_type:
+ * @field: A #ClutterBox2DField
+ *
+ * Retrieves the type of the field.
+ *
+ * Returns: a #ClutterBox2DFieldType
+ */
+ClutterBox2DFieldType
+clutter_box2d_field_get_type (ClutterBox2DField *field);
+
+/**
+ * clutter_box2d_add_radial_field:
+ * @box2d: a #ClutterBox2D
+ * @actor: the actor the field is attached to, or %NULL
+ * @center: the center of the field
+ * @radius: the distance from the center where the field fades out
+ * @strength: the acceleration at the center, toward it
+ *
+ * Create a radial field, like a gravity well. The acceleration falls
+ * linearly from @strength at the center to nothing at @radius; a negative
+ * @strength pushes actors away.
+ *
+ * Returns: a #ClutterBox2DField handle or %NULL on error.
+ */
+ClutterBox2DField *clutter_box2d_add_radial_field (ClutterBox2D        *box2d,
+                                                   ClutterActor        *actor,
+                                                   const ClutterVertex *center,
+                                                   gdouble              radius,
+                                                   gdouble              strength);
+
+/**
+ * clutter_box2d_add_vortex_field:
+ * @box2d: a #ClutterBox2D
+ * @actor: the actor the field is attached to, or %NULL
+ * @center: the center of the field
+ * @radius: the distance from the center where the field fades out
+ * @strength: the acceleration at the center, clockwise on the screen
+ *
+ * Create a vortex field. The acceleration is perpendicular to the
+ * direction of the center and falls linearly from @strength at the center
+ * to nothing at @radius. Actors drift out of a vortex on their own, add a
+ * radial field at the same place to draw them in.
+ *
+ * Returns: a #ClutterBox2DField handle or %NULL on error.
+ */
+ClutterBox2DField *clutter_box2d_add_vortex_field (ClutterBox2D        *box2d,
+                                                   ClutterActor        *actor,
+                                                   const ClutterVertex *center,
+                                                   gdouble              radius,
+                                                   gdouble              strength);
+
+/**
+ * clutter_box2d_add_directional_field:
+ * @box2d: a #ClutterBox2D
+ * @actor: the actor the field is attached to, or %NULL
+ * @area: the area of the field
+ * @acceleration: a constant acceleration, or %NULL
+ * @velocity: the velocity of the wind, in pixels per second, or %NULL
+ * @drag: how fast actors are brought to the velocity of the wind, in 1/s
+ *
+ * Create a directional field, such as a local gravity or a wind. Actors
+ * of any mass are accelerated the same way.
+ *
+ * Returns: a #ClutterBox2DField handle or %NULL on error.
+ */
+ClutterBox2DField *clutter_box2d_add_directional_field (ClutterBox2D          *box2d,
+                                                        ClutterActor          *actor,
+                                                        const ClutterActorBox *area,
+                                                        const ClutterVertex   *acceleration,
+                                                        const ClutterVertex   *velocity,
+                                                        gdouble                drag);
+
+/**
+ * clutter_box2d_add_buoyancy_field:
+ * @box2d: a #ClutterBox2D
+ * @actor: the actor the field is attached to, or %NULL
+ * @area: the area of the field, which should cover the fluid
+ * @level: the vertical position of the surface of the fluid
+ * @density: the density of the fluid, compared to the density of actors
+ * @linear_drag: the drag of the fluid on actors moving through it
+ * @angular_drag: the drag of the fluid on actors turning in it
+ *
+ * Create a buoyancy field. The part of an actor below @level floats up
+ * against the gravity of @box2d, actors less dense than the fluid float
+ * on its surface.
+ *
+ * Returns: a #ClutterBox2DField handle or %NULL on error.
+ */
+ClutterBox2DField *clutter_box2d_add_buoyancy_field (ClutterBox2D          *box2d,
+                                                     ClutterActor          *actor,
+                                                     const ClutterActorBox *area,
+                                                     gdouble                level,
+                                                     gdouble                density,
+                                                     gdouble                linear_drag,
+                                                     gdouble                angular_drag);
+
+/**
+ * clutter_box2d_field_set_mask_bits:
+ * @field: A #ClutterBox2DField
+ * @mask_bits: the collision categories of the actors affected
+ *
+ * Limits the field to the actors of some collision categories, see the
+ * #ClutterBox2DChild:category-bits property.
+ */
+void clutter_box2d_field_set_mask_bits (ClutterBox2DField *field,
+                                        guint16            mask_bits);
+
+/**
+ * clutter_box2d_field_destroy:
+ * @field: A #ClutterBox2DField
+ *
+ * Destroys a #ClutterBox2DField.
+ */
+void clutter_box2d_field_destroy (ClutterBox2DField *field);
+
+G_END_DECLS
+
+#endif
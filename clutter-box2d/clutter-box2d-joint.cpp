@@ -24,6 +24,9 @@ struct _ClutterBox2DJoint
   ClutterBox2DJointType  type;  /* The type of joint */
 
   b2Joint               *joint; /* Box2d joint*/
+  b2JointDef            *def;   /* Copy of the definition the joint was
+                                   created from, kept up to date with the
+                                   engine settings for saving scenes */
 
   /* The actors hooked up to this joint, for a JOINT_MOUSE, only actor1 will
    * be set actor2 will be NULL
@@ -40,17 +43,28 @@ clutter_box2d_joint_get_type (ClutterBox2DJoint *joint)
   return joint->type;
 }
 
-static ClutterBox2DJoint *
-joint_new (ClutterBox2D          *box2d,
-           b2Joint               *joint,
-           ClutterBox2DJointType  type)
+const b2JointDef *
+_clutter_box2d_joint_get_def (ClutterBox2DJoint *joint)
+{
+  return joint->def;
+}
+
+ClutterBox2DJoint *
+_clutter_box2d_joint_new (ClutterBox2D          *box2d,
+                          const b2JointDef      *def,
+                          gsize                  def_size,
+                          ClutterBox2DJointType  type)
 {
   ClutterBox2DPrivate *priv = box2d->priv;
   ClutterBox2DJoint *self = g_new0 (ClutterBox2DJoint, 1);
+  b2Joint *joint = priv->world->CreateJoint (def);
   self->box2d = box2d;
   self->joint = joint;
+  self->def = (b2JointDef *) g_memdup (def, def_size);
   self->type = type;
 
+  joint->SetUserData (self);
+
   self->actor1 = (ClutterBox2DChild*)
       g_hash_table_lookup (priv->bodies, joint->GetBodyA());
   if (self->actor1)
@@ -74,7 +88,9 @@ clutter_box2d_joint_destroy (ClutterBox2DJoint *joint)
 {
   g_return_if_fail (joint);
 
+  _clutter_box2d_lock_world (joint->box2d);
   joint->box2d->priv->world->DestroyJoint (joint->joint);
+  _clutter_box2d_unlock_world (joint->box2d);
 
   if (joint->actor1)
     {
@@ -87,6 +103,7 @@ clutter_box2d_joint_destroy (ClutterBox2DJoint *joint)
         g_list_remove (joint->actor2->priv->joints, joint);
     }
 
+  g_free (joint->def);
   g_free (joint);
 }
 
@@ -118,6 +135,7 @@ clutter_box2d_add_distance_joint (ClutterBox2D        *box2d,
                                   gdouble              damping_ratio)
 {
   ClutterBox2DPrivate *priv;
+  ClutterBox2DJoint *joint;
   b2DistanceJointDef jd;
 
   g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), NULL);
@@ -128,6 +146,8 @@ clutter_box2d_add_distance_joint (ClutterBox2D        *box2d,
 
   priv = box2d->priv;
 
+  _clutter_box2d_lock_world (box2d);
+
   clutter_box2d_joint_ensure_bodies (box2d, actor1, actor2);
 
   jd.collideConnected = false;
@@ -135,7 +155,10 @@ clutter_box2d_add_distance_joint (ClutterBox2D        *box2d,
   jd.bodyB = clutter_box2d_get_child (box2d, actor2)->priv->body;
 
   if (!jd.bodyA || !jd.bodyB)
-    return NULL;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
 
   jd.localAnchorA = b2Vec2( (anchor1->x) * priv->scale_factor,
                             (anchor1->y) * priv->scale_factor);
@@ -145,7 +168,11 @@ clutter_box2d_add_distance_joint (ClutterBox2D        *box2d,
   jd.frequencyHz = frequency;
   jd.dampingRatio = damping_ratio;
 
-  return joint_new (box2d, priv->world->CreateJoint (&jd), CLUTTER_BOX2D_JOINT_DISTANCE);
+  joint = _clutter_box2d_joint_new (box2d, &jd, sizeof (jd), CLUTTER_BOX2D_JOINT_DISTANCE);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return joint;
 }
 
 
@@ -159,6 +186,7 @@ clutter_box2d_add_distance_joint2 (ClutterBox2D        *box2d,
                                    gdouble              damping_ratio)
 {
   ClutterBox2DPrivate *priv;
+  ClutterBox2DJoint *joint;
   b2DistanceJointDef jd;
   b2Body *bodyA, *bodyB;
 
@@ -170,6 +198,8 @@ clutter_box2d_add_distance_joint2 (ClutterBox2D        *box2d,
 
   priv = box2d->priv;
 
+  _clutter_box2d_lock_world (box2d);
+
   clutter_box2d_joint_ensure_bodies (box2d, actor1, actor2);
 
   jd.collideConnected = false;
@@ -177,7 +207,10 @@ clutter_box2d_add_distance_joint2 (ClutterBox2D        *box2d,
   bodyA = clutter_box2d_get_child (box2d, actor1)->priv->body;
   bodyB = clutter_box2d_get_child (box2d, actor2)->priv->body;
   if (!bodyA || !bodyB)
-    return NULL;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
 
   jd.Initialize (bodyA, bodyB,
                  b2Vec2(anchor1->x * priv->scale_factor,
@@ -187,7 +220,11 @@ clutter_box2d_add_distance_joint2 (ClutterBox2D        *box2d,
   jd.frequencyHz = frequency;
   jd.dampingRatio = damping_ratio;
 
-  return joint_new (box2d, priv->world->CreateJoint (&jd), CLUTTER_BOX2D_JOINT_DISTANCE);
+  joint = _clutter_box2d_joint_new (box2d, &jd, sizeof (jd), CLUTTER_BOX2D_JOINT_DISTANCE);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return joint;
 }
 
 
@@ -199,6 +236,7 @@ clutter_box2d_add_revolute_joint (ClutterBox2D        *box2d,
                                   const ClutterVertex *anchor2)
 {
   ClutterBox2DPrivate *priv;
+  ClutterBox2DJoint *joint;
   b2RevoluteJointDef jd;
 
   g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), NULL);
@@ -209,6 +247,8 @@ clutter_box2d_add_revolute_joint (ClutterBox2D        *box2d,
 
   priv = box2d->priv;
 
+  _clutter_box2d_lock_world (box2d);
+
   clutter_box2d_joint_ensure_bodies (box2d, actor1, actor2);
 
   jd.collideConnected = false;
@@ -216,7 +256,10 @@ clutter_box2d_add_revolute_joint (ClutterBox2D        *box2d,
   jd.bodyB = clutter_box2d_get_child (box2d, actor2)->priv->body;
 
   if (!jd.bodyA || !jd.bodyB)
-    return NULL;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
 
   jd.localAnchorA = b2Vec2( (anchor1->x) * priv->scale_factor,
                             (anchor1->y) * priv->scale_factor);
@@ -224,7 +267,11 @@ clutter_box2d_add_revolute_joint (ClutterBox2D        *box2d,
                             (anchor2->y) * priv->scale_factor);
   jd.referenceAngle = jd.bodyB->GetAngle() - jd.bodyA->GetAngle();
 
-  return joint_new (box2d, priv->world->CreateJoint (&jd), CLUTTER_BOX2D_JOINT_REVOLUTE);
+  joint = _clutter_box2d_joint_new (box2d, &jd, sizeof (jd), CLUTTER_BOX2D_JOINT_REVOLUTE);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return joint;
 }
 
 ClutterBox2DJoint *
@@ -234,6 +281,7 @@ clutter_box2d_add_revolute_joint2 (ClutterBox2D        *box2d,
                                    const ClutterVertex *anchor)
 {
   ClutterBox2DPrivate *priv;
+  ClutterBox2DJoint *joint;
   b2RevoluteJointDef jd;
   b2Body *bodyA, *bodyB;
 
@@ -244,6 +292,8 @@ clutter_box2d_add_revolute_joint2 (ClutterBox2D        *box2d,
 
   priv = box2d->priv;
 
+  _clutter_box2d_lock_world (box2d);
+
   clutter_box2d_joint_ensure_bodies (box2d, actor1, actor2);
 
   jd.collideConnected = false;
@@ -251,14 +301,21 @@ clutter_box2d_add_revolute_joint2 (ClutterBox2D        *box2d,
   bodyA = clutter_box2d_get_child (box2d, actor1)->priv->body;
   bodyB = clutter_box2d_get_child (box2d, actor2)->priv->body;
   if (!bodyA || !bodyB)
-    return NULL;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
 
   b2Vec2 ancho  ( (anchor->x) * priv->scale_factor,
                   (anchor->y) * priv->scale_factor);
 
   jd.Initialize (bodyA, bodyB,
                 ancho);
-  return joint_new (box2d, priv->world->CreateJoint (&jd), CLUTTER_BOX2D_JOINT_REVOLUTE);
+  joint = _clutter_box2d_joint_new (box2d, &jd, sizeof (jd), CLUTTER_BOX2D_JOINT_REVOLUTE);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return joint;
 }
 
 ClutterBox2DJoint *
@@ -272,6 +329,7 @@ clutter_box2d_add_prismatic_joint (ClutterBox2D        *box2d,
                                    const ClutterVertex *axis)
 {
   ClutterBox2DPrivate *priv;
+  ClutterBox2DJoint *joint;
   b2PrismaticJointDef jd;
 
   g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), NULL);
@@ -283,6 +341,8 @@ clutter_box2d_add_prismatic_joint (ClutterBox2D        *box2d,
 
   priv = box2d->priv;
 
+  _clutter_box2d_lock_world (box2d);
+
   clutter_box2d_joint_ensure_bodies (box2d, actor1, actor2);
 
   jd.collideConnected = false;
@@ -290,7 +350,10 @@ clutter_box2d_add_prismatic_joint (ClutterBox2D        *box2d,
   jd.bodyB = clutter_box2d_get_child (box2d, actor2)->priv->body;
 
   if (!jd.bodyA || !jd.bodyB)
-    return NULL;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
 
   jd.localAnchorA = b2Vec2( (anchor1->x) * priv->scale_factor,
                             (anchor1->y) * priv->scale_factor);
@@ -303,7 +366,11 @@ clutter_box2d_add_prismatic_joint (ClutterBox2D        *box2d,
                           (axis->y));
   jd.referenceAngle = jd.bodyB->GetAngle() - jd.bodyA->GetAngle();
 
-  return joint_new (box2d, priv->world->CreateJoint (&jd), CLUTTER_BOX2D_JOINT_PRISMATIC);
+  joint = _clutter_box2d_joint_new (box2d, &jd, sizeof (jd), CLUTTER_BOX2D_JOINT_PRISMATIC);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return joint;
 }
 
 ClutterBox2DJoint *
@@ -316,6 +383,7 @@ clutter_box2d_add_prismatic_joint2 (ClutterBox2D        *box2d,
                                     const ClutterVertex *axis)
 {
   ClutterBox2DPrivate *priv;
+  ClutterBox2DJoint *joint;
   b2PrismaticJointDef jd;
   b2Body *bodyA, *bodyB;
 
@@ -327,6 +395,8 @@ clutter_box2d_add_prismatic_joint2 (ClutterBox2D        *box2d,
 
   priv = box2d->priv;
 
+  _clutter_box2d_lock_world (box2d);
+
   clutter_box2d_joint_ensure_bodies (box2d, actor1, actor2);
 
   jd.collideConnected = false;
@@ -334,7 +404,10 @@ clutter_box2d_add_prismatic_joint2 (ClutterBox2D        *box2d,
   bodyA = clutter_box2d_get_child (box2d, actor1)->priv->body;
   bodyB = clutter_box2d_get_child (box2d, actor2)->priv->body;
   if (!bodyA || !bodyB)
-    return NULL;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
 
   jd.Initialize (bodyA, bodyB,
                  b2Vec2(anchor->x * priv->scale_factor,
@@ -345,7 +418,11 @@ clutter_box2d_add_prismatic_joint2 (ClutterBox2D        *box2d,
   jd.upperTranslation = max_length * priv->scale_factor;
   jd.enableLimit = true;
 
-  return joint_new (box2d, priv->world->CreateJoint (&jd), CLUTTER_BOX2D_JOINT_PRISMATIC);
+  joint = _clutter_box2d_joint_new (box2d, &jd, sizeof (jd), CLUTTER_BOX2D_JOINT_PRISMATIC);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return joint;
 }
 
 ClutterBox2DJoint *
@@ -359,6 +436,7 @@ clutter_box2d_add_line_joint (ClutterBox2D        *box2d,
                               const ClutterVertex *axis)
 {
   ClutterBox2DPrivate *priv;
+  ClutterBox2DJoint *joint;
   b2LineJointDef jd;
 
   g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), NULL);
@@ -370,6 +448,8 @@ clutter_box2d_add_line_joint (ClutterBox2D        *box2d,
 
   priv = box2d->priv;
 
+  _clutter_box2d_lock_world (box2d);
+
   clutter_box2d_joint_ensure_bodies (box2d, actor1, actor2);
 
   jd.collideConnected = false;
@@ -377,7 +457,10 @@ clutter_box2d_add_line_joint (ClutterBox2D        *box2d,
   jd.bodyB = clutter_box2d_get_child (box2d, actor2)->priv->body;
 
   if (!jd.bodyA || !jd.bodyB)
-    return NULL;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
 
   jd.localAnchorA = b2Vec2( (anchor1->x) * priv->scale_factor,
                             (anchor1->y) * priv->scale_factor);
@@ -389,7 +472,11 @@ clutter_box2d_add_line_joint (ClutterBox2D        *box2d,
   jd.localAxisA = b2Vec2( (axis->x),
                           (axis->y));
 
-  return joint_new (box2d, priv->world->CreateJoint (&jd), CLUTTER_BOX2D_JOINT_LINE);
+  joint = _clutter_box2d_joint_new (box2d, &jd, sizeof (jd), CLUTTER_BOX2D_JOINT_LINE);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return joint;
 }
 
 ClutterBox2DJoint *
@@ -402,6 +489,7 @@ clutter_box2d_add_line_joint2 (ClutterBox2D        *box2d,
                                const ClutterVertex *axis)
 {
   ClutterBox2DPrivate *priv;
+  ClutterBox2DJoint *joint;
   b2Body *bodyA, *bodyB;
   b2LineJointDef jd;
 
@@ -413,6 +501,8 @@ clutter_box2d_add_line_joint2 (ClutterBox2D        *box2d,
 
   priv = box2d->priv;
 
+  _clutter_box2d_lock_world (box2d);
+
   clutter_box2d_joint_ensure_bodies (box2d, actor1, actor2);
 
   jd.collideConnected = false;
@@ -420,7 +510,10 @@ clutter_box2d_add_line_joint2 (ClutterBox2D        *box2d,
   bodyA = clutter_box2d_get_child (box2d, actor1)->priv->body;
   bodyB = clutter_box2d_get_child (box2d, actor2)->priv->body;
   if (!bodyA || !bodyB)
-    return NULL;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
 
   jd.Initialize (bodyA, bodyB,
                  b2Vec2(anchor->x * priv->scale_factor,
@@ -431,7 +524,11 @@ clutter_box2d_add_line_joint2 (ClutterBox2D        *box2d,
   jd.upperTranslation = max_length * priv->scale_factor;
   jd.enableLimit = true;
 
-  return joint_new (box2d, priv->world->CreateJoint (&jd), CLUTTER_BOX2D_JOINT_LINE);
+  joint = _clutter_box2d_joint_new (box2d, &jd, sizeof (jd), CLUTTER_BOX2D_JOINT_LINE);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return joint;
 }
 
 ClutterBox2DJoint *
@@ -449,6 +546,7 @@ clutter_box2d_add_pulley_joint (ClutterBox2D        *box2d,
                                 gdouble              ratio)
 {
   ClutterBox2DPrivate *priv;
+  ClutterBox2DJoint *joint;
   b2PulleyJointDef jd;
 
   g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), NULL);
@@ -461,6 +559,8 @@ clutter_box2d_add_pulley_joint (ClutterBox2D        *box2d,
 
   priv = box2d->priv;
 
+  _clutter_box2d_lock_world (box2d);
+
   clutter_box2d_joint_ensure_bodies (box2d, actor1, actor2);
 
   jd.collideConnected = false;
@@ -468,7 +568,10 @@ clutter_box2d_add_pulley_joint (ClutterBox2D        *box2d,
   jd.bodyB = clutter_box2d_get_child (box2d, actor2)->priv->body;
 
   if (!jd.bodyA || !jd.bodyB)
-    return NULL;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
 
   jd.groundAnchorA = b2Vec2 (ground_anchor1->x * priv->scale_factor,
                              ground_anchor1->y * priv->scale_factor);
@@ -484,7 +587,11 @@ clutter_box2d_add_pulley_joint (ClutterBox2D        *box2d,
   jd.maxLengthA = max_length1 * priv->scale_factor;
   jd.maxLengthB = max_length2 * priv->scale_factor;
 
-  return joint_new (box2d, priv->world->CreateJoint (&jd), CLUTTER_BOX2D_JOINT_PULLEY);
+  joint = _clutter_box2d_joint_new (box2d, &jd, sizeof (jd), CLUTTER_BOX2D_JOINT_PULLEY);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return joint;
 }
 
 ClutterBox2DJoint *
@@ -500,6 +607,7 @@ clutter_box2d_add_pulley_joint2 (ClutterBox2D        *box2d,
                                  gdouble              ratio)
 {
   ClutterBox2DPrivate *priv;
+  ClutterBox2DJoint *joint;
   b2Body *bodyA, *bodyB;
   b2PulleyJointDef jd;
 
@@ -513,6 +621,8 @@ clutter_box2d_add_pulley_joint2 (ClutterBox2D        *box2d,
 
   priv = box2d->priv;
 
+  _clutter_box2d_lock_world (box2d);
+
   clutter_box2d_joint_ensure_bodies (box2d, actor1, actor2);
 
   jd.collideConnected = false;
@@ -520,7 +630,10 @@ clutter_box2d_add_pulley_joint2 (ClutterBox2D        *box2d,
   bodyA = clutter_box2d_get_child (box2d, actor1)->priv->body;
   bodyB = clutter_box2d_get_child (box2d, actor2)->priv->body;
   if (!bodyA || !bodyB)
-    return NULL;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
 
   jd.Initialize (bodyA, bodyB,
                  b2Vec2 (ground_anchor1->x * priv->scale_factor,
@@ -533,7 +646,11 @@ clutter_box2d_add_pulley_joint2 (ClutterBox2D        *box2d,
                          anchor2->y * priv->scale_factor),
                  ratio);
 
-  return joint_new (box2d, priv->world->CreateJoint (&jd), CLUTTER_BOX2D_JOINT_PULLEY);
+  joint = _clutter_box2d_joint_new (box2d, &jd, sizeof (jd), CLUTTER_BOX2D_JOINT_PULLEY);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return joint;
 }
 
 ClutterBox2DJoint *
@@ -544,6 +661,7 @@ clutter_box2d_add_weld_joint (ClutterBox2D        *box2d,
                               const ClutterVertex *anchor2)
 {
   ClutterBox2DPrivate *priv;
+  ClutterBox2DJoint *joint;
   b2WeldJointDef jd;
 
   g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), NULL);
@@ -554,6 +672,8 @@ clutter_box2d_add_weld_joint (ClutterBox2D        *box2d,
 
   priv = box2d->priv;
 
+  _clutter_box2d_lock_world (box2d);
+
   clutter_box2d_joint_ensure_bodies (box2d, actor1, actor2);
 
   jd.collideConnected = false;
@@ -561,7 +681,10 @@ clutter_box2d_add_weld_joint (ClutterBox2D        *box2d,
   jd.bodyB = clutter_box2d_get_child (box2d, actor2)->priv->body;
 
   if (!jd.bodyA || !jd.bodyB)
-    return NULL;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
 
   jd.localAnchorA = b2Vec2 (anchor1->x * priv->scale_factor,
                             anchor1->y * priv->scale_factor);
@@ -569,7 +692,11 @@ clutter_box2d_add_weld_joint (ClutterBox2D        *box2d,
                             anchor2->y * priv->scale_factor);
   jd.referenceAngle = jd.bodyB->GetAngle() - jd.bodyA->GetAngle();
 
-  return joint_new (box2d, priv->world->CreateJoint (&jd), CLUTTER_BOX2D_JOINT_WELD);
+  joint = _clutter_box2d_joint_new (box2d, &jd, sizeof (jd), CLUTTER_BOX2D_JOINT_WELD);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return joint;
 }
 
 ClutterBox2DJoint *
@@ -579,6 +706,7 @@ clutter_box2d_add_weld_joint2 (ClutterBox2D        *box2d,
                                const ClutterVertex *anchor)
 {
   ClutterBox2DPrivate *priv;
+  ClutterBox2DJoint *joint;
   b2Body *bodyA, *bodyB;
   b2WeldJointDef jd;
 
@@ -589,6 +717,8 @@ clutter_box2d_add_weld_joint2 (ClutterBox2D        *box2d,
 
   priv = box2d->priv;
 
+  _clutter_box2d_lock_world (box2d);
+
   clutter_box2d_joint_ensure_bodies (box2d, actor1, actor2);
 
   jd.collideConnected = false;
@@ -596,13 +726,20 @@ clutter_box2d_add_weld_joint2 (ClutterBox2D        *box2d,
   bodyA = clutter_box2d_get_child (box2d, actor1)->priv->body;
   bodyB = clutter_box2d_get_child (box2d, actor2)->priv->body;
   if (!bodyA || !bodyB)
-    return NULL;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
 
   jd.Initialize (bodyA, bodyB,
                  b2Vec2 (anchor->x * priv->scale_factor,
                          anchor->y * priv->scale_factor));
 
-  return joint_new (box2d, priv->world->CreateJoint (&jd), CLUTTER_BOX2D_JOINT_WELD);
+  joint = _clutter_box2d_joint_new (box2d, &jd, sizeof (jd), CLUTTER_BOX2D_JOINT_WELD);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return joint;
 }
 
 ClutterBox2DJoint *
@@ -611,6 +748,7 @@ clutter_box2d_add_mouse_joint (ClutterBox2D        *box2d,
                                const ClutterVertex *target)
 {
   ClutterBox2DPrivate *priv;
+  ClutterBox2DJoint *joint;
   b2MouseJointDef md;
 
   g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), NULL);
@@ -619,20 +757,29 @@ clutter_box2d_add_mouse_joint (ClutterBox2D        *box2d,
 
   priv = box2d->priv;
 
+  _clutter_box2d_lock_world (box2d);
+
   clutter_box2d_joint_ensure_body (box2d, actor);
 
   md.bodyA = priv->ground_body;
   md.bodyB = clutter_box2d_get_child (box2d, actor)->priv->body;
 
   if (!md.bodyB)
-    return NULL;
+    {
+      _clutter_box2d_unlock_world (box2d);
+      return NULL;
+    }
 
   md.target = b2Vec2( (target->x) * priv->scale_factor,
                       (target->y) * priv->scale_factor);
   md.bodyA->SetAwake (false);
   md.maxForce = 5100.0f * md.bodyB->GetMass ();
 
-  return joint_new (box2d, priv->world->CreateJoint(&md), CLUTTER_BOX2D_JOINT_MOUSE);
+  joint = _clutter_box2d_joint_new (box2d, &md, sizeof (md), CLUTTER_BOX2D_JOINT_MOUSE);
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return joint;
 }
 
 void
@@ -651,7 +798,10 @@ clutter_box2d_mouse_joint_update_target (ClutterBox2DJoint   *joint,
   b2target = b2Vec2( (target->x) * priv->scale_factor,
                      (target->y) * priv->scale_factor);
 
-  static_cast<b2MouseJoint*>(joint->joint)->SetTarget(b2target);
+  if (!_clutter_box2d_queue_command (joint->box2d,
+                                     CLUTTER_BOX2D_COMMAND_MOUSE_TARGET,
+                                     joint->joint, b2target))
+    static_cast<b2MouseJoint*>(joint->joint)->SetTarget(b2target);
 }
 
 void
@@ -662,6 +812,8 @@ clutter_box2d_joint_set_engine (ClutterBox2DJoint *joint,
 {
   g_return_if_fail (joint != NULL);
 
+  _clutter_box2d_lock_world (joint->box2d);
+
   switch (joint->type)
     {
     case CLUTTER_BOX2D_JOINT_REVOLUTE:
@@ -670,6 +822,11 @@ clutter_box2d_joint_set_engine (ClutterBox2DJoint *joint,
         motor_joint->EnableMotor(enable);
         motor_joint->SetMaxMotorTorque(max_force);
         motor_joint->SetMotorSpeed(speed);
+
+        b2RevoluteJointDef *def = static_cast<b2RevoluteJointDef*>(joint->def);
+        def->enableMotor = enable;
+        def->maxMotorTorque = max_force;
+        def->motorSpeed = speed;
       }
       break;
 
@@ -679,6 +836,11 @@ clutter_box2d_joint_set_engine (ClutterBox2DJoint *joint,
         motor_joint->EnableMotor(enable);
         motor_joint->SetMaxMotorForce(max_force);
         motor_joint->SetMotorSpeed(speed);
+
+        b2PrismaticJointDef *def = static_cast<b2PrismaticJointDef*>(joint->def);
+        def->enableMotor = enable;
+        def->maxMotorForce = max_force;
+        def->motorSpeed = speed;
       }
       break;
 
@@ -688,7 +850,14 @@ clutter_box2d_joint_set_engine (ClutterBox2DJoint *joint,
         motor_joint->EnableMotor(enable);
         motor_joint->SetMaxMotorForce(max_force);
         motor_joint->SetMotorSpeed(speed);
+
+        b2LineJointDef *def = static_cast<b2LineJointDef*>(joint->def);
+        def->enableMotor = enable;
+        def->maxMotorForce = max_force;
+        def->motorSpeed = speed;
       }
       break;
     }
+
+  _clutter_box2d_unlock_world (joint->box2d);
 }
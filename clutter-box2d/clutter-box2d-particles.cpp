@@ -0,0 +1,519 @@
+/* clutter-box2d - Clutter box2d integration
+ *
+ * This file implements an actor simulating and drawing many small
+ * bodies that have no actors of their own.
+ *
+ * Copyright 2010 Intel Corporation
+ * Licensed under the LGPL v2 or greater.
+ */
+
+#include "Box2D.h"
+#include <clutter/clutter.h>
+#include "clutter-box2d.h"
+#include "clutter-box2d-particles.h"
+#include "clutter-box2d-private.h"
+#include "math.h"
+
+G_DEFINE_TYPE (ClutterBox2DParticles, clutter_box2d_particles,
+               CLUTTER_TYPE_ACTOR);
+
+#define CLUTTER_BOX2D_PARTICLES_GET_PRIVATE(obj) \
+  (G_TYPE_INSTANCE_GET_PRIVATE ((obj), CLUTTER_TYPE_BOX2D_PARTICLES, \
+                                ClutterBox2DParticlesPrivate))
+
+/* Circles are drawn as polygons with this many sides */
+#define CIRCLE_SIDES 8
+
+/* The most vertices drawn for a particle, as separate triangles */
+#define MAX_PARTICLE_VERTICES (3 * (CIRCLE_SIDES - 2))
+
+enum
+{
+  PROP_0,
+  PROP_COLOR
+};
+
+struct _ClutterBox2DParticlesPrivate
+{
+  ClutterBox2D              *box2d; /* NULL once removed from it */
+  ClutterBox2DParticleShape  shape;
+  gfloat                     size;
+  gfloat                     density;
+  gfloat                     friction;
+  gfloat                     restitution;
+  ClutterColor               color;
+
+  GPtrArray                 *bodies;     /* b2Body of each particle */
+  GArray                    *transforms; /* x, y, cos, sin of each
+                                          * particle, in pixels */
+
+  gfloat                    *vertices;   /* The triangles of the last
+                                          * paint, two floats a vertex */
+  guint                      n_vertices; /* Vertices buffer can hold */
+  CoglHandle                 buffer;
+};
+
+/* Destroys the bodies and stops being stepped by the container */
+static void
+clutter_box2d_particles_detach (ClutterBox2DParticles *self)
+{
+  ClutterBox2DParticlesPrivate *priv = self->priv;
+  ClutterBox2D *box2d = priv->box2d;
+  guint i;
+
+  if (!box2d)
+    return;
+
+  _clutter_box2d_lock_world (box2d);
+  for (i = 0; i < priv->bodies->len; i++)
+    box2d->priv->world->DestroyBody ((b2Body *) priv->bodies->pdata[i]);
+  _clutter_box2d_unlock_world (box2d);
+
+  g_ptr_array_set_size (priv->bodies, 0);
+  g_array_set_size (priv->transforms, 0);
+
+  box2d->priv->particles = g_list_remove (box2d->priv->particles, self);
+  priv->box2d = NULL;
+}
+
+/* Packs the transforms of the bodies for painting, must be called with
+ * the world lock held.
+ */
+void
+_clutter_box2d_particles_sync (ClutterBox2DParticles *particles)
+{
+  ClutterBox2DParticlesPrivate *priv = particles->priv;
+  gfloat inv_scale_factor;
+  gfloat *transform;
+  guint i;
+
+  if (!priv->box2d)
+    return;
+
+  inv_scale_factor = priv->box2d->priv->inv_scale_factor;
+
+  g_array_set_size (priv->transforms, priv->bodies->len * 4);
+  transform = (gfloat *) priv->transforms->data;
+
+  for (i = 0; i < priv->bodies->len; i++, transform += 4)
+    {
+      const b2Transform &xf = ((b2Body *) priv->bodies->pdata[i])->GetTransform ();
+
+      transform[0] = xf.position.x * inv_scale_factor;
+      transform[1] = xf.position.y * inv_scale_factor;
+      transform[2] = xf.R.col1.x;
+      transform[3] = xf.R.col1.y;
+    }
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (particles));
+}
+
+/* The triangles of one particle around its center, returns the number of
+ * vertices.
+ */
+static guint
+clutter_box2d_particles_get_outline (ClutterBox2DParticles *self,
+                                     gfloat                *outline)
+{
+  ClutterBox2DParticlesPrivate *priv = self->priv;
+  gfloat half = priv->size / 2.f;
+  guint i;
+
+  if (priv->shape == CLUTTER_BOX2D_PARTICLE_BOX)
+    {
+      static const gfloat corners[] = { -1, -1,  1, -1,  1,  1,
+                                        -1, -1,  1,  1, -1,  1 };
+
+      for (i = 0; i < G_N_ELEMENTS (corners); i++)
+        outline[i] = corners[i] * half;
+
+      return 6;
+    }
+
+  /* A fan around the first corner, as separate triangles */
+  for (i = 0; i < CIRCLE_SIDES - 2; i++)
+    {
+      gfloat a = (i + 1) * 2 * G_PI / CIRCLE_SIDES;
+      gfloat b = (i + 2) * 2 * G_PI / CIRCLE_SIDES;
+
+      outline[i * 6 + 0] = half;
+      outline[i * 6 + 1] = 0;
+      outline[i * 6 + 2] = half * cosf (a);
+      outline[i * 6 + 3] = half * sinf (a);
+      outline[i * 6 + 4] = half * cosf (b);
+      outline[i * 6 + 5] = half * sinf (b);
+    }
+
+  return MAX_PARTICLE_VERTICES;
+}
+
+static void
+clutter_box2d_particles_paint (ClutterActor *actor)
+{
+  ClutterBox2DParticles *self = CLUTTER_BOX2D_PARTICLES (actor);
+  ClutterBox2DParticlesPrivate *priv = self->priv;
+  gfloat outline[MAX_PARTICLE_VERTICES * 2];
+  const gfloat *transform;
+  gfloat *vertex;
+  guint n_particles, n_outline, n_vertices, i, j;
+
+  n_particles = priv->transforms->len / 4;
+  if (!n_particles || !priv->color.alpha)
+    return;
+
+  n_outline = clutter_box2d_particles_get_outline (self, outline);
+  n_vertices = n_particles * n_outline;
+
+  /* Vertex buffers have a fixed size, so they are only replaced to grow */
+  if (n_vertices > priv->n_vertices)
+    {
+      if (priv->buffer)
+        cogl_handle_unref (priv->buffer);
+      g_free (priv->vertices);
+
+      priv->n_vertices = MAX (n_vertices, priv->n_vertices * 2);
+      priv->vertices = g_new (gfloat, priv->n_vertices * 2);
+      priv->buffer = cogl_vertex_buffer_new (priv->n_vertices);
+    }
+
+  transform = (const gfloat *) priv->transforms->data;
+  vertex = priv->vertices;
+  for (i = 0; i < n_particles; i++, transform += 4)
+    for (j = 0; j < n_outline; j++, vertex += 2)
+      {
+        gfloat x = outline[j * 2];
+        gfloat y = outline[j * 2 + 1];
+
+        vertex[0] = transform[0] + transform[2] * x - transform[3] * y;
+        vertex[1] = transform[1] + transform[3] * x + transform[2] * y;
+      }
+
+  cogl_vertex_buffer_add (priv->buffer, "gl_Vertex", 2,
+                          COGL_ATTRIBUTE_TYPE_FLOAT, FALSE, 0,
+                          priv->vertices);
+  cogl_vertex_buffer_submit (priv->buffer);
+
+  cogl_set_source_color4ub (priv->color.red,
+                            priv->color.green,
+                            priv->color.blue,
+                            priv->color.alpha *
+                            clutter_actor_get_paint_opacity (actor) / 255);
+  cogl_vertex_buffer_draw (priv->buffer, COGL_VERTICES_MODE_TRIANGLES,
+                           0, n_vertices);
+}
+
+static void
+clutter_box2d_particles_parent_set (ClutterActor *actor,
+                                    ClutterActor *old_parent)
+{
+  ClutterBox2DParticles *self = CLUTTER_BOX2D_PARTICLES (actor);
+
+  if (CLUTTER_ACTOR_CLASS (clutter_box2d_particles_parent_class)->parent_set)
+    CLUTTER_ACTOR_CLASS (clutter_box2d_particles_parent_class)->parent_set (
+      actor, old_parent);
+
+  /* The particles only exist in the world of the container */
+  if (self->priv->box2d &&
+      clutter_actor_get_parent (actor) != CLUTTER_ACTOR (self->priv->box2d))
+    clutter_box2d_particles_detach (self);
+}
+
+static void
+clutter_box2d_particles_set_property (GObject      *gobject,
+                                      guint         prop_id,
+                                      const GValue *value,
+                                      GParamSpec   *pspec)
+{
+  ClutterBox2DParticles *self = CLUTTER_BOX2D_PARTICLES (gobject);
+
+  switch (prop_id)
+    {
+    case PROP_COLOR:
+      clutter_box2d_particles_set_color (self, (ClutterColor *)
+                                         g_value_get_boxed (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+clutter_box2d_particles_get_property (GObject    *gobject,
+                                      guint       prop_id,
+                                      GValue     *value,
+                                      GParamSpec *pspec)
+{
+  ClutterBox2DParticles *self = CLUTTER_BOX2D_PARTICLES (gobject);
+
+  switch (prop_id)
+    {
+    case PROP_COLOR:
+      g_value_set_boxed (value, &self->priv->color);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+clutter_box2d_particles_dispose (GObject *object)
+{
+  ClutterBox2DParticles *self = CLUTTER_BOX2D_PARTICLES (object);
+  ClutterBox2DParticlesPrivate *priv = self->priv;
+
+  clutter_box2d_particles_detach (self);
+
+  if (priv->buffer)
+    {
+      cogl_handle_unref (priv->buffer);
+      priv->buffer = NULL;
+      priv->n_vertices = 0;
+    }
+
+  G_OBJECT_CLASS (clutter_box2d_particles_parent_class)->dispose (object);
+}
+
+static void
+clutter_box2d_particles_finalize (GObject *object)
+{
+  ClutterBox2DParticlesPrivate *priv = CLUTTER_BOX2D_PARTICLES (object)->priv;
+
+  g_ptr_array_free (priv->bodies, TRUE);
+  g_array_free (priv->transforms, TRUE);
+  g_free (priv->vertices);
+
+  G_OBJECT_CLASS (clutter_box2d_particles_parent_class)->finalize (object);
+}
+
+static void
+clutter_box2d_particles_class_init (ClutterBox2DParticlesClass *klass)
+{
+  GObjectClass      *gobject_class = G_OBJECT_CLASS (klass);
+  ClutterActorClass *actor_class = CLUTTER_ACTOR_CLASS (klass);
+
+  gobject_class->dispose      = clutter_box2d_particles_dispose;
+  gobject_class->finalize     = clutter_box2d_particles_finalize;
+  gobject_class->set_property = clutter_box2d_particles_set_property;
+  gobject_class->get_property = clutter_box2d_particles_get_property;
+
+  actor_class->paint      = clutter_box2d_particles_paint;
+  actor_class->parent_set = clutter_box2d_particles_parent_set;
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_COLOR,
+                                   g_param_spec_boxed ("color",
+                                                       "Color",
+                                                       "The color of the particles",
+                                                       CLUTTER_TYPE_COLOR,
+                                                       (GParamFlags)G_PARAM_READWRITE));
+
+  g_type_class_add_private (gobject_class,
+                            sizeof (ClutterBox2DParticlesPrivate));
+}
+
+static void
+clutter_box2d_particles_init (ClutterBox2DParticles *self)
+{
+  ClutterBox2DParticlesPrivate *priv = self->priv =
+    CLUTTER_BOX2D_PARTICLES_GET_PRIVATE (self);
+
+  priv->density = 7.0f;
+  priv->friction = 0.4f;
+  priv->restitution = 0.f;
+  priv->color.red = 0xff;
+  priv->color.green = 0xff;
+  priv->color.blue = 0xff;
+  priv->color.alpha = 0xff;
+
+  priv->bodies = g_ptr_array_new ();
+  priv->transforms = g_array_new (FALSE, FALSE, sizeof (gfloat));
+}
+
+ClutterActor *
+clutter_box2d_particles_new (ClutterBox2D              *box2d,
+                             ClutterBox2DParticleShape  shape,
+                             gfloat                     size)
+{
+  ClutterBox2DParticles *self;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), NULL);
+  g_return_val_if_fail (size > 0, NULL);
+
+  self = CLUTTER_BOX2D_PARTICLES (
+    g_object_new (CLUTTER_TYPE_BOX2D_PARTICLES, NULL));
+  self->priv->shape = shape;
+  self->priv->size = size;
+  self->priv->box2d = box2d;
+
+  box2d->priv->particles = g_list_prepend (box2d->priv->particles, self);
+  clutter_container_add_actor (CLUTTER_CONTAINER (box2d),
+                               CLUTTER_ACTOR (self));
+
+  return CLUTTER_ACTOR (self);
+}
+
+guint
+clutter_box2d_particles_add (ClutterBox2DParticles *particles,
+                             const ClutterVertex   *positions,
+                             const ClutterVertex   *velocities,
+                             guint                  n_particles)
+{
+  ClutterBox2DParticlesPrivate *priv;
+  b2CircleShape circle;
+  b2PolygonShape box;
+  b2FixtureDef fixtureDef;
+  b2BodyDef bodyDef;
+  b2World *world;
+  gfloat scale_factor;
+  guint first, i;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D_PARTICLES (particles), 0);
+  g_return_val_if_fail (positions != NULL || n_particles == 0, 0);
+
+  priv = particles->priv;
+  first = priv->bodies->len;
+
+  if (!priv->box2d || !n_particles)
+    return first;
+
+  world = priv->box2d->priv->world;
+  scale_factor = priv->box2d->priv->scale_factor;
+
+  if (priv->shape == CLUTTER_BOX2D_PARTICLE_BOX)
+    {
+      box.SetAsBox (priv->size / 2.f * scale_factor,
+                    priv->size / 2.f * scale_factor);
+      fixtureDef.shape = &box;
+    }
+  else
+    {
+      circle.m_radius = priv->size / 2.f * scale_factor;
+      fixtureDef.shape = &circle;
+    }
+
+  fixtureDef.density = priv->density;
+  fixtureDef.friction = priv->friction;
+  fixtureDef.restitution = priv->restitution;
+
+  bodyDef.type = b2_dynamicBody;
+  bodyDef.linearDamping = 0.5f;
+  bodyDef.angularDamping = 0.5f;
+
+  _clutter_box2d_lock_world (priv->box2d);
+
+  for (i = 0; i < n_particles; i++)
+    {
+      b2Body *body;
+
+      bodyDef.position.Set (positions[i].x * scale_factor,
+                            positions[i].y * scale_factor);
+      if (velocities)
+        bodyDef.linearVelocity.Set (velocities[i].x * scale_factor,
+                                    velocities[i].y * scale_factor);
+
+      body = world->CreateBody (&bodyDef);
+      body->CreateFixture (&fixtureDef);
+      g_ptr_array_add (priv->bodies, body);
+    }
+
+  _clutter_box2d_particles_sync (particles);
+
+  _clutter_box2d_unlock_world (priv->box2d);
+
+  return first;
+}
+
+void
+clutter_box2d_particles_remove (ClutterBox2DParticles *particles,
+                                guint                  first,
+                                guint                  n_particles)
+{
+  ClutterBox2DParticlesPrivate *priv;
+  guint i;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D_PARTICLES (particles));
+
+  priv = particles->priv;
+
+  if (!priv->box2d || first >= priv->bodies->len)
+    return;
+
+  n_particles = MIN (n_particles, priv->bodies->len - first);
+
+  _clutter_box2d_lock_world (priv->box2d);
+
+  for (i = first; i < first + n_particles; i++)
+    priv->box2d->priv->world->DestroyBody ((b2Body *) priv->bodies->pdata[i]);
+  g_ptr_array_remove_range (priv->bodies, first, n_particles);
+
+  _clutter_box2d_particles_sync (particles);
+
+  _clutter_box2d_unlock_world (priv->box2d);
+}
+
+guint
+clutter_box2d_particles_get_n_particles (ClutterBox2DParticles *particles)
+{
+  g_return_val_if_fail (CLUTTER_IS_BOX2D_PARTICLES (particles), 0);
+
+  return particles->priv->bodies->len;
+}
+
+void
+clutter_box2d_particles_set_material (ClutterBox2DParticles *particles,
+                                      gfloat                 density,
+                                      gfloat                 friction,
+                                      gfloat                 restitution)
+{
+  ClutterBox2DParticlesPrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D_PARTICLES (particles));
+
+  priv = particles->priv;
+  priv->density = density;
+  priv->friction = friction;
+  priv->restitution = restitution;
+}
+
+void
+clutter_box2d_particles_set_color (ClutterBox2DParticles *particles,
+                                   const ClutterColor    *color)
+{
+  g_return_if_fail (CLUTTER_IS_BOX2D_PARTICLES (particles));
+  g_return_if_fail (color != NULL);
+
+  particles->priv->color = *color;
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (particles));
+  g_object_notify (G_OBJECT (particles), "color");
+}
+
+void
+clutter_box2d_particles_get_color (ClutterBox2DParticles *particles,
+                                   ClutterColor          *color)
+{
+  g_return_if_fail (CLUTTER_IS_BOX2D_PARTICLES (particles));
+  g_return_if_fail (color != NULL);
+
+  *color = particles->priv->color;
+}
+
+const gfloat *
+clutter_box2d_particles_get_transforms (ClutterBox2DParticles *particles,
+                                        guint                 *n_particles)
+{
+  ClutterBox2DParticlesPrivate *priv;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D_PARTICLES (particles), NULL);
+
+  priv = particles->priv;
+
+  if (n_particles)
+    *n_particles = priv->transforms->len / 4;
+
+  return (const gfloat *) priv->transforms->data;
+}
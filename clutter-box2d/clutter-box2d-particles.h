@@ -0,0 +1,209 @@
+/* clutter-box2d - Clutter box2d integration
+ *
+ * Copyright 2010 Intel Corporation
+ * Licensed under the LGPL v2 or greater.
+ */
+
+#ifndef _CLUTTER_BOX2D_PARTICLES_H
+#define _CLUTTER_BOX2D_PARTICLES_H
+
+#include <clutter/clutter.h>
+#include <clutter-box2d/clutter-box2d.h>
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:clutter-box2d-particles
+ * @short_description: Many small bodies drawn by one actor.
+ *
+ * Every child of a #ClutterBox2D is an actor of its own, which limits a
+ * scene to a few thousand bodies. A #ClutterBox2DParticles actor instead
+ * simulates a group of identical circles or squares that collide with each
+ * other and with the children, without an actor, child meta or table
+ * entry per particle, and draws all of them at once.
+ *
+ * The particles are dynamic and do not emit collisions. Positions are
+ * those of the centers of the particles, in the coordinates of the
+ * #ClutterBox2D, and velocities are in pixels per second.
+ */
+
+#define CLUTTER_TYPE_BOX2D_PARTICLES    clutter_box2d_particles_get_type ()
+
+#define CLUTTER_BOX2D_PARTICLES(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), \
+                               CLUTTER_TYPE_BOX2D_PARTICLES, ClutterBox2DParticles))
+
+#define CLUTTER_BOX2D_PARTICLES_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), \
+                            CLUTTER_TYPE_BOX2D_PARTICLES, ClutterBox2DParticlesClass))
+
+#define CLUTTER_IS_BOX2D_PARTICLES(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), \
+                               CLUTTER_TYPE_BOX2D_PARTICLES))
+
+#define CLUTTER_IS_BOX2D_PARTICLES_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE ((klass), \
+                            CLUTTER_TYPE_BOX2D_PARTICLES))
+
+#define CLUTTER_BOX2D_PARTICLES_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), \
+                              CLUTTER_TYPE_BOX2D_PARTICLES, ClutterBox2DParticlesClass))
+
+/**
+ * ClutterBox2DParticles:
+ *
+ * An actor simulating and drawing a group of particles, the struct has no
+ * public fields.
+ */
+typedef struct _ClutterBox2DParticles        ClutterBox2DParticles;
+typedef struct _ClutterBox2DParticlesClass   ClutterBox2DParticlesClass;
+typedef struct _ClutterBox2DParticlesPrivate ClutterBox2DParticlesPrivate;
+
+struct _ClutterBox2DParticles
+{
+  /*< private >*/
+  ClutterActor                  parent_instance;
+
+  ClutterBox2DParticlesPrivate *priv;
+};
+
+struct _ClutterBox2DParticlesClass
+{
+  /*< private >*/
+  ClutterActorClass parent_class;
+};
+
+/**
+ * ClutterBox2DParticleShape:
+ * @CLUTTER_BOX2D_PARTICLE_CIRCLE: The particles are circles
+ * @CLUTTER_BOX2D_PARTICLE_BOX: The particles are squares
+ *
+ * Identifiers for the shape of the particles of a group.
+ */
+typedef enum
+{
+  CLUTTER_BOX2D_PARTICLE_CIRCLE,
+  CLUTTER_BOX2D_PARTICLE_BOX
+} ClutterBox2DParticleShape;
+
+GType clutter_box2d_particles_get_type (void) G_GNUC_CONST;
+
+/**
+ * ClutterBox2DParticles:color
+ *
+ * The color the particles are drawn with.
+ */
+
+/**
+ * clutter_box2d_particles_new:
+ * @box2d: a #ClutterBox2D
+ * @shape: the shape of the particles
+ * @size: the diameter of circles or the side of squares, in pixels
+ *
+ * Creates a group of particles and adds it to @box2d. The particles are
+ * destroyed along with the actor, or when it is removed from @box2d.
+ *
+ * Returns: a new #ClutterBox2DParticles actor, owned by @box2d
+ */
+ClutterActor *clutter_box2d_particles_new (ClutterBox2D              *box2d,
+                                           ClutterBox2DParticleShape  shape,
+                                           gfloat                     size);
+
+/**
+ * clutter_box2d_particles_add:
+ * @particles: a #ClutterBox2DParticles
+ * @positions: (array length=n_particles): the centers of the new particles
+ * @velocities: (array length=n_particles) (allow-none): the velocities of
+ * the new particles, or %NULL for particles at rest
+ * @n_particles: the number of particles to add
+ *
+ * Adds particles to the group, with the material set with
+ * clutter_box2d_particles_set_material(). The new particles come after
+ * the existing ones.
+ *
+ * Returns: the index of the first new particle
+ */
+guint  clutter_box2d_particles_add (ClutterBox2DParticles *particles,
+                                    const ClutterVertex   *positions,
+                                    const ClutterVertex   *velocities,
+                                    guint                  n_particles);
+
+/**
+ * clutter_box2d_particles_remove:
+ * @particles: a #ClutterBox2DParticles
+ * @first: the index of the first particle to remove
+ * @n_particles: the number of particles to remove
+ *
+ * Removes a range of particles from the group. The particles after them
+ * keep their order and move down to fill the gap.
+ */
+void   clutter_box2d_particles_remove (ClutterBox2DParticles *particles,
+                                       guint                  first,
+                                       guint                  n_particles);
+
+/**
+ * clutter_box2d_particles_get_n_particles:
+ * @particles: a #ClutterBox2DParticles
+ *
+ * Gets the number of particles in the group.
+ *
+ * Returns: the number of particles
+ */
+guint  clutter_box2d_particles_get_n_particles (ClutterBox2DParticles *particles);
+
+/**
+ * clutter_box2d_particles_set_material:
+ * @particles: a #ClutterBox2DParticles
+ * @density: the density of the particles
+ * @friction: the friction of the particles
+ * @restitution: the restitution of the particles
+ *
+ * Sets the material of the particles added from now on, see the
+ * properties of the same names of #ClutterBox2DChild. The defaults are
+ * those of children.
+ */
+void   clutter_box2d_particles_set_material (ClutterBox2DParticles *particles,
+                                             gfloat                 density,
+                                             gfloat                 friction,
+                                             gfloat                 restitution);
+
+/**
+ * clutter_box2d_particles_set_color:
+ * @particles: a #ClutterBox2DParticles
+ * @color: the color to draw the particles with
+ *
+ * Sets the color of the particles, see #ClutterBox2DParticles:color.
+ */
+void   clutter_box2d_particles_set_color (ClutterBox2DParticles *particles,
+                                          const ClutterColor    *color);
+
+/**
+ * clutter_box2d_particles_get_color:
+ * @particles: a #ClutterBox2DParticles
+ * @color: (out): return location for the color
+ *
+ * Gets the color of the particles.
+ */
+void   clutter_box2d_particles_get_color (ClutterBox2DParticles *particles,
+                                          ClutterColor          *color);
+
+/**
+ * clutter_box2d_particles_get_transforms:
+ * @particles: a #ClutterBox2DParticles
+ * @n_particles: (out) (allow-none): return location for the number of
+ * particles, or %NULL
+ *
+ * Gets the transforms of the particles as of the last step, packed as
+ * four floats per particle: the center in pixels, then the cosine and
+ * sine of the rotation. This is what the actor draws from, and lets
+ * subclasses and applications draw the particles their own way.
+ *
+ * Returns: (transfer none): the transforms, owned by @particles and valid
+ * until the next step or change to the group
+ */
+const gfloat *clutter_box2d_particles_get_transforms (ClutterBox2DParticles *particles,
+                                                      guint                 *n_particles);
+
+G_END_DECLS
+
+#endif
@@ -17,6 +17,63 @@
 
 G_BEGIN_DECLS
 
+/* Transform of one body as published by the simulation thread, in world
+ * units and radians.
+ */
+typedef struct
+{
+  ClutterBox2DChild *child;
+  gfloat             x;
+  gfloat             y;
+  gfloat             angle;
+} ClutterBox2DTransform;
+
+typedef struct
+{
+  GArray *transforms; /* ClutterBox2DTransform of all non-static bodies */
+  guint   serial;     /* snapshot_serial at the time of the step */
+} ClutterBox2DSnapshot;
+
+/* Flag set on snapshot_ready when the slot holds a snapshot the main
+ * thread hasn't picked up yet.
+ */
+#define CLUTTER_BOX2D_SNAPSHOT_FRESH 4
+#define CLUTTER_BOX2D_SNAPSHOT_INDEX 3
+
+/* Streaming of regions, see clutter_box2d_set_streaming() */
+typedef struct _ClutterBox2DRegions ClutterBox2DRegions;
+
+/* An actor entering or leaving a sensor child, see
+ * clutter_box2d_child_set_is_sensor()
+ */
+typedef struct
+{
+  ClutterActor *sensor;
+  ClutterActor *actor;
+  gboolean      enter;
+} ClutterBox2DSensorEvent;
+
+typedef enum
+{
+  CLUTTER_BOX2D_COMMAND_LINEAR_VELOCITY,
+  CLUTTER_BOX2D_COMMAND_ANGULAR_VELOCITY,
+  CLUTTER_BOX2D_COMMAND_MOUSE_TARGET,
+  CLUTTER_BOX2D_COMMAND_LINEAR_IMPULSE,
+  CLUTTER_BOX2D_COMMAND_FORCE
+} ClutterBox2DCommandType;
+
+/* A change to the world queued by the main thread while the simulation
+ * thread is stepping. The object is the b2Body or b2Joint the command
+ * applies to, this is safe as destroying either takes the world lock,
+ * which flushes the queue first.
+ */
+typedef struct
+{
+  ClutterBox2DCommandType  type;
+  gpointer                 object;
+  b2Vec2                   value;
+} ClutterBox2DCommand;
+
 struct _ClutterBox2DPrivate
 {
   gint             iterations;  /* number of engine iterations per processing */
@@ -24,18 +81,63 @@ struct _ClutterBox2DPrivate
   gfloat           scale_factor; /* The scale factor of pixels to units */
   gfloat           inv_scale_factor; /* The inverse of the above */
   guint            iterate_id;  /* The iteration callback */
+  gboolean         coordinated; /* Stepped by the shared coordinator
+                                 * instead of iterate_id */
+  gdouble          next_step;   /* When the coordinator steps next, in ms */
   gboolean         simulate_inactive; /* Whether to simulate inactive bodies */
+  gint             lod_interval; /* Steps between steps of hidden children */
 
   b2World         *world;  /* The Box2D world which contains our simulation*/
   GHashTable      *actors; /* a hash table that maps actors to */
   GHashTable      *bodies; /* a hash table that maps bodies to */
   GHashTable      *joints;
+  GList           *fields; /* ClutterBox2DField not attached to a child */
+  GList           *particles; /* ClutterBox2DParticles of the container */
   b2Body          *ground_body;
   gboolean         dirty;  /* Shapes need to be recreated */
 
   GList           *collisions; /* List of ClutterBox2DCollision contact 
                                 * points from last iteration through time */
+  GArray          *sensor_events; /* ClutterBox2DSensorEvent of the steps
+                                   * since the last iteration, or NULL */
   ClutterBox2DContactListener *contact_listener;
+
+  /* Threaded simulation, see clutter_box2d_set_threaded() */
+  gboolean         threaded;
+  GThread         *thread;     /* Steps the world when simulating */
+  gboolean         thread_quit;
+  GMutex          *world_lock; /* Held by the thread while stepping */
+  GCond           *world_cond; /* Wakes the thread up early, to quit */
+  gint             world_lock_depth; /* Nesting of the main thread lock */
+  GMutex          *commands_lock;
+  GQueue           commands;   /* ClutterBox2DCommand to apply before
+                                * the next step */
+  GArray          *bulk_commands; /* ClutterBox2DCommand of the bulk
+                                   * calls, under commands_lock too */
+
+  /* Triple buffer of snapshots; the thread owns snapshot_back, the
+   * main thread snapshot_front and the third slot is swapped through
+   * snapshot_ready, so neither side ever waits for the other.
+   */
+  ClutterBox2DSnapshot snapshots[3];
+  volatile gint    snapshot_ready;
+  gint             snapshot_front;
+  gint             snapshot_back;
+  guint            snapshot_serial; /* Bumped whenever the main thread
+                                     * invalidates published snapshots */
+
+  /* Pipelined simulation, see clutter_box2d_set_pipelined() */
+  gboolean         pipelined;
+  gboolean         step_pending; /* A step was pushed to the pipeline pool
+                                  * and not joined yet */
+  gboolean         step_done;    /* Set by the pool, under world_lock */
+
+  GList           *scene_files;  /* GMappedFile of loaded scenes whose tree
+                                  * nodes the broad-phase works on */
+
+  gdouble          origin_x;     /* Total of clutter_box2d_shift_origin(), */
+  gdouble          origin_y;     /* in pixels */
+  ClutterBox2DRegions *regions;  /* Cached regions, NULL unless streaming */
 };
 
 struct _ClutterBox2DChildPrivate {
@@ -55,28 +157,85 @@ struct _ClutterBox2DChildPrivate {
                              affected by collisions. None: The object is not
                              included in the simulation. */
   gboolean          is_circle;
+  gboolean          is_sensor;
   ClutterVertex    *outline;
   b2Vec2           *b2outline;
   guint             n_vertices;
 
   b2Body           *body;   /* Box2D body, if any */
   b2Fixture        *fixture; /* Fixture for this body, if any */
+  b2Sensor         *sensor;  /* Takes the place of the fixture when
+                              * is_sensor is set */
   GList            *joints; /* list of joints this body participates in */
+  GList            *fields; /* list of fields attached to this body */
   b2World          *world;  /*the Box2D world (could be looked up through box2d)*/
 
   gfloat            density;
   gfloat            friction;
   gfloat            restitution;
 
-  gfloat            old_x;   /* The last set position and rotation. */
-  gfloat            old_y;   /* We store this to know when we need to resync */
-  gdouble           old_rot; /* the box2d state with the Clutter state */
+  guint16           category_bits; /* Collision filter, as in b2Filter */
+  guint16           mask_bits;
+  gint16            group_index;
+
+  ClutterBox2DLod   lod;        /* Policy while not visible */
+  gboolean          lod_hidden; /* Not visible at the last step */
+  b2Vec2            lod_linear_velocity; /* Of a child put to sleep */
+  gfloat            lod_angular_velocity;
+
+  /* The transform last written to the actor, which isn't written again
+   * while the body doesn't move */
+  gboolean          synced;
+  b2Vec2            synced_position;
+  float32           synced_angle;
+  gfloat            radius;    /* Of a circle, in pixels, else 0 */
+  gfloat            centre_x;  /* The centre of rotation of the actor */
+  gfloat            centre_y;
+
+  /* Moves of the actor by the application, counted from the notifications
+   * of its fixed position and rotation, synced to the body when they
+   * differ */
+  guint             changes;
+  guint             synced_changes;
+  gboolean          syncing;   /* Set while writing the transform back */
 };
 
 ClutterBox2DChild * clutter_box2d_get_child (ClutterBox2D *box2d,
                                              ClutterActor *actor);
 void _clutter_box2d_sync_body (ClutterBox2D      *box2d,
                                ClutterBox2DChild *box2d_child);
+void _clutter_box2d_sync_actor (ClutterBox2D      *box2d,
+                                ClutterBox2DChild *box2d_child);
+void _clutter_box2d_ensure_shape (ClutterBox2D      *box2d,
+                                  ClutterBox2DChild *box2d_child);
+void _clutter_box2d_purge_sensor_events (ClutterBox2D *box2d,
+                                         ClutterActor *actor);
+void _clutter_box2d_purge_bulk_commands (ClutterBox2D *box2d,
+                                         b2Body       *body);
+void _clutter_box2d_child_set_hidden (ClutterBox2D      *box2d,
+                                      ClutterBox2DChild *box2d_child,
+                                      gboolean           hidden);
+
+void _clutter_box2d_particles_sync (ClutterBox2DParticles *particles);
+
+ClutterBox2DJoint *_clutter_box2d_joint_new (ClutterBox2D          *box2d,
+                                             const b2JointDef      *def,
+                                             gsize                  def_size,
+                                             ClutterBox2DJointType  type);
+const b2JointDef *_clutter_box2d_joint_get_def (ClutterBox2DJoint *joint);
+
+gboolean _clutter_box2d_save_actors (ClutterBox2D  *box2d,
+                                     GList         *children,
+                                     const gchar   *filename,
+                                     GError       **error);
+void _clutter_box2d_regions_free (ClutterBox2DRegions *regions);
+
+void _clutter_box2d_lock_world   (ClutterBox2D *box2d);
+void _clutter_box2d_unlock_world (ClutterBox2D *box2d);
+gboolean _clutter_box2d_queue_command (ClutterBox2D            *box2d,
+                                       ClutterBox2DCommandType  type,
+                                       gpointer                 object,
+                                       const b2Vec2            &value);
 
 G_END_DECLS
 
@@ -0,0 +1,366 @@
+/* clutter-box2d - Clutter box2d integration
+ *
+ * This file implements streaming of regions of a scene to scene files in a
+ * cache directory, for scenes too large to simulate as a whole.
+ *
+ * Copyright 2010 Intel Corporation
+ * Licensed under the LGPL v2 or greater.
+ */
+
+#include "Box2D.h"
+#include <clutter/clutter.h>
+#include <glib/gstdio.h>
+#include "clutter-box2d.h"
+#include "clutter-box2d-child.h"
+#include "clutter-box2d-private.h"
+#include "clutter-box2d-scene.h"
+#include <math.h>
+
+struct _ClutterBox2DRegions
+{
+  gfloat                      size;      /* Of a region, in pixels */
+  gchar                      *cache_dir;
+  ClutterBox2DSceneActorFunc  func;
+  gpointer                    user_data;
+  GList                      *cached;    /* ClutterBox2DRegion streamed out */
+  guint                       serial;    /* Makes cache file names unique */
+};
+
+typedef struct
+{
+  gint    x;
+  gint    y;
+  GSList *files;  /* Scene files of a cached region */
+  GList  *actors; /* Children of a region being streamed out */
+} ClutterBox2DRegion;
+
+/* Regions that are kept loaded, inclusive */
+typedef struct
+{
+  gint x1, y1;
+  gint x2, y2;
+} ClutterBox2DRegionRange;
+
+static ClutterBox2DRegion *
+regions_find (GList **list,
+              gint    x,
+              gint    y)
+{
+  ClutterBox2DRegion *region;
+  GList *iter;
+
+  for (iter = *list; iter; iter = g_list_next (iter))
+    {
+      region = (ClutterBox2DRegion *) iter->data;
+      if (region->x == x && region->y == y)
+        return region;
+    }
+
+  region = g_slice_new0 (ClutterBox2DRegion);
+  region->x = x;
+  region->y = y;
+  *list = g_list_prepend (*list, region);
+
+  return region;
+}
+
+/* The region the centre of an actor is in, without the origin shifts */
+static void
+regions_locate (ClutterBox2D *box2d,
+                ClutterActor *actor,
+                gint         *x,
+                gint         *y)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  gfloat ax, ay, width, height;
+
+  clutter_actor_get_position (actor, &ax, &ay);
+  clutter_actor_get_size (actor, &width, &height);
+
+  *x = (gint) floor ((ax + width / 2 + priv->origin_x) / priv->regions->size);
+  *y = (gint) floor ((ay + height / 2 + priv->origin_y) / priv->regions->size);
+}
+
+static gboolean
+regions_in_range (const ClutterBox2DRegionRange *range,
+                  gint                           x,
+                  gint                           y)
+{
+  return x >= range->x1 && x <= range->x2 &&
+         y >= range->y1 && y <= range->y2;
+}
+
+/* Gets the actors connected to actor by joints, which have to be streamed
+ * together */
+static GList *
+regions_collect (ClutterBox2D *box2d,
+                 ClutterActor *actor,
+                 GHashTable   *visited)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  GList *component = NULL;
+  GSList *stack;
+
+  stack = g_slist_prepend (NULL, actor);
+  g_hash_table_insert (visited, actor, actor);
+
+  while (stack)
+    {
+      ClutterBox2DChild *child;
+      b2Body *body;
+
+      actor = CLUTTER_ACTOR (stack->data);
+      stack = g_slist_delete_link (stack, stack);
+      component = g_list_prepend (component, actor);
+
+      child = clutter_box2d_get_child (box2d, actor);
+      body = child->priv->body;
+      if (!body)
+        continue;
+
+      for (b2JointEdge *edge = body->GetJointList (); edge; edge = edge->next)
+        {
+          ClutterBox2DChild *other = (ClutterBox2DChild *)
+            g_hash_table_lookup (priv->bodies, edge->other);
+          ClutterActor *other_actor;
+
+          /* The ground body of mouse joints isn't a child */
+          if (!other)
+            continue;
+
+          other_actor = CLUTTER_CHILD_META (other)->actor;
+          if (g_hash_table_lookup (visited, other_actor))
+            continue;
+
+          g_hash_table_insert (visited, other_actor, other_actor);
+          stack = g_slist_prepend (stack, other_actor);
+        }
+    }
+
+  return component;
+}
+
+/* Loads all files of a cached region, removing them from the cache */
+static gboolean
+regions_load (ClutterBox2D        *box2d,
+              ClutterBox2DRegion  *region,
+              GError             **error)
+{
+  ClutterBox2DRegions *regions = box2d->priv->regions;
+
+  while (region->files)
+    {
+      gchar *filename = (gchar *) region->files->data;
+
+      if (!clutter_box2d_load_scene (box2d, filename, regions->func,
+                                     regions->user_data, error))
+        return FALSE;
+
+      g_unlink (filename);
+      g_free (filename);
+      region->files = g_slist_delete_link (region->files, region->files);
+    }
+
+  regions->cached = g_list_remove (regions->cached, region);
+  g_slice_free (ClutterBox2DRegion, region);
+
+  return TRUE;
+}
+
+void
+_clutter_box2d_regions_free (ClutterBox2DRegions *regions)
+{
+  while (regions->cached)
+    {
+      ClutterBox2DRegion *region = (ClutterBox2DRegion *) regions->cached->data;
+
+      while (region->files)
+        {
+          g_unlink ((gchar *) region->files->data);
+          g_free (region->files->data);
+          region->files = g_slist_delete_link (region->files, region->files);
+        }
+
+      g_slice_free (ClutterBox2DRegion, region);
+      regions->cached = g_list_delete_link (regions->cached, regions->cached);
+    }
+
+  g_free (regions->cache_dir);
+  g_slice_free (ClutterBox2DRegions, regions);
+}
+
+void
+clutter_box2d_set_streaming (ClutterBox2D                *box2d,
+                             gfloat                       region_size,
+                             const gchar                 *cache_dir,
+                             ClutterBox2DSceneActorFunc   func,
+                             gpointer                     user_data)
+{
+  ClutterBox2DPrivate *priv;
+  ClutterBox2DRegions *regions;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (region_size >= 0);
+  g_return_if_fail (region_size == 0 || cache_dir != NULL);
+
+  priv = box2d->priv;
+
+  if (priv->regions)
+    {
+      GList *cached;
+
+      /* Nothing streamed out is lost by changing the settings */
+      _clutter_box2d_lock_world (box2d);
+      cached = g_list_copy (priv->regions->cached);
+      while (cached)
+        {
+          GError *error = NULL;
+
+          if (!regions_load (box2d, (ClutterBox2DRegion *) cached->data,
+                             &error))
+            {
+              g_warning ("Couldn't load a cached region: %s", error->message);
+              g_error_free (error);
+            }
+          cached = g_list_delete_link (cached, cached);
+        }
+      _clutter_box2d_unlock_world (box2d);
+
+      _clutter_box2d_regions_free (priv->regions);
+      priv->regions = NULL;
+    }
+
+  if (region_size == 0)
+    return;
+
+  if (g_mkdir_with_parents (cache_dir, 0700) != 0)
+    g_warning ("Couldn't create the region cache '%s'", cache_dir);
+
+  regions = g_slice_new0 (ClutterBox2DRegions);
+  regions->size = region_size;
+  regions->cache_dir = g_strdup (cache_dir);
+  regions->func = func;
+  regions->user_data = user_data;
+  priv->regions = regions;
+}
+
+gboolean
+clutter_box2d_update_viewport (ClutterBox2D  *box2d,
+                               gfloat         x,
+                               gfloat         y,
+                               gfloat         width,
+                               gfloat         height,
+                               GError       **error)
+{
+  ClutterBox2DPrivate *priv;
+  ClutterBox2DRegions *regions;
+  ClutterBox2DRegionRange range;
+  GHashTable *visited;
+  GList *children, *unload, *iter;
+  gboolean success = TRUE;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), FALSE);
+
+  priv = box2d->priv;
+  regions = priv->regions;
+  if (!regions)
+    return TRUE;
+
+  /* One region of margin all around, so children are back before they
+   * scroll into view */
+  range.x1 = (gint) floor ((x + priv->origin_x) / regions->size) - 1;
+  range.y1 = (gint) floor ((y + priv->origin_y) / regions->size) - 1;
+  range.x2 = (gint) floor ((x + width + priv->origin_x) / regions->size) + 1;
+  range.y2 = (gint) floor ((y + height + priv->origin_y) / regions->size) + 1;
+
+  _clutter_box2d_lock_world (box2d);
+
+  /* Group the children to stream out by the region they are in */
+  unload = NULL;
+  visited = g_hash_table_new (NULL, NULL);
+  children = clutter_container_get_children (CLUTTER_CONTAINER (box2d));
+  for (iter = children; iter; iter = g_list_next (iter))
+    {
+      ClutterActor *actor = CLUTTER_ACTOR (iter->data);
+      ClutterBox2DRegion *region;
+      GList *component, *member;
+      gint rx, ry;
+
+      /* Particle groups span regions and are not saved, they stay */
+      if (CLUTTER_IS_BOX2D_PARTICLES (actor) ||
+          g_hash_table_lookup (visited, actor))
+        continue;
+
+      /* Fields aren't saved and their handles belong to the application,
+       * so children with fields attached stay loaded too */
+      component = regions_collect (box2d, actor, visited);
+      for (member = component; member; member = g_list_next (member))
+        {
+          ClutterActor *member_actor = CLUTTER_ACTOR (member->data);
+
+          if (clutter_box2d_get_child (box2d, member_actor)->priv->fields)
+            break;
+
+          regions_locate (box2d, member_actor, &rx, &ry);
+          if (regions_in_range (&range, rx, ry))
+            break;
+        }
+
+      if (member)
+        {
+          g_list_free (component);
+          continue;
+        }
+
+      regions_locate (box2d, actor, &rx, &ry);
+      region = regions_find (&unload, rx, ry);
+      region->actors = g_list_concat (region->actors, component);
+    }
+  g_list_free (children);
+  g_hash_table_destroy (visited);
+
+  while (unload)
+    {
+      ClutterBox2DRegion *region = (ClutterBox2DRegion *) unload->data;
+      gchar *basename, *filename;
+
+      basename = g_strdup_printf ("region-%d-%d-%u.scene",
+                                  region->x, region->y, regions->serial++);
+      filename = g_build_filename (regions->cache_dir, basename, NULL);
+      g_free (basename);
+
+      if (success &&
+          _clutter_box2d_save_actors (box2d, region->actors, filename, error))
+        {
+          ClutterBox2DRegion *cached;
+
+          for (iter = region->actors; iter; iter = g_list_next (iter))
+            clutter_actor_destroy (CLUTTER_ACTOR (iter->data));
+
+          cached = regions_find (&regions->cached, region->x, region->y);
+          cached->files = g_slist_prepend (cached->files, filename);
+        }
+      else
+        {
+          success = FALSE;
+          g_free (filename);
+        }
+
+      g_list_free (region->actors);
+      g_slice_free (ClutterBox2DRegion, region);
+      unload = g_list_delete_link (unload, unload);
+    }
+
+  for (iter = regions->cached; iter && success; )
+    {
+      ClutterBox2DRegion *region = (ClutterBox2DRegion *) iter->data;
+
+      iter = g_list_next (iter);
+      if (regions_in_range (&range, region->x, region->y))
+        success = regions_load (box2d, region, error);
+    }
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return success;
+}
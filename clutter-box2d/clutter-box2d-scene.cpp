@@ -0,0 +1,903 @@
+/* clutter-box2d - Clutter box2d integration
+ *
+ * This file implements saving and loading of scene files. A scene file is
+ * mapped into memory when it is loaded, and the broad-phase tree saved in
+ * it is handed to the world without copying.
+ *
+ * Copyright 2010 Intel Corporation
+ * Licensed under the LGPL v2 or greater.
+ */
+
+#include "Box2D.h"
+#include <clutter/clutter.h>
+#include "clutter-box2d.h"
+#include "clutter-box2d-child.h"
+#include "clutter-box2d-private.h"
+#include "clutter-box2d-scene.h"
+#include <string.h>
+
+#define SCENE_MAGIC      "CB2SCENE"
+#define SCENE_VERSION    4
+#define SCENE_BYTE_ORDER 0x01020304
+
+/* Every section starts on this boundary, so the tree nodes can be used
+ * straight from the mapped file */
+#define SCENE_ALIGN      8
+#define SCENE_NO_NAME    G_MAXUINT32
+
+typedef struct
+{
+  gchar   magic[8];
+  guint32 version;
+  guint32 byte_order;
+  guint32 size;         /* Of the whole file */
+  gfloat  scale_factor; /* Of the ClutterBox2D the scene was saved from */
+  gdouble origin[2];    /* Its origin, in pixels; positions are relative
+                         * to it */
+
+  guint32 n_bodies;
+  guint32 n_vertices;
+  guint32 n_joints;
+  guint32 n_nodes;      /* 0 if the broad-phase tree wasn't saved */
+  guint32 node_size;    /* sizeof (b2DynamicTreeNode) when saved */
+  gint32  root;
+  guint32 strings_size;
+
+  guint32 bodies_offset;
+  guint32 vertices_offset;
+  guint32 joints_offset;
+  guint32 nodes_offset;
+  guint32 strings_offset;
+} ClutterBox2DSceneHeader;
+
+enum
+{
+  SCENE_BODY_CIRCLE        = 1 << 0,
+  SCENE_BODY_BULLET        = 1 << 1,
+  SCENE_BODY_MANIPULATABLE = 1 << 2,
+  SCENE_BODY_AWAKE         = 1 << 3,
+  SCENE_BODY_SENSOR        = 1 << 4
+};
+
+/* One per child, in the order of the children. Bodies are identified by
+ * their index, and the leaves of the tree refer to the fixtures of the
+ * bodies by the same index.
+ */
+typedef struct
+{
+  guint32 name;         /* Offset of the actor name in the strings */
+  guint32 type;         /* ClutterBox2DType */
+  guint32 flags;
+  guint32 first_vertex; /* Outline, relative to the actor size */
+  guint32 n_vertices;
+  gfloat  width;        /* Actor size in pixels */
+  gfloat  height;
+  gfloat  density;
+  gfloat  friction;
+  gfloat  restitution;
+  guint16 category_bits; /* Collision filter */
+  guint16 mask_bits;
+  gint16  group_index;
+  guint16 lod;          /* ClutterBox2DLod */
+  gfloat  position[2];  /* Of the body in world units, or the actor for
+                         * CLUTTER_BOX2D_NONE */
+  gfloat  angle;
+  gfloat  linear_velocity[2];
+  gfloat  angular_velocity;
+  gfloat  linear_damping;
+  gfloat  angular_damping;
+} ClutterBox2DSceneBody;
+
+enum
+{
+  SCENE_JOINT_COLLIDE = 1 << 0,
+  SCENE_JOINT_LIMIT   = 1 << 1,
+  SCENE_JOINT_MOTOR   = 1 << 2
+};
+
+/* The definition of a joint, in world units. The values depend on the type:
+ *
+ *   distance:        length, frequency, damping ratio
+ *   revolute:        lower angle, upper angle, motor speed, max torque
+ *   prismatic, line: lower, upper translation, motor speed, max force
+ *   pulley:          length 1, max length 1, length 2, max length 2, ratio
+ */
+typedef struct
+{
+  guint32 type;         /* ClutterBox2DJointType */
+  guint32 body1;
+  guint32 body2;
+  guint32 flags;
+  gfloat  anchor1[2];   /* Local to the bodies */
+  gfloat  anchor2[2];
+  gfloat  axis[2];      /* Prismatic and line axis, pulley ground anchor 1 */
+  gfloat  ground2[2];   /* Pulley ground anchor 2 */
+  gfloat  angle;        /* Reference angle */
+  gfloat  values[5];
+} ClutterBox2DSceneJoint;
+
+GQuark
+clutter_box2d_scene_error_quark (void)
+{
+  return g_quark_from_static_string ("clutter-box2d-scene-error-quark");
+}
+
+static inline void
+scene_vec_save (gfloat *v, const b2Vec2 &vec)
+{
+  v[0] = vec.x;
+  v[1] = vec.y;
+}
+
+static inline b2Vec2
+scene_vec_load (const gfloat *v, gfloat ratio)
+{
+  return b2Vec2 (v[0] * ratio, v[1] * ratio);
+}
+
+/* All joint definitions the bindings create have local anchors */
+template <typename T> static void
+scene_joint_save_anchors (ClutterBox2DSceneJoint *record,
+                          const b2JointDef       *def)
+{
+  const T *jd = static_cast<const T *> (def);
+
+  scene_vec_save (record->anchor1, jd->localAnchorA);
+  scene_vec_save (record->anchor2, jd->localAnchorB);
+}
+
+template <typename T> static void
+scene_joint_load_anchors (T                            *jd,
+                          const ClutterBox2DSceneJoint *record,
+                          b2Body                       *body_a,
+                          b2Body                       *body_b,
+                          gfloat                        ratio)
+{
+  jd->bodyA = body_a;
+  jd->bodyB = body_b;
+  jd->collideConnected = (record->flags & SCENE_JOINT_COLLIDE) != 0;
+  jd->localAnchorA = scene_vec_load (record->anchor1, ratio);
+  jd->localAnchorB = scene_vec_load (record->anchor2, ratio);
+}
+
+static gboolean
+scene_joint_save (ClutterBox2DSceneJoint *record,
+                  ClutterBox2DJointType   type,
+                  const b2JointDef       *def)
+{
+  memset (record, 0, sizeof (ClutterBox2DSceneJoint));
+  record->type = type;
+
+  if (def->collideConnected)
+    record->flags |= SCENE_JOINT_COLLIDE;
+
+  switch (type)
+    {
+    case CLUTTER_BOX2D_JOINT_DISTANCE:
+      {
+        const b2DistanceJointDef *jd =
+          static_cast<const b2DistanceJointDef *> (def);
+        scene_joint_save_anchors<b2DistanceJointDef> (record, def);
+        record->values[0] = jd->length;
+        record->values[1] = jd->frequencyHz;
+        record->values[2] = jd->dampingRatio;
+      }
+      break;
+
+    case CLUTTER_BOX2D_JOINT_REVOLUTE:
+      {
+        const b2RevoluteJointDef *jd =
+          static_cast<const b2RevoluteJointDef *> (def);
+        scene_joint_save_anchors<b2RevoluteJointDef> (record, def);
+        record->angle = jd->referenceAngle;
+        record->flags |= (jd->enableLimit ? SCENE_JOINT_LIMIT : 0) |
+                         (jd->enableMotor ? SCENE_JOINT_MOTOR : 0);
+        record->values[0] = jd->lowerAngle;
+        record->values[1] = jd->upperAngle;
+        record->values[2] = jd->motorSpeed;
+        record->values[3] = jd->maxMotorTorque;
+      }
+      break;
+
+    case CLUTTER_BOX2D_JOINT_PRISMATIC:
+      {
+        const b2PrismaticJointDef *jd =
+          static_cast<const b2PrismaticJointDef *> (def);
+        scene_joint_save_anchors<b2PrismaticJointDef> (record, def);
+        scene_vec_save (record->axis, jd->localAxis1);
+        record->angle = jd->referenceAngle;
+        record->flags |= (jd->enableLimit ? SCENE_JOINT_LIMIT : 0) |
+                         (jd->enableMotor ? SCENE_JOINT_MOTOR : 0);
+        record->values[0] = jd->lowerTranslation;
+        record->values[1] = jd->upperTranslation;
+        record->values[2] = jd->motorSpeed;
+        record->values[3] = jd->maxMotorForce;
+      }
+      break;
+
+    case CLUTTER_BOX2D_JOINT_LINE:
+      {
+        const b2LineJointDef *jd = static_cast<const b2LineJointDef *> (def);
+        scene_joint_save_anchors<b2LineJointDef> (record, def);
+        scene_vec_save (record->axis, jd->localAxisA);
+        record->flags |= (jd->enableLimit ? SCENE_JOINT_LIMIT : 0) |
+                         (jd->enableMotor ? SCENE_JOINT_MOTOR : 0);
+        record->values[0] = jd->lowerTranslation;
+        record->values[1] = jd->upperTranslation;
+        record->values[2] = jd->motorSpeed;
+        record->values[3] = jd->maxMotorForce;
+      }
+      break;
+
+    case CLUTTER_BOX2D_JOINT_PULLEY:
+      {
+        const b2PulleyJointDef *jd = static_cast<const b2PulleyJointDef *> (def);
+        scene_joint_save_anchors<b2PulleyJointDef> (record, def);
+        scene_vec_save (record->axis, jd->groundAnchorA);
+        scene_vec_save (record->ground2, jd->groundAnchorB);
+        record->values[0] = jd->lengthA;
+        record->values[1] = jd->maxLengthA;
+        record->values[2] = jd->lengthB;
+        record->values[3] = jd->maxLengthB;
+        record->values[4] = jd->ratio;
+      }
+      break;
+
+    case CLUTTER_BOX2D_JOINT_WELD:
+      {
+        const b2WeldJointDef *jd = static_cast<const b2WeldJointDef *> (def);
+        scene_joint_save_anchors<b2WeldJointDef> (record, def);
+        record->angle = jd->referenceAngle;
+      }
+      break;
+
+    default:
+      /* Mouse joints follow the pointer, there is no point saving them */
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+scene_joint_load (ClutterBox2D                 *box2d,
+                  const ClutterBox2DSceneJoint *record,
+                  b2Body                       *body_a,
+                  b2Body                       *body_b,
+                  gfloat                        ratio,
+                  const b2Vec2                 &offset)
+{
+  gboolean limit = (record->flags & SCENE_JOINT_LIMIT) != 0;
+  gboolean motor = (record->flags & SCENE_JOINT_MOTOR) != 0;
+
+  switch (record->type)
+    {
+    case CLUTTER_BOX2D_JOINT_DISTANCE:
+      {
+        b2DistanceJointDef jd;
+        scene_joint_load_anchors (&jd, record, body_a, body_b, ratio);
+        jd.length = record->values[0] * ratio;
+        jd.frequencyHz = record->values[1];
+        jd.dampingRatio = record->values[2];
+        _clutter_box2d_joint_new (box2d, &jd, sizeof (jd),
+                                  CLUTTER_BOX2D_JOINT_DISTANCE);
+      }
+      break;
+
+    case CLUTTER_BOX2D_JOINT_REVOLUTE:
+      {
+        b2RevoluteJointDef jd;
+        scene_joint_load_anchors (&jd, record, body_a, body_b, ratio);
+        jd.referenceAngle = record->angle;
+        jd.enableLimit = limit;
+        jd.enableMotor = motor;
+        jd.lowerAngle = record->values[0];
+        jd.upperAngle = record->values[1];
+        jd.motorSpeed = record->values[2];
+        jd.maxMotorTorque = record->values[3];
+        _clutter_box2d_joint_new (box2d, &jd, sizeof (jd),
+                                  CLUTTER_BOX2D_JOINT_REVOLUTE);
+      }
+      break;
+
+    case CLUTTER_BOX2D_JOINT_PRISMATIC:
+      {
+        b2PrismaticJointDef jd;
+        scene_joint_load_anchors (&jd, record, body_a, body_b, ratio);
+        jd.localAxis1 = scene_vec_load (record->axis, 1.f);
+        jd.referenceAngle = record->angle;
+        jd.enableLimit = limit;
+        jd.enableMotor = motor;
+        jd.lowerTranslation = record->values[0] * ratio;
+        jd.upperTranslation = record->values[1] * ratio;
+        jd.motorSpeed = record->values[2] * ratio;
+        jd.maxMotorForce = record->values[3];
+        _clutter_box2d_joint_new (box2d, &jd, sizeof (jd),
+                                  CLUTTER_BOX2D_JOINT_PRISMATIC);
+      }
+      break;
+
+    case CLUTTER_BOX2D_JOINT_LINE:
+      {
+        b2LineJointDef jd;
+        scene_joint_load_anchors (&jd, record, body_a, body_b, ratio);
+        jd.localAxisA = scene_vec_load (record->axis, 1.f);
+        jd.enableLimit = limit;
+        jd.enableMotor = motor;
+        jd.lowerTranslation = record->values[0] * ratio;
+        jd.upperTranslation = record->values[1] * ratio;
+        jd.motorSpeed = record->values[2] * ratio;
+        jd.maxMotorForce = record->values[3];
+        _clutter_box2d_joint_new (box2d, &jd, sizeof (jd),
+                                  CLUTTER_BOX2D_JOINT_LINE);
+      }
+      break;
+
+    case CLUTTER_BOX2D_JOINT_PULLEY:
+      {
+        b2PulleyJointDef jd;
+        scene_joint_load_anchors (&jd, record, body_a, body_b, ratio);
+        jd.groundAnchorA = scene_vec_load (record->axis, ratio) + offset;
+        jd.groundAnchorB = scene_vec_load (record->ground2, ratio) + offset;
+        jd.lengthA = record->values[0] * ratio;
+        jd.maxLengthA = record->values[1] * ratio;
+        jd.lengthB = record->values[2] * ratio;
+        jd.maxLengthB = record->values[3] * ratio;
+        jd.ratio = record->values[4];
+        _clutter_box2d_joint_new (box2d, &jd, sizeof (jd),
+                                  CLUTTER_BOX2D_JOINT_PULLEY);
+      }
+      break;
+
+    case CLUTTER_BOX2D_JOINT_WELD:
+      {
+        b2WeldJointDef jd;
+        scene_joint_load_anchors (&jd, record, body_a, body_b, ratio);
+        jd.referenceAngle = record->angle;
+        _clutter_box2d_joint_new (box2d, &jd, sizeof (jd),
+                                  CLUTTER_BOX2D_JOINT_WELD);
+      }
+      break;
+    }
+}
+
+/* Appends a section to the file, returning its offset */
+static guint32
+scene_append (GByteArray    *data,
+              gconstpointer  section,
+              gsize          size)
+{
+  static const guint8 padding[SCENE_ALIGN] = { 0 };
+  guint32 offset;
+
+  if (data->len % SCENE_ALIGN)
+    g_byte_array_append (data, padding, SCENE_ALIGN - data->len % SCENE_ALIGN);
+
+  offset = data->len;
+  g_byte_array_append (data, (const guint8 *) section, size);
+
+  return offset;
+}
+
+/* Saves the given children and the joints between them. Particle groups
+ * are skipped, they are not bodies of their own. The tree is only saved
+ * when the children are all the bodies of the world. */
+gboolean
+_clutter_box2d_save_actors (ClutterBox2D  *box2d,
+                            GList         *children,
+                            const gchar   *filename,
+                            GError       **error)
+{
+  ClutterBox2DPrivate *priv;
+  ClutterBox2DSceneHeader header;
+  GList *iter;
+  GHashTable *indices;
+  GArray *bodies, *vertices, *joints;
+  GString *strings;
+  GByteArray *data;
+  b2Fixture **fixtures;
+  b2DynamicTreeNode *nodes = NULL;
+  guint n_children, i;
+  gboolean saved;
+
+  priv = box2d->priv;
+
+  n_children = g_list_length (children);
+
+  indices = g_hash_table_new (NULL, NULL);
+  fixtures = g_new0 (b2Fixture *, MAX (n_children, 1));
+  bodies = g_array_sized_new (FALSE, TRUE, sizeof (ClutterBox2DSceneBody),
+                              n_children);
+  vertices = g_array_new (FALSE, FALSE, sizeof (gfloat));
+  joints = g_array_new (FALSE, TRUE, sizeof (ClutterBox2DSceneJoint));
+  strings = g_string_new (NULL);
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, SCENE_MAGIC, sizeof (header.magic));
+  header.version = SCENE_VERSION;
+  header.byte_order = SCENE_BYTE_ORDER;
+  header.scale_factor = priv->scale_factor;
+  header.origin[0] = priv->origin_x;
+  header.origin[1] = priv->origin_y;
+  header.node_size = sizeof (b2DynamicTreeNode);
+
+  _clutter_box2d_lock_world (box2d);
+
+  for (iter = children; iter; iter = g_list_next (iter))
+    {
+      ClutterActor *actor = CLUTTER_ACTOR (iter->data);
+      ClutterBox2DChild *child;
+      ClutterBox2DChildPrivate *child_priv;
+      const gchar *name;
+      ClutterBox2DSceneBody body;
+
+      if (CLUTTER_IS_BOX2D_PARTICLES (actor))
+        continue;
+
+      child = clutter_box2d_get_child (box2d, actor);
+      child_priv = child->priv;
+      name = clutter_actor_get_name (actor);
+      i = bodies->len;
+
+      memset (&body, 0, sizeof (body));
+
+      if (name)
+        {
+          body.name = strings->len;
+          g_string_append_len (strings, name, strlen (name) + 1);
+        }
+      else
+        body.name = SCENE_NO_NAME;
+
+      body.type = child_priv->type;
+      body.flags = (child_priv->is_circle ? SCENE_BODY_CIRCLE : 0) |
+                   (child_priv->is_sensor ? SCENE_BODY_SENSOR : 0) |
+                   (child_priv->manipulatable ? SCENE_BODY_MANIPULATABLE : 0);
+      clutter_actor_get_size (actor, &body.width, &body.height);
+      body.density = child_priv->density;
+      body.friction = child_priv->friction;
+      body.restitution = child_priv->restitution;
+      body.category_bits = child_priv->category_bits;
+      body.mask_bits = child_priv->mask_bits;
+      body.group_index = child_priv->group_index;
+      body.lod = child_priv->lod;
+
+      if (child_priv->outline && !child_priv->is_circle)
+        {
+          guint j;
+
+          body.first_vertex = vertices->len / 2;
+          body.n_vertices = child_priv->n_vertices;
+          for (j = 0; j < child_priv->n_vertices; j++)
+            {
+              g_array_append_val (vertices, child_priv->outline[j].x);
+              g_array_append_val (vertices, child_priv->outline[j].y);
+            }
+        }
+
+      if (child_priv->body)
+        {
+          b2Body *b = child_priv->body;
+
+          scene_vec_save (body.position, b->GetPosition ());
+          body.angle = b->GetAngle ();
+          body.linear_damping = b->GetLinearDamping ();
+          body.angular_damping = b->GetAngularDamping ();
+
+          /* A child put to sleep while hidden is saved with the motion
+           * it gets back, the policy puts it to sleep again once loaded */
+          if (child_priv->lod == CLUTTER_BOX2D_LOD_SLEEP &&
+              child_priv->lod_hidden && !b->IsAwake ())
+            {
+              scene_vec_save (body.linear_velocity,
+                              child_priv->lod_linear_velocity);
+              body.angular_velocity = child_priv->lod_angular_velocity;
+              body.flags |= SCENE_BODY_AWAKE;
+            }
+          else
+            {
+              scene_vec_save (body.linear_velocity, b->GetLinearVelocity ());
+              body.angular_velocity = b->GetAngularVelocity ();
+              if (b->IsAwake ())
+                body.flags |= SCENE_BODY_AWAKE;
+            }
+          if (b->IsBullet ())
+            body.flags |= SCENE_BODY_BULLET;
+
+          fixtures[i] = child_priv->fixture;
+        }
+      else
+        {
+          gfloat x, y;
+
+          clutter_actor_get_position (actor, &x, &y);
+          body.position[0] = x * priv->scale_factor;
+          body.position[1] = y * priv->scale_factor;
+          body.angle = clutter_actor_get_rotation (actor, CLUTTER_Z_AXIS,
+                                                   NULL, NULL, NULL) / (180 / G_PI);
+          body.linear_damping = 0.5f;
+          body.angular_damping = 0.5f;
+        }
+
+      g_array_append_val (bodies, body);
+      g_hash_table_insert (indices, child, GUINT_TO_POINTER (i + 1));
+    }
+
+  for (b2Joint *j = priv->world->GetJointList (); j; j = j->GetNext ())
+    {
+      ClutterBox2DJoint *joint = (ClutterBox2DJoint *) j->GetUserData ();
+      ClutterBox2DSceneJoint record;
+      guint body1, body2;
+
+      if (!joint ||
+          !scene_joint_save (&record, clutter_box2d_joint_get_type (joint),
+                             _clutter_box2d_joint_get_def (joint)))
+        continue;
+
+      body1 = GPOINTER_TO_UINT (g_hash_table_lookup (indices,
+                g_hash_table_lookup (priv->bodies, j->GetBodyA ())));
+      body2 = GPOINTER_TO_UINT (g_hash_table_lookup (indices,
+                g_hash_table_lookup (priv->bodies, j->GetBodyB ())));
+      if (!body1 || !body2)
+        continue;
+
+      record.body1 = body1 - 1;
+      record.body2 = body2 - 1;
+      g_array_append_val (joints, record);
+    }
+
+  /* The tree is left out when it has proxies that aren't children */
+  if (priv->world->GetProxyCount () > 0)
+    {
+      nodes = g_new (b2DynamicTreeNode, 2 * priv->world->GetProxyCount () - 1);
+      header.n_nodes = priv->world->SaveBroadPhase (nodes, &header.root,
+                                                     fixtures, n_children);
+    }
+
+  _clutter_box2d_unlock_world (box2d);
+
+  header.n_bodies = bodies->len;
+  header.n_vertices = vertices->len / 2;
+  header.n_joints = joints->len;
+  header.strings_size = strings->len;
+
+  data = g_byte_array_new ();
+  scene_append (data, &header, sizeof (header));
+  header.bodies_offset = scene_append (data, bodies->data,
+                                       bodies->len * sizeof (ClutterBox2DSceneBody));
+  header.vertices_offset = scene_append (data, vertices->data,
+                                         vertices->len * sizeof (gfloat));
+  header.joints_offset = scene_append (data, joints->data,
+                                       joints->len * sizeof (ClutterBox2DSceneJoint));
+  header.nodes_offset = scene_append (data, nodes,
+                                      header.n_nodes * sizeof (b2DynamicTreeNode));
+  header.strings_offset = scene_append (data, strings->str, strings->len);
+  header.size = data->len;
+  memcpy (data->data, &header, sizeof (header));
+
+  saved = g_file_set_contents (filename, (const gchar *) data->data,
+                               data->len, error);
+
+  g_byte_array_free (data, TRUE);
+  g_string_free (strings, TRUE);
+  g_array_free (joints, TRUE);
+  g_array_free (vertices, TRUE);
+  g_array_free (bodies, TRUE);
+  g_free (nodes);
+  g_free (fixtures);
+  g_hash_table_destroy (indices);
+
+  return saved;
+}
+
+gboolean
+clutter_box2d_save_scene (ClutterBox2D  *box2d,
+                          const gchar   *filename,
+                          GError       **error)
+{
+  GList *children;
+  gboolean saved;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+
+  children = clutter_container_get_children (CLUTTER_CONTAINER (box2d));
+  saved = _clutter_box2d_save_actors (box2d, children, filename, error);
+  g_list_free (children);
+
+  return saved;
+}
+
+/* Whether count items of size bytes at offset fit in the file */
+static gboolean
+scene_check_section (const ClutterBox2DSceneHeader *header,
+                     guint32                        offset,
+                     guint32                        count,
+                     guint32                        size)
+{
+  return offset % SCENE_ALIGN == 0 &&
+    (guint64) offset + (guint64) count * size <= header->size;
+}
+
+static gboolean
+scene_check (const gchar  *contents,
+             gsize         length,
+             GError      **error)
+{
+  const ClutterBox2DSceneHeader *header;
+  const ClutterBox2DSceneBody *bodies;
+  const ClutterBox2DSceneJoint *joints;
+  guint i;
+
+  header = (const ClutterBox2DSceneHeader *) contents;
+
+  if (length < sizeof (ClutterBox2DSceneHeader) ||
+      memcmp (header->magic, SCENE_MAGIC, sizeof (header->magic)) != 0)
+    {
+      g_set_error (error, CLUTTER_BOX2D_SCENE_ERROR,
+                   CLUTTER_BOX2D_SCENE_ERROR_INVALID,
+                   "Not a scene file");
+      return FALSE;
+    }
+
+  if (header->version != SCENE_VERSION ||
+      header->byte_order != SCENE_BYTE_ORDER)
+    {
+      g_set_error (error, CLUTTER_BOX2D_SCENE_ERROR,
+                   CLUTTER_BOX2D_SCENE_ERROR_VERSION,
+                   "Scene file version %u is not supported",
+                   header->version);
+      return FALSE;
+    }
+
+  if (header->size != length ||
+      !scene_check_section (header, header->bodies_offset, header->n_bodies,
+                            sizeof (ClutterBox2DSceneBody)) ||
+      !scene_check_section (header, header->vertices_offset,
+                            header->n_vertices, 2 * sizeof (gfloat)) ||
+      !scene_check_section (header, header->joints_offset, header->n_joints,
+                            sizeof (ClutterBox2DSceneJoint)) ||
+      !scene_check_section (header, header->nodes_offset, header->n_nodes,
+                            header->node_size) ||
+      !scene_check_section (header, header->strings_offset,
+                            header->strings_size, 1) ||
+      (header->strings_size &&
+       contents[header->strings_offset + header->strings_size - 1] != '\0'))
+    goto invalid;
+
+  bodies = (const ClutterBox2DSceneBody *) (contents + header->bodies_offset);
+  for (i = 0; i < header->n_bodies; i++)
+    {
+      const ClutterBox2DSceneBody *body = bodies + i;
+
+      if ((body->name != SCENE_NO_NAME && body->name >= header->strings_size) ||
+          body->type > CLUTTER_BOX2D_STATIC ||
+          body->lod > CLUTTER_BOX2D_LOD_SLEEP ||
+          (guint64) body->first_vertex + body->n_vertices > header->n_vertices ||
+          body->n_vertices > b2_maxPolygonVertices)
+        goto invalid;
+    }
+
+  joints = (const ClutterBox2DSceneJoint *) (contents + header->joints_offset);
+  for (i = 0; i < header->n_joints; i++)
+    {
+      const ClutterBox2DSceneJoint *joint = joints + i;
+
+      if (joint->body1 >= header->n_bodies ||
+          joint->body2 >= header->n_bodies ||
+          joint->type < CLUTTER_BOX2D_JOINT_DISTANCE ||
+          joint->type > CLUTTER_BOX2D_JOINT_WELD)
+        goto invalid;
+    }
+
+  return TRUE;
+
+invalid:
+  g_set_error (error, CLUTTER_BOX2D_SCENE_ERROR,
+               CLUTTER_BOX2D_SCENE_ERROR_INVALID,
+               "The scene file is corrupt");
+  return FALSE;
+}
+
+gboolean
+clutter_box2d_load_scene (ClutterBox2D                *box2d,
+                          const gchar                 *filename,
+                          ClutterBox2DSceneActorFunc   func,
+                          gpointer                     user_data,
+                          GError                     **error)
+{
+  ClutterBox2DPrivate *priv;
+  const ClutterBox2DSceneHeader *header;
+  const ClutterBox2DSceneBody *bodies;
+  const ClutterBox2DSceneJoint *joints;
+  const gfloat *vertices;
+  const gchar *strings;
+  ClutterBox2DChild **children;
+  b2Fixture **fixtures;
+  GMappedFile *file;
+  gchar *contents;
+  gboolean use_tree;
+  gfloat ratio;
+  b2Vec2 offset;
+  guint i;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), FALSE);
+  g_return_val_if_fail (filename != NULL, FALSE);
+
+  priv = box2d->priv;
+
+  /* Writable, so the tree nodes are copied on write rather than
+   * changing the file */
+  file = g_mapped_file_new (filename, TRUE, error);
+  if (!file)
+    return FALSE;
+
+  contents = g_mapped_file_get_contents (file);
+  if (!scene_check (contents, g_mapped_file_get_length (file), error))
+    {
+      g_mapped_file_unref (file);
+      return FALSE;
+    }
+
+  header = (const ClutterBox2DSceneHeader *) contents;
+  bodies = (const ClutterBox2DSceneBody *) (contents + header->bodies_offset);
+  vertices = (const gfloat *) (contents + header->vertices_offset);
+  joints = (const ClutterBox2DSceneJoint *) (contents + header->joints_offset);
+  strings = contents + header->strings_offset;
+  ratio = priv->scale_factor / header->scale_factor;
+
+  /* Move the scene from the origin it was saved at to the current one */
+  offset.Set ((header->origin[0] - priv->origin_x) * priv->scale_factor,
+              (header->origin[1] - priv->origin_y) * priv->scale_factor);
+
+  children = g_new0 (ClutterBox2DChild *, MAX (header->n_bodies, 1));
+  fixtures = g_new0 (b2Fixture *, MAX (header->n_bodies, 1));
+
+  _clutter_box2d_lock_world (box2d);
+
+  /* The tree can only be taken over as a whole by an empty world */
+  use_tree = header->n_nodes > 0 &&
+             header->node_size == sizeof (b2DynamicTreeNode) &&
+             ratio == 1.f &&
+             offset.x == 0.f && offset.y == 0.f &&
+             priv->world->GetProxyCount () == 0;
+
+  for (i = 0; i < header->n_bodies; i++)
+    {
+      const ClutterBox2DSceneBody *body = bodies + i;
+      const gchar *name = NULL;
+      ClutterBox2DChild *child;
+      ClutterActor *actor;
+      b2BodyDef def;
+
+      if (body->name != SCENE_NO_NAME)
+        name = strings + body->name;
+
+      if (func)
+        actor = func (box2d, name, body->width, body->height, user_data);
+      else
+        actor = clutter_rectangle_new ();
+
+      if (name)
+        clutter_actor_set_name (actor, name);
+      clutter_actor_set_size (actor, body->width, body->height);
+      clutter_container_add_actor (CLUTTER_CONTAINER (box2d), actor);
+
+      child = clutter_box2d_get_child (box2d, actor);
+      children[i] = child;
+
+      clutter_box2d_child_set_density (box2d, actor, body->density);
+      clutter_box2d_child_set_friction (box2d, actor, body->friction);
+      clutter_box2d_child_set_restitution (box2d, actor, body->restitution);
+      clutter_box2d_child_set_collision_filter (box2d, actor,
+                                                body->category_bits,
+                                                body->mask_bits,
+                                                body->group_index);
+
+      if (body->flags & SCENE_BODY_CIRCLE)
+        clutter_box2d_child_set_is_circle (box2d, actor, TRUE);
+      else if (body->n_vertices)
+        {
+          ClutterVertex outline[b2_maxPolygonVertices];
+          guint j;
+
+          for (j = 0; j < body->n_vertices; j++)
+            {
+              outline[j].x = vertices[2 * (body->first_vertex + j)];
+              outline[j].y = vertices[2 * (body->first_vertex + j) + 1];
+              outline[j].z = 0;
+            }
+          clutter_box2d_child_set_outline (box2d, actor, outline,
+                                           body->n_vertices);
+        }
+
+      if (body->flags & SCENE_BODY_SENSOR)
+        clutter_box2d_child_set_is_sensor (box2d, actor, TRUE);
+
+      if (body->flags & SCENE_BODY_MANIPULATABLE)
+        clutter_box2d_child_set_manipulatable (box2d, actor, TRUE);
+
+      clutter_box2d_child_set_lod (box2d, actor, (ClutterBox2DLod) body->lod);
+
+      if (body->type == CLUTTER_BOX2D_NONE)
+        {
+          clutter_actor_set_position (actor,
+                                      (body->position[0] * ratio + offset.x) *
+                                      priv->inv_scale_factor,
+                                      (body->position[1] * ratio + offset.y) *
+                                      priv->inv_scale_factor);
+          clutter_actor_set_rotation (actor, CLUTTER_Z_AXIS,
+                                      body->angle * (180 / G_PI), 0, 0, 0);
+          continue;
+        }
+
+      /* Like clutter_box2d_child_set_type2(), but with the saved motion,
+       * and without proxies when the tree is going to provide them */
+      def.type = body->type == CLUTTER_BOX2D_DYNAMIC ?
+                 b2_dynamicBody : b2_staticBody;
+      def.position = scene_vec_load (body->position, ratio) + offset;
+      def.angle = body->angle;
+      def.linearVelocity = scene_vec_load (body->linear_velocity, ratio);
+      def.angularVelocity = body->angular_velocity;
+      def.linearDamping = body->linear_damping;
+      def.angularDamping = body->angular_damping;
+      def.awake = (body->flags & SCENE_BODY_AWAKE) != 0;
+      def.bullet = (body->flags & SCENE_BODY_BULLET) != 0;
+      /* Sensors have no fixture in the tree to be activated with */
+      def.active = !use_tree || (body->flags & SCENE_BODY_SENSOR);
+      def.userData = child;
+
+      child->priv->type = (ClutterBox2DType) body->type;
+      child->priv->body = priv->world->CreateBody (&def);
+      g_hash_table_insert (priv->bodies, child->priv->body, child);
+
+      _clutter_box2d_ensure_shape (box2d, child);
+      fixtures[i] = child->priv->fixture;
+    }
+
+  if (use_tree)
+    {
+      b2DynamicTreeNode *nodes =
+        (b2DynamicTreeNode *) (contents + header->nodes_offset);
+
+      if (priv->world->LoadBroadPhase (nodes, header->n_nodes, header->root,
+                                       fixtures, header->n_bodies))
+        {
+          priv->scene_files = g_list_prepend (priv->scene_files,
+                                              g_mapped_file_ref (file));
+        }
+      else
+        {
+          g_warning ("The broad-phase tree of the scene '%s' doesn't match "
+                     "its bodies", filename);
+
+          for (i = 0; i < header->n_bodies; i++)
+            if (children[i]->priv->body)
+              children[i]->priv->body->SetActive (true);
+        }
+    }
+
+  for (i = 0; i < header->n_bodies; i++)
+    if (children[i]->priv->body)
+      _clutter_box2d_sync_actor (box2d, children[i]);
+
+  for (i = 0; i < header->n_joints; i++)
+    {
+      const ClutterBox2DSceneJoint *joint = joints + i;
+      b2Body *body_a = children[joint->body1]->priv->body;
+      b2Body *body_b = children[joint->body2]->priv->body;
+
+      if (body_a && body_b)
+        scene_joint_load (box2d, joint, body_a, body_b, ratio, offset);
+    }
+
+  priv->snapshot_serial++;
+
+  _clutter_box2d_unlock_world (box2d);
+
+  g_free (fixtures);
+  g_free (children);
+  g_mapped_file_unref (file);
+
+  return TRUE;
+}
@@ -0,0 +1,174 @@
+/* clutter-box2d - Clutter box2d integration
+ *
+ * Copyright 2010 Intel Corporation
+ * Licensed under the LGPL v2 or greater.
+ */
+
+#ifndef _CLUTTER_BOX2D_SCENE_H
+#define _CLUTTER_BOX2D_SCENE_H
+
+#include <clutter/clutter.h>
+#include <clutter-box2d/clutter-box2d.h>
+
+G_BEGIN_DECLS
+
+/**
+ * SECTION:clutter-box2d-scene
+ * @short_description: Saving and loading whole scenes.
+ *
+ * A scene file holds the children of a #ClutterBox2D with their shapes,
+ * materials and motion, the joints between them and the broad-phase tree
+ * of the world. Loading a scene maps the file into memory and creates all
+ * bodies in one go; the tree is used in place rather than being rebuilt one
+ * body at a time, which makes loading large levels fast.
+ *
+ * Scene files do not hold the appearance of actors, the application
+ * creates the actors while a scene is loaded, see
+ * #ClutterBox2DSceneActorFunc. They are not portable between
+ * architectures.
+ *
+ * Scrolling scenes can be far bigger than what needs simulating at any
+ * one time. When streaming is enabled, the plane is divided into square
+ * regions and the children of regions far from the viewport are saved
+ * to scene files in a cache directory and removed; they are loaded again,
+ * with their motion and sleeping state, before they scroll back into
+ * view. Children connected by joints are always streamed together.
+ * Particle groups and children with fields attached, along with the
+ * children jointed to them, are never streamed out.
+ *
+ * Streaming works in the coordinates without the shifts of
+ * clutter_box2d_shift_origin(), so the origin can be kept close to the
+ * viewport as the scene scrolls.
+ */
+
+/**
+ * CLUTTER_BOX2D_SCENE_ERROR:
+ *
+ * Error domain for scene loading and saving.
+ */
+#define CLUTTER_BOX2D_SCENE_ERROR (clutter_box2d_scene_error_quark ())
+
+/**
+ * ClutterBox2DSceneError:
+ * @CLUTTER_BOX2D_SCENE_ERROR_INVALID: The file is not a valid scene
+ * @CLUTTER_BOX2D_SCENE_ERROR_VERSION: The scene was saved by an
+ *   incompatible version or on a different architecture
+ *
+ * Error codes in the #CLUTTER_BOX2D_SCENE_ERROR domain.
+ */
+typedef enum
+{
+  CLUTTER_BOX2D_SCENE_ERROR_INVALID,
+  CLUTTER_BOX2D_SCENE_ERROR_VERSION
+} ClutterBox2DSceneError;
+
+/**
+ * ClutterBox2DSceneActorFunc:
+ * @box2d: the #ClutterBox2D the scene is loaded into
+ * @name: the name of the actor when the scene was saved, or %NULL
+ * @width: the width of the actor
+ * @height: the height of the actor
+ * @user_data: data passed to clutter_box2d_load_scene()
+ *
+ * Creates the actor for a child of a scene being loaded. The actor is
+ * sized and added to @box2d by the caller.
+ *
+ * Returns: a new #ClutterActor
+ */
+typedef ClutterActor * (*ClutterBox2DSceneActorFunc) (ClutterBox2D *box2d,
+                                                      const gchar  *name,
+                                                      gfloat        width,
+                                                      gfloat        height,
+                                                      gpointer      user_data);
+
+GQuark clutter_box2d_scene_error_quark (void);
+
+/**
+ * clutter_box2d_save_scene:
+ * @box2d: a #ClutterBox2D
+ * @filename: the file to write the scene to
+ * @error: return location for a #GError, or %NULL
+ *
+ * Saves the children of @box2d and the joints between them to a scene file
+ * that can be loaded with clutter_box2d_load_scene(). Mouse joints and
+ * #ClutterBox2DParticles groups are not saved.
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurred.
+ */
+gboolean clutter_box2d_save_scene (ClutterBox2D  *box2d,
+                                   const gchar   *filename,
+                                   GError       **error);
+
+/**
+ * clutter_box2d_load_scene:
+ * @box2d: a #ClutterBox2D
+ * @filename: a scene file saved with clutter_box2d_save_scene()
+ * @func: function creating the actors, or %NULL for #ClutterRectangle<!-- -->s
+ * @user_data: data to pass to @func
+ * @error: return location for a #GError, or %NULL
+ *
+ * Adds the children and joints of a scene file to @box2d. Children are
+ * placed relative to the origin the scene was saved at, so a scene saved
+ * before clutter_box2d_shift_origin() comes back where it was. The saved
+ * broad-phase tree is only used when @box2d has no bodies with shapes yet
+ * and the same scale factor and origin as the scene was saved with;
+ * otherwise the bodies are added to the existing tree one by one.
+ *
+ * Returns: %TRUE on success, %FALSE if an error occurred.
+ */
+gboolean clutter_box2d_load_scene (ClutterBox2D                *box2d,
+                                   const gchar                 *filename,
+                                   ClutterBox2DSceneActorFunc   func,
+                                   gpointer                     user_data,
+                                   GError                     **error);
+
+/**
+ * clutter_box2d_set_streaming:
+ * @box2d: a #ClutterBox2D
+ * @region_size: the width and height of a region in pixels, or 0 to stop
+ *   streaming
+ * @cache_dir: the directory to save regions to; it is created if needed
+ *   and must not be shared with other #ClutterBox2D<!-- -->s
+ * @func: function creating the actors of loaded regions, see
+ *   clutter_box2d_load_scene()
+ * @user_data: data to pass to @func
+ *
+ * Enables streaming of regions, see clutter_box2d_update_viewport().
+ * Regions that were streamed out with previous settings are loaded back
+ * first.
+ */
+void     clutter_box2d_set_streaming   (ClutterBox2D                *box2d,
+                                        gfloat                       region_size,
+                                        const gchar                 *cache_dir,
+                                        ClutterBox2DSceneActorFunc   func,
+                                        gpointer                     user_data);
+
+/**
+ * clutter_box2d_update_viewport:
+ * @box2d: a #ClutterBox2D
+ * @x: left edge of the viewport, in the coordinates of @box2d
+ * @y: top edge of the viewport
+ * @width: width of the viewport
+ * @height: height of the viewport
+ * @error: return location for a #GError, or %NULL
+ *
+ * Keeps the regions that the viewport touches, and the regions around
+ * them, loaded. Children outside of those regions are saved to the cache
+ * and destroyed, unless they or the children jointed to them are inside
+ * or have a #ClutterBox2DField attached, and cached regions that came
+ * into range are loaded. Call this whenever the viewport scrolls; it does
+ * nothing unless clutter_box2d_set_streaming() was called.
+ *
+ * Returns: %TRUE on success, %FALSE if a region couldn't be saved or
+ * loaded, in which case it stays as it was.
+ */
+gboolean clutter_box2d_update_viewport (ClutterBox2D  *box2d,
+                                        gfloat         x,
+                                        gfloat         y,
+                                        gfloat         width,
+                                        gfloat         height,
+                                        GError       **error);
+
+G_END_DECLS
+
+#endif
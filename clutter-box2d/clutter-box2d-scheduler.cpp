@@ -0,0 +1,202 @@
+/*
+ * This file implements a b2TaskScheduler that runs the parallel parts
+ * of the Box2D step on a GThreadPool shared by all ClutterBox2D worlds.
+ *
+ * Licensed under the LGPL v2 or greater.
+ */
+#include "Box2D.h"
+#include <glib.h>
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#endif
+#include "clutter-box2d-scheduler.h"
+
+/* One ParallelFor call. The ranges are claimed with an atomic counter by
+ * the pool threads and by the thread waiting on the group, the job is
+ * freed when the last of them lets go of it.
+ */
+typedef struct _ClutterBox2DJob ClutterBox2DJob;
+struct _ClutterBox2DJob
+{
+  b2Task          *task;
+  b2TaskGroup     *group;
+  gint             count;
+  gint             n_ranges;
+  volatile gint    next_range;
+  volatile gint    ref_count;
+  ClutterBox2DJob *next; /* other jobs of the same group */
+};
+
+static void
+clutter_box2d_job_unref (ClutterBox2DJob *job)
+{
+  if (g_atomic_int_dec_and_test (&job->ref_count))
+    g_slice_free (ClutterBox2DJob, job);
+}
+
+static void
+clutter_box2d_job_run (ClutterBox2DJob *job,
+                       gint             thread_index)
+{
+  gint range;
+
+  while ((range = g_atomic_int_exchange_and_add (&job->next_range, 1))
+         < job->n_ranges)
+    {
+      /* The first count % n_ranges ranges get one extra item */
+      gint size = job->count / job->n_ranges;
+      gint remainder = job->count % job->n_ranges;
+      gint begin = range * size + MIN (range, remainder);
+      gint end = begin + size + (range < remainder ? 1 : 0);
+
+      job->task->Execute (begin, end, thread_index);
+      g_atomic_int_add ((volatile gint *)&job->group->pending, -1);
+    }
+}
+
+__ClutterBox2DTaskScheduler::
+__ClutterBox2DTaskScheduler (gint n_threads)
+{
+  m_n_threads = MAX (n_threads, 1);
+  m_thread_index = g_private_new (NULL);
+  m_next_thread_index = 1;
+
+  /* The thread calling Wait is the first thread, the pool has the rest */
+  m_pool = NULL;
+  if (m_n_threads > 1)
+    m_pool = g_thread_pool_new (worker, this, m_n_threads - 1, TRUE, NULL);
+  if (!m_pool)
+    m_n_threads = 1;
+}
+
+__ClutterBox2DTaskScheduler::~__ClutterBox2DTaskScheduler ()
+{
+  if (m_pool)
+    g_thread_pool_free (m_pool, FALSE, TRUE);
+}
+
+gint
+__ClutterBox2DTaskScheduler::get_thread_index ()
+{
+  gint index = GPOINTER_TO_INT (g_private_get (m_thread_index));
+
+  if (!index)
+    {
+      index = g_atomic_int_exchange_and_add (&m_next_thread_index, 1);
+      g_private_set (m_thread_index, GINT_TO_POINTER (index));
+    }
+
+  return index;
+}
+
+void
+__ClutterBox2DTaskScheduler::worker (gpointer data,
+                                     gpointer user_data)
+{
+  ClutterBox2DJob *job = (ClutterBox2DJob *)data;
+  __ClutterBox2DTaskScheduler *self = (__ClutterBox2DTaskScheduler *)user_data;
+
+  clutter_box2d_job_run (job, self->get_thread_index ());
+  clutter_box2d_job_unref (job);
+}
+
+int32
+__ClutterBox2DTaskScheduler::GetThreadCount () const
+{
+  return m_n_threads;
+}
+
+void
+__ClutterBox2DTaskScheduler::ParallelFor (b2TaskGroup *group,
+                                          b2Task      *task,
+                                          int32        count,
+                                          int32        minRange)
+{
+  ClutterBox2DJob *job;
+  gint n_ranges, n_workers, i;
+
+  if (count <= 0)
+    return;
+
+  n_ranges = MIN (count / MAX (minRange, 1), 4 * m_n_threads);
+  if (m_n_threads == 1 || n_ranges <= 1)
+    {
+      task->Execute (0, count, 0);
+      return;
+    }
+
+  /* No point in waking more workers than there are ranges to share */
+  n_workers = MIN (n_ranges - 1, m_n_threads - 1);
+
+  job = g_slice_new (ClutterBox2DJob);
+  job->task = task;
+  job->group = group;
+  job->count = count;
+  job->n_ranges = n_ranges;
+  job->next_range = 0;
+  job->ref_count = n_workers + 1;
+  job->next = (ClutterBox2DJob *)group->userData;
+  group->userData = job;
+
+  g_atomic_int_add ((volatile gint *)&group->pending, n_ranges);
+
+  for (i = 0; i < n_workers; i++)
+    g_thread_pool_push (m_pool, job, NULL);
+}
+
+void
+__ClutterBox2DTaskScheduler::Wait (b2TaskGroup *group)
+{
+  ClutterBox2DJob *job, *next;
+
+  for (job = (ClutterBox2DJob *)group->userData; job; job = job->next)
+    clutter_box2d_job_run (job, 0);
+
+  /* Whatever is left is already running on the pool */
+  while (g_atomic_int_get ((volatile gint *)&group->pending) > 0)
+    g_thread_yield ();
+
+  for (job = (ClutterBox2DJob *)group->userData; job; job = next)
+    {
+      next = job->next;
+      clutter_box2d_job_unref (job);
+    }
+  group->userData = NULL;
+}
+
+static gint
+clutter_box2d_get_n_processors (void)
+{
+#if defined (G_OS_UNIX) && defined (_SC_NPROCESSORS_ONLN)
+  long n = sysconf (_SC_NPROCESSORS_ONLN);
+
+  if (n > 0)
+    return (gint)n;
+#endif
+  return 1;
+}
+
+b2TaskScheduler *
+_clutter_box2d_get_task_scheduler (void)
+{
+  static __ClutterBox2DTaskScheduler *scheduler = NULL;
+  static gboolean initialized = FALSE;
+  G_LOCK_DEFINE_STATIC (scheduler);
+
+  /* Worker threads can only be used once the application set up GThread */
+  if (!g_thread_supported ())
+    return NULL;
+
+  G_LOCK (scheduler);
+  if (!initialized)
+    {
+      gint n_processors = clutter_box2d_get_n_processors ();
+
+      if (n_processors > 1)
+        scheduler = new __ClutterBox2DTaskScheduler (n_processors);
+      initialized = TRUE;
+    }
+  G_UNLOCK (scheduler);
+
+  return scheduler;
+}
@@ -0,0 +1,37 @@
+/*
+ * This file implements the header for the C++ class used to run
+ * Box2D tasks on a GThreadPool.
+ *
+ * Licensed under the LGPL v2 or greater.
+ */
+#ifndef __clutter_box2d_scheduler_h__
+#define __clutter_box2d_scheduler_h__
+
+#include <glib.h>
+#include "Box2D.h"         /* b2TaskScheduler */
+
+class __ClutterBox2DTaskScheduler : public b2TaskScheduler
+{
+private:
+  GThreadPool *m_pool;
+  gint         m_n_threads;
+  GPrivate    *m_thread_index;
+  gint         m_next_thread_index;
+
+  static void worker (gpointer data, gpointer user_data);
+  gint        get_thread_index ();
+
+public:
+  __ClutterBox2DTaskScheduler(gint n_threads);
+  ~__ClutterBox2DTaskScheduler();
+  int32 GetThreadCount() const;
+  void ParallelFor(b2TaskGroup* group, b2Task* task, int32 count, int32 minRange);
+  void Wait(b2TaskGroup* group);
+};
+
+/* The scheduler shared by all the ClutterBox2D worlds of the process, or
+ * NULL when GThread is not initialized or there is only one processor.
+ */
+b2TaskScheduler *_clutter_box2d_get_task_scheduler (void);
+
+#endif
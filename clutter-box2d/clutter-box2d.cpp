@@ -16,6 +16,7 @@
 #include "clutter-box2d.h"
 #include "clutter-box2d-child.h"
 #include "clutter-box2d-contact.h"
+#include "clutter-box2d-scheduler.h"
 #include "clutter-box2d-private.h"
 #include "math.h"
 
@@ -39,7 +40,11 @@ enum
   PROP_SCALE_FACTOR,
   PROP_TIME_STEP,
   PROP_ITERATIONS,
-  PROP_SIMULATE_INACTIVE
+  PROP_SIMULATE_INACTIVE,
+  PROP_THREADED,
+  PROP_PIPELINED,
+  PROP_LOD_INTERVAL,
+  PROP_SUB_STEPPING
 };
 
 static GObject * clutter_box2d_constructor (GType                  type,
@@ -48,6 +53,11 @@ static GObject * clutter_box2d_constructor (GType                  type,
 static void      clutter_box2d_dispose     (GObject               *object);
 
 static gboolean  clutter_box2d_iterate     (ClutterBox2D          *box2d);
+static gpointer  clutter_box2d_thread_func (gpointer               data);
+
+static void      clutter_box2d_coordinator_add    (ClutterBox2D *box2d);
+static void      clutter_box2d_coordinator_remove (ClutterBox2D *box2d);
+static void      clutter_box2d_join_step          (ClutterBox2D *box2d);
 
 ClutterBox2DChild *
 clutter_box2d_get_child (ClutterBox2D *box2d,
@@ -62,24 +72,356 @@ clutter_box2d_get_child (ClutterBox2D *box2d,
   return CLUTTER_BOX2D_CHILD (meta);
 }
 
+/* Whether the default iteration can be split up and stepped together
+ * with the other boxes of the process, see the coordinator below.
+ */
+static gboolean
+can_coordinate (ClutterBox2D *self)
+{
+  return !self->priv->threaded &&
+    CLUTTER_BOX2D_GET_CLASS (self)->iterate == clutter_box2d_real_iterate;
+}
+
+static gboolean
+is_simulating (ClutterBox2D *self)
+{
+  return self->priv->iterate_id || self->priv->coordinated;
+}
+
 static void
 start_simulation (ClutterBox2D *self)
 {
-  if (!self->priv->iterate_id)
+  if (can_coordinate (self))
+    {
+      if (!self->priv->coordinated)
+        clutter_box2d_coordinator_add (self);
+    }
+  else if (!self->priv->iterate_id)
     self->priv->iterate_id =
       g_timeout_add_full (CLUTTER_PRIORITY_REDRAW, self->priv->time_step,
                           (GSourceFunc)clutter_box2d_iterate,
                           self, NULL);
+
+  if (self->priv->threaded && !self->priv->thread)
+    self->priv->thread = g_thread_create (clutter_box2d_thread_func,
+                                          self, TRUE, NULL);
 }
 
 static void
 stop_simulation (ClutterBox2D *self)
 {
-  if (self->priv->iterate_id)
+  ClutterBox2DPrivate *priv = self->priv;
+
+  if (priv->iterate_id)
+    {
+      g_source_remove (priv->iterate_id);
+      priv->iterate_id = 0;
+    }
+
+  if (priv->coordinated)
+    clutter_box2d_coordinator_remove (self);
+
+  clutter_box2d_join_step (self);
+
+  if (priv->thread)
+    {
+      g_mutex_lock (priv->world_lock);
+      priv->thread_quit = TRUE;
+      g_cond_signal (priv->world_cond);
+      g_mutex_unlock (priv->world_lock);
+
+      g_thread_join (priv->thread);
+      priv->thread = NULL;
+      priv->thread_quit = FALSE;
+    }
+}
+
+static void
+clutter_box2d_apply_command (ClutterBox2DCommand *command)
+{
+  switch (command->type)
+    {
+    case CLUTTER_BOX2D_COMMAND_LINEAR_VELOCITY:
+      ((b2Body *)command->object)->SetLinearVelocity (command->value);
+      break;
+
+    case CLUTTER_BOX2D_COMMAND_ANGULAR_VELOCITY:
+      ((b2Body *)command->object)->SetAngularVelocity (command->value.x);
+      break;
+
+    case CLUTTER_BOX2D_COMMAND_MOUSE_TARGET:
+      ((b2MouseJoint *)command->object)->SetTarget (command->value);
+      break;
+
+    case CLUTTER_BOX2D_COMMAND_LINEAR_IMPULSE:
+      {
+        b2Body *body = (b2Body *)command->object;
+        body->ApplyLinearImpulse (command->value, body->GetWorldCenter ());
+      }
+      break;
+
+    case CLUTTER_BOX2D_COMMAND_FORCE:
+      {
+        b2Body *body = (b2Body *)command->object;
+        body->ApplyForce (command->value, body->GetWorldCenter ());
+      }
+      break;
+    }
+}
+
+/* Applies the commands queued by the main thread, must be called with
+ * the world lock held.
+ */
+static void
+clutter_box2d_flush_commands (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  ClutterBox2DCommand *command;
+
+  g_mutex_lock (priv->commands_lock);
+  while ((command = (ClutterBox2DCommand *)g_queue_pop_head (&priv->commands)))
+    {
+      clutter_box2d_apply_command (command);
+      g_slice_free (ClutterBox2DCommand, command);
+    }
+  g_mutex_unlock (priv->commands_lock);
+}
+
+/* Applies the commands of the bulk calls in the order they were made,
+ * right before a step.
+ */
+static void
+clutter_box2d_flush_bulk_commands (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  ClutterBox2DCommand *commands;
+  guint                i;
+
+  if (priv->commands_lock)
+    g_mutex_lock (priv->commands_lock);
+
+  commands = (ClutterBox2DCommand *)priv->bulk_commands->data;
+  for (i = 0; i < priv->bulk_commands->len; i++)
+    clutter_box2d_apply_command (&commands[i]);
+  g_array_set_size (priv->bulk_commands, 0);
+
+  if (priv->commands_lock)
+    g_mutex_unlock (priv->commands_lock);
+}
+
+/* Drops the bulk commands for a body that is about to be destroyed */
+void
+_clutter_box2d_purge_bulk_commands (ClutterBox2D *box2d,
+                                    b2Body       *body)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  ClutterBox2DCommand *commands;
+  guint                i, n;
+
+  if (!priv->bulk_commands)
+    return;
+
+  if (priv->commands_lock)
+    g_mutex_lock (priv->commands_lock);
+
+  commands = (ClutterBox2DCommand *)priv->bulk_commands->data;
+  for (i = 0, n = 0; i < priv->bulk_commands->len; i++)
+    if (commands[i].object != body)
+      commands[n++] = commands[i];
+  g_array_set_size (priv->bulk_commands, n);
+
+  if (priv->commands_lock)
+    g_mutex_unlock (priv->commands_lock);
+}
+
+/* Takes the world lock when the simulation is threaded, blocking until
+ * the simulation thread finishes its current step. Nests, so internal
+ * helpers can lock regardless of whether their caller already has.
+ */
+void
+_clutter_box2d_lock_world (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+
+  if (!priv->world_lock)
+    return;
+
+  if (priv->world_lock_depth++ == 0)
+    {
+      g_mutex_lock (priv->world_lock);
+
+      /* Changes made under the lock must not be overtaken by
+       * earlier queued ones */
+      clutter_box2d_flush_commands (box2d);
+    }
+}
+
+void
+_clutter_box2d_unlock_world (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+
+  if (!priv->world_lock)
+    return;
+
+  if (--priv->world_lock_depth == 0)
+    g_mutex_unlock (priv->world_lock);
+}
+
+/* Queues a command to be applied by the simulation thread at the start
+ * of its next step. Returns FALSE when there is no simulation thread or
+ * the world is already locked, in which case the caller should apply the
+ * change directly.
+ */
+gboolean
+_clutter_box2d_queue_command (ClutterBox2D            *box2d,
+                              ClutterBox2DCommandType  type,
+                              gpointer                 object,
+                              const b2Vec2            &value)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  ClutterBox2DCommand *command;
+
+  if ((!priv->thread && !priv->step_pending) || priv->world_lock_depth)
+    return FALSE;
+
+  command = g_slice_new (ClutterBox2DCommand);
+  command->type = type;
+  command->object = object;
+  command->value = value;
+
+  g_mutex_lock (priv->commands_lock);
+  g_queue_push_tail (&priv->commands, command);
+  g_mutex_unlock (priv->commands_lock);
+
+  return TRUE;
+}
+
+static gint
+atomic_int_exchange (volatile gint *atomic,
+                     gint           newval)
+{
+  gint oldval;
+
+  do
+    oldval = g_atomic_int_get (atomic);
+  while (!g_atomic_int_compare_and_exchange (atomic, oldval, newval));
+
+  return oldval;
+}
+
+/* Records the transform of every body into the back snapshot and swaps
+ * it into the ready slot for the main thread to pick up.
+ */
+static void
+clutter_box2d_publish_snapshot (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate  *priv = box2d->priv;
+  ClutterBox2DSnapshot *snapshot = &priv->snapshots[priv->snapshot_back];
+  b2Body               *body;
+
+  g_array_set_size (snapshot->transforms, 0);
+  snapshot->serial = priv->snapshot_serial;
+
+  for (body = priv->world->GetBodyList (); body; body = body->GetNext ())
+    {
+      ClutterBox2DTransform transform;
+
+      if (body->GetType () == b2_staticBody || !body->GetUserData ())
+        continue;
+
+      transform.child = (ClutterBox2DChild *)body->GetUserData ();
+      transform.x = body->GetPosition ().x;
+      transform.y = body->GetPosition ().y;
+      transform.angle = body->GetAngle ();
+      g_array_append_val (snapshot->transforms, transform);
+    }
+
+  priv->snapshot_back =
+    atomic_int_exchange (&priv->snapshot_ready,
+                         priv->snapshot_back | CLUTTER_BOX2D_SNAPSHOT_FRESH) &
+    CLUTTER_BOX2D_SNAPSHOT_INDEX;
+}
+
+/* Turns the sensor events of the last step into actors, to be emitted by
+ * the next iteration. Called right after every step, by whichever thread
+ * stepped.
+ */
+static void
+clutter_box2d_collect_sensor_events (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate  *priv = box2d->priv;
+  const b2SensorEvent  *events = priv->world->GetSensorEvents ();
+  gint                  n_events = priv->world->GetSensorEventCount ();
+  gint                  i;
+
+  for (i = 0; i < n_events; i++)
+    {
+      ClutterBox2DChild *sensor, *other;
+      ClutterBox2DSensorEvent event;
+
+      sensor = (ClutterBox2DChild *) events[i].sensor->GetUserData ();
+      other = (ClutterBox2DChild *) events[i].fixture->GetBody ()->GetUserData ();
+      if (!sensor || !other)
+        continue;
+
+      if (!priv->sensor_events)
+        priv->sensor_events = g_array_new (FALSE, FALSE,
+                                           sizeof (ClutterBox2DSensorEvent));
+
+      event.sensor = CLUTTER_CHILD_META (sensor)->actor;
+      event.actor = CLUTTER_CHILD_META (other)->actor;
+      event.enter = events[i].begin;
+      g_array_append_val (priv->sensor_events, event);
+    }
+}
+
+static gpointer
+clutter_box2d_thread_func (gpointer data)
+{
+  ClutterBox2D        *box2d = CLUTTER_BOX2D (data);
+  ClutterBox2DPrivate *priv = box2d->priv;
+  GTimeVal             deadline;
+
+  g_mutex_lock (priv->world_lock);
+
+  g_get_current_time (&deadline);
+
+  while (!priv->thread_quit)
     {
-      g_source_remove (self->priv->iterate_id);
-      self->priv->iterate_id = 0;
+      GTimeVal now;
+      glong    step_usec = priv->time_step * 1000;
+
+      g_time_val_add (&deadline, step_usec);
+
+      /* Don't try to catch up on steps lost to a busy machine */
+      g_get_current_time (&now);
+      if ((now.tv_sec - deadline.tv_sec) * G_USEC_PER_SEC +
+          (now.tv_usec - deadline.tv_usec) > step_usec * 4)
+        deadline = now;
+
+      /* The lock is released while waiting, this is when the main
+       * thread gets to change the world */
+      while (!priv->thread_quit &&
+             g_cond_timed_wait (priv->world_cond, priv->world_lock, &deadline))
+        ;
+
+      if (priv->thread_quit)
+        break;
+
+      clutter_box2d_flush_commands (box2d);
+      clutter_box2d_flush_bulk_commands (box2d);
+
+      priv->world->Step (priv->time_step / 1000.f,
+                         priv->iterations, priv->iterations);
+
+      clutter_box2d_collect_sensor_events (box2d);
+      clutter_box2d_publish_snapshot (box2d);
     }
+
+  g_mutex_unlock (priv->world_lock);
+
+  return NULL;
 }
 
 static void
@@ -123,9 +465,12 @@ clutter_box2d_set_property (GObject      *gobject,
         gfloat time_step = g_value_get_float (value);
         if (box2d->priv->time_step != time_step)
           {
-            box2d->priv->time_step = time_step;
+            gboolean simulating = is_simulating (box2d);
+
             stop_simulation (box2d);
-            start_simulation (box2d);
+            box2d->priv->time_step = time_step;
+            if (simulating)
+              start_simulation (box2d);
             g_object_notify (gobject, "time-step");
           }
       }
@@ -135,7 +480,9 @@ clutter_box2d_set_property (GObject      *gobject,
         gint iterations = g_value_get_int (value);
         if (box2d->priv->iterations != iterations)
           {
+            _clutter_box2d_lock_world (box2d);
             box2d->priv->iterations = iterations;
+            _clutter_box2d_unlock_world (box2d);
             g_object_notify (gobject, "iterations");
           }
       }
@@ -145,6 +492,18 @@ clutter_box2d_set_property (GObject      *gobject,
         box2d->priv->simulate_inactive = g_value_get_boolean (value);
       }
       break;
+    case PROP_THREADED:
+      clutter_box2d_set_threaded (box2d, g_value_get_boolean (value));
+      break;
+    case PROP_PIPELINED:
+      clutter_box2d_set_pipelined (box2d, g_value_get_boolean (value));
+      break;
+    case PROP_LOD_INTERVAL:
+      clutter_box2d_set_lod_interval (box2d, g_value_get_int (value));
+      break;
+    case PROP_SUB_STEPPING:
+      clutter_box2d_set_sub_stepping (box2d, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -189,6 +548,22 @@ clutter_box2d_get_property (GObject    *gobject,
       g_value_set_boolean (value, box2d->priv->simulate_inactive);
       break;
 
+    case PROP_THREADED:
+      g_value_set_boolean (value, box2d->priv->threaded);
+      break;
+
+    case PROP_PIPELINED:
+      g_value_set_boolean (value, box2d->priv->pipelined);
+      break;
+
+    case PROP_LOD_INTERVAL:
+      g_value_set_int (value, box2d->priv->lod_interval);
+      break;
+
+    case PROP_SUB_STEPPING:
+      g_value_set_boolean (value, clutter_box2d_get_sub_stepping (box2d));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -210,6 +585,11 @@ clutter_box2d_constructed (GObject *gobject)
    */
   priv->world = new b2World (b2Vec2 (0.0f, 9.8f), !priv->simulate_inactive);
 
+  /* Spread the narrow-phase over the shared thread pool when the
+   * application has initialized threads.
+   */
+  priv->world->SetTaskScheduler (_clutter_box2d_get_task_scheduler ());
+
   priv->contact_listener = (_ClutterBox2DContactListener *)
     new __ClutterBox2DContactListener (self);
 
@@ -282,6 +662,38 @@ clutter_box2d_class_init (ClutterBox2DClass *klass)
                                                          "Whether to simulate inactive bodies",
                                                          TRUE,
                                                          static_cast<GParamFlags>(G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY)));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_THREADED,
+                                   g_param_spec_boolean ("threaded",
+                                                         "Threaded",
+                                                         "Whether the simulation is stepped in a separate thread",
+                                                         FALSE,
+                                                         static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_PIPELINED,
+                                   g_param_spec_boolean ("pipelined",
+                                                         "Pipelined",
+                                                         "Whether the next step runs while the stage is painted",
+                                                         FALSE,
+                                                         static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_LOD_INTERVAL,
+                                   g_param_spec_int ("lod-interval",
+                                                     "LOD interval",
+                                                     "The number of steps between steps of children that aren't visible",
+                                                     1, G_MAXINT, 4,
+                                                     static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_SUB_STEPPING,
+                                   g_param_spec_boolean ("sub-stepping",
+                                                         "Sub-stepping",
+                                                         "Whether contacts are solved softly in sub-steps of each physics step",
+                                                         FALSE,
+                                                         static_cast<GParamFlags>(G_PARAM_READWRITE)));
 }
 
 static void
@@ -296,12 +708,17 @@ clutter_box2d_init (ClutterBox2D *self)
   priv->iterations = 10;
   priv->time_step  = 1000 / 60.f;
   priv->simulate_inactive = TRUE;
+  priv->lod_interval = 4;
 
   priv->scale_factor     = 1/50.f;
   priv->inv_scale_factor = 1.f / priv->scale_factor;
 
   priv->actors = g_hash_table_new (g_direct_hash, g_direct_equal);
   priv->bodies = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  g_queue_init (&priv->commands);
+  priv->bulk_commands = g_array_new (FALSE, FALSE,
+                                     sizeof (ClutterBox2DCommand));
 }
 
 ClutterActor *
@@ -332,6 +749,11 @@ clutter_box2d_dispose (GObject *object)
   G_OBJECT_CLASS (clutter_box2d_parent_class)->dispose (object);
 
   stop_simulation (self);
+  clutter_box2d_set_threaded (self, FALSE);
+  clutter_box2d_set_pipelined (self, FALSE);
+
+  while (priv->fields)
+    clutter_box2d_field_destroy ((ClutterBox2DField *) priv->fields->data);
 
   if (priv->actors)
     {
@@ -349,6 +771,34 @@ clutter_box2d_dispose (GObject *object)
       delete (__ClutterBox2DContactListener *)priv->contact_listener;
       priv->contact_listener = NULL;
     }
+
+  if (priv->sensor_events)
+    {
+      g_array_free (priv->sensor_events, TRUE);
+      priv->sensor_events = NULL;
+    }
+
+  if (priv->bulk_commands)
+    {
+      g_array_free (priv->bulk_commands, TRUE);
+      priv->bulk_commands = NULL;
+    }
+
+  /* The children are gone, so the broad-phase has no more use for the
+   * tree nodes of loaded scenes */
+  while (priv->scene_files)
+    {
+      g_mapped_file_unref ((GMappedFile *) priv->scene_files->data);
+      priv->scene_files = g_list_delete_link (priv->scene_files,
+                                              priv->scene_files);
+    }
+
+  /* Regions streamed out are dropped along with the rest of the scene */
+  if (priv->regions)
+    {
+      _clutter_box2d_regions_free (priv->regions);
+      priv->regions = NULL;
+    }
 }
 
 
@@ -384,10 +834,14 @@ clutter_box2d_destroy_child_meta (ClutterContainer *box2d,
   ClutterBox2DPrivate *priv = CLUTTER_BOX2D (box2d)->priv;
   b2Body *body = box2d_child->priv->body;
 
+  _clutter_box2d_lock_world (CLUTTER_BOX2D (box2d));
+
   g_object_unref (box2d_child);
 
   g_hash_table_remove (priv->actors, actor);
   g_hash_table_remove (priv->bodies, body);
+
+  _clutter_box2d_unlock_world (CLUTTER_BOX2D (box2d));
 }
 
 static ClutterChildMeta *
@@ -410,8 +864,8 @@ static void clutter_container_iface_init (ClutterContainerIface *iface)
 /* make sure that the shape attached to the body matches the clutter realms
  * idea of the shape.
  */
-static inline void
-ensure_shape (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
+void
+_clutter_box2d_ensure_shape (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
 {
   ClutterBox2DPrivate *priv = box2d->priv;
 
@@ -421,20 +875,41 @@ ensure_shape (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
       box2d_child->priv->body->DestroyFixture (box2d_child->priv->fixture);
       box2d_child->priv->fixture = NULL;
     }
+  if (priv->dirty && box2d_child->priv->sensor)
+    {
+      priv->world->DestroySensor (box2d_child->priv->sensor);
+      box2d_child->priv->sensor = NULL;
+    }
 
-  if (box2d_child->priv->fixture == NULL)
+  if (box2d_child->priv->fixture == NULL &&
+      box2d_child->priv->sensor == NULL)
     {
       gfloat width, height;
       b2Shape *shape;
       b2FixtureDef fixture;
+      b2SensorDef sensor;
+      b2Filter filter;
       b2CircleShape circle;
       b2PolygonShape polygon;
       ClutterChildMeta *meta = CLUTTER_CHILD_META (box2d_child);
 
       clutter_actor_get_size (meta->actor, &width, &height);
 
+      filter.categoryBits = box2d_child->priv->category_bits;
+      filter.maskBits = box2d_child->priv->mask_bits;
+      filter.groupIndex = box2d_child->priv->group_index;
+
+      /* Kept for writing the transform back without asking the actor */
+      box2d_child->priv->synced = FALSE;
+      box2d_child->priv->radius = 0;
+      box2d_child->priv->centre_x = 0;
+      box2d_child->priv->centre_y = 0;
+
       if (box2d_child->priv->is_circle)
         {
+          box2d_child->priv->radius = MIN (width, height) / 2.f;
+          box2d_child->priv->centre_x = width / 2.f;
+          box2d_child->priv->centre_y = height / 2.f;
 
           circle.m_radius = MIN (width, height) * 0.5 * priv->scale_factor;
           shape = &circle;
@@ -460,10 +935,24 @@ ensure_shape (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
           shape = &polygon;
         }
 
+      /* A sensor only reports what overlaps it, so it doesn't need a
+       * fixture */
+      if (box2d_child->priv->is_sensor)
+        {
+          sensor.shape = shape;
+          sensor.body = box2d_child->priv->body;
+          sensor.userData = box2d_child;
+          sensor.filter = filter;
+
+          box2d_child->priv->sensor = priv->world->CreateSensor (&sensor);
+          return;
+        }
+
       fixture.shape = shape;
       fixture.friction = box2d_child->priv->friction;
       fixture.density = box2d_child->priv->density;
       fixture.restitution = box2d_child->priv->restitution;
+      fixture.filter = filter;
 
       box2d_child->priv->fixture =
         box2d_child->priv->body->CreateFixture (&fixture);
@@ -486,6 +975,8 @@ _clutter_box2d_sync_body (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
   ClutterActor *actor = CLUTTER_CHILD_META (box2d_child)->actor;
   b2Body       *body  = box2d_child->priv->body;
 
+  box2d_child->priv->synced_changes = box2d_child->priv->changes;
+
   if (!body)
     return;
 
@@ -504,142 +995,713 @@ _clutter_box2d_sync_body (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
       y += radius;
     }
 
-  ensure_shape (box2d, box2d_child);
+  _clutter_box2d_ensure_shape (box2d, box2d_child);
 
   b2Vec2 position = body->GetPosition ();
 
   body->SetTransform (b2Vec2 (x * priv->scale_factor, y * priv->scale_factor),
                       rot / (180 / G_PI));
 
+  /* Snapshots stepped from the old transform would move the actor back */
+  priv->snapshot_serial++;
+
+  /* The actor is written back from the rounded transform */
+  box2d_child->priv->synced = FALSE;
+
   SYNCLOG ("\t setxform: %d, %d, %f\n", x, y, rot);
 }
 
+/* Only the parts of the transform that changed since the last write are
+ * set, so resting bodies cost nothing and turning ones don't queue a
+ * relayout. The notifications of the actor are dispatched once for both.
+ */
 static void
-_clutter_box2d_sync_actor (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
+_clutter_box2d_sync_actor_transform (ClutterBox2D      *box2d,
+                                     ClutterBox2DChild *box2d_child,
+                                     const b2Vec2      &position,
+                                     float32            angle)
 {
-  gdouble rot;
-  gfloat x, y, centre_x, centre_y;
   ClutterBox2DPrivate *priv = box2d->priv;
+  ClutterBox2DChildPrivate *child_priv = box2d_child->priv;
   ClutterActor *actor = CLUTTER_CHILD_META (box2d_child)->actor;
-  b2Body       *body  = box2d_child->priv->body;
+  gboolean moved, turned;
 
-  if (!body)
-    return;
+  moved = !child_priv->synced || !(child_priv->synced_position == position);
+  turned = !child_priv->synced || child_priv->synced_angle != angle;
 
-  ensure_shape (box2d, box2d_child);
+  if (!moved && !turned)
+    return;
 
-  x = body->GetPosition ().x * priv->inv_scale_factor;
-  y = body->GetPosition ().y * priv->inv_scale_factor;
+  g_object_freeze_notify (G_OBJECT (actor));
+  child_priv->syncing = TRUE;
 
-  if (box2d_child->priv->is_circle)
+  if (moved)
     {
-      gfloat width = clutter_actor_get_width (actor);
-      gfloat height = clutter_actor_get_height (actor);
-      gfloat radius = MIN (width, height) / 2.f;
-
-      x -= radius;
-      y -= radius;
+      gfloat x = position.x * priv->inv_scale_factor - child_priv->radius;
+      gfloat y = position.y * priv->inv_scale_factor - child_priv->radius;
 
-      centre_x = width / 2.f;
-      centre_y = height / 2.f;
-    }
-  else
-    {
-      centre_x = 0;
-      centre_y = 0;
+      SYNCLOG ("setting actor position: ' %f %f\n", x, y);
+      clutter_actor_set_position (actor, x, y);
     }
 
-  rot = body->GetAngle () * (180 / G_PI);
+  if (turned)
+    {
+      gdouble rot = angle * (180 / G_PI);
 
-  SYNCLOG ("setting actor position: ' %f %f angle: %lf\n", x, y, rot);
+      SYNCLOG ("setting actor angle: %lf\n", rot);
+      clutter_actor_set_rotation (actor, CLUTTER_Z_AXIS, rot,
+                                  child_priv->centre_x,
+                                  child_priv->centre_y, 0);
+    }
 
-  clutter_actor_set_position (actor, x, y);
-  clutter_actor_set_rotation (actor, CLUTTER_Z_AXIS,
-                              body->GetAngle () * (180 / G_PI),
-                              centre_x, centre_y, 0);
+  g_object_thaw_notify (G_OBJECT (actor));
+  child_priv->syncing = FALSE;
 
-  /* Store the set values to know when to resync the body */
-  box2d_child->priv->old_x = x;
-  box2d_child->priv->old_y = y;
-  box2d_child->priv->old_rot = rot;
+  child_priv->synced = TRUE;
+  child_priv->synced_position = position;
+  child_priv->synced_angle = angle;
 }
 
-static void
-clutter_box2d_real_iterate (ClutterBox2D *box2d)
+void
+_clutter_box2d_sync_actor (ClutterBox2D *box2d, ClutterBox2DChild *box2d_child)
 {
-  ClutterBox2DPrivate *priv = box2d->priv;
-  gint                 steps = priv->iterations;
-  b2World             *world = priv->world;
-  GList               *actors = g_hash_table_get_values (priv->actors);
-  GList *iter;
-
-  /* First we check for each actor the need for, and perform a sync
-   * from the actor to the body, if necessary, before running simulation
-   */
-  for (iter = actors; iter; iter = g_list_next (iter))
-    {
-      gfloat x, y;
-      gdouble rot;
-
-      ClutterBox2DChild *box2d_child = (ClutterBox2DChild*) iter->data;
-      ClutterActor *actor = CLUTTER_CHILD_META (box2d_child)->actor;
+  b2Body *body = box2d_child->priv->body;
 
-      clutter_actor_get_position (actor, &x, &y);
-      rot = clutter_actor_get_rotation (actor, CLUTTER_Z_AXIS,
-                                        NULL, NULL, NULL);
+  if (!body)
+    return;
 
-      if ((box2d_child->priv->old_x != x) ||
-          (box2d_child->priv->old_y != y) ||
-          (box2d_child->priv->old_rot != rot))
-        _clutter_box2d_sync_body (box2d, box2d_child);
-    }
+  _clutter_box2d_ensure_shape (box2d, box2d_child);
 
-  /* Iterate Box2D simulation of bodies */
-  world->Step (priv->time_step / 1000.f, steps, steps);
+  _clutter_box2d_sync_actor_transform (box2d, box2d_child,
+                                       body->GetPosition (),
+                                       body->GetAngle ());
+}
 
-  /* Synchronise actor to have geometrical sync with bodies */
-  for (iter = actors; iter; iter = g_list_next (iter))
-    {
-      ClutterBox2DChild *box2d_child = (ClutterBox2DChild*) iter->data;
-      _clutter_box2d_sync_actor (box2d, box2d_child);
-    }
-  g_list_free (actors);
+static gboolean
+_clutter_box2d_actor_moved (ClutterBox2DChild *box2d_child)
+{
+  return box2d_child->priv->changes != box2d_child->priv->synced_changes;
+}
 
-  /* Reset the 'dirty' flag - all shapes would be recreated by the above
-   * for-loop in the ensure_shape function.
-   */
-  priv->dirty = FALSE;
+/* Process list of collisions and emit signals for any actors with
+ * a registered callback. */
+static void
+clutter_box2d_emit_collisions (ClutterBox2D *box2d,
+                               GList        *collisions)
+{
+  GList *iter;
 
-  /* Process list of collisions and emit signals for any actors with
-   * a registered callback. */
-  for (iter = priv->collisions; iter; iter = g_list_next (iter))
+  for (iter = collisions; iter; iter = g_list_next (iter))
     {
       ClutterBox2DCollision  *collision;
       ClutterBox2DChild      *box2d_child1, *box2d_child2;
-      ClutterBox2DChildClass *klass;
 
       collision = CLUTTER_BOX2D_COLLISION (iter->data);
 
       box2d_child1 = clutter_box2d_get_child (box2d, collision->actor1);
 
       if (box2d_child1)
-        {
-          klass = CLUTTER_BOX2D_CHILD_CLASS (G_OBJECT_GET_CLASS (box2d_child1));
-          g_signal_emit_by_name (box2d_child1, "collision", collision);
-        }
+        g_signal_emit_by_name (box2d_child1, "collision", collision);
 
       box2d_child2 = clutter_box2d_get_child (box2d, collision->actor2);
 
       if (box2d_child2)
-        {
-          klass = CLUTTER_BOX2D_CHILD_CLASS (G_OBJECT_GET_CLASS (box2d_child2));
-          g_signal_emit_by_name (box2d_child2, "collision", collision);
-        }
+        g_signal_emit_by_name (box2d_child2, "collision", collision);
 
       g_object_unref (collision);
     }
-  g_list_free (priv->collisions);
+  g_list_free (collisions);
+}
+
+/* Emits the "enter" and "leave" signals of sensor children, in the order
+ * of the steps. Actors removed by a handler are skipped. */
+static void
+clutter_box2d_emit_sensor_events (ClutterBox2D *box2d,
+                                  GArray       *events)
+{
+  guint i;
+
+  if (!events)
+    return;
+
+  for (i = 0; i < events->len; i++)
+    {
+      ClutterBox2DSensorEvent *event =
+        &g_array_index (events, ClutterBox2DSensorEvent, i);
+      ClutterBox2DChild *box2d_child;
+
+      box2d_child = clutter_box2d_get_child (box2d, event->sensor);
+      if (!box2d_child || !clutter_box2d_get_child (box2d, event->actor))
+        continue;
+
+      g_signal_emit_by_name (box2d_child, event->enter ? "enter" : "leave",
+                             event->actor);
+    }
+  g_array_free (events, TRUE);
+}
+
+/* Drops the pending sensor events of an actor that is being removed */
+void
+_clutter_box2d_purge_sensor_events (ClutterBox2D *box2d,
+                                    ClutterActor *actor)
+{
+  GArray *events = box2d->priv->sensor_events;
+  guint i;
+
+  if (!events)
+    return;
+
+  for (i = events->len; i > 0; i--)
+    {
+      ClutterBox2DSensorEvent *event =
+        &g_array_index (events, ClutterBox2DSensorEvent, i - 1);
+
+      if (event->sensor == actor || event->actor == actor)
+        g_array_remove_index (events, i - 1);
+    }
+}
+
+void
+_clutter_box2d_child_set_hidden (ClutterBox2D      *box2d,
+                                 ClutterBox2DChild *box2d_child,
+                                 gboolean           hidden)
+{
+  ClutterBox2DChildPrivate *priv = box2d_child->priv;
+  b2Body *body = priv->body;
+
+  if (!body)
+    return;
+
+  switch (priv->lod)
+    {
+    case CLUTTER_BOX2D_LOD_REDUCE:
+      body->SetStepInterval (hidden ? box2d->priv->lod_interval : 1);
+      break;
+
+    case CLUTTER_BOX2D_LOD_SLEEP:
+      if (hidden)
+        {
+          if (!priv->lod_hidden)
+            {
+              priv->lod_linear_velocity.SetZero ();
+              priv->lod_angular_velocity = 0;
+            }
+
+          /* Also when woken by a collision since */
+          if (body->IsAwake ())
+            {
+              priv->lod_linear_velocity = body->GetLinearVelocity ();
+              priv->lod_angular_velocity = body->GetAngularVelocity ();
+              body->SetAwake (false);
+            }
+        }
+      else if (priv->lod_hidden)
+        {
+          body->SetAwake (true);
+          body->SetLinearVelocity (priv->lod_linear_velocity);
+          body->SetAngularVelocity (priv->lod_angular_velocity);
+        }
+      break;
+
+    default:
+      break;
+    }
+
+  priv->lod_hidden = hidden;
+}
+
+/* Gets the part of the stage the children can be seen in, in stage
+ * coordinates */
+static gboolean
+clutter_box2d_get_visible_box (ClutterBox2D    *box2d,
+                               ClutterActorBox *box)
+{
+  ClutterActor *stage = clutter_actor_get_stage (CLUTTER_ACTOR (box2d));
+  ClutterActor *actor;
+
+  if (!stage)
+    return FALSE;
+
+  box->x1 = 0;
+  box->y1 = 0;
+  clutter_actor_get_size (stage, &box->x2, &box->y2);
+
+  for (actor = CLUTTER_ACTOR (box2d); actor && actor != stage;
+       actor = clutter_actor_get_parent (actor))
+    {
+      ClutterVertex corners[4], point;
+      gfloat x, y, width, height;
+      gint i;
+
+      if (!clutter_actor_has_clip (actor))
+        continue;
+
+      clutter_actor_get_clip (actor, &x, &y, &width, &height);
+      for (i = 0; i < 4; i++)
+        {
+          point.x = (i & 1) ? x + width : x;
+          point.y = (i & 2) ? y + height : y;
+          point.z = 0;
+          clutter_actor_apply_transform_to_point (actor, &point, &corners[i]);
+        }
+
+      box->x1 = MAX (box->x1, MIN (MIN (corners[0].x, corners[1].x),
+                                   MIN (corners[2].x, corners[3].x)));
+      box->y1 = MAX (box->y1, MIN (MIN (corners[0].y, corners[1].y),
+                                   MIN (corners[2].y, corners[3].y)));
+      box->x2 = MIN (box->x2, MAX (MAX (corners[0].x, corners[1].x),
+                                   MAX (corners[2].x, corners[3].x)));
+      box->y2 = MIN (box->y2, MAX (MAX (corners[0].y, corners[1].y),
+                                   MAX (corners[2].y, corners[3].y)));
+    }
+
+  return box->x1 < box->x2 && box->y1 < box->y2;
+}
+
+static gboolean
+clutter_box2d_actor_is_visible (ClutterActor          *actor,
+                                const ClutterActorBox *visible)
+{
+  ClutterVertex verts[4];
+  gfloat x1, y1, x2, y2;
+  gint i;
+
+  if (!CLUTTER_ACTOR_IS_MAPPED (actor))
+    return FALSE;
+
+  clutter_actor_get_abs_allocation_vertices (actor, verts);
+  x1 = x2 = verts[0].x;
+  y1 = y2 = verts[0].y;
+  for (i = 1; i < 4; i++)
+    {
+      x1 = MIN (x1, verts[i].x);
+      y1 = MIN (y1, verts[i].y);
+      x2 = MAX (x2, verts[i].x);
+      y2 = MAX (y2, verts[i].y);
+    }
+
+  return x2 >= visible->x1 && x1 <= visible->x2 &&
+         y2 >= visible->y1 && y1 <= visible->y2;
+}
+
+/* Applies the level of detail policies of the children for the next step */
+static void
+clutter_box2d_update_lod (ClutterBox2D *box2d,
+                          GList        *actors)
+{
+  ClutterActorBox visible;
+  gboolean        have_visible = FALSE;
+  gboolean        on_stage = FALSE;
+  GList          *iter;
+
+  for (iter = actors; iter; iter = g_list_next (iter))
+    {
+      ClutterBox2DChild *box2d_child = (ClutterBox2DChild*) iter->data;
+      ClutterActor *actor = CLUTTER_CHILD_META (box2d_child)->actor;
+
+      if (box2d_child->priv->lod == CLUTTER_BOX2D_LOD_NONE ||
+          !box2d_child->priv->body)
+        continue;
+
+      /* Only worked out when some child has a policy */
+      if (!have_visible)
+        {
+          on_stage = clutter_box2d_get_visible_box (box2d, &visible);
+          have_visible = TRUE;
+        }
+
+      _clutter_box2d_child_set_hidden (box2d, box2d_child, !on_stage ||
+        !clutter_box2d_actor_is_visible (actor, &visible));
+    }
+}
+
+/* The iteration when a thread is doing the stepping; this only feeds
+ * actor changes to the world when it can do so without waiting for the
+ * thread, and moves the actors to the latest published snapshot.
+ */
+static void
+clutter_box2d_threaded_iterate (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  GList               *actors = g_hash_table_get_values (priv->actors);
+  GList               *collisions = NULL;
+  GArray              *sensor_events = NULL;
+  GList               *iter;
+
+  if (g_mutex_trylock (priv->world_lock))
+    {
+      priv->world_lock_depth++;
+      clutter_box2d_flush_commands (box2d);
+
+      for (iter = actors; iter; iter = g_list_next (iter))
+        {
+          ClutterBox2DChild *box2d_child = (ClutterBox2DChild*) iter->data;
+
+          if (priv->dirty && box2d_child->priv->body)
+            _clutter_box2d_ensure_shape (box2d, box2d_child);
+
+          if (_clutter_box2d_actor_moved (box2d_child))
+            _clutter_box2d_sync_body (box2d, box2d_child);
+        }
+      priv->dirty = FALSE;
+
+      g_list_foreach (priv->particles,
+                      (GFunc) _clutter_box2d_particles_sync, NULL);
+
+      clutter_box2d_update_lod (box2d, actors);
+
+      collisions = priv->collisions;
+      priv->collisions = NULL;
+      sensor_events = priv->sensor_events;
+      priv->sensor_events = NULL;
+
+      priv->world_lock_depth--;
+      g_mutex_unlock (priv->world_lock);
+    }
+  g_list_free (actors);
+
+  if (g_atomic_int_get (&priv->snapshot_ready) & CLUTTER_BOX2D_SNAPSHOT_FRESH)
+    {
+      ClutterBox2DSnapshot *snapshot;
+      guint                 i;
+
+      priv->snapshot_front =
+        atomic_int_exchange (&priv->snapshot_ready, priv->snapshot_front) &
+        CLUTTER_BOX2D_SNAPSHOT_INDEX;
+      snapshot = &priv->snapshots[priv->snapshot_front];
+
+      /* Snapshots stepped before bodies were moved or destroyed by
+       * the main thread are dropped */
+      if (snapshot->serial == priv->snapshot_serial)
+        for (i = 0; i < snapshot->transforms->len; i++)
+          {
+            ClutterBox2DTransform *transform =
+              &g_array_index (snapshot->transforms, ClutterBox2DTransform, i);
+
+            /* Moved by the application, but not synced yet */
+            if (_clutter_box2d_actor_moved (transform->child))
+              continue;
+
+            _clutter_box2d_sync_actor_transform (box2d, transform->child,
+                                                 b2Vec2 (transform->x,
+                                                         transform->y),
+                                                 transform->angle);
+          }
+    }
+
+  clutter_box2d_emit_collisions (box2d, collisions);
+  clutter_box2d_emit_sensor_events (box2d, sensor_events);
+}
+
+/* The default iteration is split in three so the coordinator can run
+ * the steps of several boxes at once: only clutter_box2d_step may run
+ * outside of the main thread.
+ */
+static void
+clutter_box2d_prepare_step (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  GList               *actors;
+  GList *iter;
+
+  actors = g_hash_table_get_values (priv->actors);
+
+  /* First we check for each actor the need for, and perform a sync
+   * from the actor to the body, if necessary, before running simulation
+   */
+  for (iter = actors; iter; iter = g_list_next (iter))
+    {
+      ClutterBox2DChild *box2d_child = (ClutterBox2DChild*) iter->data;
+
+      if (_clutter_box2d_actor_moved (box2d_child))
+        _clutter_box2d_sync_body (box2d, box2d_child);
+    }
+
+  clutter_box2d_update_lod (box2d, actors);
+  g_list_free (actors);
+}
+
+static void
+clutter_box2d_step (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  gint                 steps = priv->iterations;
+
+  clutter_box2d_flush_bulk_commands (box2d);
+
+  /* Iterate Box2D simulation of bodies */
+  priv->world->Step (priv->time_step / 1000.f, steps, steps);
+
+  clutter_box2d_collect_sensor_events (box2d);
+}
+
+static void
+clutter_box2d_finish_step (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  GList               *actors;
+  GArray              *sensor_events;
+  GList *iter;
+
+  actors = g_hash_table_get_values (priv->actors);
+
+  /* Synchronise actor to have geometrical sync with bodies */
+  for (iter = actors; iter; iter = g_list_next (iter))
+    {
+      ClutterBox2DChild *box2d_child = (ClutterBox2DChild*) iter->data;
+      _clutter_box2d_sync_actor (box2d, box2d_child);
+    }
+  g_list_free (actors);
+
+  g_list_foreach (priv->particles, (GFunc) _clutter_box2d_particles_sync, NULL);
+
+  /* Reset the 'dirty' flag - all shapes would be recreated by the above
+   * for-loop in the ensure_shape function.
+   */
+  priv->dirty = FALSE;
+
+  iter = priv->collisions;
   priv->collisions = NULL;
+  clutter_box2d_emit_collisions (box2d, iter);
+
+  sensor_events = priv->sensor_events;
+  priv->sensor_events = NULL;
+  clutter_box2d_emit_sensor_events (box2d, sensor_events);
+}
+
+static void
+clutter_box2d_real_iterate (ClutterBox2D *box2d)
+{
+  if (box2d->priv->thread)
+    {
+      clutter_box2d_threaded_iterate (box2d);
+      return;
+    }
+
+  clutter_box2d_prepare_step (box2d);
+  clutter_box2d_step (box2d);
+  clutter_box2d_finish_step (box2d);
+}
+
+/* The coordinator steps all the boxes of the process that use the default
+ * iteration from a single timeout. The boxes due in the same frame have
+ * their steps run in parallel on the shared task scheduler, while syncing
+ * the actors and emitting the collision signals stays on the main thread.
+ */
+typedef struct _ClutterBox2DCoordinator
+{
+  GList  *boxes;     /* The simulating ClutterBox2D */
+  guint   source_id;
+  gfloat  interval;  /* The smallest time-step of the boxes */
+} ClutterBox2DCoordinator;
+
+static ClutterBox2DCoordinator coordinator = { NULL, 0, 0.f };
+
+/* Steps the worlds of an array of ClutterBox2D */
+class ClutterBox2DStepTask : public b2Task
+{
+public:
+  ClutterBox2DStepTask (GPtrArray *boxes) : m_boxes (boxes) {}
+
+  void Execute (int32 begin, int32 end, int32 threadIndex)
+  {
+    int32 i;
+
+    for (i = begin; i < end; i++)
+      clutter_box2d_step (CLUTTER_BOX2D (g_ptr_array_index (m_boxes, i)));
+  }
+
+private:
+  GPtrArray *m_boxes;
+};
+
+static gdouble
+clutter_box2d_get_time (void)
+{
+  GTimeVal now;
+
+  g_get_current_time (&now);
+
+  return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+}
+
+/* Pipelined boxes step on this pool between two ticks of the
+ * coordinator, while the main loop paints the previous step.
+ */
+static GThreadPool *pipeline_pool = NULL;
+
+static void
+clutter_box2d_pipeline_func (gpointer data,
+                             gpointer user_data)
+{
+  ClutterBox2D        *box2d = CLUTTER_BOX2D (data);
+  ClutterBox2DPrivate *priv = box2d->priv;
+
+  g_mutex_lock (priv->world_lock);
+
+  clutter_box2d_flush_commands (box2d);
+  clutter_box2d_step (box2d);
+
+  priv->step_done = TRUE;
+  g_cond_broadcast (priv->world_cond);
+  g_mutex_unlock (priv->world_lock);
+}
+
+static void
+clutter_box2d_kick_step (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+
+  if (!pipeline_pool)
+    pipeline_pool = g_thread_pool_new (clutter_box2d_pipeline_func, NULL,
+                                       -1, FALSE, NULL);
+
+  priv->step_pending = TRUE;
+  priv->step_done = FALSE;
+  g_thread_pool_push (pipeline_pool, box2d, NULL);
+}
+
+/* Waits for the step started by clutter_box2d_kick_step, if any */
+static void
+clutter_box2d_join_step (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+
+  if (!priv->step_pending)
+    return;
+
+  g_mutex_lock (priv->world_lock);
+  while (!priv->step_done)
+    g_cond_wait (priv->world_cond, priv->world_lock);
+  g_mutex_unlock (priv->world_lock);
+
+  priv->step_pending = FALSE;
+}
+
+static gboolean
+clutter_box2d_coordinator_iterate (gpointer data)
+{
+  static b2SerialTaskScheduler serial;
+  b2TaskScheduler *scheduler;
+  GPtrArray       *due, *serial_due;
+  gdouble          now = clutter_box2d_get_time ();
+  GList           *iter;
+  guint            i;
+
+  due = g_ptr_array_new ();
+  serial_due = g_ptr_array_new ();
+
+  for (iter = coordinator.boxes; iter; iter = g_list_next (iter))
+    {
+      ClutterBox2D        *box2d = CLUTTER_BOX2D (iter->data);
+      ClutterBox2DPrivate *priv = box2d->priv;
+
+      /* Allow half a tick of slack, so boxes with the same time-step
+       * always end up in the same frame */
+      if (priv->next_step - now > coordinator.interval / 2.f)
+        continue;
+
+      /* Like a timeout, drop the steps we are too late for */
+      priv->next_step += priv->time_step;
+      if (priv->next_step < now)
+        priv->next_step = now + priv->time_step;
+
+      g_ptr_array_add (due, g_object_ref (box2d));
+
+      /* Pipelined boxes were stepped since the last tick, the others
+       * are stepped now */
+      if (priv->pipelined)
+        clutter_box2d_join_step (box2d);
+      else
+        g_ptr_array_add (serial_due, box2d);
+    }
+
+  for (i = 0; i < due->len; i++)
+    clutter_box2d_prepare_step (CLUTTER_BOX2D (g_ptr_array_index (due, i)));
+
+  scheduler = _clutter_box2d_get_task_scheduler ();
+  if (!scheduler)
+    scheduler = &serial;
+
+  ClutterBox2DStepTask task (serial_due);
+  scheduler->Run (&task, serial_due->len, 1);
+
+  for (i = 0; i < due->len; i++)
+    {
+      ClutterBox2D *box2d = CLUTTER_BOX2D (g_ptr_array_index (due, i));
+
+      /* A collision handler may have destroyed one of the boxes */
+      if (box2d->priv->actors)
+        clutter_box2d_finish_step (box2d);
+    }
+
+  /* The actors now show the results, start on the next step while
+   * the stage is painted */
+  for (i = 0; i < due->len; i++)
+    {
+      ClutterBox2D *box2d = CLUTTER_BOX2D (g_ptr_array_index (due, i));
+
+      if (box2d->priv->pipelined && box2d->priv->coordinated)
+        clutter_box2d_kick_step (box2d);
+
+      g_object_unref (box2d);
+    }
+  g_ptr_array_free (serial_due, TRUE);
+  g_ptr_array_free (due, TRUE);
+
+  return TRUE;
+}
+
+static void
+clutter_box2d_coordinator_update (void)
+{
+  gfloat  interval = 0.f;
+  GList  *iter;
+
+  for (iter = coordinator.boxes; iter; iter = g_list_next (iter))
+    {
+      ClutterBox2D *box2d = CLUTTER_BOX2D (iter->data);
+
+      if (interval == 0.f || box2d->priv->time_step < interval)
+        interval = box2d->priv->time_step;
+    }
+
+  if (coordinator.source_id && interval == coordinator.interval)
+    return;
+
+  if (coordinator.source_id)
+    {
+      g_source_remove (coordinator.source_id);
+      coordinator.source_id = 0;
+    }
+
+  coordinator.interval = interval;
+  if (coordinator.boxes)
+    coordinator.source_id =
+      g_timeout_add_full (CLUTTER_PRIORITY_REDRAW, interval,
+                          clutter_box2d_coordinator_iterate,
+                          NULL, NULL);
+}
+
+static void
+clutter_box2d_coordinator_add (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+
+  priv->coordinated = TRUE;
+  priv->next_step = clutter_box2d_get_time () + priv->time_step;
+
+  coordinator.boxes = g_list_prepend (coordinator.boxes, box2d);
+  clutter_box2d_coordinator_update ();
+}
+
+static void
+clutter_box2d_coordinator_remove (ClutterBox2D *box2d)
+{
+  box2d->priv->coordinated = FALSE;
+
+  coordinator.boxes = g_list_remove (coordinator.boxes, box2d);
+  clutter_box2d_coordinator_update ();
 }
 
 static gboolean
@@ -666,7 +1728,9 @@ clutter_box2d_set_gravity (ClutterBox2D        *box2d,
     {
       b2Vec2 b2gravity = b2Vec2 (gravity->x, gravity->y);
 
+      _clutter_box2d_lock_world (box2d);
       box2d->priv->world->SetGravity (b2gravity);
+      _clutter_box2d_unlock_world (box2d);
 
       g_object_notify (G_OBJECT (box2d), "gravity");
     }
@@ -683,7 +1747,9 @@ clutter_box2d_get_gravity (ClutterBox2D  *box2d,
   if (!gravity)
     return;
 
+  _clutter_box2d_lock_world (box2d);
   b2gravity = box2d->priv->world->GetGravity ();
+  _clutter_box2d_unlock_world (box2d);
 
   gravity->x = b2gravity.x;
   gravity->y = b2gravity.y;
@@ -694,14 +1760,11 @@ void
 clutter_box2d_set_simulating (ClutterBox2D  *box2d,
                               gboolean       simulating)
 {
-  ClutterBox2DPrivate *priv;
   gboolean currently_simulating;
 
   g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
 
-  priv = box2d->priv;
-
-  if (!!simulating == !!priv->iterate_id)
+  if (!!simulating == !!is_simulating (box2d))
     return;
 
   if (simulating)
@@ -715,13 +1778,9 @@ clutter_box2d_set_simulating (ClutterBox2D  *box2d,
 gboolean
 clutter_box2d_get_simulating (ClutterBox2D *box2d)
 {
-  ClutterBox2DPrivate *priv;
-
   g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), FALSE);
 
-  priv = box2d->priv;
-
-  return priv->iterate_id ? TRUE : FALSE;
+  return is_simulating (box2d);
 }
 
 void
@@ -735,9 +1794,12 @@ clutter_box2d_set_scale_factor (ClutterBox2D *box2d,
   priv = box2d->priv;
   if (priv->scale_factor != scale_factor)
     {
+      /* The contact listener converts with the scale in the thread */
+      _clutter_box2d_lock_world (box2d);
       priv->scale_factor = scale_factor;
       priv->inv_scale_factor = 1.f/scale_factor;
       priv->dirty = TRUE;
+      _clutter_box2d_unlock_world (box2d);
       g_object_notify (G_OBJECT (box2d), "scale-factor");
     }
 }
@@ -748,3 +1810,554 @@ clutter_box2d_get_scale_factor (ClutterBox2D *box2d)
   g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), 0.f);
   return box2d->priv->scale_factor;
 }
+
+/* Creates the locks needed when the world is stepped outside of the
+ * main thread, or frees them once it no longer is.
+ */
+static void
+clutter_box2d_update_locks (ClutterBox2D *box2d)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  gboolean             needed = priv->threaded || priv->pipelined;
+
+  if (needed && !priv->world_lock)
+    {
+      if (!g_thread_supported ())
+        g_thread_init (NULL);
+
+      priv->world->SetTaskScheduler (_clutter_box2d_get_task_scheduler ());
+
+      priv->world_lock = g_mutex_new ();
+      priv->world_cond = g_cond_new ();
+      priv->commands_lock = g_mutex_new ();
+    }
+  else if (!needed && priv->world_lock)
+    {
+      /* Nothing steps the world anymore, the queue can go directly */
+      clutter_box2d_flush_commands (box2d);
+
+      g_mutex_free (priv->world_lock);
+      g_cond_free (priv->world_cond);
+      g_mutex_free (priv->commands_lock);
+      priv->world_lock = NULL;
+      priv->world_cond = NULL;
+      priv->commands_lock = NULL;
+    }
+}
+
+void
+clutter_box2d_set_threaded (ClutterBox2D *box2d,
+                            gboolean      threaded)
+{
+  ClutterBox2DPrivate *priv;
+  gboolean simulating;
+  gint i;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+
+  priv = box2d->priv;
+
+  if (!!priv->threaded == !!threaded)
+    return;
+
+  simulating = is_simulating (box2d);
+  stop_simulation (box2d);
+
+  priv->threaded = threaded;
+  clutter_box2d_update_locks (box2d);
+
+  if (threaded)
+    {
+      for (i = 0; i < 3; i++)
+        {
+          priv->snapshots[i].transforms =
+            g_array_new (FALSE, FALSE, sizeof (ClutterBox2DTransform));
+          priv->snapshots[i].serial = 0;
+        }
+      priv->snapshot_ready = 0;
+      priv->snapshot_front = 1;
+      priv->snapshot_back = 2;
+    }
+  else
+    {
+      for (i = 0; i < 3; i++)
+        {
+          g_array_free (priv->snapshots[i].transforms, TRUE);
+          priv->snapshots[i].transforms = NULL;
+        }
+    }
+
+  if (simulating)
+    start_simulation (box2d);
+
+  g_object_notify (G_OBJECT (box2d), "threaded");
+}
+
+gboolean
+clutter_box2d_get_threaded (ClutterBox2D *box2d)
+{
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), FALSE);
+  return box2d->priv->threaded;
+}
+
+void
+clutter_box2d_set_pipelined (ClutterBox2D *box2d,
+                             gboolean      pipelined)
+{
+  ClutterBox2DPrivate *priv;
+  gboolean simulating;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+
+  priv = box2d->priv;
+
+  if (!!priv->pipelined == !!pipelined)
+    return;
+
+  simulating = is_simulating (box2d);
+  stop_simulation (box2d);
+
+  priv->pipelined = pipelined;
+  clutter_box2d_update_locks (box2d);
+
+  if (simulating)
+    start_simulation (box2d);
+
+  g_object_notify (G_OBJECT (box2d), "pipelined");
+}
+
+gboolean
+clutter_box2d_get_pipelined (ClutterBox2D *box2d)
+{
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), FALSE);
+  return box2d->priv->pipelined;
+}
+
+void
+clutter_box2d_set_lod_interval (ClutterBox2D *box2d,
+                                gint          interval)
+{
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (interval >= 1);
+
+  if (box2d->priv->lod_interval == interval)
+    return;
+
+  /* Children that are hidden get the new interval at the next step */
+  box2d->priv->lod_interval = interval;
+  g_object_notify (G_OBJECT (box2d), "lod-interval");
+}
+
+gint
+clutter_box2d_get_lod_interval (ClutterBox2D *box2d)
+{
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), 1);
+  return box2d->priv->lod_interval;
+}
+
+void
+clutter_box2d_set_sub_stepping (ClutterBox2D *box2d,
+                                gboolean      sub_stepping)
+{
+  ClutterBox2DPrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+
+  priv = box2d->priv;
+  sub_stepping = !!sub_stepping;
+  if (priv->world->GetSubStepping () == (bool) sub_stepping)
+    return;
+
+  _clutter_box2d_lock_world (box2d);
+  priv->world->SetSubStepping (sub_stepping);
+  _clutter_box2d_unlock_world (box2d);
+
+  g_object_notify (G_OBJECT (box2d), "sub-stepping");
+}
+
+gboolean
+clutter_box2d_get_sub_stepping (ClutterBox2D *box2d)
+{
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), FALSE);
+  return box2d->priv->world->GetSubStepping ();
+}
+
+gsize
+clutter_box2d_get_state_size (ClutterBox2D *box2d)
+{
+  gsize size;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), 0);
+
+  clutter_box2d_join_step (box2d);
+  _clutter_box2d_lock_world (box2d);
+  size = box2d->priv->world->GetStateSize ();
+  _clutter_box2d_unlock_world (box2d);
+
+  return size;
+}
+
+gboolean
+clutter_box2d_save_state (ClutterBox2D *box2d,
+                          gpointer      buffer,
+                          gsize         size)
+{
+  gint32 saved;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), FALSE);
+  g_return_val_if_fail (buffer != NULL, FALSE);
+
+  clutter_box2d_join_step (box2d);
+  _clutter_box2d_lock_world (box2d);
+  saved = box2d->priv->world->SaveState (buffer, MIN (size, G_MAXINT32));
+  _clutter_box2d_unlock_world (box2d);
+
+  return saved > 0;
+}
+
+gboolean
+clutter_box2d_restore_state (ClutterBox2D  *box2d,
+                             gconstpointer  buffer,
+                             gsize          size)
+{
+  ClutterBox2DPrivate *priv;
+  GList *actors, *iter;
+  gboolean restored;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), FALSE);
+  g_return_val_if_fail (buffer != NULL, FALSE);
+
+  priv = box2d->priv;
+
+  clutter_box2d_join_step (box2d);
+  _clutter_box2d_lock_world (box2d);
+
+  restored = priv->world->RestoreState (buffer, MIN (size, G_MAXINT32));
+
+  if (restored)
+    {
+      /* Collisions of steps that have been rolled back never happened */
+      for (iter = priv->collisions; iter; iter = g_list_next (iter))
+        g_object_unref (iter->data);
+      g_list_free (priv->collisions);
+      priv->collisions = NULL;
+
+      /* Pending sensor events are kept, the sensors report what changed
+       * from them on */
+
+      priv->snapshot_serial++;
+
+      actors = g_hash_table_get_values (priv->actors);
+      for (iter = actors; iter; iter = g_list_next (iter))
+        _clutter_box2d_sync_actor (box2d, (ClutterBox2DChild*) iter->data);
+      g_list_free (actors);
+
+      g_list_foreach (priv->particles,
+                      (GFunc) _clutter_box2d_particles_sync, NULL);
+    }
+
+  _clutter_box2d_unlock_world (box2d);
+
+  return restored;
+}
+
+void
+clutter_box2d_shift_origin (ClutterBox2D *box2d,
+                            gfloat        x,
+                            gfloat        y)
+{
+  ClutterBox2DPrivate *priv;
+  GList *children, *iter;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+
+  priv = box2d->priv;
+
+  clutter_box2d_join_step (box2d);
+  _clutter_box2d_lock_world (box2d);
+
+  priv->world->ShiftOrigin (b2Vec2 (x * priv->scale_factor,
+                                    y * priv->scale_factor));
+  priv->origin_x += x;
+  priv->origin_y += y;
+
+  /* Published snapshots hold positions relative to the old origin */
+  priv->snapshot_serial++;
+
+  children = clutter_container_get_children (CLUTTER_CONTAINER (box2d));
+  for (iter = children; iter; iter = g_list_next (iter))
+    {
+      ClutterActor *actor = CLUTTER_ACTOR (iter->data);
+      ClutterBox2DChild *child = clutter_box2d_get_child (box2d, actor);
+
+      /* Particle groups draw their particles where the world has them */
+      if (CLUTTER_IS_BOX2D_PARTICLES (actor))
+        continue;
+
+      if (child->priv->body)
+        _clutter_box2d_sync_actor (box2d, child);
+      else
+        clutter_actor_move_by (actor, -x, -y);
+    }
+  g_list_free (children);
+
+  g_list_foreach (priv->particles, (GFunc) _clutter_box2d_particles_sync, NULL);
+
+  _clutter_box2d_unlock_world (box2d);
+}
+
+void
+clutter_box2d_get_origin (ClutterBox2D *box2d,
+                          gdouble      *x,
+                          gdouble      *y)
+{
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+
+  if (x)
+    *x = box2d->priv->origin_x;
+  if (y)
+    *y = box2d->priv->origin_y;
+}
+
+/* Appends a command for the body of each actor to the bulk commands, with
+ * the value taken from @vectors in pixels or from @scalars as it is.
+ * Actors without a body are skipped.
+ */
+static void
+clutter_box2d_queue_bulk_commands (ClutterBox2D            *box2d,
+                                   ClutterBox2DCommandType  type,
+                                   ClutterActor           **actors,
+                                   const ClutterVertex     *vectors,
+                                   const gfloat            *scalars,
+                                   guint                    n_actors)
+{
+  ClutterBox2DPrivate *priv = box2d->priv;
+  ClutterBox2DCommand *commands;
+  guint                i, n, len;
+
+  if (priv->commands_lock)
+    g_mutex_lock (priv->commands_lock);
+
+  len = priv->bulk_commands->len;
+  g_array_set_size (priv->bulk_commands, len + n_actors);
+  commands = &g_array_index (priv->bulk_commands, ClutterBox2DCommand, len);
+
+  for (i = 0, n = 0; i < n_actors; i++)
+    {
+      ClutterBox2DChild *box2d_child = (ClutterBox2DChild *)
+        g_hash_table_lookup (priv->actors, actors[i]);
+
+      if (!box2d_child || !box2d_child->priv->body)
+        continue;
+
+      commands[n].type = type;
+      commands[n].object = box2d_child->priv->body;
+      if (vectors)
+        commands[n].value.Set (vectors[i].x * priv->scale_factor,
+                               vectors[i].y * priv->scale_factor);
+      else
+        commands[n].value.Set (scalars[i], 0);
+      n++;
+    }
+
+  g_array_set_size (priv->bulk_commands, len + n);
+
+  if (priv->commands_lock)
+    g_mutex_unlock (priv->commands_lock);
+}
+
+void
+clutter_box2d_set_linear_velocities (ClutterBox2D         *box2d,
+                                     ClutterActor        **actors,
+                                     const ClutterVertex  *velocities,
+                                     guint                 n_actors)
+{
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (actors != NULL || n_actors == 0);
+  g_return_if_fail (velocities != NULL || n_actors == 0);
+
+  clutter_box2d_queue_bulk_commands (box2d,
+                                     CLUTTER_BOX2D_COMMAND_LINEAR_VELOCITY,
+                                     actors, velocities, NULL, n_actors);
+}
+
+void
+clutter_box2d_set_angular_velocities (ClutterBox2D  *box2d,
+                                      ClutterActor **actors,
+                                      const gfloat  *velocities,
+                                      guint          n_actors)
+{
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (actors != NULL || n_actors == 0);
+  g_return_if_fail (velocities != NULL || n_actors == 0);
+
+  clutter_box2d_queue_bulk_commands (box2d,
+                                     CLUTTER_BOX2D_COMMAND_ANGULAR_VELOCITY,
+                                     actors, NULL, velocities, n_actors);
+}
+
+void
+clutter_box2d_apply_impulses (ClutterBox2D         *box2d,
+                              ClutterActor        **actors,
+                              const ClutterVertex  *impulses,
+                              guint                 n_actors)
+{
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (actors != NULL || n_actors == 0);
+  g_return_if_fail (impulses != NULL || n_actors == 0);
+
+  clutter_box2d_queue_bulk_commands (box2d,
+                                     CLUTTER_BOX2D_COMMAND_LINEAR_IMPULSE,
+                                     actors, impulses, NULL, n_actors);
+}
+
+void
+clutter_box2d_apply_forces (ClutterBox2D         *box2d,
+                            ClutterActor        **actors,
+                            const ClutterVertex  *forces,
+                            guint                 n_actors)
+{
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (actors != NULL || n_actors == 0);
+  g_return_if_fail (forces != NULL || n_actors == 0);
+
+  clutter_box2d_queue_bulk_commands (box2d,
+                                     CLUTTER_BOX2D_COMMAND_FORCE,
+                                     actors, forces, NULL, n_actors);
+}
+
+void
+clutter_box2d_get_positions (ClutterBox2D   *box2d,
+                             ClutterActor  **actors,
+                             ClutterVertex  *positions,
+                             gfloat         *angles,
+                             guint           n_actors)
+{
+  ClutterBox2DPrivate *priv;
+  guint                i;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (actors != NULL || n_actors == 0);
+
+  priv = box2d->priv;
+
+  _clutter_box2d_lock_world (box2d);
+
+  for (i = 0; i < n_actors; i++)
+    {
+      ClutterBox2DChild *box2d_child = (ClutterBox2DChild *)
+        g_hash_table_lookup (priv->actors, actors[i]);
+      b2Body *body = box2d_child ? box2d_child->priv->body : NULL;
+
+      if (!body)
+        {
+          if (positions)
+            positions[i] = (ClutterVertex){ 0, 0, 0 };
+          if (angles)
+            angles[i] = 0.f;
+          continue;
+        }
+
+      if (positions)
+        {
+          const b2Vec2 &position = body->GetPosition ();
+
+          positions[i].x = position.x * priv->inv_scale_factor;
+          positions[i].y = position.y * priv->inv_scale_factor;
+          positions[i].z = 0;
+
+          /* Circles are positioned by their centre */
+          if (box2d_child->priv->is_circle)
+            {
+              gfloat width, height, radius;
+
+              clutter_actor_get_size (actors[i], &width, &height);
+              radius = MIN (width, height) / 2.f;
+
+              positions[i].x -= radius;
+              positions[i].y -= radius;
+            }
+        }
+
+      if (angles)
+        angles[i] = body->GetAngle () * (180 / G_PI);
+    }
+
+  _clutter_box2d_unlock_world (box2d);
+}
+
+void
+clutter_box2d_get_velocities (ClutterBox2D   *box2d,
+                              ClutterActor  **actors,
+                              ClutterVertex  *linear,
+                              gfloat         *angular,
+                              guint           n_actors)
+{
+  ClutterBox2DPrivate *priv;
+  guint                i;
+
+  g_return_if_fail (CLUTTER_IS_BOX2D (box2d));
+  g_return_if_fail (actors != NULL || n_actors == 0);
+
+  priv = box2d->priv;
+
+  _clutter_box2d_lock_world (box2d);
+
+  for (i = 0; i < n_actors; i++)
+    {
+      ClutterBox2DChild *box2d_child = (ClutterBox2DChild *)
+        g_hash_table_lookup (priv->actors, actors[i]);
+      b2Body *body = box2d_child ? box2d_child->priv->body : NULL;
+
+      if (linear)
+        {
+          if (body)
+            {
+              b2Vec2 velocity = body->GetLinearVelocity ();
+
+              linear[i].x = velocity.x * priv->inv_scale_factor;
+              linear[i].y = velocity.y * priv->inv_scale_factor;
+              linear[i].z = 0;
+            }
+          else
+            linear[i] = (ClutterVertex){ 0, 0, 0 };
+        }
+
+      if (angular)
+        angular[i] = body ? body->GetAngularVelocity () : 0.f;
+    }
+
+  _clutter_box2d_unlock_world (box2d);
+}
+
+guint
+clutter_box2d_apply_radial_impulse (ClutterBox2D        *box2d,
+                                    const ClutterVertex *center,
+                                    gdouble              radius,
+                                    gdouble              strength,
+                                    gdouble              falloff,
+                                    gboolean             occlusion)
+{
+  ClutterBox2DPrivate *priv;
+  b2ExplosionDef       def;
+  guint                count;
+
+  g_return_val_if_fail (CLUTTER_IS_BOX2D (box2d), 0);
+  g_return_val_if_fail (center != NULL, 0);
+  g_return_val_if_fail (radius >= 0 && falloff >= 0, 0);
+
+  priv = box2d->priv;
+
+  def.position.Set (center->x * priv->scale_factor,
+                    center->y * priv->scale_factor);
+  def.radius = radius * priv->scale_factor;
+  def.falloff = falloff * priv->scale_factor;
+  def.impulse = strength * priv->scale_factor;
+  def.occlusion = occlusion ? true : false;
+
+  _clutter_box2d_lock_world (box2d);
+  count = priv->world->Explode (def);
+  _clutter_box2d_unlock_world (box2d);
+
+  return count;
+}
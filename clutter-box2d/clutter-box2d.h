@@ -23,6 +23,12 @@ G_BEGIN_DECLS
  *
  * ClutterBox2D is a container that can physically simulate collisions
  * between dynamic and static actors.
+ *
+ * All the containers of a process that keep the default iterate function
+ * are stepped from one shared timeout. When threads have been initialized
+ * with g_thread_init(), the physics steps of containers due in the same
+ * frame run in parallel; actors are moved and collision signals are
+ * emitted from the main thread afterwards.
  */
 
 #define CLUTTER_TYPE_BOX2D    clutter_box2d_get_type ()
@@ -110,7 +116,50 @@ GType            clutter_box2d_get_type         (void) G_GNUC_CONST;
  *
  * The amount of iterations to perform on each physics step to resolve
  * contacts and joints. Larger values yield a more accurate simulation,
- * at the cost of CPU usage.
+ * at the cost of CPU usage. With #ClutterBox2D:sub-stepping this is the
+ * number of sub-steps instead.
+ */
+
+/**
+ * ClutterBox2D:threaded
+ *
+ * Whether the physics steps are run in a separate thread. When enabled the
+ * main loop only moves actors to the latest simulated positions, so a slow
+ * step no longer delays painting. Changes to the simulation made while a
+ * step is in progress either wait for the step to finish or, for
+ * velocities and mouse joint targets, are applied before the next one.
+ */
+
+
+/**
+ * ClutterBox2D:pipelined
+ *
+ * Whether the next physics step runs on a worker thread while the stage
+ * paints the previous one. Right after the actors have been moved to the
+ * results of a step, the following step is started and it is picked up on
+ * the next tick, so a step no longer adds to the frame time on multicore
+ * machines. Actors moved by the application take effect one step later
+ * than without pipelining. Has no effect on threaded containers or on
+ * subclasses overriding the iterate function.
+ */
+
+/**
+ * ClutterBox2D:lod-interval
+ *
+ * The number of physics steps between steps of children with the
+ * %CLUTTER_BOX2D_LOD_REDUCE policy while they are not visible. Each of
+ * their steps covers the time they missed, so larger values save more CPU
+ * at the cost of accuracy.
+ */
+
+/**
+ * ClutterBox2D:sub-stepping
+ *
+ * Whether each physics step is divided into sub-steps, as many as
+ * #ClutterBox2D:iterations, with contacts solved as stiff springs once per
+ * sub-step instead of iteratively. Tall stacks of actors stay upright
+ * with about 4 sub-steps, where the default solver needs several times
+ * the iterations and CPU time. Joints are solved in each sub-step too.
  */
 
 
@@ -185,6 +234,312 @@ void  clutter_box2d_set_scale_factor (ClutterBox2D *box2d,
  */
 gfloat  clutter_box2d_get_scale_factor (ClutterBox2D *box2d);
 
+/**
+ * clutter_box2d_set_threaded:
+ * @box2d: a #ClutterBox2D
+ * @threaded: whether to step the simulation in a separate thread
+ *
+ * Sets whether the physics simulation of @box2d runs in its own thread,
+ * see #ClutterBox2D:threaded. The value defaults to FALSE.
+ */
+void  clutter_box2d_set_threaded (ClutterBox2D *box2d,
+                                  gboolean      threaded);
+
+/**
+ * clutter_box2d_get_threaded:
+ * @box2d: a #ClutterBox2D
+ *
+ * Checks whether the simulation of @box2d is stepped in a separate thread.
+ *
+ * Returns: whether the simulation is threaded.
+ */
+gboolean  clutter_box2d_get_threaded (ClutterBox2D *box2d);
+
+/**
+ * clutter_box2d_set_pipelined:
+ * @box2d: a #ClutterBox2D
+ * @pipelined: whether to overlap physics steps with painting
+ *
+ * Sets whether @box2d steps its simulation while the stage is painted,
+ * see #ClutterBox2D:pipelined. The value defaults to FALSE.
+ */
+void  clutter_box2d_set_pipelined (ClutterBox2D *box2d,
+                                   gboolean      pipelined);
+
+/**
+ * clutter_box2d_get_pipelined:
+ * @box2d: a #ClutterBox2D
+ *
+ * Checks whether @box2d overlaps its physics steps with painting.
+ *
+ * Returns: whether the simulation is pipelined.
+ */
+gboolean  clutter_box2d_get_pipelined (ClutterBox2D *box2d);
+
+/**
+ * clutter_box2d_set_lod_interval:
+ * @box2d: a #ClutterBox2D
+ * @interval: the number of steps, at least 1
+ *
+ * Sets how often children that are not visible are stepped, see
+ * #ClutterBox2D:lod-interval. The value defaults to 4.
+ */
+void  clutter_box2d_set_lod_interval (ClutterBox2D *box2d,
+                                      gint          interval);
+
+/**
+ * clutter_box2d_get_lod_interval:
+ * @box2d: a #ClutterBox2D
+ *
+ * Gets how often children that are not visible are stepped.
+ *
+ * Returns: the number of steps between steps of children that are not
+ * visible.
+ */
+gint  clutter_box2d_get_lod_interval (ClutterBox2D *box2d);
+
+/**
+ * clutter_box2d_set_sub_stepping:
+ * @box2d: a #ClutterBox2D
+ * @sub_stepping: whether to solve contacts in sub-steps
+ *
+ * Sets whether physics steps are divided into sub-steps, see
+ * #ClutterBox2D:sub-stepping. The value defaults to %FALSE.
+ */
+void  clutter_box2d_set_sub_stepping (ClutterBox2D *box2d,
+                                      gboolean      sub_stepping);
+
+/**
+ * clutter_box2d_get_sub_stepping:
+ * @box2d: a #ClutterBox2D
+ *
+ * Checks whether @box2d divides its physics steps into sub-steps.
+ *
+ * Returns: whether sub-stepping is enabled.
+ */
+gboolean  clutter_box2d_get_sub_stepping (ClutterBox2D *box2d);
+
+/**
+ * clutter_box2d_get_state_size:
+ * @box2d: a #ClutterBox2D
+ *
+ * Gets the number of bytes clutter_box2d_save_state() needs to save the
+ * current state of @box2d. The size changes as bodies come into and go
+ * out of contact.
+ *
+ * Returns: the size of the saved state in bytes.
+ */
+gsize  clutter_box2d_get_state_size (ClutterBox2D *box2d);
+
+/**
+ * clutter_box2d_save_state:
+ * @box2d: a #ClutterBox2D
+ * @buffer: memory to save the state to
+ * @size: the size of @buffer in bytes
+ *
+ * Saves the simulation state of @box2d, the positions and velocities of
+ * all bodies along with the contacts and joints between them, so that it
+ * can be rolled back to with clutter_box2d_restore_state(). The saved
+ * state is only meaningful to the same @box2d in the same process.
+ *
+ * Returns: %TRUE if the state was saved, %FALSE if @size is smaller than
+ * clutter_box2d_get_state_size().
+ */
+gboolean  clutter_box2d_save_state (ClutterBox2D *box2d,
+                                    gpointer      buffer,
+                                    gsize         size);
+
+/**
+ * clutter_box2d_restore_state:
+ * @box2d: a #ClutterBox2D
+ * @buffer: a state saved with clutter_box2d_save_state()
+ * @size: the size of @buffer in bytes
+ *
+ * Rolls the simulation of @box2d back to a saved state and moves the
+ * actors to match. Stepping from the restored state gives exactly the
+ * same results as stepping from the point it was saved at. Collisions
+ * that have not been emitted yet are dropped.
+ *
+ * The children, their shapes and the joints between them have to be the
+ * same as when the state was saved. Changing the size, outline or material
+ * of a child recreates its shape, so a state saved before does not match
+ * anymore.
+ *
+ * Returns: %TRUE if the state was restored, %FALSE if it does not match
+ * the world, in which case @box2d is left unchanged.
+ */
+gboolean  clutter_box2d_restore_state (ClutterBox2D  *box2d,
+                                       gconstpointer  buffer,
+                                       gsize          size);
+
+/**
+ * clutter_box2d_shift_origin:
+ * @box2d: a #ClutterBox2D
+ * @x: horizontal distance to move the origin by, in pixels
+ * @y: vertical distance to move the origin by, in pixels
+ *
+ * Moves the origin of the simulation to (@x, @y) of the current
+ * coordinates. All bodies, joints and children are moved by (-@x, -@y),
+ * the simulation carries on unchanged. Scrolling scenes that keep the
+ * origin near the viewport keep the precision of the engine, which gets
+ * worse the further bodies are from the origin.
+ */
+void      clutter_box2d_shift_origin (ClutterBox2D *box2d,
+                                      gfloat        x,
+                                      gfloat        y);
+
+/**
+ * clutter_box2d_get_origin:
+ * @box2d: a #ClutterBox2D
+ * @x: (out): return location for the horizontal position, or %NULL
+ * @y: (out): return location for the vertical position, or %NULL
+ *
+ * Gets how far the origin has been moved by clutter_box2d_shift_origin()
+ * in total, in pixels. Adding it to the position of a child gives the
+ * position the child would have without the shifts.
+ */
+void      clutter_box2d_get_origin   (ClutterBox2D *box2d,
+                                      gdouble      *x,
+                                      gdouble      *y);
+
+/**
+ * clutter_box2d_set_linear_velocities:
+ * @box2d: a #ClutterBox2D
+ * @actors: (array length=n_actors): children of @box2d
+ * @velocities: (array length=n_actors): the velocity of each actor, in
+ * pixels per second
+ * @n_actors: the number of actors
+ *
+ * Sets the linear velocity of many children at once. Unlike
+ * clutter_box2d_child_set_linear_velocity() the velocities are applied in
+ * one pass right before the next step, after any change made with the
+ * per-child functions, and no property notifications are emitted. Actors
+ * that have no body in @box2d are skipped.
+ */
+void      clutter_box2d_set_linear_velocities  (ClutterBox2D         *box2d,
+                                                ClutterActor        **actors,
+                                                const ClutterVertex  *velocities,
+                                                guint                 n_actors);
+
+/**
+ * clutter_box2d_set_angular_velocities:
+ * @box2d: a #ClutterBox2D
+ * @actors: (array length=n_actors): children of @box2d
+ * @velocities: (array length=n_actors): the angular velocity of each
+ * actor, in radians per second
+ * @n_actors: the number of actors
+ *
+ * Sets the angular velocity of many children at once, in the same way as
+ * clutter_box2d_set_linear_velocities().
+ */
+void      clutter_box2d_set_angular_velocities (ClutterBox2D  *box2d,
+                                                ClutterActor **actors,
+                                                const gfloat  *velocities,
+                                                guint          n_actors);
+
+/**
+ * clutter_box2d_apply_impulses:
+ * @box2d: a #ClutterBox2D
+ * @actors: (array length=n_actors): children of @box2d
+ * @impulses: (array length=n_actors): the impulse for each actor, the
+ * change of velocity in pixels per second times the mass
+ * @n_actors: the number of actors
+ *
+ * Applies an impulse at the centre of mass of many dynamic children at
+ * once, in the same way as clutter_box2d_set_linear_velocities().
+ * Impulses for the same actor add up.
+ */
+void      clutter_box2d_apply_impulses (ClutterBox2D         *box2d,
+                                        ClutterActor        **actors,
+                                        const ClutterVertex  *impulses,
+                                        guint                 n_actors);
+
+/**
+ * clutter_box2d_apply_forces:
+ * @box2d: a #ClutterBox2D
+ * @actors: (array length=n_actors): children of @box2d
+ * @forces: (array length=n_actors): the force on each actor, in the units
+ * of @impulses of clutter_box2d_apply_impulses() per second
+ * @n_actors: the number of actors
+ *
+ * Applies a force at the centre of mass of many dynamic children for the
+ * duration of the next step, in the same way as
+ * clutter_box2d_set_linear_velocities(). Forces for the same actor add
+ * up; to keep pushing, call this before every step.
+ */
+void      clutter_box2d_apply_forces   (ClutterBox2D         *box2d,
+                                        ClutterActor        **actors,
+                                        const ClutterVertex  *forces,
+                                        guint                 n_actors);
+
+/**
+ * clutter_box2d_get_positions:
+ * @box2d: a #ClutterBox2D
+ * @actors: (array length=n_actors): children of @box2d
+ * @positions: (out caller-allocates) (array length=n_actors) (allow-none):
+ * return location for the position of each actor, in pixels, or %NULL
+ * @angles: (out caller-allocates) (array length=n_actors) (allow-none):
+ * return location for the rotation of each actor, in degrees, or %NULL
+ * @n_actors: the number of actors
+ *
+ * Reads the positions of the bodies of many children at once, locking a
+ * threaded simulation only once. The positions are those the actors will
+ * be moved to, which may be ahead of the actors themselves. Actors that
+ * have no body in @box2d get zeros.
+ */
+void      clutter_box2d_get_positions  (ClutterBox2D   *box2d,
+                                        ClutterActor  **actors,
+                                        ClutterVertex  *positions,
+                                        gfloat         *angles,
+                                        guint           n_actors);
+
+/**
+ * clutter_box2d_get_velocities:
+ * @box2d: a #ClutterBox2D
+ * @actors: (array length=n_actors): children of @box2d
+ * @linear: (out caller-allocates) (array length=n_actors) (allow-none):
+ * return location for the velocity of each actor, in pixels per second,
+ * or %NULL
+ * @angular: (out caller-allocates) (array length=n_actors) (allow-none):
+ * return location for the angular velocity of each actor, in radians per
+ * second, or %NULL
+ * @n_actors: the number of actors
+ *
+ * Reads the velocities of the bodies of many children at once, in the
+ * same way as clutter_box2d_get_positions().
+ */
+void      clutter_box2d_get_velocities (ClutterBox2D   *box2d,
+                                        ClutterActor  **actors,
+                                        ClutterVertex  *linear,
+                                        gfloat         *angular,
+                                        guint           n_actors);
+
+/**
+ * clutter_box2d_apply_radial_impulse:
+ * @box2d: a #ClutterBox2D
+ * @center: the center of the explosion, in pixels
+ * @radius: the distance from @center within which actors get the full
+ * impulse, in pixels
+ * @strength: the impulse, in the units of clutter_box2d_apply_impulses()
+ * @falloff: the distance past @radius over which the impulse fades out
+ * linearly, in pixels
+ * @occlusion: whether actors hidden from @center by another actor are
+ * spared
+ *
+ * Pushes the dynamic actors near @center away from it, like an explosion;
+ * a negative @strength pulls them in instead. Each actor is pushed at its
+ * point closest to @center, so it may start spinning too. Only the actors
+ * within reach are visited, so this stays cheap in large scenes.
+ *
+ * Returns: the number of actors that were pushed.
+ */
+guint     clutter_box2d_apply_radial_impulse (ClutterBox2D        *box2d,
+                                              const ClutterVertex *center,
+                                              gdouble              radius,
+                                              gdouble              strength,
+                                              gdouble              falloff,
+                                              gboolean             occlusion);
+
 /**
  * SECTION:clutter-box2d-actor
  * @short_description: Options for the children of ClutterBox2D
@@ -219,11 +574,35 @@ typedef enum {
   CLUTTER_BOX2D_STATIC,
 } ClutterBox2DType;
 
+/**
+ * ClutterBox2DLod:
+ * @CLUTTER_BOX2D_LOD_NONE: The child is always simulated at the full rate
+ * @CLUTTER_BOX2D_LOD_REDUCE: The child is simulated at a lower rate, see
+ *   #ClutterBox2D:lod-interval
+ * @CLUTTER_BOX2D_LOD_SLEEP: The child is put to sleep; it keeps its
+ *   velocity for when it is visible again
+ *
+ * What happens to a child while it is not visible, that is while its
+ * actor isn't mapped or lies outside of the stage and of the clip areas
+ * of the #ClutterBox2D and its ancestors. Children return to the full rate
+ * as soon as they become visible, catching up with the time they missed.
+ * Children touching or jointed to visible children are simulated at the
+ * rate of those.
+ */
+typedef enum {
+  CLUTTER_BOX2D_LOD_NONE = 0,
+  CLUTTER_BOX2D_LOD_REDUCE,
+  CLUTTER_BOX2D_LOD_SLEEP
+} ClutterBox2DLod;
+
 G_END_DECLS
 
 #endif
 
 #include <clutter-box2d/clutter-box2d-child.h>
 #include <clutter-box2d/clutter-box2d-collision.h>
+#include <clutter-box2d/clutter-box2d-field.h>
 #include <clutter-box2d/clutter-box2d-joint.h>
+#include <clutter-box2d/clutter-box2d-particles.h>
+#include <clutter-box2d/clutter-box2d-scene.h>
 #include <clutter-box2d/clutter-box2d-util.h>